@@ -0,0 +1,650 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the qe_bench
+ * program, which measures the speed of the solving functions.
+ *
+ * Every path (a solving function in one precision mode) solves
+ * the same arrays of equations with parameters from several
+ * distributions. A path is run several times, and the fastest
+ * run is reported as nanoseconds and processor cycles per
+ * equation and equations per second. The cycles are read with
+ * rdtsc, they are the cycles of the constant-rate time stamp
+ * counter (empty on other processors).
+ *
+ * Usage: qe_bench [-j] [-n size] [-r runs] [-s seed] [-i isa]
+ *
+ *   -j  JSON output instead of CSV;
+ *   -n  the number of equations (1048576 by default);
+ *   -r  the number of runs of every path (5 by default);
+ *   -s  the seed of the random parameters;
+ *   -i  the instruction set of the batch kernels (the
+ *       QE_ISA_* values), by default the best supported one;
+ *       an unsupported one is replaced as in qe_batch_set_isa.
+ *
+-------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 199309L
+#define QE_INLINE
+
+#include "qe_async.h"
+#include "qe_pool.h"
+#include "qe_reduce.h"
+#include "qe_sweep.h"
+#include "quadratic_equation.h"
+#include <float.h>
+#include <math.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define QE_BENCH_TSC 1
+#else
+#define QE_BENCH_TSC 0
+#endif
+
+/* The arrays of the equations and of the results. */
+typedef struct {
+  double *a, *b, *c, *res1, *res2, *im;
+  int *msg_id;
+  double *roots;         /* 2 * n roots of the packed path. */
+  unsigned char *status; /* The packed msg_id of the packed path. */
+  size_t *idx;           /* The indices of the select path. */
+  float *fa, *fb, *fc;   /* The parameters rounded to float. */
+  float *fres1, *fres2;  /* The roots of the float path. */
+  size_t n;
+} bench_data;
+
+/* A generator of the parameters of one equation. */
+typedef void (*bench_gen)(double *a, double *b, double *c);
+
+/* A function that solves all the equations of data. */
+typedef void (*bench_run)(bench_data *data, int prec);
+
+/*
+ * A structure that describes a distribution
+ * of the parameters `a`, `b`, `c`.
+ */
+typedef struct {
+  bench_gen gen; /* Generator of the parameters. */
+  char *name;    /* Name of the distribution. */
+} bench_dist;
+
+/*
+ * A structure that describes a path: the
+ * solving function and the precision mode.
+ */
+typedef struct {
+  bench_run run; /* The function that solves the equations. */
+  int prec;      /* Precision mode. */
+  char *name;    /* Name of the path. */
+} bench_path;
+
+/* The state of the random generator (xorshift64*). */
+static uint64_t rand_state = 88172645463325252ULL;
+
+/* The function returns a random number from 0 to 1. */
+static double random_unit(void) {
+  rand_state ^= rand_state >> 12;
+  rand_state ^= rand_state << 25;
+  rand_state ^= rand_state >> 27;
+  return (double)((rand_state * 2685821657736338717ULL) >> 11) /
+         9007199254740992.0;
+}
+
+/* The function returns a random number from -1 to 1. */
+static double random_sym(void) { return 2 * random_unit() - 1; }
+
+/* Parameters from -1 to 1. */
+static void gen_uniform(double *a, double *b, double *c) {
+  *a = random_sym();
+  *b = random_sym();
+  *c = random_sym();
+}
+
+/*
+ * Every parameter is zero with the probability 1/2, so the linear,
+ * incomplete and identity equations make up most of the data.
+ */
+static void gen_degenerate(double *a, double *b, double *c) {
+  *a = (random_unit() < 0.5) ? 0 : random_sym();
+  *b = (random_unit() < 0.5) ? 0 : random_sym();
+  *c = (random_unit() < 0.5) ? 0 : random_sym();
+}
+
+/*
+ * Equations a(x - r)^2 = 0 with `c` changed by a relative
+ * amount up to 1e-12: the discriminant is close to 0.
+ */
+static void gen_double_root(double *a, double *b, double *c) {
+  double r = random_sym();
+
+  *a = random_sym();
+  *b = -2 * *a * r;
+  *c = *a * r * r * (1 + 1e-12 * random_sym());
+}
+
+/* b * b >> 4ac: one root is much smaller than the other one. */
+static void gen_ill_conditioned(double *a, double *b, double *c) {
+  *a = random_sym();
+  *b = ((random_unit() < 0.5) ? -1 : 1) * (1e6 + 1e8 * random_unit());
+  *c = random_sym();
+}
+
+/*
+ * Parameters close to DBL_MAX, and a quarter of linear equations
+ * with a small `b` (like test6): many results overflow.
+ */
+static void gen_overflow_edge(double *a, double *b, double *c) {
+  *a = (random_unit() < 0.25) ? 0 : DBL_MAX * random_sym();
+  *b = (*a == 0) ? 0.01 * random_sym() : DBL_MAX * random_sym();
+  *c = DBL_MAX * random_sym();
+}
+
+/* The paths of solve_equation and solve_equation_prec. */
+static void run_scalar(bench_data *data, int prec) {
+  for (size_t i = 0; i < data->n; i++)
+    data->msg_id[i] =
+        (prec == QE_PREC_EXTENDED)
+            ? solve_equation(data->a[i], data->b[i], data->c[i],
+                             &data->res1[i], &data->res2[i])
+            : solve_equation_prec(data->a[i], data->b[i], data->c[i],
+                                  &data->res1[i], &data->res2[i], prec);
+}
+
+/* The path of solve_equation_inline. */
+static void run_inline(bench_data *data, int prec) {
+  (void)prec;
+  for (size_t i = 0; i < data->n; i++) {
+    qe_result r = solve_equation_inline(data->a[i], data->b[i], data->c[i]);
+
+    data->msg_id[i] = r.msg_id;
+    data->res1[i] = r.res1;
+    data->res2[i] = r.res2;
+  }
+}
+
+/* The path of solve_equation_branchless. */
+static void run_branchless(bench_data *data, int prec) {
+  (void)prec;
+  for (size_t i = 0; i < data->n; i++)
+    data->msg_id[i] = solve_equation_branchless(
+        data->a[i], data->b[i], data->c[i], &data->res1[i], &data->res2[i]);
+}
+
+/* The path of solve_equation_batch_prec. */
+static void run_batch(bench_data *data, int prec) {
+  solve_equation_batch_prec(data->a, data->b, data->c, data->res1, data->res2,
+                            data->msg_id, data->n, prec);
+}
+
+/* The path of solve_equation_batch_polish. */
+static void run_polish(bench_data *data, int prec) {
+  solve_equation_batch_polish(data->a, data->b, data->c, data->res1,
+                              data->res2, data->msg_id, data->n, prec);
+}
+
+/*
+ * The path of solve_equation_batch_float with the tolerance 1e-5:
+ * the parameters rounded to float.
+ */
+static void run_float(bench_data *data, int prec) {
+  solve_equation_batch_float(data->fa, data->fb, data->fc, data->fres1,
+                             data->fres2, data->msg_id, data->n, 1e-5f, prec,
+                             NULL);
+}
+
+/* The path of solve_equation_batch_packed. */
+static void run_packed(bench_data *data, int prec) {
+  size_t nroots;
+
+  solve_equation_batch_packed(data->a, data->b, data->c, data->roots, &nroots,
+                              data->status, data->n, prec);
+}
+
+/*
+ * The path of solve_equation_sweep_c: the equations share `a` and
+ * `b` of the first one, so it is compared with the other paths only
+ * by the time.
+ */
+static void run_sweep(bench_data *data, int prec) {
+  solve_equation_sweep_c(data->a[0], data->b[0], data->c, data->res1,
+                         data->res2, data->msg_id, data->n, prec);
+}
+
+/*
+ * The path of solve_equation_batch_fixed_a: the equations share `a`
+ * of the first one.
+ */
+static void run_fixed_a(bench_data *data, int prec) {
+  solve_equation_batch_fixed_a(data->a[0], data->b, data->c, data->res1,
+                               data->res2, data->msg_id, data->n, prec);
+}
+
+/* The path of solve_equation_batch_monic: `a` is replaced by 1. */
+static void run_monic(bench_data *data, int prec) {
+  solve_equation_batch_monic(data->b, data->c, data->res1, data->res2,
+                             data->msg_id, data->n, prec);
+}
+
+/* The path of classify_equation_batch. */
+static void run_classify(bench_data *data, int prec) {
+  classify_equation_batch(data->a, data->b, data->c, data->msg_id, data->n,
+                          prec);
+}
+
+/* The path of classify_equation_select: the equations with real roots. */
+static void run_select(bench_data *data, int prec) {
+  size_t count;
+
+  classify_equation_select(data->a, data->b, data->c,
+                           QE_CLASS(QE_OK_TWO_RES) | QE_CLASS(QE_OK_ONE_RES),
+                           data->idx, &count, data->n, prec);
+}
+
+/* The path of select_equation_roots_in: the roots in [-0.5, 0.5]. */
+static void run_range(bench_data *data, int prec) {
+  size_t count;
+
+  select_equation_roots_in(data->a, data->b, data->c, -0.5, 0.5, data->idx,
+                           &count, data->n, prec);
+}
+
+/* The bins of the histogram of the reduce paths. */
+static unsigned long long reduce_bins[256];
+
+/*
+ * The path of solve_equation_batch_reduce: the counts, the smallest
+ * and the largest root, the sum and the histogram on [-4, 4).
+ */
+static void run_reduce(bench_data *data, int prec) {
+  qe_reduce r = {.what = QE_REDUCE_COUNTS | QE_REDUCE_MINMAX |
+                         QE_REDUCE_SUM | QE_REDUCE_HIST,
+                 .hist_lo = -4,
+                 .hist_hi = 4,
+                 .nbins = 256,
+                 .bins = reduce_bins};
+
+  qe_reduce_reset(&r);
+  solve_equation_batch_reduce(data->a, data->b, data->c, &r, data->n, prec);
+}
+
+/* The aggregates of the solve_scan path. */
+static qe_reduce scan_result;
+
+/*
+ * The path that solve_equation_batch_reduce replaces: the equations
+ * are solved into the arrays by solve_equation_batch_prec, then a
+ * plain loop computes the aggregates of run_reduce.
+ */
+static void run_solve_scan(bench_data *data, int prec) {
+  qe_reduce *r = &scan_result;
+  const double scale = 256 / 8.0;
+
+  solve_equation_batch_prec(data->a, data->b, data->c, data->res1, data->res2,
+                            data->msg_id, data->n, prec);
+
+  memset(r, 0, sizeof(*r));
+  memset(reduce_bins, 0, sizeof(reduce_bins));
+  r->min_root = INFINITY;
+  r->max_root = -INFINITY;
+
+  for (size_t i = 0; i < data->n; i++) {
+    int msg_id = data->msg_id[i], nk;
+    double larger = data->res1[i];
+
+    r->counts[msg_id - QE_ERR_NULLPTR]++;
+    if ((msg_id != QE_OK_TWO_RES) && (msg_id != QE_OK_ONE_RES))
+      continue;
+
+    nk = (msg_id == QE_OK_TWO_RES) ? 2 : 1;
+    for (int k = 0; k < nk; k++) {
+      double x = k ? data->res2[i] : data->res1[i];
+
+      r->nroots++;
+      if (x < r->min_root)
+        r->min_root = x;
+      if (x > r->max_root)
+        r->max_root = x;
+      if (x < -4)
+        r->below++;
+      else if (x >= 4)
+        r->above++;
+      else if (x == x)
+        reduce_bins[((x + 4) * scale < 255) ? (size_t)((x + 4) * scale)
+                                            : 255]++;
+    }
+
+    if ((nk == 2) && !(data->res2[i] <= larger))
+      larger = data->res2[i];
+    if (larger == larger) {
+      double t = r->sum_larger + larger, bp = t - r->sum_larger;
+
+      r->sum_err += (r->sum_larger - (t - bp)) + (larger - bp);
+      r->sum_larger = t;
+    }
+  }
+}
+
+/* The path of solve_equation_batch_reduce_parallel on the default pool. */
+static void run_reduce_parallel(bench_data *data, int prec) {
+  qe_reduce r = {.what = QE_REDUCE_COUNTS | QE_REDUCE_MINMAX |
+                         QE_REDUCE_SUM | QE_REDUCE_HIST,
+                 .hist_lo = -4,
+                 .hist_hi = 4,
+                 .nbins = 256,
+                 .bins = reduce_bins};
+
+  qe_reduce_reset(&r);
+  solve_equation_batch_reduce_parallel(NULL, data->a, data->b, data->c, &r,
+                                       data->n, prec);
+}
+
+/* The path of solve_equation_batch_complex. */
+static void run_complex(bench_data *data, int prec) {
+  solve_equation_batch_complex(data->a, data->b, data->c, data->res1,
+                               data->res2, data->im, data->msg_id, data->n,
+                               prec);
+}
+
+/* The path of solve_equation_batch_parallel on the default pool. */
+static void run_parallel(bench_data *data, int prec) {
+  solve_equation_batch_parallel(NULL, data->a, data->b, data->c, data->res1,
+                                data->res2, data->msg_id, data->n, prec);
+}
+
+/* The queues of the async path, created at the first run. */
+static qe_async *async_queues[2];
+
+/*
+ * The path of the asynchronous queue with one solver thread: the
+ * equations are submitted and the results are polled by the
+ * calling thread, so the time includes the way there and back.
+ */
+static void run_async(bench_data *data, int prec) {
+  qe_async *q = async_queues[prec];
+  qe_request *req;
+  size_t next = 0, solved = 0;
+
+  if (q == NULL)
+    q = async_queues[prec] = qe_async_create(1, 4096, prec);
+
+  while (solved < data->n) {
+    size_t before = solved;
+
+    while ((next < data->n) && ((req = qe_async_acquire(q)) != NULL)) {
+      req->a = data->a[next];
+      req->b = data->b[next];
+      req->c = data->c[next];
+      req->done = NULL;
+      req->user = &data->res1[next++];
+      qe_async_submit(q, req);
+    }
+
+    while ((req = qe_async_poll(q)) != NULL) {
+      size_t i = (size_t)((double *)req->user - data->res1);
+
+      data->res1[i] = req->res1;
+      data->res2[i] = req->res2;
+      data->msg_id[i] = req->msg_id;
+      qe_async_release(q, req);
+      solved++;
+    }
+
+    /* Every request is in flight, the solver needs the processor. */
+    if (solved == before)
+      sched_yield();
+  }
+}
+
+/* An array of the distributions. */
+static const bench_dist dist_arr[] = {
+    {.gen = gen_uniform, .name = "uniform"},
+    {.gen = gen_degenerate, .name = "degenerate"},
+    {.gen = gen_double_root, .name = "double_root"},
+    {.gen = gen_ill_conditioned, .name = "ill_conditioned"},
+    {.gen = gen_overflow_edge, .name = "overflow_edge"}};
+
+/* An array of the paths. */
+static const bench_path path_arr[] = {
+    {.run = run_scalar, .prec = QE_PREC_EXTENDED, .name = "scalar"},
+    {.run = run_inline, .prec = QE_PREC_EXTENDED, .name = "inline"},
+    {.run = run_branchless, .prec = QE_PREC_EXTENDED, .name = "branchless"},
+    {.run = run_scalar, .prec = QE_PREC_DOUBLE, .name = "scalar"},
+    {.run = run_sweep, .prec = QE_PREC_EXTENDED, .name = "sweep"},
+    {.run = run_sweep, .prec = QE_PREC_DOUBLE, .name = "sweep"},
+    {.run = run_fixed_a, .prec = QE_PREC_EXTENDED, .name = "fixed_a"},
+    {.run = run_fixed_a, .prec = QE_PREC_DOUBLE, .name = "fixed_a"},
+    {.run = run_monic, .prec = QE_PREC_EXTENDED, .name = "monic"},
+    {.run = run_monic, .prec = QE_PREC_DOUBLE, .name = "monic"},
+    {.run = run_batch, .prec = QE_PREC_EXTENDED, .name = "batch"},
+    {.run = run_batch, .prec = QE_PREC_DOUBLE, .name = "batch"},
+    {.run = run_polish, .prec = QE_PREC_EXTENDED, .name = "polish"},
+    {.run = run_float, .prec = QE_PREC_EXTENDED, .name = "float"},
+    {.run = run_float, .prec = QE_PREC_DOUBLE, .name = "float"},
+    {.run = run_classify, .prec = QE_PREC_EXTENDED, .name = "classify"},
+    {.run = run_classify, .prec = QE_PREC_DOUBLE, .name = "classify"},
+    {.run = run_select, .prec = QE_PREC_EXTENDED, .name = "select"},
+    {.run = run_select, .prec = QE_PREC_DOUBLE, .name = "select"},
+    {.run = run_range, .prec = QE_PREC_EXTENDED, .name = "range"},
+    {.run = run_range, .prec = QE_PREC_DOUBLE, .name = "range"},
+    {.run = run_reduce, .prec = QE_PREC_EXTENDED, .name = "reduce"},
+    {.run = run_reduce, .prec = QE_PREC_DOUBLE, .name = "reduce"},
+    {.run = run_solve_scan, .prec = QE_PREC_EXTENDED, .name = "solve_scan"},
+    {.run = run_solve_scan, .prec = QE_PREC_DOUBLE, .name = "solve_scan"},
+    {.run = run_packed, .prec = QE_PREC_EXTENDED, .name = "packed"},
+    {.run = run_packed, .prec = QE_PREC_DOUBLE, .name = "packed"},
+    {.run = run_complex, .prec = QE_PREC_EXTENDED, .name = "complex"},
+    {.run = run_complex, .prec = QE_PREC_DOUBLE, .name = "complex"},
+    {.run = run_parallel, .prec = QE_PREC_EXTENDED, .name = "parallel"},
+    {.run = run_parallel, .prec = QE_PREC_DOUBLE, .name = "parallel"},
+    {.run = run_reduce_parallel,
+     .prec = QE_PREC_EXTENDED,
+     .name = "reduce_parallel"},
+    {.run = run_reduce_parallel,
+     .prec = QE_PREC_DOUBLE,
+     .name = "reduce_parallel"},
+    {.run = run_async, .prec = QE_PREC_EXTENDED, .name = "async"},
+    {.run = run_async, .prec = QE_PREC_DOUBLE, .name = "async"}};
+
+/* The function returns the time in nanoseconds. */
+static double time_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/* The function returns the time stamp counter, or 0. */
+static uint64_t cycles(void) {
+#if QE_BENCH_TSC
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+/*
+ * The function runs the path the given number of times and
+ * writes the time and the cycles of the fastest run.
+ */
+static void measure(const bench_path *path, bench_data *data, int runs,
+                    double *best_ns, double *best_cycles) {
+
+  /* The first run warms up the caches and the pool. */
+  path->run(data, path->prec);
+
+  *best_ns = -1;
+  for (int i = 0; i < runs; i++) {
+    double t0 = time_ns(), t1;
+    uint64_t c0 = cycles(), c1;
+
+    path->run(data, path->prec);
+
+    c1 = cycles();
+    t1 = time_ns();
+    if ((*best_ns < 0) || (t1 - t0 < *best_ns)) {
+      *best_ns = t1 - t0;
+      *best_cycles = (double)(c1 - c0);
+    }
+  }
+}
+
+/*
+ * The main function parses the options, measures every path on
+ * every distribution and writes the results to stdout.
+ */
+int main(int argc, char *argv[]) {
+  int json = 0, runs = 5, opt, first = 1;
+  long isa = -1;
+  bench_data data;
+
+  data.n = 1 << 20;
+
+  while ((opt = getopt(argc, argv, "jn:r:s:i:h")) != -1) {
+    switch (opt) {
+    case 'j':
+      json = 1;
+      break;
+    case 'n':
+      data.n = strtoul(optarg, NULL, 10);
+      break;
+    case 'r':
+      runs = atoi(optarg);
+      break;
+    case 's':
+      rand_state = strtoull(optarg, NULL, 10) | 1;
+      break;
+    case 'i':
+      isa = strtol(optarg, NULL, 10);
+      break;
+    default:
+      fprintf(stderr,
+              "Usage: %s [-j] [-n size] [-r runs] [-s seed] [-i isa]\n",
+              argv[0]);
+      return (opt == 'h') ? 0 : 1;
+    }
+  }
+
+  if ((data.n == 0) || (runs < 1)) {
+    fprintf(stderr, "qe_bench: the size and the runs must be positive.\n");
+    return 1;
+  }
+  if ((isa >= 0) && (qe_batch_set_isa((int)isa) != isa))
+    fprintf(stderr, "qe_bench: the instruction set %ld is not supported, "
+                    "%s is used.\n",
+            isa, qe_batch_isa_name(qe_batch_get_isa()));
+
+  data.a = malloc(data.n * sizeof(double));
+  data.b = malloc(data.n * sizeof(double));
+  data.c = malloc(data.n * sizeof(double));
+  data.res1 = malloc(data.n * sizeof(double));
+  data.res2 = malloc(data.n * sizeof(double));
+  data.im = malloc(data.n * sizeof(double));
+  data.msg_id = malloc(data.n * sizeof(int));
+  data.roots = malloc(2 * data.n * sizeof(double));
+  data.status = malloc(QE_PACKED_SIZE(data.n));
+  data.idx = malloc(data.n * sizeof(size_t));
+  data.fa = malloc(data.n * sizeof(float));
+  data.fb = malloc(data.n * sizeof(float));
+  data.fc = malloc(data.n * sizeof(float));
+  data.fres1 = malloc(data.n * sizeof(float));
+  data.fres2 = malloc(data.n * sizeof(float));
+  if (!data.a || !data.b || !data.c || !data.res1 || !data.res2 ||
+      !data.im || !data.msg_id || !data.roots || !data.status ||
+      !data.idx || !data.fa || !data.fb || !data.fc || !data.fres1 ||
+      !data.fres2) {
+    fprintf(stderr, "qe_bench: out of memory.\n");
+    return 1;
+  }
+
+  if (json)
+    printf("[\n");
+  else
+    printf("path,prec,isa,dist,n,ns_per_eq,eq_per_s,cycles_per_eq\n");
+
+  for (size_t d = 0; d < sizeof(dist_arr) / sizeof(dist_arr[0]); d++) {
+    for (size_t i = 0; i < data.n; i++) {
+      dist_arr[d].gen(&data.a[i], &data.b[i], &data.c[i]);
+      data.fa[i] = (float)data.a[i];
+      data.fb[i] = (float)data.b[i];
+      data.fc[i] = (float)data.c[i];
+    }
+
+    for (size_t p = 0; p < sizeof(path_arr) / sizeof(path_arr[0]); p++) {
+      const bench_path *path = &path_arr[p];
+      const char *prec =
+          (path->prec == QE_PREC_DOUBLE) ? "double" : "extended";
+      const char *isa_name = ((path->run == run_batch) ||
+                              (path->run == run_sweep) ||
+                              (path->run == run_fixed_a) ||
+                              (path->run == run_monic) ||
+                              (path->run == run_polish) ||
+                              (path->run == run_float) ||
+                              (path->run == run_classify) ||
+                              (path->run == run_select) ||
+                              (path->run == run_range) ||
+                              (path->run == run_reduce) ||
+                              (path->run == run_reduce_parallel) ||
+                              (path->run == run_packed) ||
+                              (path->run == run_complex) ||
+                              (path->run == run_parallel) ||
+                              (path->run == run_async))
+                                 ? qe_batch_isa_name(qe_batch_get_isa())
+                                 : "scalar";
+      double ns, cyc = 0, ns_eq, cyc_eq;
+
+      measure(path, &data, runs, &ns, &cyc);
+      ns_eq = ns / (double)data.n;
+      cyc_eq = cyc / (double)data.n;
+
+      if (json) {
+        printf("%s  {\"path\": \"%s\", \"prec\": \"%s\", \"isa\": \"%s\", "
+               "\"dist\": \"%s\", \"n\": %zu, \"ns_per_eq\": %.3f, "
+               "\"eq_per_s\": %.0f, \"cycles_per_eq\": ",
+               first ? "" : ",\n", path->name, prec, isa_name,
+               dist_arr[d].name, data.n, ns_eq, 1e9 / ns_eq);
+        if (QE_BENCH_TSC)
+          printf("%.2f}", cyc_eq);
+        else
+          printf("null}");
+      } else {
+        printf("%s,%s,%s,%s,%zu,%.3f,%.0f,", path->name, prec, isa_name,
+               dist_arr[d].name, data.n, ns_eq, 1e9 / ns_eq);
+        if (QE_BENCH_TSC)
+          printf("%.2f\n", cyc_eq);
+        else
+          printf("\n");
+      }
+      first = 0;
+      fflush(stdout);
+    }
+  }
+
+  if (json)
+    printf("\n]\n");
+
+  qe_async_destroy(async_queues[QE_PREC_EXTENDED]);
+  qe_async_destroy(async_queues[QE_PREC_DOUBLE]);
+  free(data.a);
+  free(data.b);
+  free(data.c);
+  free(data.res1);
+  free(data.res2);
+  free(data.im);
+  free(data.msg_id);
+  free(data.roots);
+  free(data.status);
+  free(data.idx);
+  free(data.fa);
+  free(data.fb);
+  free(data.fc);
+  free(data.fres1);
+  free(data.fres2);
+  return 0;
+}
@@ -0,0 +1,93 @@
+#ifndef QE_ASYNC_H
+#define QE_ASYNC_H
+
+#include "quadratic_equation.h"
+#include <stddef.h>
+
+/*
+ * The maximum number of requests solved at once by a solver thread
+ * of the asynchronous queue. The requests that are in the ring of
+ * the thread are taken up to this number and solved by one call of
+ * solve_equation_batch_prec.
+ */
+#define QE_ASYNC_BATCH 64
+
+/*
+ * The number of times a solver thread checks its empty ring before
+ * it goes to sleep. While it spins, a submission does not need to
+ * wake it up.
+ */
+#define QE_ASYNC_SPIN 4096
+
+/*
+ * An asynchronous queue of equations. The requests are taken from
+ * a pool allocated at the creation, put into the lock-free rings of
+ * the solver threads and solved in batches. A solved request is
+ * either passed to its callback on the solver thread or put into
+ * the completion ring, from which the caller takes it.
+ */
+typedef struct qe_async qe_async;
+
+/* A request of the asynchronous queue. */
+typedef struct qe_request qe_request;
+
+/*
+ * The type of the completion callback. It is called on a solver
+ * thread, so it must be short and must not block.
+ */
+typedef void (*qe_async_callback)(qe_request *req);
+
+struct qe_request {
+  double a, b, c;         /* The parameters, set by the caller. */
+  double res1, res2;      /* The roots, as in solve_equation. */
+  int msg_id;             /* The result of solving. */
+  qe_async_callback done; /* The callback, or NULL to poll. */
+  void *user;             /* Any pointer of the caller. */
+};
+
+/*
+ * A function that creates a queue of nrequests requests (rounded up
+ * to a power of two) and nthreads solver threads (if nthreads is not
+ * positive, one). The equations are solved in the precision mode
+ * prec. Returns NULL if the memory or the threads could not be
+ * allocated.
+ */
+extern qe_async *qe_async_create(int nthreads, size_t nrequests, int prec);
+
+/*
+ * A function that solves the submitted requests, stops the solver
+ * threads and frees the queue. The requests that were not released
+ * are freed too.
+ */
+extern void qe_async_destroy(qe_async *q);
+
+/*
+ * A function that takes a free request from the pool of the queue.
+ * Returns NULL if every request is in use. It may be called from
+ * any thread.
+ */
+extern qe_request *qe_async_acquire(qe_async *q);
+
+/*
+ * A function that returns a request to the pool. It is called for
+ * the requests taken by qe_async_poll; the requests with a callback
+ * are returned by the queue after the callback.
+ */
+extern void qe_async_release(qe_async *q, qe_request *req);
+
+/*
+ * A function that submits the request with the parameters set. It
+ * does not block: the request is put into the ring of a solver
+ * thread, and the thread is woken up only if it sleeps. It may be
+ * called from any thread.
+ */
+extern void qe_async_submit(qe_async *q, qe_request *req);
+
+/*
+ * A function that takes a solved request without a callback from
+ * the completion ring. Returns NULL if there is none. It may be
+ * called from any thread.
+ */
+extern qe_request *qe_async_poll(qe_async *q);
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef QE_CACHE_H
+#define QE_CACHE_H
+
+#include "quadratic_equation.h"
+#include <stddef.h>
+
+/*
+ * The number of entries in one set of the cache. An equation can
+ * be stored only in the set selected by the hash of its parameters,
+ * in any of its QE_CACHE_WAYS entries.
+ */
+#define QE_CACHE_WAYS 8
+
+/*
+ * Eviction policies: which entry of a full set is replaced by a
+ * new equation.
+ *
+ * QE_CACHE_EVICT_CLOCK replaces an entry that has not been hit
+ * since the hand of the set passed it last time (second chance),
+ * so the equations that repeat stay in the cache.
+ *
+ * QE_CACHE_EVICT_FIFO replaces the entries of the set in turn.
+ *
+ * QE_CACHE_EVICT_NONE does not replace entries: when a set is
+ * full, new equations are solved but not stored.
+ */
+#define QE_CACHE_EVICT_CLOCK 0
+#define QE_CACHE_EVICT_FIFO 1
+#define QE_CACHE_EVICT_NONE 2
+
+/*
+ * A cache of the results of solve_equation_prec. The entries are
+ * found by the exact bits of `a`, `b`, `c` and the precision mode.
+ * Every entry is protected by its own sequence counter: readers
+ * never wait, and a thread that finds an entry being written treats
+ * it as a miss. The cache can be used from many threads at once.
+ */
+typedef struct qe_cache qe_cache;
+
+/* The counters of a cache. */
+typedef struct {
+  unsigned long long hits;       /* Results found in the cache. */
+  unsigned long long misses;     /* Equations solved. */
+  unsigned long long insertions; /* Results stored. */
+  unsigned long long evictions;  /* Results replaced by other ones. */
+} qe_cache_stats;
+
+/*
+ * A function that creates a cache of at least capacity entries (the
+ * number of sets is rounded up to a power of two) with the given
+ * eviction policy. Returns NULL if the memory could not be allocated
+ * or the policy is unknown.
+ */
+extern qe_cache *qe_cache_create(size_t capacity, int policy);
+
+/*
+ * A function that frees the cache. It must not be
+ * called while other threads are using it.
+ */
+extern void qe_cache_destroy(qe_cache *cache);
+
+/*
+ * A function that solves the equation like solve_equation_prec,
+ * but first looks for its results in the cache. A hit returns
+ * exactly the msg_id and the roots of solve_equation_prec, and the
+ * results of a miss are stored in the cache.
+ */
+extern int qe_cache_solve(qe_cache *cache, double a, double b, double c,
+                          double *res1, double *res2, int prec);
+
+/*
+ * A function that writes the counters of the cache to *stats. The
+ * counters are updated by many threads, so they are consistent only
+ * when the cache is not used.
+ */
+extern void qe_cache_get_stats(const qe_cache *cache, qe_cache_stats *stats);
+
+/*
+ * A function that sets the counters of the cache to zero. It must
+ * be called when the cache is not used, otherwise some counters may
+ * keep their values.
+ */
+extern void qe_cache_reset_stats(qe_cache *cache);
+
+/*
+ * A function that removes all the entries of the cache. It may be
+ * called while other threads are using it.
+ */
+extern void qe_cache_clear(qe_cache *cache);
+
+#endif
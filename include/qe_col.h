@@ -0,0 +1,126 @@
+#ifndef QE_COL_H
+#define QE_COL_H
+
+#include "qe_pool.h"
+#include "quadratic_equation.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * A columnar file of equations. The file starts with a
+ * qe_col_header padded to QE_COL_ALIGN bytes, followed by groups of
+ * `group` rows (the last group may be shorter). A group of m rows
+ * holds the columns a, b, c and, if the file has results, res1, res2
+ * (doubles) and msg_id (int32), one after another; every column
+ * starts at a multiple of QE_COL_ALIGN, so it is page-aligned when
+ * the file is mapped. The numbers are in the byte order of the host.
+ *
+ * A group is solved right in the mapping by the batch functions,
+ * without parsing or copying, and the groups are processed one
+ * after another, so the file may be larger than the memory.
+ */
+#define QE_COL_MAGIC 0x31434551u /* "QEC1" */
+#define QE_COL_ALIGN 4096
+
+/* The number of rows of a group written by qe_col_writer. */
+#define QE_COL_GROUP 65536
+
+/* The flags of a file. */
+#define QE_COL_RESULTS 1 /* The file has the result columns. */
+#define QE_COL_SOLVED 2  /* The result columns are filled. */
+
+/* The header of a file. */
+typedef struct {
+  uint32_t magic; /* QE_COL_MAGIC. */
+  uint32_t flags; /* QE_COL_RESULTS, QE_COL_SOLVED. */
+  uint64_t n;     /* The number of rows. */
+  uint32_t group; /* The number of rows of a group. */
+  int32_t prec;   /* The precision mode of the results. */
+  uint8_t reserved[40];
+} qe_col_header;
+
+/*
+ * The columns of a group, as mapped in memory. The result columns
+ * are NULL if the file has none, and may only be written if the
+ * file is opened for writing.
+ */
+typedef struct {
+  const double *a, *b, *c;
+  double *res1, *res2;
+  int *msg_id; /* The int32 column. */
+  size_t n;    /* The number of rows of the group. */
+} qe_col_chunk;
+
+/* A file being written. */
+typedef struct qe_col_writer qe_col_writer;
+
+/*
+ * A function that creates (or truncates) the file at path for
+ * writing, with the result columns if flags has QE_COL_RESULTS.
+ * Returns NULL if the file could not be created or there is no
+ * memory (errno is set).
+ */
+extern qe_col_writer *qe_col_writer_create(const char *path, int flags);
+
+/*
+ * A function that appends n rows to the file. The rows are buffered
+ * and written by groups. Returns 0, or -1 if writing failed.
+ */
+extern int qe_col_writer_append(qe_col_writer *w, const double *a,
+                                const double *b, const double *c, size_t n);
+
+/*
+ * A function that writes the last group and the header, closes the
+ * file and frees the writer. The result columns are left zero (they
+ * take no disk space until solved). Returns 0, or -1 if one of the
+ * writes failed.
+ */
+extern int qe_col_writer_close(qe_col_writer *w);
+
+/* A file mapped for reading or solving. */
+typedef struct qe_col_file qe_col_file;
+
+/*
+ * A function that maps the file at path, for reading and writing if
+ * writable is not zero. Returns NULL if the file could not be mapped
+ * or is not a correct columnar file (errno is set).
+ */
+extern qe_col_file *qe_col_open(const char *path, int writable);
+
+/* A function that returns the header of the file. */
+extern const qe_col_header *qe_col_get_header(const qe_col_file *f);
+
+/* A function that returns the number of groups of the file. */
+extern size_t qe_col_groups(const qe_col_file *f);
+
+/*
+ * A function that returns the columns of the group g and asks the
+ * kernel to read the next group ahead. Returns 0, or -1 if there is
+ * no such group.
+ */
+extern int qe_col_get_group(const qe_col_file *f, size_t g,
+                            qe_col_chunk *chunk);
+
+/*
+ * A function that drops the pages of the group g from the mapping
+ * after it was processed. The written results stay in the page cache
+ * and reach the file as usual; the memory of the process stays
+ * bounded by a few groups whatever the size of the file.
+ */
+extern void qe_col_release_group(const qe_col_file *f, size_t g);
+
+/*
+ * A function that solves all the rows of a file opened for writing
+ * and writes the results into its result columns, group by group.
+ * The groups are solved by solve_equation_batch_parallel on the pool,
+ * or by solve_equation_batch_prec if pool is NULL; the header gets
+ * QE_COL_SOLVED and the precision mode.
+ *
+ * Returns 0, or -1 if the file is read-only or has no result columns.
+ */
+extern int qe_col_solve(qe_col_file *f, qe_pool *pool, int prec);
+
+/* A function that unmaps and closes the file. */
+extern void qe_col_close(qe_col_file *f);
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef QE_OUT_H
+#define QE_OUT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * A writer of results to a file descriptor. The rows (res1, res2,
+ * msg_id) are formatted into QE_OUT_BUFFERS buffers of QE_OUT_BUFFER
+ * bytes each; when all of them are full, they are written by one
+ * writev call, so a large output takes one system call per
+ * QE_OUT_BUFFERS * QE_OUT_BUFFER bytes and the buffers are reused.
+ *
+ * In the QE_OUT_TEXT format a row is the line "res1,res2,msg_id"
+ * with the roots written by qe_format_double (the shortest numbers
+ * that read back exactly). In the QE_OUT_BINARY format a row is
+ * QE_OUT_ROW bytes: res1 and res2 as little-endian IEEE doubles and
+ * msg_id as a little-endian int32, without separators.
+ */
+#define QE_OUT_TEXT 0
+#define QE_OUT_BINARY 1
+
+#define QE_OUT_BUFFER (1 << 20)
+#define QE_OUT_BUFFERS 4
+
+/* The size of a row of the QE_OUT_BINARY format. */
+#define QE_OUT_ROW 20
+
+typedef struct qe_out qe_out;
+
+/*
+ * A function that creates a writer to the descriptor fd in the
+ * format QE_OUT_TEXT or QE_OUT_BINARY. The descriptor is not closed
+ * by the writer. Returns NULL if there is no memory or the format is
+ * wrong.
+ */
+extern qe_out *qe_out_create(int fd, int format);
+
+/*
+ * A function that writes n rows of results. Returns 0, or -1 if
+ * writing failed (errno is set); after a failure the writer writes
+ * nothing more.
+ */
+extern int qe_out_rows(qe_out *out, const double *res1, const double *res2,
+                       const int *msg_id, size_t n);
+
+/*
+ * A function that writes len bytes as they are (a header or other
+ * lines of the text format). Returns 0, or -1 if writing failed.
+ */
+extern int qe_out_write(qe_out *out, const void *data, size_t len);
+
+/*
+ * A function that writes all the buffered bytes. Returns 0, or -1 if
+ * writing failed.
+ */
+extern int qe_out_flush(qe_out *out);
+
+/*
+ * A function that flushes the writer and frees it. Returns 0, or -1
+ * if one of the writes failed.
+ */
+extern int qe_out_close(qe_out *out);
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef QE_POOL_H
+#define QE_POOL_H
+
+#include "quadratic_equation.h"
+#include <stddef.h>
+
+/*
+ * The number of equations in one chunk of the parallel batch
+ * function. The parameters and the results of a chunk take
+ * 176 KB, so a chunk fits in the L2 cache of a core.
+ */
+#define QE_POOL_CHUNK 4096
+
+/*
+ * A pool of worker threads. The threads are created once and
+ * wait for jobs, a job is split into chunks that the threads take
+ * from their own range and then steal from the ranges of others.
+ */
+typedef struct qe_pool qe_pool;
+
+/*
+ * The type of the function that processes the chunk with the
+ * given number. ctx is the pointer passed to qe_pool_run.
+ */
+typedef void (*qe_pool_task)(void *ctx, size_t chunk);
+
+/*
+ * A function that creates a pool of nthreads threads (if nthreads
+ * is not positive, one thread per processor available to the
+ * process). If pin is not zero, the i-th thread is bound to the
+ * i-th available processor. Returns NULL if the threads could not
+ * be created.
+ */
+extern qe_pool *qe_pool_create(int nthreads, int pin);
+
+/*
+ * A function that stops the threads of the pool and frees it.
+ * It must not be called while a job is running.
+ */
+extern void qe_pool_destroy(qe_pool *pool);
+
+/* A function that returns the number of threads of the pool. */
+extern int qe_pool_size(const qe_pool *pool);
+
+/*
+ * A function that calls fn(ctx, i) for every chunk i from 0 to
+ * nchunks - 1 on the threads of the pool and returns when all of
+ * them are processed. Jobs from several threads are run one after
+ * another. A job of one chunk is run in the calling thread, and so
+ * is a job run by a task on a thread of the same pool (in order of
+ * the chunks, with the thread index of that thread): the pool is
+ * busy with the job of the task.
+ */
+extern void qe_pool_run(qe_pool *pool, size_t nchunks, qe_pool_task fn,
+                        void *ctx);
+
+/*
+ * A function that returns the number of the calling thread in the
+ * pool, from 0 to qe_pool_size(pool) - 1, or qe_pool_size(pool) if
+ * the thread does not belong to the pool (the caller of qe_pool_run
+ * runs a job of one chunk itself). A task may keep per-thread
+ * partial results in an array of qe_pool_size(pool) + 1 elements
+ * indexed by it, without locks.
+ */
+extern int qe_pool_thread_index(const qe_pool *pool);
+
+/*
+ * A parallel variant of the solve_equation_batch_prec function.
+ * The equations are split into chunks of QE_POOL_CHUNK and solved
+ * on the threads of the pool; the results are the same as the
+ * results of solve_equation_batch_prec. If pool is NULL, the
+ * default pool is used (one thread per available processor,
+ * created at the first call).
+ *
+ * Returns QE_BATCH_OK, or QE_ERR_NULLPTR if one of the arrays
+ * is NULL (in this case nothing is written).
+ */
+extern int solve_equation_batch_parallel(qe_pool *pool, const double *a,
+                                         const double *b, const double *c,
+                                         double *res1, double *res2,
+                                         int *msg_id, size_t n, int prec);
+
+#endif
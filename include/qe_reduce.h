@@ -0,0 +1,112 @@
+#ifndef QE_REDUCE_H
+#define QE_REDUCE_H
+
+#include "qe_pool.h"
+#include "quadratic_equation.h"
+#include <stddef.h>
+
+/*
+ * The reducers of the fused batch functions: the equations are
+ * solved and only the aggregates of their results are kept, the
+ * roots are not written to arrays. The reducers are selected by the
+ * bits of the `what` field of qe_reduce.
+ */
+#define QE_REDUCE_COUNTS 1 /* The number of equations with every msg_id. */
+#define QE_REDUCE_MINMAX 2 /* The smallest and the largest root. */
+#define QE_REDUCE_SUM 4    /* The sum of the larger roots. */
+#define QE_REDUCE_HIST 8   /* The histogram of the roots. */
+
+/* The msg_id values from QE_ERR_NULLPTR to QE_OK_INF_RES. */
+#define QE_REDUCE_STATUSES 6
+
+/* The number of equations solved at once by the fused functions. */
+#define QE_REDUCE_TILE 512
+
+/*
+ * The aggregates of the solved equations. The roots are the ones
+ * written by solve_equation_batch_prec: both roots of an equation
+ * with QE_OK_TWO_RES, one root of an equation with QE_OK_ONE_RES,
+ * none for the other msg_id values. The larger root is the larger
+ * of the two (the only one for QE_OK_ONE_RES). A NaN root (written
+ * by the extended mode for an infinite a) is ignored by all the
+ * reducers but QE_REDUCE_MINMAX's count of the roots.
+ *
+ * The caller sets `what` and, for QE_REDUCE_HIST, the histogram:
+ * nbins bins of equal width on [hist_lo, hist_hi), counted in the
+ * array bins. A root x from the range falls into the bin
+ * (size_t)((x - hist_lo) * s), s = nbins / (hist_hi - hist_lo),
+ * or into the last one if rounding gives nbins. Then
+ * qe_reduce_reset clears the other fields (and the bins), and every
+ * call of the fused functions adds its equations to them, so a
+ * stream of batches may be reduced into one qe_reduce.
+ */
+typedef struct {
+  unsigned int what; /* QE_REDUCE_* bits. */
+
+  double hist_lo, hist_hi;   /* The range of the histogram. */
+  size_t nbins;              /* The number of bins, up to 2^32 - 1. */
+  unsigned long long *bins;  /* The counts of the bins. */
+  unsigned long long below;  /* The roots below hist_lo. */
+  unsigned long long above;  /* The roots from hist_hi up. */
+
+  unsigned long long counts[QE_REDUCE_STATUSES]; /* By msg_id + 2. */
+  unsigned long long nroots; /* The roots counted by QE_REDUCE_MINMAX. */
+  double min_root;           /* +inf if there are no roots. */
+  double max_root;           /* -inf if there are no roots. */
+
+  /*
+   * The sum of the larger roots, compensated (TwoSum): sum_larger
+   * is the sum rounded to a double, sum_err the rest of it. If the
+   * sum overflows, sum_larger is an infinity (or NaN if both signs
+   * overflow) and sum_err is meaningless.
+   */
+  double sum_larger;
+  double sum_err;
+} qe_reduce;
+
+/*
+ * A function that clears the aggregates of r and its bins; `what`
+ * and the range of the histogram are kept.
+ */
+extern void qe_reduce_reset(qe_reduce *r);
+
+/*
+ * A function that adds the aggregates of src to dst. The reducers
+ * of dst are merged; for QE_REDUCE_HIST both must have the same
+ * bins (their own arrays).
+ */
+extern void qe_reduce_merge(qe_reduce *dst, const qe_reduce *src);
+
+/*
+ * A function that solves n equations as solve_equation_batch_prec
+ * does and adds their results to the reducers of r. The roots are
+ * solved by tiles of QE_REDUCE_TILE equations into buffers on the
+ * stack, which stay in the L1 cache, and are reduced there: no
+ * memory proportional to n is written.
+ *
+ * Returns QE_BATCH_OK, or QE_ERR_NULLPTR if one of the pointers is
+ * NULL or QE_REDUCE_HIST is set without bins, with too many bins or
+ * with an empty range (nothing is added then).
+ */
+extern int solve_equation_batch_reduce(const double *a, const double *b,
+                                       const double *c, qe_reduce *r,
+                                       size_t n, int prec);
+
+/*
+ * A parallel variant of the solve_equation_batch_reduce function.
+ * The chunks of QE_POOL_CHUNK equations are reduced on the threads
+ * of the pool (the default pool if pool is NULL), every thread into
+ * its own partial qe_reduce, and the partial results are merged into
+ * r at the end. The aggregates are the same as the ones of
+ * solve_equation_batch_reduce, only the sum may differ in the last
+ * bits, since it is added in another order.
+ *
+ * Returns as solve_equation_batch_reduce.
+ */
+extern int solve_equation_batch_reduce_parallel(qe_pool *pool,
+                                                const double *a,
+                                                const double *b,
+                                                const double *c, qe_reduce *r,
+                                                size_t n, int prec);
+
+#endif
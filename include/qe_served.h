@@ -0,0 +1,110 @@
+#ifndef QE_SERVED_H
+#define QE_SERVED_H
+
+#include "quadratic_equation.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * The protocol of the qe_served daemon. A client sends frames over a
+ * Unix domain stream socket: a qe_served_header with the magic value
+ * QE_SERVED_MAGIC, the number of equations n and the precision mode,
+ * followed by n qe_served_eq records. For every frame the server
+ * replies with a header with the same magic and n, followed by n
+ * qe_served_res records. The replies come in the order of the frames,
+ * so a client may send several frames before reading the replies.
+ * The numbers are in the byte order of the host: the socket is local.
+ *
+ * A frame with a wrong magic value or with more than
+ * QE_SERVED_MAX_BATCH equations closes the connection.
+ */
+#define QE_SERVED_MAGIC 0x31534551u /* "QES1" */
+#define QE_SERVED_MAX_BATCH 65536
+
+/* The header of a frame and of a reply. */
+typedef struct {
+  uint32_t magic;    /* QE_SERVED_MAGIC. */
+  uint32_t n;        /* The number of records after the header. */
+  int32_t prec;      /* The precision mode (0 in a reply). */
+  uint32_t reserved; /* 0. */
+} qe_served_header;
+
+/* An equation of a frame. */
+typedef struct {
+  double a, b, c;
+} qe_served_eq;
+
+/* The result of an equation in a reply. */
+typedef struct {
+  double res1, res2;
+  int32_t msg_id;
+  int32_t reserved;
+} qe_served_res;
+
+/*
+ * The return value of the client functions if the connection to the
+ * server failed or the server broke the protocol.
+ */
+#define QE_SERVED_ERR_IO -3
+
+/*
+ * A server that solves the frames of its clients. It runs an epoll
+ * event loop in one thread; the equations of all the frames that
+ * arrived in one round of the loop are solved together, by the batch
+ * kernels, so small frames of many clients make large batches.
+ */
+typedef struct qe_server qe_server;
+
+/*
+ * A function that creates a server listening on the Unix domain
+ * socket path. A socket file that nobody listens on is replaced;
+ * if another server listens on it, it is left and the creation
+ * fails with errno EADDRINUSE; any other file is left and the
+ * creation fails. Returns NULL if the socket could not be created.
+ */
+extern qe_server *qe_server_create(const char *path);
+
+/*
+ * A function that runs the event loop of the server until
+ * qe_server_stop is called. Returns 0, or -1 if epoll failed.
+ */
+extern int qe_server_run(qe_server *srv);
+
+/*
+ * A function that makes qe_server_run return. It may be called from
+ * another thread or from a signal handler.
+ */
+extern void qe_server_stop(qe_server *srv);
+
+/*
+ * A function that closes the connections and the socket of the
+ * server, removes the socket file it created and frees the server.
+ */
+extern void qe_server_destroy(qe_server *srv);
+
+/* A connection of a client to the server. */
+typedef struct qe_client qe_client;
+
+/*
+ * A function that connects to the server at the socket path.
+ * Returns NULL if the connection failed.
+ */
+extern qe_client *qe_client_connect(const char *path);
+
+/*
+ * A function that solves the equations on the server, as
+ * solve_equation_batch_prec does. More than QE_SERVED_MAX_BATCH
+ * equations are sent in several frames.
+ *
+ * Returns QE_BATCH_OK, QE_ERR_NULLPTR if one of the pointers is
+ * NULL or QE_SERVED_ERR_IO if the connection failed (the client
+ * must be closed then).
+ */
+extern int qe_client_solve(qe_client *cl, const double *a, const double *b,
+                           const double *c, double *res1, double *res2,
+                           int *msg_id, size_t n, int prec);
+
+/* A function that closes the connection and frees the client. */
+extern void qe_client_close(qe_client *cl);
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef QE_SHM_H
+#define QE_SHM_H
+
+#include "qe_pool.h"
+#include "quadratic_equation.h"
+#include <stddef.h>
+
+/*
+ * A shared-memory channel between a producer process and a solver
+ * process (Linux). The region is a memfd with a header and the
+ * arrays a, b, c, res1, res2 and msg_id of capacity equations; both
+ * processes map it, so the solver runs the batch kernels on the
+ * arrays written by the producer and writes the results next to
+ * them, without copying. A batch is passed by two futexes in the
+ * header: the producer rings the doorbell, the solver answers when
+ * the results are written.
+ *
+ * The region is created by the producer; its descriptor is passed
+ * to the solver process by fork, by SCM_RIGHTS over a Unix socket or
+ * as /proc/<pid>/fd/<fd>, and mapped there by qe_shm_open. The size
+ * of the memfd is sealed, so neither side can cut the mapping of the
+ * other. One channel serves one producer and one solver.
+ */
+typedef struct qe_shm qe_shm;
+
+/*
+ * The number of times a waiting side checks the futex before it
+ * goes to sleep in the kernel. While it spins, the other side does
+ * not need a system call to wake it up. On a single processor the
+ * sides do not spin.
+ */
+#define QE_SHM_SPIN 4096
+
+/*
+ * The return value of qe_shm_submit and qe_shm_wait if the batch is
+ * larger than the capacity of the region.
+ */
+#define QE_SHM_ERR_SIZE -4
+
+/*
+ * The return value of qe_shm_submit if qe_shm_shutdown has been
+ * called on the region.
+ */
+#define QE_SHM_ERR_SHUTDOWN -5
+
+/* The arrays of the region, as mapped in this process. */
+typedef struct {
+  double *a, *b, *c;   /* The parameters, written by the producer. */
+  double *res1, *res2; /* The roots, written by the solver. */
+  int *msg_id;         /* The results of solving. */
+  size_t capacity;     /* The length of every array. */
+} qe_shm_arrays;
+
+/*
+ * A function that creates a region for capacity equations. Returns
+ * NULL if the memfd could not be created or mapped.
+ */
+extern qe_shm *qe_shm_create(size_t capacity);
+
+/*
+ * A function that maps the region of the descriptor fd created by
+ * qe_shm_create in another process (on success fd is owned by the
+ * channel). Returns NULL if fd is not such a region.
+ */
+extern qe_shm *qe_shm_open(int fd);
+
+/* A function that returns the descriptor of the region. */
+extern int qe_shm_fd(const qe_shm *shm);
+
+/* A function that returns the arrays of the region. */
+extern const qe_shm_arrays *qe_shm_get_arrays(const qe_shm *shm);
+
+/*
+ * A function of the producer that passes the first n equations of
+ * the arrays to the solver in the given precision mode. The arrays
+ * must not be touched until qe_shm_wait returns.
+ *
+ * Returns QE_BATCH_OK, QE_ERR_NULLPTR if shm is NULL,
+ * QE_SHM_ERR_SIZE if n is larger than the capacity or
+ * QE_SHM_ERR_SHUTDOWN after qe_shm_shutdown.
+ */
+extern int qe_shm_submit(qe_shm *shm, size_t n, int prec);
+
+/*
+ * A function of the producer that waits until the solver has
+ * written the results of the submitted batch.
+ *
+ * Returns the result of the batch function of the solver,
+ * QE_ERR_NULLPTR if shm is NULL or QE_SHM_ERR_SIZE if the solver
+ * rejected the batch.
+ */
+extern int qe_shm_wait(qe_shm *shm);
+
+/*
+ * A function of the solver that solves the submitted batches until
+ * the producer calls qe_shm_shutdown. The batches are solved by
+ * solve_equation_batch_parallel on the pool, or by
+ * solve_equation_batch_prec in the calling thread if pool is NULL.
+ *
+ * Returns 0, or QE_ERR_NULLPTR if shm is NULL.
+ */
+extern int qe_shm_serve(qe_shm *shm, qe_pool *pool);
+
+/*
+ * A function of the producer that makes qe_shm_serve return. A
+ * batch submitted before it is still solved, so qe_shm_wait may be
+ * called after the shutdown and returns the results of that batch.
+ */
+extern void qe_shm_shutdown(qe_shm *shm);
+
+/*
+ * A function that unmaps the region and closes its descriptor in
+ * this process. The memory is freed when both sides have closed it.
+ */
+extern void qe_shm_close(qe_shm *shm);
+
+#endif
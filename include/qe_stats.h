@@ -0,0 +1,84 @@
+#ifndef QE_STATS_H
+#define QE_STATS_H
+
+#include "quadratic_equation.h"
+
+/*
+ * Statistics of the calls of the solvers. They are collected only if
+ * the library is built with the QE_STATS option (cmake -DQE_STATS=ON),
+ * otherwise the solvers contain no code for them and the snapshot is
+ * all zeros.
+ *
+ * The calls of solve_equation and of solve_equation_prec in both
+ * precision modes are counted, including the calls made by the other
+ * functions of the library (solve_equation_complex, the misses of
+ * qe_cache, the special cases of the sweeps). The batch kernels are
+ * counted only for the lanes they pass to these solvers.
+ *
+ * Every thread writes its own counters, without locked instructions;
+ * a snapshot adds up the counters of all the threads.
+ */
+
+/*
+ * The branches of the solvers: the special cases of solve_equation
+ * (the parameters that are zero), the sign of the discriminant, and
+ * in the QE_PREC_DOUBLE mode the parameters that need scaling or are
+ * not finite.
+ */
+#define QE_STATS_BR_ALL_ZERO 0   /* a = b = c = 0, infinite roots. */
+#define QE_STATS_BR_ONLY_C 1     /* a = b = 0, no roots. */
+#define QE_STATS_BR_ONLY_B 2     /* a = c = 0, the root 0. */
+#define QE_STATS_BR_ONLY_A 3     /* b = c = 0, the root 0. */
+#define QE_STATS_BR_LINEAR 4     /* a = 0, the root -c / b. */
+#define QE_STATS_BR_DISC_POS 5   /* Two roots. */
+#define QE_STATS_BR_DISC_ZERO 6  /* One root. */
+#define QE_STATS_BR_DISC_NEG 7   /* No real roots. */
+#define QE_STATS_BR_SCALED 8     /* Huge or tiny parameters. */
+#define QE_STATS_BR_NOT_FINITE 9 /* Infinite or NaN parameters. */
+#define QE_STATS_BRANCHES 10
+
+/*
+ * The number of the msg_id values, from QE_ERR_NULLPTR to
+ * QE_OK_CPLX_RES. The counter of a msg_id is
+ * status[msg_id - QE_ERR_NULLPTR].
+ */
+#define QE_STATS_STATUSES (QE_OK_CPLX_RES - QE_ERR_NULLPTR + 1)
+
+/*
+ * The latency histogram. The time of every QE_STATS_SAMPLE_PERIOD-th
+ * call of a thread is measured in cycles of the time stamp counter
+ * (rdtsc, x86 only), and the sample is counted in the bucket i such
+ * that 2^(i - 1) <= cycles < 2^i.
+ */
+#define QE_STATS_BUCKETS 32
+#define QE_STATS_SAMPLE_PERIOD 64
+
+/* A snapshot of the statistics. */
+typedef struct {
+  int enabled;                                /* Built with QE_STATS. */
+  unsigned long long calls;                   /* Calls of the solvers. */
+  unsigned long long status[QE_STATS_STATUSES]; /* Calls by msg_id. */
+  unsigned long long branch[QE_STATS_BRANCHES]; /* Calls by branch. */
+  unsigned long long latency[QE_STATS_BUCKETS]; /* Samples by cycles. */
+  unsigned long long samples; /* The number of the measured calls. */
+  unsigned long long cycles;  /* Their total time in cycles. */
+} qe_stats;
+
+/* A function that returns 1 if the statistics are collected. */
+extern int qe_stats_enabled(void);
+
+/*
+ * A function that writes the sums of the counters of all the threads
+ * to *stats. It may be called while other threads solve equations,
+ * then the counters of a call may be partly included.
+ */
+extern void qe_stats_snapshot(qe_stats *stats);
+
+/*
+ * A function that sets all the counters to zero. It must be called
+ * when no thread solves equations, otherwise some counters may keep
+ * their values.
+ */
+extern void qe_stats_reset(void);
+
+#endif
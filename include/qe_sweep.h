@@ -0,0 +1,65 @@
+#ifndef QE_SWEEP_H
+#define QE_SWEEP_H
+
+#include "quadratic_equation.h"
+#include <stddef.h>
+
+/*
+ * Sweeps: the equations a * x^2 + b * x + c = 0 where only one
+ * parameter changes from equation to equation, and the batches of
+ * equations with a shared `a`. The terms that do not depend on the
+ * changing parameters (the checks of `a` and `b`, 4 * a, b * b and
+ * the reciprocal of 2 * a) are computed once for the whole batch,
+ * and the roots are multiplied by the reciprocal instead of being
+ * divided by 2 * a.
+ *
+ * The msg_id is the same as in solve_equation_prec in the given
+ * precision mode. With the x86 kernels the roots of the
+ * QE_PREC_EXTENDED mode are bit-identical to the ones of
+ * solve_equation_batch_prec; otherwise (and in the QE_PREC_DOUBLE
+ * mode if `a` is not a power of two) they differ from them by at
+ * most one unit in the last place. Equations with a zero, infinite
+ * or NaN parameter (and in the QE_PREC_DOUBLE mode with a huge or
+ * tiny one) are solved by solve_equation_prec itself.
+ *
+ * The functions return QE_BATCH_OK, or QE_ERR_NULLPTR if a pointer
+ * is NULL (when n is not zero).
+ */
+
+/*
+ * A function that solves the equations with the parameters a, b[i],
+ * c[i], for example the same polynomial scaled by different factors.
+ */
+extern int solve_equation_batch_fixed_a(double a, const double *b,
+                                        const double *c, double *res1,
+                                        double *res2, int *msg_id, size_t n,
+                                        int prec);
+
+/*
+ * A function that solves the monic equations x^2 + b[i] * x + c[i] = 0.
+ * As for every `a` that is a power of two, the roots are bit-identical
+ * to the ones of solve_equation_batch_prec in both precision modes.
+ */
+extern int solve_equation_batch_monic(const double *b, const double *c,
+                                      double *res1, double *res2, int *msg_id,
+                                      size_t n, int prec);
+
+/* A function that solves the equations with the parameters a, b, c[i]. */
+extern int solve_equation_sweep_c(double a, double b, const double *c,
+                                  double *res1, double *res2, int *msg_id,
+                                  size_t n, int prec);
+
+/*
+ * A function that solves the equations with the parameters a, b and
+ * c0 + i * dc (computed in double), for example a grid of values of c.
+ */
+extern int solve_equation_sweep_c_range(double a, double b, double c0,
+                                        double dc, double *res1, double *res2,
+                                        int *msg_id, size_t n, int prec);
+
+/* A function that solves the equations with the parameters a, b[i], c. */
+extern int solve_equation_sweep_b(double a, const double *b, double c,
+                                  double *res1, double *res2, int *msg_id,
+                                  size_t n, int prec);
+
+#endif
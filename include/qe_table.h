@@ -0,0 +1,103 @@
+#ifndef QE_TABLE_H
+#define QE_TABLE_H
+
+#include "qe_pool.h"
+#include "quadratic_equation.h"
+#include <stddef.h>
+
+/*
+ * A table of equations that keeps their parameters and results
+ * between calls, in a separate array for every field. The setters
+ * mark the changed equations in a bitmap of dirty entries, and
+ * qe_table_refresh solves only these ones again, so a table where a
+ * few equations change between the refreshes costs time in
+ * proportion to the changes, plus a scan of one word per block of
+ * QE_TABLE_BLOCK equations.
+ *
+ * The setters and the refresh must not be called by several threads
+ * at once; the parallel refresh uses the threads of a pool itself.
+ */
+typedef struct qe_table qe_table;
+
+/*
+ * The equations of a block: a word of the summary bitmap marks the
+ * 64 dirty words of the block, 64 equations each.
+ */
+#define QE_TABLE_BLOCK (64 * 64)
+
+/*
+ * A function that creates a table of n equations solved in the
+ * given precision mode. All the parameters are zero and all the
+ * equations are dirty, so the first refresh solves the whole table.
+ * Returns NULL if n is zero or the memory could not be allocated.
+ */
+extern qe_table *qe_table_create(size_t n, int prec);
+
+/* A function that frees the table. */
+extern void qe_table_destroy(qe_table *table);
+
+/* A function that returns the number of equations of the table. */
+extern size_t qe_table_size(const qe_table *table);
+
+/* A function that returns the number of dirty equations. */
+extern size_t qe_table_dirty(const qe_table *table);
+
+/*
+ * A function that sets the parameters of the i-th equation. The
+ * equation becomes dirty only if the bits of a parameter change.
+ *
+ * Returns QE_BATCH_OK, or QE_ERR_NULLPTR if table is NULL or i is
+ * out of the table (nothing is changed then).
+ */
+extern int qe_table_set(qe_table *table, size_t i, double a, double b,
+                        double c);
+
+/*
+ * A function that sets the parameters of the m equations from the
+ * first one, as m calls of qe_table_set would do.
+ *
+ * Returns QE_BATCH_OK, or QE_ERR_NULLPTR if one of the pointers is
+ * NULL or the equations are out of the table (nothing is changed).
+ */
+extern int qe_table_set_range(qe_table *table, size_t first, const double *a,
+                              const double *b, const double *c, size_t m);
+
+/*
+ * A function that returns the msg_id of the i-th equation and writes
+ * its roots to *res1 and *res2, as solved by the last refresh (the
+ * changes since then are not seen). Before the first refresh, or if
+ * table or a pointer is NULL or i is out of the table, it returns
+ * QE_ERR_NULLPTR (and writes nothing in the last cases).
+ */
+extern int qe_table_get(const qe_table *table, size_t i, double *res1,
+                        double *res2);
+
+/*
+ * A function that writes the pointers to the arrays of the results
+ * (qe_table_size elements each) to *res1, *res2 and *msg_id. The
+ * arrays are valid until the table is destroyed and are written only
+ * by the refresh. A NULL pointer is skipped.
+ */
+extern void qe_table_results(const qe_table *table, const double **res1,
+                             const double **res2, const int **msg_id);
+
+/*
+ * A function that solves the dirty equations of the table again and
+ * makes them clean. Runs of dirty equations are solved in place by
+ * the batch kernels, scattered ones are gathered by tiles, solved
+ * and scattered back; the results are the ones of
+ * solve_equation_batch_prec. Returns the number of the dirty
+ * equations (0 if table is NULL).
+ */
+extern size_t qe_table_refresh(qe_table *table);
+
+/*
+ * A parallel variant of the qe_table_refresh function: the blocks
+ * of QE_TABLE_BLOCK equations with dirty ones are refreshed on the
+ * threads of the pool (the default pool if pool is NULL). With at most
+ * QE_POOL_CHUNK dirty equations, or if the default pool could not
+ * be created, the table is refreshed in the calling thread.
+ */
+extern size_t qe_table_refresh_parallel(qe_table *table, qe_pool *pool);
+
+#endif
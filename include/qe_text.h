@@ -0,0 +1,40 @@
+#ifndef QE_TEXT_H
+#define QE_TEXT_H
+
+/*
+ * The maximum length of a number that qe_parse_double accepts.
+ * Longer tokens are considered malformed.
+ */
+#define QE_TEXT_MAX_NUMBER 127
+
+/*
+ * A function that parses a decimal number (an optional sign, digits
+ * with an optional point, an optional exponent) from the text
+ * [p, end), which does not have to end with a zero byte. The result
+ * is the double nearest to the number, as with strtod, and is written
+ * to *x. "inf", "nan" and hexadecimal numbers are also accepted.
+ *
+ * Returns the pointer to the first character after the number,
+ * or NULL if there is no number at p.
+ */
+extern const char *qe_parse_double(const char *p, const char *end, double *x);
+
+/*
+ * The maximum length of a number written by qe_format_double
+ * ("-2.2250738585072014e-308" and the like).
+ */
+#define QE_TEXT_MAX_FORMAT 32
+
+/*
+ * A function that writes the double x to out as the shortest
+ * decimal number that reads back (by strtod or qe_parse_double)
+ * as exactly x; of the shortest ones, the closest to x. The number
+ * is laid out as by printf("%.17g"): "0.1", "-2", "1e+100",
+ * "1.5e-07", also "-0", "inf", "-inf", "nan" and "-nan".
+ *
+ * The text does not end with a zero byte, out must have room for
+ * QE_TEXT_MAX_FORMAT characters. Returns the length of the text.
+ */
+extern int qe_format_double(double x, char *out);
+
+#endif
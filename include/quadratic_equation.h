@@ -1,6 +1,15 @@
 #ifndef QUADRATIC_EQUATION_H
 #define QUADRATIC_EQUATION_H
 
+#include <stddef.h>
+
+/*
+ * The return value of the solve_equation_complex function if the
+ * discriminant is negative. Two complex conjugate roots have been
+ * found. The other functions return QE_OK_NO_RES in this case.
+ */
+#define QE_OK_CPLX_RES 4
+
 /*
  * The return value if the solve_equation function works without
  * errors. The infinity of roots is found.
@@ -61,6 +70,165 @@
 extern int solve_equation(double a, double b, double c, double *res1,
                           double *res2);
 
+/*
+ * A branch-free variant of the solve_equation function. All the
+ * cases are computed, and the msg_id and the roots are selected by
+ * masks at the end, so the time of a call does not depend on the mix
+ * of degenerate and complete equations. The results are identical
+ * to the results of solve_equation.
+ */
+extern int solve_equation_branchless(double a, double b, double c,
+                                     double *res1, double *res2);
+
+/*
+ * The result of the solve_equation_inline function: the msg_id and
+ * the roots, as solve_equation returns and writes them.
+ */
+typedef struct {
+  int msg_id;  /* The value returned by solve_equation. */
+  double res1; /* The value written to *res1. */
+  double res2; /* The value written to *res2. */
+} qe_result;
+
+#if defined(QE_INLINE)
+#include <float.h>
+#include <math.h>
+
+/*
+ * A variant of the solve_equation function that is compiled into the
+ * caller. It is defined if QE_INLINE is defined before this file is
+ * included, and it needs only the math library.
+ *
+ * The calculations are the ones of solve_equation, in the same order
+ * and in long double, so the results are bit-identical. The result is
+ * returned by value, so there are no pointers to check and the roots
+ * may stay in registers. The calls are not counted by qe_stats.
+ */
+static inline qe_result solve_equation_inline(double a, double b, double c) {
+  qe_result r = {QE_OK_NO_RES, QE_STD_VAL_RES, QE_STD_VAL_RES};
+  long double discriminant, _a = a, _b = b, _c = c, _res1, _res2;
+
+  /* The infinity of roots if `c` is zero too, otherwise no roots. */
+  if ((a == 0) && (b == 0)) {
+    if (c == 0)
+      r.msg_id = QE_OK_INF_RES;
+    return r;
+  }
+
+  /* If only `a` or only `b` is not zero, the root is 0. */
+  if ((c == 0) && ((a == 0) || (b == 0))) {
+    r.msg_id = QE_OK_ONE_RES;
+    r.res1 = r.res2 = 0;
+    return r;
+  }
+
+  /* The linear equation. */
+  if (a == 0) {
+    _res1 = -_c / _b;
+    if ((_res1 > DBL_MAX) || (_res1 < -DBL_MAX)) {
+      r.msg_id = QE_ERR_OVERFLOW;
+    } else {
+      r.msg_id = QE_OK_ONE_RES;
+      r.res1 = r.res2 = _res1;
+    }
+    return r;
+  }
+
+  discriminant = _b * _b - 4.0 * _a * _c;
+
+  if (discriminant > 0) {
+    _res1 = (-_b + sqrt(discriminant)) / (2.0 * _a);
+    _res2 = (-_b - sqrt(discriminant)) / (2.0 * _a);
+    if ((_res1 > DBL_MAX) || (_res1 < -DBL_MAX) || (_res2 > DBL_MAX) ||
+        (_res2 < -DBL_MAX)) {
+      r.msg_id = QE_ERR_OVERFLOW;
+    } else {
+      r.msg_id = QE_OK_TWO_RES;
+      r.res1 = _res1;
+      r.res2 = _res2;
+    }
+  } else if (discriminant == 0) {
+    _res1 = (-_b) / (2.0 * _a);
+    if ((_res1 > DBL_MAX) || (_res1 < -DBL_MAX)) {
+      r.msg_id = QE_ERR_OVERFLOW;
+    } else {
+      r.msg_id = QE_OK_ONE_RES;
+      r.res1 = r.res2 = _res1;
+    }
+  }
+
+  return r;
+}
+#endif
+
+/*
+ * Identifiers of the precision modes.
+ *
+ * QE_PREC_EXTENDED is the behaviour of solve_equation: the
+ * calculations are performed in long double (x87 on x86-64).
+ *
+ * QE_PREC_DOUBLE uses only double. The discriminant is computed with
+ * the rounding errors of the products (Kahan's method with a fused
+ * multiply-add), and the roots by the formula without cancellation,
+ * so they are usually more accurate than in QE_PREC_EXTENDED. Huge
+ * and tiny parameters are scaled by powers of two, and QE_ERR_OVERFLOW
+ * is returned only if a root itself is outside the double range or a
+ * parameter is infinite or NaN. The roots may differ from the roots
+ * of solve_equation in the last bits.
+ */
+#define QE_PREC_EXTENDED 0
+#define QE_PREC_DOUBLE 1
+
+/*
+ * A function that solves a quadratic equation in the given precision
+ * mode (any value other than QE_PREC_DOUBLE means QE_PREC_EXTENDED).
+ * In the QE_PREC_EXTENDED mode the msg_id and the roots are the
+ * same as in solve_equation. In the QE_PREC_DOUBLE mode the roots
+ * may differ in the last bits, and the msg_id differs where
+ * solve_equation overflows on huge or tiny parameters or a
+ * parameter is not finite (see above).
+ */
+extern int solve_equation_prec(double a, double b, double c, double *res1,
+                               double *res2, int prec);
+
+/*
+ * A function that solves a quadratic equation on the complex plane.
+ * If the discriminant is negative, it returns QE_OK_CPLX_RES, writes
+ * the real part of the roots to both res1 and res2 and the imaginary
+ * part (positive) to im: the roots are res1 + i * im and
+ * res2 - i * im. Otherwise the msg_id and the roots are the same as
+ * in solve_equation_prec, and 0 is written to im.
+ *
+ * The complex roots are computed in double precision in both modes
+ * (the discriminant by Kahan's method, huge and tiny parameters are
+ * scaled), QE_ERR_OVERFLOW is returned if a part of them is outside
+ * the double range.
+ */
+extern int solve_equation_complex(double a, double b, double c, double *res1,
+                                  double *res2, double *im, int prec);
+
+/*
+ * A function that returns the msg_id of the equation without its
+ * roots: the sign of the discriminant is found as in
+ * solve_equation_prec, but no square root and no division is
+ * computed. The result is the msg_id of solve_equation_prec, except
+ * that the roots are not checked for the overflow: if they are
+ * outside the double range, QE_OK_TWO_RES or QE_OK_ONE_RES is
+ * returned instead of QE_ERR_OVERFLOW. In QE_PREC_DOUBLE mode
+ * QE_ERR_OVERFLOW is still returned for infinite and NaN parameters.
+ */
+extern int classify_equation(double a, double b, double c, int prec);
+
+/*
+ * A function that returns 1 if the equation has a root in [lo, hi]
+ * and 0 otherwise: solve_equation_prec returns QE_OK_TWO_RES or
+ * QE_OK_ONE_RES and res1 or res2 lies in [lo, hi], or it returns
+ * QE_OK_INF_RES (every number is a root). The ends may be infinite;
+ * if lo > hi or one of them is NaN, the interval is empty.
+ */
+extern int equation_has_root_in(double a, double b, double c, double lo,
+                                double hi, int prec);
+
 /*
  * A function that allows you to get a pointer to a string
  * with a description of msg_id (the values are described above).
@@ -68,4 +236,240 @@ extern int solve_equation(double a, double b, double c, double *res1,
  */
 extern char *get_solve_equation_msg(int msg_id);
 
+/*
+ * The return value of the batch functions if all the equations
+ * have been processed. The result of each equation is written
+ * to its own msg_id element.
+ */
+#define QE_BATCH_OK 0
+
+/*
+ * Identifiers of the instruction sets that the batch functions
+ * can use. The best one supported by the processor is selected
+ * at runtime (CPUID), QE_ISA_GENERIC is portable C code.
+ */
+#define QE_ISA_GENERIC 0
+#define QE_ISA_SSE2 1
+#define QE_ISA_AVX2 2
+#define QE_ISA_AVX512 3
+
+/*
+ * A function that solves n quadratic equations stored as a structure
+ * of arrays: the i-th equation is a[i] * x^2 + b[i] * x + c[i] = 0.
+ * Its roots are written to res1[i] and res2[i], and its msg_id to
+ * msg_id[i]. The results are bit-identical to the results of
+ * solve_equation for the same parameters.
+ *
+ * Returns QE_BATCH_OK, or QE_ERR_NULLPTR if one of the pointers
+ * is NULL (in this case nothing is written).
+ */
+extern int solve_equation_batch(const double *a, const double *b,
+                                const double *c, double *res1, double *res2,
+                                int *msg_id, size_t n);
+
+/*
+ * A variant of the solve_equation_batch function with the given
+ * precision mode. In QE_PREC_DOUBLE mode the results are
+ * bit-identical to the results of solve_equation_prec.
+ */
+extern int solve_equation_batch_prec(const double *a, const double *b,
+                                     const double *c, double *res1,
+                                     double *res2, int *msg_id, size_t n,
+                                     int prec);
+
+/*
+ * A batch variant of the solve_equation_complex function. The
+ * imaginary parts are written to im[i] by the same kernels, without
+ * a separate pass over the equations. The results are bit-identical
+ * to the results of solve_equation_complex.
+ *
+ * Returns QE_BATCH_OK, or QE_ERR_NULLPTR if one of the pointers
+ * is NULL (in this case nothing is written).
+ */
+extern int solve_equation_batch_complex(const double *a, const double *b,
+                                        const double *c, double *res1,
+                                        double *res2, double *im, int *msg_id,
+                                        size_t n, int prec);
+
+/*
+ * The packed format of the results of a batch. The msg_id of the
+ * i-th equation takes 4 bits: the low half of the byte status[i / 2]
+ * for even i and the high half for odd i. QE_PACKED_STATUS returns
+ * it as a msg_id.
+ */
+#define QE_PACKED_STATUS(status, i)                                            \
+  ((int)(((status)[(i) >> 1] >> (((i)&1) * 4)) & 0xF) + QE_ERR_NULLPTR)
+
+/*
+ * The number of bytes of the packed msg_id of n equations.
+ */
+#define QE_PACKED_SIZE(n) (((n) + 1) / 2)
+
+/*
+ * A variant of the solve_equation_batch_prec function that writes the
+ * results in the packed format. The msg_id values are written to
+ * status (QE_PACKED_SIZE(n) bytes), and only the roots that exist are
+ * written to roots, one after another: two for QE_OK_TWO_RES, one for
+ * QE_OK_ONE_RES, none for the other msg_id values. The number of the
+ * written roots is stored to *nroots. The roots array must have room
+ * for 2 * n roots, the elements after the written ones may change.
+ *
+ * Returns QE_BATCH_OK, or QE_ERR_NULLPTR if one of the pointers
+ * is NULL (in this case nothing is written).
+ */
+extern int solve_equation_batch_packed(const double *a, const double *b,
+                                       const double *c, double *roots,
+                                       size_t *nroots, unsigned char *status,
+                                       size_t n, int prec);
+
+/*
+ * A variant of the solve_equation_batch_prec function that writes the
+ * roots over the parameters: the first root of the i-th equation to
+ * a[i] and the second one to b[i]. The msg_id values are written to
+ * status in the packed format (QE_PACKED_SIZE(n) bytes).
+ *
+ * Returns QE_BATCH_OK, or QE_ERR_NULLPTR if one of the pointers
+ * is NULL (in this case nothing is written).
+ */
+extern int solve_equation_batch_inplace(double *a, double *b, const double *c,
+                                        unsigned char *status, size_t n,
+                                        int prec);
+
+/*
+ * A variant of the solve_equation_batch_prec function that polishes
+ * the roots of the ill-conditioned equations. In QE_PREC_EXTENDED
+ * mode solve_equation loses digits if the discriminant is close to 0
+ * (close roots) or if b * b >> |4 * a * c| (the smaller root is
+ * found with cancellation). The roots of such equations with two
+ * roots are corrected in the vector registers: the larger root by a
+ * Newton-like step with an accurate residual, the smaller one by
+ * Vieta's formula, so they are within a few units in the last place
+ * of the exact roots. If a parameter lies out of [2^-150, 2^150],
+ * the residuals could overflow, so such an equation gets the roots
+ * of QE_PREC_DOUBLE instead (it scales the equation), which are as
+ * accurate. The other results and every msg_id are the same as in
+ * solve_equation_batch_prec. The roots of QE_PREC_DOUBLE are already
+ * that accurate, so in this mode nothing is polished. res1 and res2
+ * must not point to the same memory as a, b and c.
+ *
+ * Returns QE_BATCH_OK, or QE_ERR_NULLPTR if one of the pointers
+ * is NULL (in this case nothing is written).
+ */
+extern int solve_equation_batch_polish(const double *a, const double *b,
+                                       const double *c, double *res1,
+                                       double *res2, int *msg_id, size_t n,
+                                       int prec);
+
+/*
+ * A variant of the solve_equation_batch_prec function for parameters
+ * and roots in single precision (float). The equations are solved in
+ * float, with twice as many lanes in a vector register, and every
+ * lane gets an estimate of the error of its roots from the rounding
+ * errors of the discriminant. The lanes whose estimate exceeds tol,
+ * the lanes where the sign of the discriminant is not certain and
+ * the lanes with a zero, non-finite or out-of-range parameter (the
+ * magnitude outside [2^-50, 2^50]) are gathered and solved again in
+ * double by solve_equation_batch_prec.
+ *
+ * Every msg_id is the one of solve_equation_prec for the same
+ * parameters in the precision mode prec. The relative error of every
+ * root is at most the greater of tol and 2^-24 (half a unit in the
+ * last place of a float): the lanes solved again get the roots of
+ * QE_PREC_DOUBLE rounded to float in both modes, since the roots of
+ * solve_equation lose digits to cancellation; only where the two
+ * modes give different msg_id, the roots of solve_equation are
+ * kept. A tol below about 2^-21 sends all the equations with two
+ * roots to the double solver. A root out of the range of normal
+ * floats (it overflows, or it is not zero but would be rounded to a
+ * subnormal float or to zero) gives QE_ERR_OVERFLOW. If nescalated
+ * is not NULL, the number of the equations solved again is written
+ * to it. res1 and res2 must not point to the same memory as a, b
+ * and c.
+ *
+ * Returns QE_BATCH_OK, or QE_ERR_NULLPTR if one of the arrays is
+ * NULL (in this case nothing is written).
+ */
+extern int solve_equation_batch_float(const float *a, const float *b,
+                                      const float *c, float *res1,
+                                      float *res2, int *msg_id, size_t n,
+                                      float tol, int prec,
+                                      size_t *nescalated);
+
+/*
+ * A batch variant of the classify_equation function: the msg_id of
+ * the i-th equation is written to msg_id[i]. The vector kernels need
+ * neither square roots nor divisions, so the equations are classified
+ * several times faster than solved.
+ *
+ * Returns QE_BATCH_OK, or QE_ERR_NULLPTR if one of the pointers
+ * is NULL (in this case nothing is written).
+ */
+extern int classify_equation_batch(const double *a, const double *b,
+                                   const double *c, int *msg_id, size_t n,
+                                   int prec);
+
+/*
+ * The bit of the msg_id in the classes of classify_equation_select,
+ * for example QE_CLASS(QE_OK_TWO_RES) | QE_CLASS(QE_OK_ONE_RES) for
+ * the equations with real roots. The bits start at QE_ERR_NULLPTR,
+ * as the values of QE_PACKED_STATUS.
+ */
+#define QE_CLASS(msg_id) (1u << ((msg_id)-QE_ERR_NULLPTR))
+
+/*
+ * A function that classifies n equations like classify_equation_batch
+ * and writes the indices of the equations whose msg_id is in classes
+ * to idx, in ascending order; their number is stored to *count. The
+ * idx array must have room for n indices, the elements after the
+ * written ones may change. The indices are compacted in the vector
+ * registers, without a branch per equation.
+ *
+ * Returns QE_BATCH_OK, or QE_ERR_NULLPTR if one of the pointers
+ * is NULL (in this case nothing is written).
+ */
+extern int classify_equation_select(const double *a, const double *b,
+                                    const double *c, unsigned int classes,
+                                    size_t *idx, size_t *count, size_t n,
+                                    int prec);
+
+/*
+ * A function that writes the indices of the equations for which
+ * equation_has_root_in is true to idx, in ascending order, and
+ * stores their number to *count. The idx array must have room for n
+ * indices, as in classify_equation_select.
+ *
+ * The roots are not computed: the vector kernels compare the signs
+ * of the polynomial at lo and hi and the position of its vertex, and
+ * solve only the equations whose roots are too close to an end (or
+ * to each other) for the signs to be certain. The result is the same
+ * as that of solving every equation and testing the roots.
+ *
+ * Returns QE_BATCH_OK, or QE_ERR_NULLPTR if one of the pointers
+ * is NULL (in this case nothing is written).
+ */
+extern int select_equation_roots_in(const double *a, const double *b,
+                                    const double *c, double lo, double hi,
+                                    size_t *idx, size_t *count, size_t n,
+                                    int prec);
+
+/*
+ * A function that returns the identifier of the instruction set
+ * used by the batch functions.
+ */
+extern int qe_batch_get_isa(void);
+
+/*
+ * A function that forces the batch functions to use the given
+ * instruction set. If the processor does not support it, the best
+ * supported one below it is selected. Returns the selected identifier.
+ * It is used in tests and benchmarks.
+ */
+extern int qe_batch_set_isa(int isa);
+
+/*
+ * A function that returns the name of the instruction set
+ * with the given identifier.
+ */
+extern const char *qe_batch_isa_name(int isa);
+
 #endif
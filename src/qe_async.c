@@ -0,0 +1,396 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the asynchronous
+ * queue of equations (qe_async).
+ *
+ * The requests live in one array allocated at the creation of
+ * the queue, and the rings hold their indices. A ring is a
+ * bounded lock-free queue of cells with sequence numbers
+ * (D. Vyukov's algorithm): a producer takes a position with an
+ * atomic compare-and-swap and publishes the cell by its sequence
+ * number, so the producers do not wait for each other. Every
+ * ring is as long as the array of requests, so it is never full.
+ *
+ * The free requests are in the free ring. Every solver thread has
+ * its own ring of submitted requests, with many producers and one
+ * consumer, the thread itself. The thread takes up to
+ * QE_ASYNC_BATCH requests at once, solves them by
+ * solve_equation_batch_prec and passes them to the callbacks or
+ * to the completion ring. A thread with an empty ring spins for a
+ * while and then sleeps on a condition variable; a submission
+ * takes the mutex only if the thread sleeps.
+ *
+-------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include "qe_async.h"
+#include "quadratic_equation.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* A cell of a ring: the index of a request and its sequence number. */
+typedef struct {
+  size_t seq;
+  size_t idx;
+} qe_cell;
+
+/*
+ * A ring of indices. The positions of the producers (tail) and of
+ * the consumers (head) are in different cache lines.
+ */
+typedef struct {
+  size_t head;
+  char pad_head[64 - sizeof(size_t)];
+  size_t tail;
+  char pad_tail[64 - sizeof(size_t)];
+  qe_cell *cells;
+  size_t mask;
+} qe_ring;
+
+/* A solver thread with its ring of submitted requests. */
+typedef struct {
+  qe_ring ring;
+  qe_async *q;
+  pthread_t thread;
+
+  /* Sleeping of the thread, the flags are changed under lock. */
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  int sleeping;
+  int stop;
+  char pad[64];
+} qe_solver;
+
+struct qe_async {
+  qe_request *reqs;
+  size_t size;
+  int prec;
+  int nsolvers; /* The number of the solvers allocated. */
+  int nthreads; /* The number of the threads created. */
+  qe_solver *solvers;
+  qe_solver **route; /* The solver of every request. */
+  qe_ring free_ring; /* The requests that can be acquired. */
+  qe_ring done_ring; /* The solved requests without a callback. */
+};
+
+/* The function tells the processor that the thread spins. */
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#endif
+}
+
+/*
+ * The function allocates the cells of a ring of size indices
+ * (a power of two). Returns 0 if there is no memory.
+ */
+static int ring_init(qe_ring *r, size_t size) {
+  r->head = r->tail = 0;
+  r->mask = size - 1;
+  r->cells = malloc(size * sizeof(qe_cell));
+  if (r->cells == NULL)
+    return 0;
+
+  for (size_t i = 0; i < size; i++)
+    r->cells[i].seq = i;
+  return 1;
+}
+
+/*
+ * The function puts the index into the ring. The ring holds at most
+ * all the requests, so a cell is always free, maybe after a consumer
+ * finishes taking it. order is the memory order of the publication
+ * of the cell.
+ */
+static void ring_push(qe_ring *r, size_t idx, int order) {
+  size_t pos = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+  qe_cell *cell;
+
+  for (;;) {
+    cell = &r->cells[pos & r->mask];
+    if (__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) == pos) {
+      if (__atomic_compare_exchange_n(&r->tail, &pos, pos + 1, 1,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        break;
+    } else
+      pos = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+  }
+
+  cell->idx = idx;
+  __atomic_store_n(&cell->seq, pos + 1, order);
+}
+
+/*
+ * The function takes an index from the ring with many consumers.
+ * Returns 0 if the ring is empty.
+ */
+static int ring_pop(qe_ring *r, size_t *idx) {
+  size_t pos = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+  qe_cell *cell;
+
+  for (;;) {
+    intptr_t diff;
+
+    cell = &r->cells[pos & r->mask];
+    diff = (intptr_t)__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) -
+           (intptr_t)(pos + 1);
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&r->head, &pos, pos + 1, 1,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        break;
+    } else if (diff < 0)
+      return 0;
+    else
+      pos = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+  }
+
+  *idx = cell->idx;
+  __atomic_store_n(&cell->seq, pos + r->mask + 1, __ATOMIC_RELEASE);
+  return 1;
+}
+
+/*
+ * The same for the ring with one consumer: the head is changed by
+ * it alone, so no compare-and-swap is needed.
+ */
+static int ring_pop_single(qe_ring *r, size_t *idx) {
+  size_t pos = r->head;
+  qe_cell *cell = &r->cells[pos & r->mask];
+
+  if (__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) != pos + 1)
+    return 0;
+
+  *idx = cell->idx;
+  __atomic_store_n(&cell->seq, pos + r->mask + 1, __ATOMIC_RELEASE);
+  r->head = pos + 1;
+  return 1;
+}
+
+/*
+ * The function checks whether the ring with one consumer has an
+ * index. It is called by the consumer.
+ */
+static int ring_ready(qe_ring *r) {
+  const qe_cell *cell = &r->cells[r->head & r->mask];
+
+  return __atomic_load_n(&cell->seq, __ATOMIC_SEQ_CST) == r->head + 1;
+}
+
+/*
+ * The function solves the requests with the given indices and
+ * passes them to the callbacks or to the completion ring.
+ */
+static void solve_requests(qe_async *q, const size_t *idx, size_t n) {
+  double a[QE_ASYNC_BATCH], b[QE_ASYNC_BATCH], c[QE_ASYNC_BATCH];
+  double res1[QE_ASYNC_BATCH], res2[QE_ASYNC_BATCH];
+  int msg_id[QE_ASYNC_BATCH];
+
+  for (size_t i = 0; i < n; i++) {
+    const qe_request *req = &q->reqs[idx[i]];
+
+    a[i] = req->a;
+    b[i] = req->b;
+    c[i] = req->c;
+  }
+
+  solve_equation_batch_prec(a, b, c, res1, res2, msg_id, n, q->prec);
+
+  for (size_t i = 0; i < n; i++) {
+    qe_request *req = &q->reqs[idx[i]];
+
+    req->res1 = res1[i];
+    req->res2 = res2[i];
+    req->msg_id = msg_id[i];
+
+    if (req->done != NULL) {
+      req->done(req);
+      ring_push(&q->free_ring, idx[i], __ATOMIC_RELEASE);
+    } else
+      ring_push(&q->done_ring, idx[i], __ATOMIC_RELEASE);
+  }
+}
+
+/*
+ * The function of a solver thread. Before it sleeps, it sets the
+ * flag and checks the ring once more: a request submitted after
+ * the check sees the flag and wakes the thread up.
+ */
+static void *solver_main(void *arg) {
+  qe_solver *s = arg;
+  size_t idx[QE_ASYNC_BATCH];
+  int spins = 0;
+
+  for (;;) {
+    size_t n = 0;
+
+    while ((n < QE_ASYNC_BATCH) && ring_pop_single(&s->ring, &idx[n]))
+      n++;
+
+    if (n > 0) {
+      solve_requests(s->q, idx, n);
+      spins = 0;
+      continue;
+    }
+
+    /* The requests submitted before the stop are solved first. */
+    if (__atomic_load_n(&s->stop, __ATOMIC_ACQUIRE)) {
+      if (!ring_ready(&s->ring))
+        return NULL;
+      continue;
+    }
+
+    if (++spins < QE_ASYNC_SPIN) {
+      cpu_relax();
+      continue;
+    }
+
+    spins = 0;
+    __atomic_store_n(&s->sleeping, 1, __ATOMIC_SEQ_CST);
+    if (ring_ready(&s->ring)) {
+      __atomic_store_n(&s->sleeping, 0, __ATOMIC_RELAXED);
+      continue;
+    }
+
+    pthread_mutex_lock(&s->lock);
+    while (s->sleeping && !s->stop)
+      pthread_cond_wait(&s->wake, &s->lock);
+    pthread_mutex_unlock(&s->lock);
+  }
+}
+
+/*
+ * The function creates the queue: the requests, the rings and the
+ * solver threads.
+ */
+qe_async *qe_async_create(int nthreads, size_t nrequests, int prec) {
+  qe_async *q;
+  void *solvers;
+  size_t size = 1;
+  int ok;
+
+  if (nthreads <= 0)
+    nthreads = 1;
+  while (size < nrequests)
+    size *= 2;
+
+  q = calloc(1, sizeof(*q));
+  if (q == NULL)
+    return NULL;
+
+  q->size = size;
+  q->prec = prec;
+  q->reqs = calloc(size, sizeof(qe_request));
+  q->route = malloc(size * sizeof(qe_solver *));
+  ok = (q->reqs != NULL) && (q->route != NULL) &&
+       (posix_memalign(&solvers, 64, nthreads * sizeof(qe_solver)) == 0);
+  if (ok) {
+    q->solvers = memset(solvers, 0, nthreads * sizeof(qe_solver));
+    q->nsolvers = nthreads;
+    ok = ring_init(&q->free_ring, size) & ring_init(&q->done_ring, size);
+    for (int i = 0; i < nthreads; i++)
+      ok &= ring_init(&q->solvers[i].ring, size);
+  }
+
+  /*
+   * The free ring gives the requests in turn, so the requests of
+   * consecutive submissions go to different threads.
+   */
+  if (ok)
+    for (size_t i = 0; i < size; i++) {
+      q->route[i] = &q->solvers[i % (size_t)nthreads];
+      ring_push(&q->free_ring, i, __ATOMIC_RELEASE);
+    }
+
+  /* The threads that were created are stopped by qe_async_destroy. */
+  for (int i = 0; ok && (i < nthreads); i++) {
+    qe_solver *s = &q->solvers[i];
+
+    s->q = q;
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->wake, NULL);
+
+    if (pthread_create(&s->thread, NULL, solver_main, s) != 0) {
+      pthread_mutex_destroy(&s->lock);
+      pthread_cond_destroy(&s->wake);
+      ok = 0;
+    } else
+      q->nthreads = i + 1;
+  }
+
+  if (!ok) {
+    qe_async_destroy(q);
+    return NULL;
+  }
+  return q;
+}
+
+/* The function stops the solver threads and frees the queue. */
+void qe_async_destroy(qe_async *q) {
+
+  if (q == NULL)
+    return;
+
+  for (int i = 0; i < q->nthreads; i++) {
+    qe_solver *s = &q->solvers[i];
+
+    pthread_mutex_lock(&s->lock);
+    __atomic_store_n(&s->stop, 1, __ATOMIC_RELEASE);
+    pthread_cond_signal(&s->wake);
+    pthread_mutex_unlock(&s->lock);
+
+    pthread_join(s->thread, NULL);
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->wake);
+  }
+
+  /* The rings of the threads that were not created are freed too. */
+  for (int i = 0; i < q->nsolvers; i++)
+    free(q->solvers[i].ring.cells);
+  free(q->solvers);
+
+  free(q->free_ring.cells);
+  free(q->done_ring.cells);
+  free(q->route);
+  free(q->reqs);
+  free(q);
+}
+
+/* The function takes a free request from the pool. */
+qe_request *qe_async_acquire(qe_async *q) {
+  size_t idx;
+
+  return ring_pop(&q->free_ring, &idx) ? &q->reqs[idx] : NULL;
+}
+
+/* The function returns the request to the pool. */
+void qe_async_release(qe_async *q, qe_request *req) {
+  ring_push(&q->free_ring, (size_t)(req - q->reqs), __ATOMIC_RELEASE);
+}
+
+/* The function puts the request into the ring of its solver thread. */
+void qe_async_submit(qe_async *q, qe_request *req) {
+  size_t idx = (size_t)(req - q->reqs);
+  qe_solver *s = q->route[idx];
+
+  /*
+   * The cell is published before the flag is read, both in the
+   * sequentially consistent order (see solver_main).
+   */
+  ring_push(&s->ring, idx, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&s->sleeping, __ATOMIC_SEQ_CST)) {
+    pthread_mutex_lock(&s->lock);
+    __atomic_store_n(&s->sleeping, 0, __ATOMIC_RELAXED);
+    pthread_cond_signal(&s->wake);
+    pthread_mutex_unlock(&s->lock);
+  }
+}
+
+/* The function takes a solved request from the completion ring. */
+qe_request *qe_async_poll(qe_async *q) {
+  size_t idx;
+
+  return ring_pop(&q->done_ring, &idx) ? &q->reqs[idx] : NULL;
+}
@@ -0,0 +1,758 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the
+ * solve_equation_batch, solve_equation_batch_prec and
+ * solve_equation_batch_complex functions, and of the
+ * functions with the packed results (solve_equation_batch_packed,
+ * solve_equation_batch_inplace), of solve_equation_batch_polish and
+ * of the classification of the equations (classify_equation_batch,
+ * classify_equation_select) and of the root range queries
+ * (equation_has_root_in, select_equation_roots_in).
+ *
+ * The functions solve arrays of quadratic equations with
+ * the kernel for the best instruction set supported by the
+ * processor. The kernel is selected once, at the first call
+ * (the CPUID instruction is used on x86).
+ *
+ * In addition, the file contains the generic kernels (and the
+ * generic polishing, classification and range queries) and
+ * the functions to select the instruction set (qe_batch_get_isa,
+ * qe_batch_set_isa, qe_batch_isa_name).
+ *
+-------------------------------------------------------------*/
+
+#include "qe_internal.h"
+#include "quadratic_equation.h"
+#include <float.h>
+
+/*
+ * The number of equations solved at once by the functions with
+ * the packed results. Their results are written to arrays on the
+ * stack, which stay in the cache, and then packed. It is even, so
+ * the msg_id of a block starts at the start of a byte. The blocks
+ * of solve_equation_batch_polish are polished while in the cache.
+ */
+#define QE_PACK_BLOCK 512
+
+/*
+ * The generic kernel. Without vector instructions the double
+ * precision kernel is slower than solve_equation itself, so
+ * the equations are solved one by one.
+ */
+void qe_batch_kernel_generic(const double *a, const double *b,
+                             const double *c, double *res1, double *res2,
+                             double *im, int *msg_id, size_t n) {
+
+  if (im != NULL)
+    for (size_t i = 0; i < n; i++)
+      msg_id[i] = qe_solve_complex(a[i], b[i], c[i], &res1[i], &res2[i],
+                                   &im[i], QE_PREC_EXTENDED);
+  else
+    for (size_t i = 0; i < n; i++)
+      msg_id[i] = solve_equation(a[i], b[i], c[i], &res1[i], &res2[i]);
+}
+
+/* The generic kernel of the QE_PREC_DOUBLE mode. */
+void qe_batch_kernel_generic_double(const double *a, const double *b,
+                                    const double *c, double *res1,
+                                    double *res2, double *im, int *msg_id,
+                                    size_t n) {
+
+  if (im != NULL)
+    for (size_t i = 0; i < n; i++)
+      msg_id[i] = qe_solve_complex(a[i], b[i], c[i], &res1[i], &res2[i],
+                                   &im[i], QE_PREC_DOUBLE);
+  else
+    for (size_t i = 0; i < n; i++)
+      msg_id[i] = qe_solve_double(a[i], b[i], c[i], &res1[i], &res2[i]);
+}
+
+/*
+ * The generic float kernel: the template of the vector kernels
+ * with one lane, so the equations are filtered by the same bound
+ * and only the uncertain ones are solved again. A mask is 0 or 1.
+ */
+typedef float qe_vf;
+typedef unsigned int qe_vfm;
+
+#define QE_FLOAT_KERNEL qe_float_kernel_generic
+#define QE_FW 1
+#define F_SET1(x) ((float)(x))
+#define F_LOADU(p) (*(p))
+#define F_STOREU(p, v) (*(p) = (v))
+#define F_STORE_MSG(p, v) (*(p) = (int)(v))
+#define F_ADD(x, y) ((x) + (y))
+#define F_SUB(x, y) ((x) - (y))
+#define F_MUL(x, y) ((x) * (y))
+#define F_DIV(x, y) ((x) / (y))
+#define F_SQRT(x) sqrtf(x)
+#define F_ABS(x) fabsf(x)
+#define F_CMPLT(x, y) ((qe_vfm)((x) < (y)))
+#define F_CMPLE(x, y) ((qe_vfm)((x) <= (y)))
+#define FM_AND(x, y) ((x) & (y))
+#define FM_OR(x, y) ((x) | (y))
+#define FM_BITS(m) (m)
+#define F_SEL(m, t, f) ((m) ? (t) : (f))
+
+#include "qe_kernel_float.h"
+
+/* The function checks that |x| lies from QE_POLISH_MIN to QE_POLISH_MAX. */
+static int polish_in_range(double x) {
+  return (fabs(x) >= QE_POLISH_MIN) && (fabs(x) <= QE_POLISH_MAX);
+}
+
+/*
+ * The function returns a * x^2 + b * x + c computed by the
+ * compensated Horner's scheme: the rounding errors of the products
+ * (qe_two_prod) and of the sums (TwoSum) are added at the end, so
+ * the residual is as accurate as in twice the precision.
+ */
+static double polish_residual(double a, double b, double c, double x) {
+  double p, pe, s, se, t, err;
+
+  qe_two_prod(a, x, &p, &pe);
+  s = p + b;
+  t = s - p;
+  se = (p - (s - t)) + (b - t);
+  err = pe + se;
+
+  qe_two_prod(s, x, &p, &pe);
+  s = p + c;
+  t = s - p;
+  se = (p - (s - t)) + (c - t);
+  err = err * x + (pe + se);
+
+  return s + err;
+}
+
+/*
+ * The function returns the root x corrected by one step. f and
+ * fp = 2 * a * x + b are the residual and the derivative at x,
+ * s is the root of the discriminant with the sign of the root:
+ * + for res1, - for res2.
+ *
+ * The correction e satisfies the equation a * e^2 + fp * e + f = 0
+ * (Newton's step -f / fp is its linearization), and its
+ * discriminant fp^2 - 4 * a * f is the discriminant of the equation
+ * itself. It is solved by the formula without cancellation, so
+ * the step does not jump to the other root and does not slow down
+ * near a double root as Newton's method does.
+ */
+static double polish_step(double a2, double x, double f, double fp,
+                          double s) {
+  int near = (s * fp <= 0);
+
+  return x + (near ? s - fp : -2.0 * f) / (near ? a2 : fp + s);
+}
+
+/*
+ * The function polishes the roots of the equation. The root larger
+ * in absolute value is corrected by QE_POLISH_STEPS steps (a step
+ * that gives an infinity or NaN is not taken), and the other
+ * one is found from it by Vieta's formula x1 * x2 = c / a: the
+ * relative error of the quotient is the error of the polished root
+ * and one or two roundings, whatever the sizes of the roots are.
+ */
+static void polish_pair(double a, double b, double c, double *x1,
+                        double *x2) {
+  int first = (fabs(*x2) <= fabs(*x1));
+  double x = first ? *x1 : *x2, sign = first ? 1.0 : -1.0, a2 = 2.0 * a, y;
+
+  for (int k = 0; k < QE_POLISH_STEPS; k++) {
+    double f, p, pe, fp, d, s;
+
+    f = polish_residual(a, b, c, x);
+    qe_two_prod(a2, x, &p, &pe);
+    fp = (p + b) + pe;
+    d = fp * fp - 4.0 * a * f;
+    s = sign * sqrt((d < 0) ? 0.0 : d);
+
+    y = polish_step(a2, x, f, fp, s);
+    if (fabs(y) <= DBL_MAX)
+      x = y;
+  }
+
+  y = c / (a * x);
+  *x1 = first ? x : y;
+  *x2 = first ? y : x;
+}
+
+/*
+ * Implementation of the qe_polish_scaled function. The products of
+ * doubles neither overflow nor underflow in long double, and the
+ * roots of QE_PREC_DOUBLE are within a few units in the last place.
+ */
+void qe_polish_scaled(double a, double b, double c, double *res1,
+                      double *res2) {
+  long double p = (long double)b * b, q = 4.0L * a * c;
+  double r1, r2;
+
+  if ((fabsl(p - q) > QE_POLISH_NEAR * p) && (fabsl(q) > QE_POLISH_FAR * p))
+    return;
+
+  if (qe_solve_double(a, b, c, &r1, &r2) == QE_OK_TWO_RES) {
+    *res1 = r1;
+    *res2 = r2;
+  }
+}
+
+/*
+ * The generic polishing kernel. The vector kernels (qe_polish.h)
+ * repeat its operations in the same order.
+ */
+void qe_polish_generic(const double *a, const double *b, const double *c,
+                       double *res1, double *res2, const int *msg_id,
+                       size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    double p = b[i] * b[i], q = 4.0 * a[i] * c[i];
+
+    if (msg_id[i] != QE_OK_TWO_RES)
+      continue;
+
+    if (!polish_in_range(a[i]) || !polish_in_range(b[i]) ||
+        !polish_in_range(c[i])) {
+      qe_polish_scaled(a[i], b[i], c[i], &res1[i], &res2[i]);
+      continue;
+    }
+
+    if ((fabs(p - q) > QE_POLISH_NEAR * p) && (fabs(q) > QE_POLISH_FAR * p))
+      continue;
+
+    polish_pair(a[i], b[i], c[i], &res1[i], &res2[i]);
+  }
+}
+
+/*
+ * The generic classification kernel. The indices are written
+ * without branches: every index is written to the next place, which
+ * is kept only if the equation is selected.
+ */
+size_t qe_count_generic(const double *a, const double *b, const double *c,
+                        int *msg_id, unsigned int classes, size_t *idx,
+                        size_t n, int prec) {
+  size_t k = 0;
+
+  for (size_t i = 0; i < n; i++) {
+    int m = classify_equation(a[i], b[i], c[i], prec);
+
+    if (msg_id != NULL)
+      msg_id[i] = m;
+    if (idx != NULL) {
+      idx[k] = i;
+      k += ((classes & QE_CLASS(m)) != 0);
+    }
+  }
+
+  return k;
+}
+
+/*
+ * Implementation of the equation_has_root_in function: the roots of
+ * solve_equation_prec are compared with the ends.
+ */
+int equation_has_root_in(double a, double b, double c, double lo, double hi,
+                         int prec) {
+  double res1, res2;
+  int msg_id = solve_equation_prec(a, b, c, &res1, &res2, prec);
+
+  if (!(lo <= hi))
+    return 0;
+  if (msg_id == QE_OK_INF_RES)
+    return 1;
+  if ((msg_id != QE_OK_TWO_RES) && (msg_id != QE_OK_ONE_RES))
+    return 0;
+
+  return ((lo <= res1) && (res1 <= hi)) || ((lo <= res2) && (res2 <= hi));
+}
+
+/* The generic range query kernel, written as qe_count_generic. */
+size_t qe_count_in_generic(const double *a, const double *b, const double *c,
+                           double lo, double hi, size_t *idx, size_t n,
+                           int prec) {
+  size_t k = 0;
+
+  for (size_t i = 0; i < n; i++) {
+    idx[k] = i;
+    k += (size_t)(equation_has_root_in(a[i], b[i], c[i], lo, hi, prec) != 0);
+  }
+
+  return k;
+}
+
+/*
+ * Kernels indexed by the identifier of the instruction set. Without
+ * the x86 kernels every identifier falls back to the generic one.
+ */
+static const qe_batch_kernel qe_kernels[] = {
+#if defined(QE_HAVE_X86_KERNELS)
+    qe_batch_kernel_generic, qe_batch_kernel_sse2, qe_batch_kernel_avx2,
+    qe_batch_kernel_avx512
+#else
+    qe_batch_kernel_generic, qe_batch_kernel_generic, qe_batch_kernel_generic,
+    qe_batch_kernel_generic
+#endif
+};
+
+/* The same for the QE_PREC_DOUBLE mode. */
+static const qe_batch_kernel qe_kernels_double[] = {
+#if defined(QE_HAVE_X86_KERNELS)
+    qe_batch_kernel_generic_double, qe_batch_kernel_sse2_double,
+    qe_batch_kernel_avx2_double, qe_batch_kernel_avx512_double
+#else
+    qe_batch_kernel_generic_double, qe_batch_kernel_generic_double,
+    qe_batch_kernel_generic_double, qe_batch_kernel_generic_double
+#endif
+};
+
+/* The polishing kernels, indexed in the same way. */
+static const qe_polish_kernel qe_polishers[] = {
+#if defined(QE_HAVE_X86_KERNELS)
+    qe_polish_generic, qe_polish_sse2, qe_polish_avx2, qe_polish_avx512
+#else
+    qe_polish_generic, qe_polish_generic, qe_polish_generic, qe_polish_generic
+#endif
+};
+
+/* The classification kernels, indexed in the same way. */
+static const qe_count_kernel qe_counters[] = {
+#if defined(QE_HAVE_X86_KERNELS)
+    qe_count_generic, qe_count_sse2, qe_count_avx2, qe_count_avx512
+#else
+    qe_count_generic, qe_count_generic, qe_count_generic, qe_count_generic
+#endif
+};
+
+/* The range query kernels, indexed in the same way. */
+static const qe_count_in_kernel qe_counters_in[] = {
+#if defined(QE_HAVE_X86_KERNELS)
+    qe_count_in_generic, qe_count_in_sse2, qe_count_in_avx2,
+    qe_count_in_avx512
+#else
+    qe_count_in_generic, qe_count_in_generic, qe_count_in_generic,
+    qe_count_in_generic
+#endif
+};
+
+/* The float kernels, indexed in the same way. */
+static const qe_float_kernel qe_float_kernels[] = {
+#if defined(QE_HAVE_X86_KERNELS)
+    qe_float_kernel_generic, qe_float_kernel_sse2, qe_float_kernel_avx2,
+    qe_float_kernel_avx512
+#else
+    qe_float_kernel_generic, qe_float_kernel_generic, qe_float_kernel_generic,
+    qe_float_kernel_generic
+#endif
+};
+
+/* The selected instruction set, -1 until the first call. */
+static int qe_isa = -1;
+
+/*
+ * The function checks whether the processor
+ * supports the instruction set.
+ */
+static int qe_isa_supported(int isa) {
+#if defined(QE_HAVE_X86_KERNELS)
+  __builtin_cpu_init();
+
+  switch (isa) {
+  case QE_ISA_GENERIC:
+    return 1;
+  case QE_ISA_SSE2:
+    return __builtin_cpu_supports("sse2");
+  case QE_ISA_AVX2:
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  case QE_ISA_AVX512:
+    return __builtin_cpu_supports("avx512f");
+  default:
+    return 0;
+  }
+#else
+  return isa == QE_ISA_GENERIC;
+#endif
+}
+
+/*
+ * The function forces the batch functions to use the given
+ * instruction set or the best supported one below it.
+ */
+int qe_batch_set_isa(int isa) {
+
+  if (isa > QE_ISA_AVX512)
+    isa = QE_ISA_AVX512;
+
+  while ((isa > QE_ISA_GENERIC) && !qe_isa_supported(isa))
+    isa--;
+
+  if (isa < QE_ISA_GENERIC)
+    isa = QE_ISA_GENERIC;
+
+  __atomic_store_n(&qe_isa, isa, __ATOMIC_RELAXED);
+  return isa;
+}
+
+/*
+ * The function returns the identifier of the instruction set
+ * used by the batch functions. At the first call the best
+ * supported one is selected. The SSE2 kernel has no fused
+ * multiply-add and is slower than solve_equation, so it is
+ * used only if selected by qe_batch_set_isa.
+ */
+int qe_batch_get_isa(void) {
+  int isa = __atomic_load_n(&qe_isa, __ATOMIC_RELAXED);
+
+  if (isa < 0) {
+    isa = qe_batch_set_isa(QE_ISA_AVX512);
+    if (isa == QE_ISA_SSE2)
+      isa = qe_batch_set_isa(QE_ISA_GENERIC);
+  }
+
+  return isa;
+}
+
+/*
+ * The function returns the name of the instruction set
+ * with the given identifier.
+ */
+const char *qe_batch_isa_name(int isa) {
+  switch (isa) {
+
+  case QE_ISA_GENERIC:
+    return "generic";
+
+  case QE_ISA_SSE2:
+    return "sse2";
+
+  case QE_ISA_AVX2:
+    return "avx2";
+
+  case QE_ISA_AVX512:
+    return "avx512";
+
+  default:
+    return "unknown";
+  }
+}
+
+/*
+ * Implementation of the solve_equation_batch function that solves
+ * n quadratic equations. The results of the i-th equation are the
+ * same as the results of solve_equation(a[i], b[i], c[i], ...).
+ */
+int solve_equation_batch(const double *a, const double *b, const double *c,
+                         double *res1, double *res2, int *msg_id, size_t n) {
+
+  return solve_equation_batch_prec(a, b, c, res1, res2, msg_id, n,
+                                   QE_PREC_EXTENDED);
+}
+
+/*
+ * Implementation of the solve_equation_batch_prec function. The
+ * results of the i-th equation are the same as the results of
+ * solve_equation_prec(a[i], b[i], c[i], ..., prec).
+ */
+int solve_equation_batch_prec(const double *a, const double *b,
+                              const double *c, double *res1, double *res2,
+                              int *msg_id, size_t n, int prec) {
+
+  /* Checking pointers for a non-NULL value. */
+  if ((a == NULL) || (b == NULL) || (c == NULL) || (res1 == NULL) ||
+      (res2 == NULL) || (msg_id == NULL))
+    return QE_ERR_NULLPTR;
+
+  if (prec == QE_PREC_DOUBLE)
+    qe_kernels_double[qe_batch_get_isa()](a, b, c, res1, res2, NULL, msg_id,
+                                          n);
+  else
+    qe_kernels[qe_batch_get_isa()](a, b, c, res1, res2, NULL, msg_id, n);
+
+  return QE_BATCH_OK;
+}
+
+/*
+ * Implementation of the solve_equation_batch_complex function. The
+ * kernels write the imaginary parts together with the roots.
+ */
+int solve_equation_batch_complex(const double *a, const double *b,
+                                 const double *c, double *res1, double *res2,
+                                 double *im, int *msg_id, size_t n, int prec) {
+
+  /* Checking pointers for a non-NULL value. */
+  if ((a == NULL) || (b == NULL) || (c == NULL) || (res1 == NULL) ||
+      (res2 == NULL) || (im == NULL) || (msg_id == NULL))
+    return QE_ERR_NULLPTR;
+
+  if (prec == QE_PREC_DOUBLE)
+    qe_kernels_double[qe_batch_get_isa()](a, b, c, res1, res2, im, msg_id, n);
+  else
+    qe_kernels[qe_batch_get_isa()](a, b, c, res1, res2, im, msg_id, n);
+
+  return QE_BATCH_OK;
+}
+
+/* The number of the roots written for a msg_id, by msg_id - QE_ERR_NULLPTR. */
+static const unsigned char nroots_of[QE_OK_CPLX_RES - QE_ERR_NULLPTR + 1] = {
+    0, 0, 0, 1, 2, 0, 0};
+
+/*
+ * The function packs the msg_id values of n equations: two per byte,
+ * the first one in the low half.
+ */
+static void pack_status(const int *msg_id, unsigned char *status, size_t n) {
+  size_t i;
+
+  for (i = 0; i + 1 < n; i += 2)
+    status[i / 2] = (unsigned char)((msg_id[i] - QE_ERR_NULLPTR) |
+                                    ((msg_id[i + 1] - QE_ERR_NULLPTR) << 4));
+  if (i < n)
+    status[i / 2] = (unsigned char)(msg_id[i] - QE_ERR_NULLPTR);
+}
+
+/*
+ * Implementation of the solve_equation_batch_packed function. Every
+ * block is solved by the kernel to the arrays on the stack. Then
+ * both roots of every equation are written at the end of the roots
+ * array, and the end moves by the number of its roots, so the
+ * copying has no branches. A root after the written ones may be
+ * written, but not after 2 * n roots.
+ */
+int solve_equation_batch_packed(const double *a, const double *b,
+                                const double *c, double *roots,
+                                size_t *nroots, unsigned char *status,
+                                size_t n, int prec) {
+  qe_batch_kernel kernel;
+  double res1[QE_PACK_BLOCK], res2[QE_PACK_BLOCK];
+  int msg_id[QE_PACK_BLOCK];
+  size_t k = 0;
+
+  /* Checking pointers for a non-NULL value. */
+  if ((a == NULL) || (b == NULL) || (c == NULL) || (roots == NULL) ||
+      (nroots == NULL) || (status == NULL))
+    return QE_ERR_NULLPTR;
+
+  kernel = (prec == QE_PREC_DOUBLE) ? qe_kernels_double[qe_batch_get_isa()]
+                                    : qe_kernels[qe_batch_get_isa()];
+
+  for (size_t i = 0; i < n; i += QE_PACK_BLOCK) {
+    size_t m = (n - i < QE_PACK_BLOCK) ? n - i : QE_PACK_BLOCK;
+
+    kernel(a + i, b + i, c + i, res1, res2, NULL, msg_id, m);
+
+    pack_status(msg_id, status + i / 2, m);
+    for (size_t j = 0; j < m; j++) {
+      roots[k] = res1[j];
+      roots[k + 1] = res2[j];
+      k += nroots_of[msg_id[j] - QE_ERR_NULLPTR];
+    }
+  }
+
+  *nroots = k;
+  return QE_BATCH_OK;
+}
+
+/*
+ * Implementation of the solve_equation_batch_inplace function. The
+ * kernels read the parameters of a vector before they write its
+ * roots, so the roots are written over a and b directly.
+ */
+int solve_equation_batch_inplace(double *a, double *b, const double *c,
+                                 unsigned char *status, size_t n, int prec) {
+  qe_batch_kernel kernel;
+  int msg_id[QE_PACK_BLOCK];
+
+  /* Checking pointers for a non-NULL value. */
+  if ((a == NULL) || (b == NULL) || (c == NULL) || (status == NULL))
+    return QE_ERR_NULLPTR;
+
+  kernel = (prec == QE_PREC_DOUBLE) ? qe_kernels_double[qe_batch_get_isa()]
+                                    : qe_kernels[qe_batch_get_isa()];
+
+  for (size_t i = 0; i < n; i += QE_PACK_BLOCK) {
+    size_t m = (n - i < QE_PACK_BLOCK) ? n - i : QE_PACK_BLOCK;
+
+    kernel(a + i, b + i, c + i, a + i, b + i, NULL, msg_id, m);
+    pack_status(msg_id, status + i / 2, m);
+  }
+
+  return QE_BATCH_OK;
+}
+
+/*
+ * Implementation of the solve_equation_batch_polish function. Every
+ * block is solved by the kernel and polished while it is in the
+ * cache.
+ */
+int solve_equation_batch_polish(const double *a, const double *b,
+                                const double *c, double *res1, double *res2,
+                                int *msg_id, size_t n, int prec) {
+  qe_batch_kernel kernel;
+  qe_polish_kernel polish;
+
+  /* Checking pointers for a non-NULL value. */
+  if ((a == NULL) || (b == NULL) || (c == NULL) || (res1 == NULL) ||
+      (res2 == NULL) || (msg_id == NULL))
+    return QE_ERR_NULLPTR;
+
+  if (prec == QE_PREC_DOUBLE)
+    return solve_equation_batch_prec(a, b, c, res1, res2, msg_id, n, prec);
+
+  kernel = qe_kernels[qe_batch_get_isa()];
+  polish = qe_polishers[qe_batch_get_isa()];
+
+  for (size_t i = 0; i < n; i += QE_PACK_BLOCK) {
+    size_t m = (n - i < QE_PACK_BLOCK) ? n - i : QE_PACK_BLOCK;
+
+    kernel(a + i, b + i, c + i, res1 + i, res2 + i, NULL, msg_id + i, m);
+    polish(a + i, b + i, c + i, res1 + i, res2 + i, msg_id + i, m);
+  }
+
+  return QE_BATCH_OK;
+}
+
+/*
+ * The function solves again the m equations of the float batch with
+ * the indices idx: they are gathered into double arrays, solved by
+ * solve_equation_batch_prec and scattered back rounded to float. The
+ * products of float parameters are exact in double, so the roots of
+ * QE_PREC_DOUBLE are within the rounding to float. The textbook
+ * roots of QE_PREC_EXTENDED lose the smaller root to cancellation
+ * when b * b >> |4 * a * c|, so in this mode only msg_id is taken
+ * from it, and its roots are kept only where the two modes disagree
+ * on msg_id.
+ */
+static void solve_float_again(const float *a, const float *b,
+                              const float *c, float *res1, float *res2,
+                              int *msg_id, const size_t *idx, size_t m,
+                              int prec) {
+  double ta[QE_FLOAT_TILE], tb[QE_FLOAT_TILE], tc[QE_FLOAT_TILE];
+  double t1[QE_FLOAT_TILE], t2[QE_FLOAT_TILE];
+  int tm[QE_FLOAT_TILE];
+
+  for (size_t j = 0; j < m; j++) {
+    ta[j] = a[idx[j]];
+    tb[j] = b[idx[j]];
+    tc[j] = c[idx[j]];
+  }
+
+  solve_equation_batch_prec(ta, tb, tc, t1, t2, tm, m, QE_PREC_DOUBLE);
+
+  if (prec != QE_PREC_DOUBLE) {
+    double e1[QE_FLOAT_TILE], e2[QE_FLOAT_TILE];
+    int em[QE_FLOAT_TILE];
+
+    solve_equation_batch_prec(ta, tb, tc, e1, e2, em, m, QE_PREC_EXTENDED);
+    for (size_t j = 0; j < m; j++)
+      if (em[j] != tm[j]) {
+        t1[j] = e1[j];
+        t2[j] = e2[j];
+        tm[j] = em[j];
+      }
+  }
+
+  /*
+   * The kernels write QE_STD_VAL_RES to the roots of the equations
+   * without roots, so only a root out of the range of float needs a
+   * branch: it overflows, or it is not zero and would become a
+   * subnormal float or zero.
+   */
+  for (size_t j = 0; j < m; j++) {
+    size_t i = idx[j];
+    double x1 = fabs(t1[j]), x2 = fabs(t2[j]);
+
+    res1[i] = (float)t1[j];
+    res2[i] = (float)t2[j];
+    msg_id[i] = tm[j];
+    if ((x1 > FLT_MAX) | (x2 > FLT_MAX) | ((x1 < FLT_MIN) & (x1 != 0)) |
+        ((x2 < FLT_MIN) & (x2 != 0))) {
+      res1[i] = res2[i] = QE_STD_VAL_RES;
+      msg_id[i] = QE_ERR_OVERFLOW;
+    }
+  }
+}
+
+/*
+ * Implementation of the solve_equation_batch_float function. The
+ * tolerance becomes the factor k of the test of the float kernels
+ * (see qe_kernel_float.h): k = 0 sends every equation with two
+ * roots to the precision mode, and k is at most 0.5, so that the
+ * error of the discriminant stays below a half of it. The kernel
+ * gets QE_FLOAT_TILE equations at a time, so the equations it
+ * returns fit in one tile.
+ */
+int solve_equation_batch_float(const float *a, const float *b,
+                               const float *c, float *res1, float *res2,
+                               int *msg_id, size_t n, float tol, int prec,
+                               size_t *nescalated) {
+  float k = (tol - 4 * 0x1p-24f) / 0.65f;
+  size_t idx[QE_FLOAT_TILE], count = 0;
+  qe_float_kernel kernel;
+
+  /* Checking pointers for a non-NULL value. */
+  if ((a == NULL) || (b == NULL) || (c == NULL) || (res1 == NULL) ||
+      (res2 == NULL) || (msg_id == NULL))
+    return QE_ERR_NULLPTR;
+
+  if (!(k > 0))
+    k = 0;
+  else if (k > 0.5f)
+    k = 0.5f;
+
+  kernel = qe_float_kernels[qe_batch_get_isa()];
+  for (size_t i = 0; i < n; i += QE_FLOAT_TILE) {
+    size_t m = (n - i < QE_FLOAT_TILE) ? n - i : QE_FLOAT_TILE, again;
+
+    again = kernel(a + i, b + i, c + i, res1 + i, res2 + i, msg_id + i, m, k,
+                   idx);
+    if (again > 0)
+      solve_float_again(a + i, b + i, c + i, res1 + i, res2 + i, msg_id + i,
+                        idx, again, prec);
+    count += again;
+  }
+
+  if (nescalated != NULL)
+    *nescalated = count;
+
+  return QE_BATCH_OK;
+}
+
+/* Implementation of the classify_equation_batch function. */
+int classify_equation_batch(const double *a, const double *b,
+                            const double *c, int *msg_id, size_t n,
+                            int prec) {
+
+  /* Checking pointers for a non-NULL value. */
+  if ((a == NULL) || (b == NULL) || (c == NULL) || (msg_id == NULL))
+    return QE_ERR_NULLPTR;
+
+  qe_counters[qe_batch_get_isa()](a, b, c, msg_id, 0, NULL, n, prec);
+  return QE_BATCH_OK;
+}
+
+/* Implementation of the classify_equation_select function. */
+int classify_equation_select(const double *a, const double *b,
+                             const double *c, unsigned int classes,
+                             size_t *idx, size_t *count, size_t n, int prec) {
+
+  /* Checking pointers for a non-NULL value. */
+  if ((a == NULL) || (b == NULL) || (c == NULL) || (idx == NULL) ||
+      (count == NULL))
+    return QE_ERR_NULLPTR;
+
+  *count = qe_counters[qe_batch_get_isa()](a, b, c, NULL, classes, idx, n,
+                                           prec);
+  return QE_BATCH_OK;
+}
+
+/* Implementation of the select_equation_roots_in function. */
+int select_equation_roots_in(const double *a, const double *b,
+                             const double *c, double lo, double hi,
+                             size_t *idx, size_t *count, size_t n, int prec) {
+
+  /* Checking pointers for a non-NULL value. */
+  if ((a == NULL) || (b == NULL) || (c == NULL) || (idx == NULL) ||
+      (count == NULL))
+    return QE_ERR_NULLPTR;
+
+  *count = qe_counters_in[qe_batch_get_isa()](a, b, c, lo, hi, idx, n, prec);
+  return QE_BATCH_OK;
+}
@@ -0,0 +1,96 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the batch kernels of both precision
+ * modes for the AVX2 and FMA instruction sets (four equations
+ * at once) and the float kernel (eight).
+ *
+ * The file is compiled with -mavx2 -mfma, the kernel is
+ * called only if the processor supports them.
+ *
+-------------------------------------------------------------*/
+
+#include "qe_internal.h"
+#include <immintrin.h>
+
+typedef __m256d qe_vd;
+typedef __m256d qe_vm;
+
+#define QE_KERNEL qe_batch_kernel_avx2
+#define QE_W 4
+#define V_SET1(x) _mm256_set1_pd(x)
+#define V_LOADU(p) _mm256_loadu_pd(p)
+#define V_STOREU(p, v) _mm256_storeu_pd((p), (v))
+#define V_STORE_MSG(p, v)                                                      \
+  _mm_storeu_si128((__m128i *)(p), _mm256_cvttpd_epi32(v))
+#define V_LOAD_MSG(p) _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i *)(p)))
+#define V_ADD(x, y) _mm256_add_pd((x), (y))
+#define V_SUB(x, y) _mm256_sub_pd((x), (y))
+#define V_MUL(x, y) _mm256_mul_pd((x), (y))
+#define V_DIV(x, y) _mm256_div_pd((x), (y))
+#define V_SQRT(x) _mm256_sqrt_pd(x)
+#define V_MIN(x, y) _mm256_min_pd((x), (y))
+#define V_ABS(x) _mm256_andnot_pd(_mm256_set1_pd(-0.0), (x))
+#define V_NEG(x) _mm256_xor_pd((x), _mm256_set1_pd(-0.0))
+#define V_EXPO(x)                                                              \
+  _mm256_and_pd((x),                                                           \
+                _mm256_castsi256_pd(_mm256_set1_epi64x(0x7ff0000000000000LL)))
+#define V_TWO_PROD(p, e, x, y)                                                 \
+  do {                                                                         \
+    (p) = _mm256_mul_pd((x), (y));                                             \
+    (e) = _mm256_fmsub_pd((x), (y), (p));                                      \
+  } while (0)
+#define V_CMPEQ(x, y) _mm256_cmp_pd((x), (y), _CMP_EQ_OQ)
+#define V_CMPLT(x, y) _mm256_cmp_pd((x), (y), _CMP_LT_OQ)
+#define V_CMPLE(x, y) _mm256_cmp_pd((x), (y), _CMP_LE_OQ)
+#define V_CMPGT(x, y) _mm256_cmp_pd((x), (y), _CMP_GT_OQ)
+#define M_AND(x, y) _mm256_and_pd((x), (y))
+#define M_OR(x, y) _mm256_or_pd((x), (y))
+#define M_NOT(x) _mm256_xor_pd((x), _mm256_castsi256_pd(_mm256_set1_epi32(-1)))
+#define M_NONE _mm256_setzero_pd()
+#define M_BITS(m) ((unsigned int)_mm256_movemask_pd(m))
+#define V_SEL(m, t, f) _mm256_blendv_pd((f), (t), (m))
+
+#include "qe_kernel.h"
+
+/* The kernel of the QE_PREC_DOUBLE mode. */
+#undef QE_KERNEL
+#define QE_KERNEL qe_batch_kernel_avx2_double
+
+#include "qe_kernel_double.h"
+
+/* The kernel of the polishing of the roots. */
+#define QE_POLISH qe_polish_avx2
+
+#include "qe_polish.h"
+
+/* The kernels of the classification and of the root range queries. */
+#define QE_COUNT qe_count_avx2
+#define QE_COUNT_IN qe_count_in_avx2
+
+#include "qe_count.h"
+
+/* The float kernel, eight equations at once. */
+typedef __m256 qe_vf;
+typedef __m256 qe_vfm;
+
+#define QE_FLOAT_KERNEL qe_float_kernel_avx2
+#define QE_FW 8
+#define F_SET1(x) _mm256_set1_ps(x)
+#define F_LOADU(p) _mm256_loadu_ps(p)
+#define F_STOREU(p, v) _mm256_storeu_ps((p), (v))
+#define F_STORE_MSG(p, v)                                                      \
+  _mm256_storeu_si256((__m256i *)(p), _mm256_cvttps_epi32(v))
+#define F_ADD(x, y) _mm256_add_ps((x), (y))
+#define F_SUB(x, y) _mm256_sub_ps((x), (y))
+#define F_MUL(x, y) _mm256_mul_ps((x), (y))
+#define F_DIV(x, y) _mm256_div_ps((x), (y))
+#define F_SQRT(x) _mm256_sqrt_ps(x)
+#define F_ABS(x) _mm256_andnot_ps(_mm256_set1_ps(-0.0f), (x))
+#define F_CMPLT(x, y) _mm256_cmp_ps((x), (y), _CMP_LT_OQ)
+#define F_CMPLE(x, y) _mm256_cmp_ps((x), (y), _CMP_LE_OQ)
+#define FM_AND(x, y) _mm256_and_ps((x), (y))
+#define FM_OR(x, y) _mm256_or_ps((x), (y))
+#define FM_BITS(m) ((unsigned int)_mm256_movemask_ps(m))
+#define F_SEL(m, t, f) _mm256_blendv_ps((f), (t), (m))
+
+#include "qe_kernel_float.h"
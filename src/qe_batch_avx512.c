@@ -0,0 +1,110 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the batch kernels of both precision
+ * modes for the AVX-512F instruction set (eight equations
+ * at once) and the float kernel (sixteen).
+ *
+ * The file is compiled with -mavx512f, the kernel is
+ * called only if the processor supports it.
+ *
+-------------------------------------------------------------*/
+
+#include "qe_internal.h"
+#include <immintrin.h>
+
+typedef __m512d qe_vd;
+typedef __mmask8 qe_vm;
+
+/* Bitwise operations on doubles through the integer instructions. */
+#define QE_AS_INT(x) _mm512_castpd_si512(x)
+#define QE_AS_PD(x) _mm512_castsi512_pd(x)
+
+#define QE_KERNEL qe_batch_kernel_avx512
+#define QE_W 8
+#define V_SET1(x) _mm512_set1_pd(x)
+#define V_LOADU(p) _mm512_loadu_pd(p)
+#define V_STOREU(p, v) _mm512_storeu_pd((p), (v))
+#define V_STORE_MSG(p, v)                                                      \
+  _mm256_storeu_si256((__m256i *)(p), _mm512_cvttpd_epi32(v))
+#define V_LOAD_MSG(p)                                                          \
+  _mm512_cvtepi32_pd(_mm256_loadu_si256((const __m256i *)(p)))
+#define V_ADD(x, y) _mm512_add_pd((x), (y))
+#define V_SUB(x, y) _mm512_sub_pd((x), (y))
+#define V_MUL(x, y) _mm512_mul_pd((x), (y))
+#define V_DIV(x, y) _mm512_div_pd((x), (y))
+#define V_SQRT(x) _mm512_sqrt_pd(x)
+#define V_MIN(x, y) _mm512_min_pd((x), (y))
+#define V_ABS(x) _mm512_abs_pd(x)
+#define V_NEG(x)                                                               \
+  QE_AS_PD(_mm512_xor_si512(                                                   \
+      QE_AS_INT(x), _mm512_set1_epi64((long long)0x8000000000000000ULL)))
+#define V_EXPO(x)                                                              \
+  QE_AS_PD(_mm512_and_si512(QE_AS_INT(x),                                      \
+                            _mm512_set1_epi64(0x7ff0000000000000LL)))
+#define V_TWO_PROD(p, e, x, y)                                                 \
+  do {                                                                         \
+    (p) = _mm512_mul_pd((x), (y));                                             \
+    (e) = _mm512_fmsub_pd((x), (y), (p));                                      \
+  } while (0)
+#define V_CMPEQ(x, y) _mm512_cmp_pd_mask((x), (y), _CMP_EQ_OQ)
+#define V_CMPLT(x, y) _mm512_cmp_pd_mask((x), (y), _CMP_LT_OQ)
+#define V_CMPLE(x, y) _mm512_cmp_pd_mask((x), (y), _CMP_LE_OQ)
+#define V_CMPGT(x, y) _mm512_cmp_pd_mask((x), (y), _CMP_GT_OQ)
+#define M_AND(x, y) ((qe_vm)((x) & (y)))
+#define M_OR(x, y) ((qe_vm)((x) | (y)))
+#define M_NOT(x) ((qe_vm)~(x))
+#define M_NONE ((qe_vm)0)
+#define M_BITS(m) ((unsigned int)(m))
+#define V_SEL(m, t, f) _mm512_mask_blend_pd((m), (f), (t))
+
+#include "qe_kernel.h"
+
+/* The kernel of the QE_PREC_DOUBLE mode. */
+#undef QE_KERNEL
+#define QE_KERNEL qe_batch_kernel_avx512_double
+
+#include "qe_kernel_double.h"
+
+/* The kernel of the polishing of the roots. */
+#define QE_POLISH qe_polish_avx512
+
+#include "qe_polish.h"
+
+/* The kernels of the classification and of the root range queries. */
+#define QE_COUNT qe_count_avx512
+#define QE_COUNT_IN qe_count_in_avx512
+
+/* The indices of the selected lanes are compacted in a register. */
+#define V_COMPRESS_IDX(p, bits, base)                                          \
+  _mm512_storeu_si512(                                                         \
+      (p), _mm512_maskz_compress_epi64(                                        \
+               (__mmask8)(bits),                                               \
+               _mm512_add_epi64(_mm512_set1_epi64((long long)(base)),          \
+                                _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0))))
+
+#include "qe_count.h"
+
+/* The float kernel, sixteen equations at once. */
+typedef __m512 qe_vf;
+typedef __mmask16 qe_vfm;
+
+#define QE_FLOAT_KERNEL qe_float_kernel_avx512
+#define QE_FW 16
+#define F_SET1(x) _mm512_set1_ps(x)
+#define F_LOADU(p) _mm512_loadu_ps(p)
+#define F_STOREU(p, v) _mm512_storeu_ps((p), (v))
+#define F_STORE_MSG(p, v) _mm512_storeu_si512((p), _mm512_cvttps_epi32(v))
+#define F_ADD(x, y) _mm512_add_ps((x), (y))
+#define F_SUB(x, y) _mm512_sub_ps((x), (y))
+#define F_MUL(x, y) _mm512_mul_ps((x), (y))
+#define F_DIV(x, y) _mm512_div_ps((x), (y))
+#define F_SQRT(x) _mm512_sqrt_ps(x)
+#define F_ABS(x) _mm512_abs_ps(x)
+#define F_CMPLT(x, y) _mm512_cmp_ps_mask((x), (y), _CMP_LT_OQ)
+#define F_CMPLE(x, y) _mm512_cmp_ps_mask((x), (y), _CMP_LE_OQ)
+#define FM_AND(x, y) ((qe_vfm)((x) & (y)))
+#define FM_OR(x, y) ((qe_vfm)((x) | (y)))
+#define FM_BITS(m) ((unsigned int)(m))
+#define F_SEL(m, t, f) _mm512_mask_blend_ps((m), (f), (t))
+
+#include "qe_kernel_float.h"
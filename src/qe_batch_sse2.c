@@ -0,0 +1,112 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the batch kernels of both precision
+ * modes for the SSE2 instruction set (two equations at once)
+ * and the float kernel (four).
+ *
+ * SSE2 has no fused multiply-add, so the exact products
+ * are computed by Dekker's algorithm.
+ *
+-------------------------------------------------------------*/
+
+#include "qe_internal.h"
+#include <emmintrin.h>
+
+typedef __m128d qe_vd;
+typedef __m128d qe_vm;
+
+/*
+ * The function computes p and e such that p + e == x * y
+ * exactly (Dekker's algorithm with Veltkamp's splitting).
+ */
+static inline void qe_two_prod_sse2(qe_vd x, qe_vd y, qe_vd *p, qe_vd *e) {
+  const qe_vd split = _mm_set1_pd(134217729.0);
+  qe_vd t, xh, xl, yh, yl;
+
+  t = _mm_mul_pd(split, x);
+  xh = _mm_sub_pd(t, _mm_sub_pd(t, x));
+  xl = _mm_sub_pd(x, xh);
+  t = _mm_mul_pd(split, y);
+  yh = _mm_sub_pd(t, _mm_sub_pd(t, y));
+  yl = _mm_sub_pd(y, yh);
+
+  *p = _mm_mul_pd(x, y);
+  *e = _mm_add_pd(
+      _mm_add_pd(_mm_add_pd(_mm_sub_pd(_mm_mul_pd(xh, yh), *p),
+                            _mm_mul_pd(xh, yl)),
+                 _mm_mul_pd(xl, yh)),
+      _mm_mul_pd(xl, yl));
+}
+
+#define QE_KERNEL qe_batch_kernel_sse2
+#define QE_W 2
+#define V_SET1(x) _mm_set1_pd(x)
+#define V_LOADU(p) _mm_loadu_pd(p)
+#define V_STOREU(p, v) _mm_storeu_pd((p), (v))
+#define V_STORE_MSG(p, v) _mm_storel_epi64((__m128i *)(p), _mm_cvttpd_epi32(v))
+#define V_LOAD_MSG(p) _mm_cvtepi32_pd(_mm_loadl_epi64((const __m128i *)(p)))
+#define V_ADD(x, y) _mm_add_pd((x), (y))
+#define V_SUB(x, y) _mm_sub_pd((x), (y))
+#define V_MUL(x, y) _mm_mul_pd((x), (y))
+#define V_DIV(x, y) _mm_div_pd((x), (y))
+#define V_SQRT(x) _mm_sqrt_pd(x)
+#define V_MIN(x, y) _mm_min_pd((x), (y))
+#define V_ABS(x) _mm_andnot_pd(_mm_set1_pd(-0.0), (x))
+#define V_NEG(x) _mm_xor_pd((x), _mm_set1_pd(-0.0))
+#define V_EXPO(x)                                                              \
+  _mm_and_pd((x), _mm_castsi128_pd(_mm_set1_epi64x(0x7ff0000000000000LL)))
+#define V_TWO_PROD(p, e, x, y) qe_two_prod_sse2((x), (y), &(p), &(e))
+#define V_CMPEQ(x, y) _mm_cmpeq_pd((x), (y))
+#define V_CMPLT(x, y) _mm_cmplt_pd((x), (y))
+#define V_CMPLE(x, y) _mm_cmple_pd((x), (y))
+#define V_CMPGT(x, y) _mm_cmpgt_pd((x), (y))
+#define M_AND(x, y) _mm_and_pd((x), (y))
+#define M_OR(x, y) _mm_or_pd((x), (y))
+#define M_NOT(x) _mm_xor_pd((x), _mm_castsi128_pd(_mm_set1_epi32(-1)))
+#define M_NONE _mm_setzero_pd()
+#define M_BITS(m) ((unsigned int)_mm_movemask_pd(m))
+#define V_SEL(m, t, f) _mm_or_pd(_mm_and_pd((m), (t)), _mm_andnot_pd((m), (f)))
+
+#include "qe_kernel.h"
+
+/* The kernel of the QE_PREC_DOUBLE mode. */
+#undef QE_KERNEL
+#define QE_KERNEL qe_batch_kernel_sse2_double
+
+#include "qe_kernel_double.h"
+
+/* The kernel of the polishing of the roots. */
+#define QE_POLISH qe_polish_sse2
+
+#include "qe_polish.h"
+
+/* The kernels of the classification and of the root range queries. */
+#define QE_COUNT qe_count_sse2
+#define QE_COUNT_IN qe_count_in_sse2
+
+#include "qe_count.h"
+
+/* The float kernel, four equations at once. */
+typedef __m128 qe_vf;
+typedef __m128 qe_vfm;
+
+#define QE_FLOAT_KERNEL qe_float_kernel_sse2
+#define QE_FW 4
+#define F_SET1(x) _mm_set1_ps(x)
+#define F_LOADU(p) _mm_loadu_ps(p)
+#define F_STOREU(p, v) _mm_storeu_ps((p), (v))
+#define F_STORE_MSG(p, v) _mm_storeu_si128((__m128i *)(p), _mm_cvttps_epi32(v))
+#define F_ADD(x, y) _mm_add_ps((x), (y))
+#define F_SUB(x, y) _mm_sub_ps((x), (y))
+#define F_MUL(x, y) _mm_mul_ps((x), (y))
+#define F_DIV(x, y) _mm_div_ps((x), (y))
+#define F_SQRT(x) _mm_sqrt_ps(x)
+#define F_ABS(x) _mm_andnot_ps(_mm_set1_ps(-0.0f), (x))
+#define F_CMPLT(x, y) _mm_cmplt_ps((x), (y))
+#define F_CMPLE(x, y) _mm_cmple_ps((x), (y))
+#define FM_AND(x, y) _mm_and_ps((x), (y))
+#define FM_OR(x, y) _mm_or_ps((x), (y))
+#define FM_BITS(m) ((unsigned int)_mm_movemask_ps(m))
+#define F_SEL(m, t, f) _mm_or_ps(_mm_and_ps((m), (t)), _mm_andnot_ps((m), (f)))
+
+#include "qe_kernel_float.h"
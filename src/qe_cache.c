@@ -0,0 +1,427 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the cache of the
+ * results of solve_equation_prec (qe_cache).
+ *
+ * The cache is a set-associative hash table: the hash of the
+ * bits of `a`, `b`, `c` and the precision mode selects a set of
+ * QE_CACHE_WAYS entries, one cache line each, and a tag that
+ * marks the entries worth comparing. Every entry has a
+ * sequence counter (seqlock). A writer makes it odd with
+ * compare-and-swap, writes the entry and makes it even again;
+ * a writer that cannot take the entry gives up, the result is
+ * just not stored. A reader copies the entry and checks that
+ * the counter was even and did not change meanwhile. So no
+ * thread ever waits for another one, and a reader never sees
+ * a half-written entry.
+ *
+ * The fields of the entries are accessed by atomic operations,
+ * because they are read while they may be written. The counters
+ * are split into shards, one cache line each. The first
+ * QE_CACHE_SHARDS threads that use a cache get a shard each and
+ * are its only writers, so they add to the counters by a plain
+ * load and store instead of a locked instruction (which would
+ * cost more than the rest of a hit). Other threads share the
+ * last shard and add to it atomically.
+ *
+-------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "qe_cache.h"
+#include "quadratic_equation.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The number of the shards of the counters owned by one thread. */
+#define QE_CACHE_SHARDS 16
+
+/* The indices of the counters in a shard. */
+#define QE_CACHE_HITS 0
+#define QE_CACHE_MISSES 1
+#define QE_CACHE_INSERTIONS 2
+#define QE_CACHE_EVICTIONS 3
+
+/* The bit of the meta field that marks a stored result. */
+#define QE_CACHE_VALID (1ULL << 63)
+
+/*
+ * An entry of the cache, one cache line. The meta field holds the
+ * valid bit, the precision mode and the msg_id. The doubles are
+ * stored as their bits.
+ */
+typedef struct {
+  uint32_t seq; /* The sequence counter, odd while written. */
+  uint32_t ref; /* The entry has been hit (QE_CACHE_EVICT_CLOCK). */
+  uint64_t meta;
+  uint64_t key[3];
+  uint64_t res[2];
+  char pad[64 - 2 * sizeof(uint32_t) - 6 * sizeof(uint64_t)];
+} qe_cache_entry;
+
+/*
+ * The tags and the state of the eviction of a set, two sets per
+ * cache line. A tag is 16 bits of the hash of the key stored in
+ * the entry (0 if the entry is empty), so a lookup reads only the
+ * entries with the same tag, usually one. The tags are only hints,
+ * the keys are always compared.
+ */
+typedef struct {
+  uint16_t tag[QE_CACHE_WAYS];
+  uint32_t hand; /* The next entry to check or to replace. */
+  char pad[32 - QE_CACHE_WAYS * sizeof(uint16_t) - sizeof(uint32_t)];
+} qe_cache_set;
+
+/* A shard of the counters, one cache line. */
+typedef struct {
+  unsigned long long count[4];
+  char pad[64 - 4 * sizeof(unsigned long long)];
+} qe_cache_shard;
+
+/*
+ * The shards go first, so they are aligned to the cache lines.
+ * The last one is shared by the threads without a shard.
+ */
+struct qe_cache {
+  qe_cache_shard shards[QE_CACHE_SHARDS + 1];
+  qe_cache_entry *entries;
+  qe_cache_set *sets;
+  size_t mask; /* The number of sets minus one. */
+  int policy;
+};
+
+/*
+ * The shard of the calling thread, the same in all the caches.
+ * It is -1 until the first call of the thread.
+ */
+static __thread int thread_shard = -1;
+
+/* The number of the threads that got a shard. */
+static int next_shard;
+
+/* The function returns the bits of the double. */
+static inline uint64_t to_bits(double x) {
+  uint64_t u;
+
+  memcpy(&u, &x, sizeof(u));
+  return u;
+}
+
+/* The function returns the double with the given bits. */
+static inline double from_bits(uint64_t u) {
+  double x;
+
+  memcpy(&x, &u, sizeof(x));
+  return x;
+}
+
+/*
+ * The function mixes the bits of the key, so that the close
+ * parameters get different sets and tags. The parameters are
+ * multiplied by different odd constants independently, and the
+ * sum is mixed by a multiply and xor-shift step.
+ */
+static inline uint64_t hash_key(const uint64_t key[3], int prec) {
+  uint64_t h;
+
+  h = (key[0] * 0x9E3779B97F4A7C15ULL) ^ (key[1] * 0xC2B2AE3D27D4EB4FULL) ^
+      (key[2] * 0x165667B19E3779F9ULL) ^ (uint64_t)prec;
+  h ^= h >> 32;
+  h *= 0xFF51AFD7ED558CCDULL;
+  h ^= h >> 29;
+  return h;
+}
+
+/* The function returns the meta field of a stored result. */
+static inline uint64_t make_meta(int prec, int msg_id) {
+  return QE_CACHE_VALID | ((uint64_t)(uint32_t)prec << 32) |
+         (uint32_t)msg_id;
+}
+
+/*
+ * The function looks for the key in the entry. If the entry holds
+ * it and was not written meanwhile, the results are written to
+ * *msg_id, *res1 and *res2, and true is returned.
+ */
+static int read_entry(qe_cache_entry *e, const uint64_t key[3], uint64_t meta,
+                      int *msg_id, double *res1, double *res2) {
+  uint32_t seq = __atomic_load_n(&e->seq, __ATOMIC_ACQUIRE);
+  uint64_t m, r1, r2;
+
+  if (seq & 1)
+    return 0;
+
+  /* The mode and the valid bit are compared, the msg_id is read. */
+  m = __atomic_load_n(&e->meta, __ATOMIC_RELAXED);
+  if (((m ^ meta) >> 32) != 0)
+    return 0;
+  if ((__atomic_load_n(&e->key[0], __ATOMIC_RELAXED) != key[0]) ||
+      (__atomic_load_n(&e->key[1], __ATOMIC_RELAXED) != key[1]) ||
+      (__atomic_load_n(&e->key[2], __ATOMIC_RELAXED) != key[2]))
+    return 0;
+  r1 = __atomic_load_n(&e->res[0], __ATOMIC_RELAXED);
+  r2 = __atomic_load_n(&e->res[1], __ATOMIC_RELAXED);
+
+  /* The entry must not have changed while it was read. */
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  if (__atomic_load_n(&e->seq, __ATOMIC_RELAXED) != seq)
+    return 0;
+
+  *msg_id = (int)(uint32_t)m;
+  *res1 = from_bits(r1);
+  *res2 = from_bits(r2);
+  return 1;
+}
+
+/*
+ * The function writes the result to the entry. Returns false if
+ * another thread is writing it now.
+ */
+static int write_entry(qe_cache_entry *e, uint16_t *tag, uint16_t key_tag,
+                       const uint64_t key[3], uint64_t meta, double res1,
+                       double res2) {
+  uint32_t seq = __atomic_load_n(&e->seq, __ATOMIC_RELAXED);
+
+  if ((seq & 1) || !__atomic_compare_exchange_n(&e->seq, &seq, seq + 1, 0,
+                                                __ATOMIC_ACQUIRE,
+                                                __ATOMIC_RELAXED))
+    return 0;
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  __atomic_store_n(tag, key_tag, __ATOMIC_RELAXED);
+  __atomic_store_n(&e->meta, meta, __ATOMIC_RELAXED);
+  __atomic_store_n(&e->key[0], key[0], __ATOMIC_RELAXED);
+  __atomic_store_n(&e->key[1], key[1], __ATOMIC_RELAXED);
+  __atomic_store_n(&e->key[2], key[2], __ATOMIC_RELAXED);
+  __atomic_store_n(&e->res[0], to_bits(res1), __ATOMIC_RELAXED);
+  __atomic_store_n(&e->res[1], to_bits(res2), __ATOMIC_RELAXED);
+  __atomic_store_n(&e->ref, 0, __ATOMIC_RELAXED);
+
+  __atomic_store_n(&e->seq, seq + 2, __ATOMIC_RELEASE);
+  return 1;
+}
+
+/*
+ * The function selects the entry of the set for a new result:
+ * an empty one, or the one selected by the eviction policy.
+ * Returns -1 if the result should not be stored. *evict is set
+ * if a stored result is replaced.
+ */
+static int select_victim(qe_cache *cache, size_t set, int *evict) {
+  qe_cache_entry *e = &cache->entries[set * QE_CACHE_WAYS];
+  uint32_t *hand = &cache->sets[set].hand;
+  uint32_t h;
+
+  *evict = 0;
+  for (int i = 0; i < QE_CACHE_WAYS; i++)
+    if (!(__atomic_load_n(&e[i].meta, __ATOMIC_RELAXED) & QE_CACHE_VALID))
+      return i;
+
+  *evict = 1;
+  switch (cache->policy) {
+
+  case QE_CACHE_EVICT_FIFO:
+    return (int)(__atomic_fetch_add(hand, 1, __ATOMIC_RELAXED) %
+                 QE_CACHE_WAYS);
+
+  case QE_CACHE_EVICT_CLOCK:
+    /* The entries hit since the last pass get a second chance. */
+    for (int i = 0; i < 2 * QE_CACHE_WAYS; i++) {
+      h = __atomic_fetch_add(hand, 1, __ATOMIC_RELAXED) % QE_CACHE_WAYS;
+      if (!__atomic_exchange_n(&e[h].ref, 0, __ATOMIC_RELAXED))
+        return (int)h;
+    }
+    return (int)(__atomic_fetch_add(hand, 1, __ATOMIC_RELAXED) %
+                 QE_CACHE_WAYS);
+
+  default:
+    return -1;
+  }
+}
+
+/* The function adds one to the counter of the calling thread. */
+static inline void count(qe_cache *cache, int counter) {
+  int id = thread_shard;
+  unsigned long long *p;
+
+  if (id < 0)
+    id = thread_shard = __atomic_fetch_add(&next_shard, 1, __ATOMIC_RELAXED);
+
+  if (id < QE_CACHE_SHARDS) {
+    /* The thread is the only writer of its shard. */
+    p = &cache->shards[id].count[counter];
+    __atomic_store_n(p, __atomic_load_n(p, __ATOMIC_RELAXED) + 1,
+                     __ATOMIC_RELAXED);
+  } else
+    __atomic_fetch_add(&cache->shards[QE_CACHE_SHARDS].count[counter], 1,
+                       __ATOMIC_RELAXED);
+}
+
+/*
+ * Implementation of the qe_cache_create function. The entries
+ * are aligned to the cache lines.
+ */
+qe_cache *qe_cache_create(size_t capacity, int policy) {
+  qe_cache *cache;
+  size_t nsets = 1;
+  void *mem, *entries;
+
+  if ((policy != QE_CACHE_EVICT_CLOCK) && (policy != QE_CACHE_EVICT_FIFO) &&
+      (policy != QE_CACHE_EVICT_NONE))
+    return NULL;
+
+  while (nsets * QE_CACHE_WAYS < capacity)
+    nsets *= 2;
+
+  if (posix_memalign(&mem, 64, sizeof(*cache)) != 0)
+    return NULL;
+  cache = mem;
+  memset(cache, 0, sizeof(*cache));
+
+  if (posix_memalign(&entries, 64, nsets * QE_CACHE_WAYS *
+                                       sizeof(qe_cache_entry)) != 0) {
+    free(cache);
+    return NULL;
+  }
+  cache->entries = entries;
+  memset(cache->entries, 0, nsets * QE_CACHE_WAYS * sizeof(qe_cache_entry));
+
+  cache->sets = calloc(nsets, sizeof(qe_cache_set));
+  if (cache->sets == NULL) {
+    free(cache->entries);
+    free(cache);
+    return NULL;
+  }
+
+  cache->mask = nsets - 1;
+  cache->policy = policy;
+  return cache;
+}
+
+/* Implementation of the qe_cache_destroy function. */
+void qe_cache_destroy(qe_cache *cache) {
+
+  if (cache == NULL)
+    return;
+
+  free(cache->entries);
+  free(cache->sets);
+  free(cache);
+}
+
+/*
+ * Implementation of the qe_cache_solve function. If the entry for
+ * the result is being written by another thread, the result is
+ * not stored.
+ */
+int qe_cache_solve(qe_cache *cache, double a, double b, double c,
+                   double *res1, double *res2, int prec) {
+  uint64_t key[3], meta, h;
+  qe_cache_entry *e;
+  uint16_t *tags, tag;
+  size_t set;
+  int msg_id, way, evict;
+
+  /* Checking pointers for a non-NULL value. */
+  if ((res1 == NULL) || (res2 == NULL))
+    return QE_ERR_NULLPTR;
+  if (cache == NULL)
+    return solve_equation_prec(a, b, c, res1, res2, prec);
+
+  /* Any mode other than QE_PREC_DOUBLE is QE_PREC_EXTENDED. */
+  prec = (prec == QE_PREC_DOUBLE) ? QE_PREC_DOUBLE : QE_PREC_EXTENDED;
+
+  key[0] = to_bits(a);
+  key[1] = to_bits(b);
+  key[2] = to_bits(c);
+  h = hash_key(key, prec);
+  set = (size_t)h & cache->mask;
+  tag = (uint16_t)((h >> 48) | 1);
+  tags = cache->sets[set].tag;
+  e = &cache->entries[set * QE_CACHE_WAYS];
+  meta = make_meta(prec, 0);
+
+  for (int i = 0; i < QE_CACHE_WAYS; i++)
+    if ((__atomic_load_n(&tags[i], __ATOMIC_RELAXED) == tag) &&
+        read_entry(&e[i], key, meta, &msg_id, res1, res2)) {
+      if ((cache->policy == QE_CACHE_EVICT_CLOCK) &&
+          !__atomic_load_n(&e[i].ref, __ATOMIC_RELAXED))
+        __atomic_store_n(&e[i].ref, 1, __ATOMIC_RELAXED);
+      count(cache, QE_CACHE_HITS);
+      return msg_id;
+    }
+
+  count(cache, QE_CACHE_MISSES);
+  msg_id = solve_equation_prec(a, b, c, res1, res2, prec);
+
+  way = select_victim(cache, set, &evict);
+  if ((way >= 0) &&
+      write_entry(&e[way], &tags[way], tag, key, make_meta(prec, msg_id),
+                  *res1, *res2)) {
+    count(cache, QE_CACHE_INSERTIONS);
+    if (evict)
+      count(cache, QE_CACHE_EVICTIONS);
+  }
+
+  return msg_id;
+}
+
+/* Implementation of the qe_cache_get_stats function. */
+void qe_cache_get_stats(const qe_cache *cache, qe_cache_stats *stats) {
+
+  memset(stats, 0, sizeof(*stats));
+  if (cache == NULL)
+    return;
+
+  for (int i = 0; i <= QE_CACHE_SHARDS; i++) {
+    const unsigned long long *n = cache->shards[i].count;
+
+    stats->hits += __atomic_load_n(&n[QE_CACHE_HITS], __ATOMIC_RELAXED);
+    stats->misses += __atomic_load_n(&n[QE_CACHE_MISSES], __ATOMIC_RELAXED);
+    stats->insertions +=
+        __atomic_load_n(&n[QE_CACHE_INSERTIONS], __ATOMIC_RELAXED);
+    stats->evictions +=
+        __atomic_load_n(&n[QE_CACHE_EVICTIONS], __ATOMIC_RELAXED);
+  }
+}
+
+/* Implementation of the qe_cache_reset_stats function. */
+void qe_cache_reset_stats(qe_cache *cache) {
+
+  if (cache == NULL)
+    return;
+
+  for (int i = 0; i <= QE_CACHE_SHARDS; i++)
+    for (int j = 0; j < 4; j++)
+      __atomic_store_n(&cache->shards[i].count[j], 0, __ATOMIC_RELAXED);
+}
+
+/*
+ * Implementation of the qe_cache_clear function. Every entry is
+ * invalidated under its sequence counter, like a write; an entry
+ * being written by another thread is waited for.
+ */
+void qe_cache_clear(qe_cache *cache) {
+  size_t n;
+
+  if (cache == NULL)
+    return;
+
+  n = (cache->mask + 1) * QE_CACHE_WAYS;
+  for (size_t i = 0; i < n; i++) {
+    qe_cache_entry *e = &cache->entries[i];
+    uint32_t seq;
+
+    do
+      seq = __atomic_load_n(&e->seq, __ATOMIC_RELAXED) & ~1U;
+    while (!__atomic_compare_exchange_n(&e->seq, &seq, seq + 1, 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    __atomic_store_n(&cache->sets[i / QE_CACHE_WAYS].tag[i % QE_CACHE_WAYS],
+                     0, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->meta, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->seq, seq + 2, __ATOMIC_RELEASE);
+  }
+}
@@ -0,0 +1,77 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the branch-free classification core:
+ * the function that selects the msg_id and the roots of the
+ * equation from the masks of its cases.
+ *
+ * It is included both by the branch-free solve_equation
+ * (one equation in long double) and by the batch kernels
+ * (vectors of doubles), after the macros are defined:
+ *
+ *   qe_vd, qe_vm            - value and mask types
+ *   V_SET1(x)               - the value x in every lane
+ *   V_SEL(m, t, f)          - t in the lanes of m, f otherwise
+ *   M_AND, M_OR, M_NOT      - operations on masks
+ *
+-------------------------------------------------------------*/
+
+#ifndef QE_CLASSIFY_H
+#define QE_CLASSIFY_H
+
+#include "quadratic_equation.h"
+
+/*
+ * The function selects the msg_id (returned as qe_vd) and writes
+ * the roots to *res1 and *res2. The masks of the cases:
+ *
+ *   za, zb, zc - the parameter `a`, `b` or `c` is zero;
+ *   dpos, dzero - the discriminant is positive or zero;
+ *   ovf0 - the single root r0 is outside the double range;
+ *   ovf12 - one of the roots r1, r2 is outside the double range.
+ *
+ * The single root r0 is -c / b if only `a` is zero and
+ * -b / (2 * a) if the discriminant is zero. The masks and roots
+ * of the cases that do not occur in a lane are ignored.
+ */
+static inline qe_vd qe_classify(qe_vm za, qe_vm zb, qe_vm zc, qe_vm dpos,
+                                qe_vm dzero, qe_vm ovf0, qe_vm ovf12,
+                                qe_vd r0, qe_vd r1, qe_vd r2, qe_vd *res1,
+                                qe_vd *res2) {
+  const qe_vd std_val = V_SET1(QE_STD_VAL_RES);
+  qe_vm quad, one, two, ovf, root0;
+  qe_vd msg;
+
+  /* The equation is solved through the discriminant. */
+  quad = M_AND(M_NOT(za), M_NOT(M_AND(zb, zc)));
+
+  /* The equation has one root r0 or two roots r1, r2. */
+  one = M_OR(M_AND(za, M_AND(M_NOT(zb), M_NOT(zc))), M_AND(quad, dzero));
+  two = M_AND(quad, dpos);
+
+  ovf = M_OR(M_AND(one, ovf0), M_AND(two, ovf12));
+
+  /*
+   * All the parameters are zero: infinity of roots. Only `c` is not
+   * zero: no roots. Only `a` or only `b` is not zero: the root 0.
+   */
+  msg = V_SEL(M_AND(za, zb),
+              V_SEL(zc, V_SET1(QE_OK_INF_RES), V_SET1(QE_OK_NO_RES)),
+              V_SET1(QE_OK_ONE_RES));
+  msg = V_SEL(quad,
+              V_SEL(dpos, V_SET1(QE_OK_TWO_RES),
+                    V_SEL(dzero, V_SET1(QE_OK_ONE_RES), V_SET1(QE_OK_NO_RES))),
+              msg);
+  msg = V_SEL(ovf, V_SET1(QE_ERR_OVERFLOW), msg);
+
+  /* The special cases with the root 0. */
+  root0 = M_AND(zc, M_NOT(M_AND(za, zb)));
+
+  *res1 = V_SEL(two, r1, V_SEL(one, r0, V_SEL(root0, V_SET1(0), std_val)));
+  *res2 = V_SEL(two, r2, V_SEL(one, r0, V_SEL(root0, V_SET1(0), std_val)));
+  *res1 = V_SEL(ovf, std_val, *res1);
+  *res2 = V_SEL(ovf, std_val, *res2);
+
+  return msg;
+}
+
+#endif
@@ -0,0 +1,174 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the client of the
+ * qe_served daemon (qe_client). The protocol is described in
+ * qe_served.h.
+ *
+ * The equations are sent in frames of at most
+ * QE_SERVED_MAX_BATCH equations, a frame at a time: the reply of
+ * a frame is read before the next one is sent, so the client
+ * never waits for the server while the server waits for it.
+ *
+-------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include "qe_served.h"
+#include "quadratic_equation.h"
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+struct qe_client {
+  int fd;
+  char *buf; /* A frame or a reply. */
+  size_t cap;
+};
+
+/*
+ * The function sends len bytes. In case of an error, it returns 1.
+ */
+static int send_all(int fd, const char *p, size_t len) {
+  while (len > 0) {
+    ssize_t k = send(fd, p, len, MSG_NOSIGNAL);
+
+    if ((k < 0) && (errno == EINTR))
+      continue;
+    if (k <= 0)
+      return 1;
+    p += k;
+    len -= (size_t)k;
+  }
+  return 0;
+}
+
+/*
+ * The function receives len bytes. In case of an error or the end
+ * of the connection, it returns 1.
+ */
+static int recv_all(int fd, char *p, size_t len) {
+  while (len > 0) {
+    ssize_t k = recv(fd, p, len, 0);
+
+    if ((k < 0) && (errno == EINTR))
+      continue;
+    if (k <= 0)
+      return 1;
+    p += k;
+    len -= (size_t)k;
+  }
+  return 0;
+}
+
+/* The function connects to the server at the socket path. */
+qe_client *qe_client_connect(const char *path) {
+  struct sockaddr_un addr;
+  qe_client *cl;
+
+  if ((path == NULL) || (strlen(path) >= sizeof(addr.sun_path)))
+    return NULL;
+
+  cl = calloc(1, sizeof(*cl));
+  if (cl == NULL)
+    return NULL;
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+
+  cl->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if ((cl->fd < 0) ||
+      (connect(cl->fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)) {
+    if (cl->fd >= 0)
+      close(cl->fd);
+    free(cl);
+    return NULL;
+  }
+
+  return cl;
+}
+
+/*
+ * The function solves one frame of n <= QE_SERVED_MAX_BATCH
+ * equations. In case of an error, it returns 1.
+ */
+static int solve_frame(qe_client *cl, const double *a, const double *b,
+                       const double *c, double *res1, double *res2,
+                       int *msg_id, size_t n, int prec) {
+  qe_served_header h = {QE_SERVED_MAGIC, (uint32_t)n, prec, 0};
+  size_t size = sizeof(h) + n * sizeof(qe_served_res);
+
+  /* The buffer holds the larger of the frame and the reply. */
+  if (size > cl->cap) {
+    char *buf = realloc(cl->buf, size);
+
+    if (buf == NULL)
+      return 1;
+    cl->buf = buf;
+    cl->cap = size;
+  }
+
+  memcpy(cl->buf, &h, sizeof(h));
+  for (size_t i = 0; i < n; i++) {
+    qe_served_eq eq = {a[i], b[i], c[i]};
+
+    memcpy(cl->buf + sizeof(h) + i * sizeof(eq), &eq, sizeof(eq));
+  }
+
+  if (send_all(cl->fd, cl->buf, sizeof(h) + n * sizeof(qe_served_eq)) ||
+      recv_all(cl->fd, cl->buf, size))
+    return 1;
+
+  memcpy(&h, cl->buf, sizeof(h));
+  if ((h.magic != QE_SERVED_MAGIC) || (h.n != n))
+    return 1;
+
+  for (size_t i = 0; i < n; i++) {
+    qe_served_res r;
+
+    memcpy(&r, cl->buf + sizeof(h) + i * sizeof(r), sizeof(r));
+    res1[i] = r.res1;
+    res2[i] = r.res2;
+    msg_id[i] = r.msg_id;
+  }
+  return 0;
+}
+
+/*
+ * Implementation of the qe_client_solve function. The equations are
+ * sent in frames of at most QE_SERVED_MAX_BATCH.
+ */
+int qe_client_solve(qe_client *cl, const double *a, const double *b,
+                    const double *c, double *res1, double *res2, int *msg_id,
+                    size_t n, int prec) {
+
+  /* Checking pointers for a non-NULL value. */
+  if ((cl == NULL) || (a == NULL) || (b == NULL) || (c == NULL) ||
+      (res1 == NULL) || (res2 == NULL) || (msg_id == NULL))
+    return QE_ERR_NULLPTR;
+
+  for (size_t i = 0; i < n; i += QE_SERVED_MAX_BATCH) {
+    size_t m = (n - i < QE_SERVED_MAX_BATCH) ? n - i : QE_SERVED_MAX_BATCH;
+
+    if (solve_frame(cl, a + i, b + i, c + i, res1 + i, res2 + i, msg_id + i,
+                    m, prec))
+      return QE_SERVED_ERR_IO;
+  }
+
+  return QE_BATCH_OK;
+}
+
+/* The function closes the connection and frees the client. */
+void qe_client_close(qe_client *cl) {
+
+  if (cl == NULL)
+    return;
+
+  close(cl->fd);
+  free(cl->buf);
+  free(cl);
+}
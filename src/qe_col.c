@@ -0,0 +1,367 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the columnar files
+ * of equations (qe_col). The format is described in qe_col.h.
+ *
+ * The writer collects a group of rows in memory and writes its
+ * three columns with pwrite at their places in the file; the
+ * result columns are not written at all, the file is extended by
+ * ftruncate at the end, so they are holes until the file is
+ * solved. The header is written last, so a file with a header
+ * is complete.
+ *
+ * The reader maps the whole file with MADV_SEQUENTIAL. The
+ * next group is requested with MADV_WILLNEED while the current
+ * one is processed, and a processed group is dropped with
+ * MADV_DONTNEED: for a shared file mapping this only unmaps the
+ * pages, the page cache keeps them (and writes back the
+ * results), so the process never holds more than a few groups.
+ *
+-------------------------------------------------------------*/
+
+#define _DEFAULT_SOURCE
+
+#include "qe_col.h"
+#include "quadratic_equation.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct qe_col_writer {
+  int fd;
+  int flags;
+  double *buf;   /* The columns a, b and c of the current group. */
+  size_t len;    /* The rows in the buffer. */
+  size_t groups; /* The groups written. */
+  int failed;
+};
+
+struct qe_col_file {
+  int fd;
+  char *map;
+  size_t size;
+  qe_col_header *hdr;
+  size_t groups;
+  int writable;
+};
+
+/* The function rounds size up to the alignment of the columns. */
+static size_t col_round(size_t size) {
+  return (size + QE_COL_ALIGN - 1) & ~(size_t)(QE_COL_ALIGN - 1);
+}
+
+/* The function returns the size of a group of m rows. */
+static size_t group_size(size_t m, int results) {
+  size_t len = col_round(m * sizeof(double));
+
+  return results ? 5 * len + col_round(m * sizeof(int)) : 3 * len;
+}
+
+/*
+ * The function returns the offset of the group g of a file whose
+ * groups have group rows.
+ */
+static size_t group_offset(size_t g, size_t group, int results) {
+  return QE_COL_ALIGN + g * group_size(group, results);
+}
+
+/* The function returns the size of a file of n rows. */
+static size_t file_size(size_t n, size_t group, int results) {
+  return group_offset(n / group, group, results) +
+         group_size(n % group, results);
+}
+
+/*
+ * The function writes len bytes at the offset off.
+ * In case of an error, it returns 1.
+ */
+static int write_at(int fd, const void *p, size_t len, size_t off) {
+  const char *q = p;
+
+  while (len > 0) {
+    ssize_t k = pwrite(fd, q, len, (off_t)off);
+
+    if ((k < 0) && (errno == EINTR))
+      continue;
+    if (k <= 0)
+      return 1;
+    q += k;
+    len -= (size_t)k;
+    off += (size_t)k;
+  }
+  return 0;
+}
+
+/* The function writes the buffered group to its place. */
+static void flush_group(qe_col_writer *w) {
+  size_t off = group_offset(w->groups, QE_COL_GROUP, w->flags);
+  size_t len = col_round(w->len * sizeof(double));
+
+  for (int k = 0; k < 3; k++)
+    if (write_at(w->fd, w->buf + (size_t)k * QE_COL_GROUP,
+                 w->len * sizeof(double), off + k * len))
+      w->failed = 1;
+
+  w->groups++;
+  w->len = 0;
+}
+
+/* The function creates the file and the buffer of a group. */
+qe_col_writer *qe_col_writer_create(const char *path, int flags) {
+  qe_col_writer *w;
+
+  if (path == NULL) {
+    errno = EINVAL;
+    return NULL;
+  }
+
+  w = calloc(1, sizeof(*w));
+  if (w == NULL)
+    return NULL;
+
+  w->flags = flags & QE_COL_RESULTS;
+  w->buf = malloc(3 * QE_COL_GROUP * sizeof(double));
+  w->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if ((w->buf == NULL) || (w->fd < 0)) {
+    if (w->fd >= 0)
+      close(w->fd);
+    free(w->buf);
+    free(w);
+    return NULL;
+  }
+
+  return w;
+}
+
+/* The function copies the rows into the buffer group by group. */
+int qe_col_writer_append(qe_col_writer *w, const double *a,
+                         const double *b, const double *c, size_t n) {
+
+  if ((w == NULL) || (a == NULL) || (b == NULL) || (c == NULL)) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  while (n > 0) {
+    size_t m = QE_COL_GROUP - w->len;
+
+    if (m > n)
+      m = n;
+
+    memcpy(w->buf + w->len, a, m * sizeof(double));
+    memcpy(w->buf + QE_COL_GROUP + w->len, b, m * sizeof(double));
+    memcpy(w->buf + 2 * QE_COL_GROUP + w->len, c, m * sizeof(double));
+    w->len += m;
+    a += m;
+    b += m;
+    c += m;
+    n -= m;
+
+    if (w->len == QE_COL_GROUP)
+      flush_group(w);
+  }
+
+  return w->failed ? -1 : 0;
+}
+
+/*
+ * The function writes the last group, sets the size of the file and
+ * writes the header.
+ */
+int qe_col_writer_close(qe_col_writer *w) {
+  qe_col_header hdr;
+  size_t n;
+  int failed;
+
+  if (w == NULL)
+    return -1;
+
+  n = w->groups * QE_COL_GROUP + w->len;
+  if (w->len > 0)
+    flush_group(w);
+
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.magic = QE_COL_MAGIC;
+  hdr.flags = (uint32_t)w->flags;
+  hdr.n = n;
+  hdr.group = QE_COL_GROUP;
+
+  failed = w->failed ||
+           (ftruncate(w->fd, (off_t)file_size(n, QE_COL_GROUP, w->flags)) !=
+            0) ||
+           write_at(w->fd, &hdr, sizeof(hdr), 0);
+  if (close(w->fd) != 0)
+    failed = 1;
+
+  free(w->buf);
+  free(w);
+  return failed ? -1 : 0;
+}
+
+/*
+ * The function checks the header against the size of the file. The
+ * number of rows is checked first, so the sizes can not overflow. A
+ * file marked solved must have the result columns.
+ */
+static int header_ok(const qe_col_header *hdr, size_t size) {
+  int results = (hdr->flags & QE_COL_RESULTS) != 0;
+
+  return (hdr->magic == QE_COL_MAGIC) && (hdr->group > 0) &&
+         (results || !(hdr->flags & QE_COL_SOLVED)) &&
+         (hdr->n <= size / (3 * sizeof(double))) &&
+         (file_size((size_t)hdr->n, hdr->group, results) <= size);
+}
+
+/* The function maps the file and checks its header. */
+qe_col_file *qe_col_open(const char *path, int writable) {
+  struct stat st;
+  qe_col_file *f;
+
+  if (path == NULL) {
+    errno = EINVAL;
+    return NULL;
+  }
+
+  f = calloc(1, sizeof(*f));
+  if (f == NULL)
+    return NULL;
+
+  f->writable = (writable != 0);
+  f->fd = open(path, f->writable ? O_RDWR : O_RDONLY);
+  if (f->fd < 0) {
+    free(f);
+    return NULL;
+  }
+
+  if ((fstat(f->fd, &st) != 0) || (st.st_size < QE_COL_ALIGN)) {
+    errno = EINVAL;
+    goto fail;
+  }
+
+  f->size = (size_t)st.st_size;
+  f->map = mmap(NULL, f->size, PROT_READ | (f->writable ? PROT_WRITE : 0),
+                MAP_SHARED, f->fd, 0);
+  if (f->map == MAP_FAILED)
+    goto fail;
+
+  f->hdr = (qe_col_header *)f->map;
+  if (!header_ok(f->hdr, f->size)) {
+    munmap(f->map, f->size);
+    errno = EINVAL;
+    goto fail;
+  }
+
+  f->groups = (size_t)((f->hdr->n + f->hdr->group - 1) / f->hdr->group);
+  madvise(f->map, f->size, MADV_SEQUENTIAL);
+  return f;
+
+fail:
+  close(f->fd);
+  free(f);
+  return NULL;
+}
+
+/* The function returns the header of the file. */
+const qe_col_header *qe_col_get_header(const qe_col_file *f) {
+  return (f == NULL) ? NULL : f->hdr;
+}
+
+/* The function returns the number of groups of the file. */
+size_t qe_col_groups(const qe_col_file *f) {
+  return (f == NULL) ? 0 : f->groups;
+}
+
+/* The function returns the number of rows of the group g. */
+static size_t group_rows(const qe_col_file *f, size_t g) {
+  size_t group = f->hdr->group;
+
+  return (g + 1 < f->groups) ? group : (size_t)(f->hdr->n - g * group);
+}
+
+/* The function returns the columns of the group g. */
+int qe_col_get_group(const qe_col_file *f, size_t g, qe_col_chunk *chunk) {
+  int results;
+  size_t m, len;
+  char *p;
+
+  if ((f == NULL) || (chunk == NULL) || (g >= f->groups))
+    return -1;
+
+  results = (f->hdr->flags & QE_COL_RESULTS) != 0;
+  m = group_rows(f, g);
+  len = col_round(m * sizeof(double));
+  p = f->map + group_offset(g, f->hdr->group, results);
+
+  chunk->a = (const double *)p;
+  chunk->b = (const double *)(p + len);
+  chunk->c = (const double *)(p + 2 * len);
+  chunk->res1 = results ? (double *)(p + 3 * len) : NULL;
+  chunk->res2 = results ? (double *)(p + 4 * len) : NULL;
+  chunk->msg_id = results ? (int *)(p + 5 * len) : NULL;
+  chunk->n = m;
+
+  /* The next group is read while this one is processed. */
+  if (g + 1 < f->groups)
+    madvise(f->map + group_offset(g + 1, f->hdr->group, results),
+            group_size(group_rows(f, g + 1), results), MADV_WILLNEED);
+
+  return 0;
+}
+
+/* The function drops the pages of the group g from the mapping. */
+void qe_col_release_group(const qe_col_file *f, size_t g) {
+  int results;
+
+  if ((f == NULL) || (g >= f->groups))
+    return;
+
+  results = (f->hdr->flags & QE_COL_RESULTS) != 0;
+  madvise(f->map + group_offset(g, f->hdr->group, results),
+          group_size(group_rows(f, g), results), MADV_DONTNEED);
+}
+
+/*
+ * Implementation of the qe_col_solve function. QE_COL_SOLVED is
+ * cleared first, so a file that was not solved to the end does not
+ * have it.
+ */
+int qe_col_solve(qe_col_file *f, qe_pool *pool, int prec) {
+
+  if ((f == NULL) || !f->writable || !(f->hdr->flags & QE_COL_RESULTS)) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  f->hdr->flags &= ~(uint32_t)QE_COL_SOLVED;
+
+  for (size_t g = 0; g < f->groups; g++) {
+    qe_col_chunk ch;
+
+    qe_col_get_group(f, g, &ch);
+    if (pool != NULL)
+      solve_equation_batch_parallel(pool, ch.a, ch.b, ch.c, ch.res1, ch.res2,
+                                    ch.msg_id, ch.n, prec);
+    else
+      solve_equation_batch_prec(ch.a, ch.b, ch.c, ch.res1, ch.res2,
+                                ch.msg_id, ch.n, prec);
+    qe_col_release_group(f, g);
+  }
+
+  f->hdr->prec = prec;
+  f->hdr->flags |= QE_COL_SOLVED;
+  return 0;
+}
+
+/* The function unmaps and closes the file. */
+void qe_col_close(qe_col_file *f) {
+  if (f == NULL)
+    return;
+
+  munmap(f->map, f->size);
+  close(f->fd);
+  free(f);
+}
@@ -0,0 +1,420 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the template of the classification
+ * kernel of the classify_equation_batch and
+ * classify_equation_select functions. It is included by the
+ * files of every instruction set after the batch kernels, with
+ * QE_COUNT defined to the name of the generated kernel (the
+ * other macros are described in qe_kernel.h). If V_COMPRESS_IDX
+ * is defined, the indices of the selected lanes are compacted by
+ * it, otherwise they are written one by one without branches.
+ *
+ * The kernel finds only the sign of the discriminant. In the
+ * QE_PREC_DOUBLE mode it is computed by the operations of
+ * qe_kernel_double.h, so it is exactly the one of
+ * qe_solve_double. In the QE_PREC_EXTENDED mode the exact
+ * discriminant is found as in qe_kernel.h; long double rounds
+ * the products b * b and 4 * a * c by at most 2^-64 of their
+ * value, so if the exact discriminant is farther from zero than
+ * that, it has the sign of the long double one. The lanes where
+ * it is not, and the lanes with huge, tiny, infinite and NaN
+ * parameters, are classified by classify_equation.
+ *
+ * If QE_COUNT_IN is defined, the file also generates the kernel of
+ * select_equation_roots_in with this name. It decides whether the
+ * roots of solve_equation_prec lie in [lo, hi] without computing
+ * them, by the signs of the polynomial at lo and hi and the side
+ * of the vertex -b / (2 * a). The computed roots differ from the
+ * exact ones by at most about 2^-50 * T / (|a| * sqrt(D)), where
+ * T = b * b + |4 * a * c| and D is the discriminant, so a sign is
+ * trusted only if |a * f(lo)| is larger than 2^-44 * T, larger
+ * than the rounding errors of f(lo), and the roots are not close
+ * (D >= 2^-40 * T). The other lanes are decided by
+ * equation_has_root_in, which solves the equation.
+ *
+-------------------------------------------------------------*/
+
+#include "qe_classify.h"
+#include "quadratic_equation.h"
+
+#ifndef QE_CAT
+#define QE_CAT_(x, y) x##y
+#define QE_CAT(x, y) QE_CAT_(x, y)
+#endif
+
+#define QE_COUNT_CLASS QE_CAT(QE_COUNT, _class)
+#define QE_COUNT_LANES QE_CAT(QE_COUNT, _lanes)
+#define QE_COUNT_IN_RANGE QE_CAT(QE_COUNT, _in_range)
+#define QE_COUNT_LOOP QE_CAT(QE_COUNT, _loop)
+#define QE_COUNT_END QE_CAT(QE_COUNT, _end)
+#define QE_COUNT_IN_LANES QE_CAT(QE_COUNT, _in_lanes)
+#define QE_COUNT_IN_LOOP QE_CAT(QE_COUNT, _in_loop)
+
+/*
+ * The function checks that the parameter is zero or its absolute
+ * value lies from lo to hi.
+ */
+static inline qe_vm QE_COUNT_IN_RANGE(qe_vd x, double lo, double hi) {
+  qe_vd ax = V_ABS(x);
+
+  return M_OR(V_CMPEQ(x, V_SET1(0.0)),
+              M_AND(V_CMPLE(V_SET1(lo), ax), V_CMPLE(ax, V_SET1(hi))));
+}
+
+/*
+ * The function classifies QE_W equations and returns their msg_id.
+ * The lanes that must be classified by classify_equation are set
+ * in fb; d gets the discriminant (rounded) and t gets
+ * b * b + |4 * a * c|.
+ */
+static inline __attribute__((always_inline)) qe_vd
+QE_COUNT_CLASS(qe_vd va, qe_vd vb, qe_vd vc, int prec, qe_vm *fb, qe_vd *d,
+               qe_vd *t) {
+  const qe_vd zero = V_SET1(0.0);
+  qe_vd p, dp, q, dq, r1, r2;
+  qe_vm za, zb, zc, quad, dpos, dzero;
+
+  za = V_CMPEQ(va, zero);
+  zb = V_CMPEQ(vb, zero);
+  zc = V_CMPEQ(vc, zero);
+  quad = M_AND(M_NOT(za), M_NOT(M_AND(zb, zc)));
+
+  V_TWO_PROD(p, dp, vb, vb);
+  V_TWO_PROD(q, dq, V_MUL(V_SET1(4.0), va), vc);
+  *t = V_ADD(p, V_ABS(q));
+
+  if (prec == QE_PREC_DOUBLE) {
+    *fb = M_NOT(M_AND(M_AND(QE_COUNT_IN_RANGE(va, 0x1p-450, 0x1p+450),
+                            QE_COUNT_IN_RANGE(vb, 0x1p-450, 0x1p+450)),
+                      QE_COUNT_IN_RANGE(vc, 0x1p-450, 0x1p+450)));
+
+    /* Kahan's method, as in qe_solve_double. */
+    *d = V_SUB(p, q);
+    *d = V_SEL(V_CMPLE(V_ADD(p, q), V_MUL(V_SET1(3.0), V_ABS(*d))), *d,
+               V_ADD(*d, V_SUB(dp, dq)));
+    dpos = V_CMPGT(*d, zero);
+    dzero = V_CMPEQ(*d, zero);
+  } else {
+    qe_vd s1, e1, u;
+    qe_vm exact;
+
+    *fb = M_NOT(M_AND(M_AND(QE_COUNT_IN_RANGE(va, 0x1p-240, 0x1p+240),
+                            QE_COUNT_IN_RANGE(vb, 0x1p-240, 0x1p+240)),
+                      QE_COUNT_IN_RANGE(vc, 0x1p-240, 0x1p+240)));
+
+    /*
+     * The exact discriminant p + dp - q - dq, rounded to d. If the
+     * products and their difference are exact, long double gets d
+     * itself, otherwise its sign is known if |d| is larger than the
+     * rounding errors of the products in long double.
+     */
+    s1 = V_SUB(p, q);
+    u = V_SUB(s1, p);
+    e1 = V_ADD(V_SUB(p, V_SUB(s1, u)), V_SUB(V_NEG(q), u));
+    *d = V_ADD(s1, V_SUB(V_ADD(e1, dp), dq));
+    exact = M_AND(M_AND(V_CMPEQ(dp, zero), V_CMPEQ(dq, zero)),
+                  V_CMPEQ(e1, zero));
+    *fb = M_OR(*fb, M_AND(M_AND(quad, M_NOT(exact)),
+                          V_CMPLE(V_ABS(*d), V_MUL(V_SET1(0x1p-62), *t))));
+    dpos = V_CMPGT(*d, zero);
+    dzero = M_AND(exact, V_CMPEQ(*d, zero));
+  }
+
+  /* The roots are not needed, the classification core gets zeros. */
+  return qe_classify(za, zb, zc, dpos, dzero, M_NONE, M_NONE, zero, zero,
+                     zero, &r1, &r2);
+}
+
+/*
+ * The function classifies QE_W equations, writes their msg_id if
+ * msg_id is not NULL and returns the bits of the lanes whose msg_id
+ * is one of the nwant values of want (the bit of the msg_id in
+ * classes).
+ */
+static inline __attribute__((always_inline)) unsigned int
+QE_COUNT_LANES(const double *a, const double *b, const double *c,
+               int *msg_id, int prec, unsigned int classes,
+               const qe_vd *want, int nwant) {
+  qe_vd d, t, msg;
+  qe_vm fb, sel;
+  unsigned int bits;
+
+  msg = QE_COUNT_CLASS(V_LOADU(a), V_LOADU(b), V_LOADU(c), prec, &fb, &d,
+                       &t);
+
+  bits = M_BITS(fb);
+  if (bits == 0) {
+    if (msg_id != NULL)
+      V_STORE_MSG(msg_id, msg);
+
+    sel = M_NONE;
+    for (int j = 0; j < nwant; j++)
+      sel = M_OR(sel, V_CMPEQ(msg, want[j]));
+    return M_BITS(sel);
+  } else {
+    int tm[QE_W];
+    unsigned int sel_bits = 0;
+
+    V_STORE_MSG(tm, msg);
+    for (int j = 0; j < QE_W; j++) {
+      if ((bits >> j) & 1)
+        tm[j] = classify_equation(a[j], b[j], c[j], prec);
+      sel_bits |= (unsigned int)((classes & QE_CLASS(tm[j])) != 0) << j;
+    }
+
+    if (msg_id != NULL)
+      for (int j = 0; j < QE_W; j++)
+        msg_id[j] = tm[j];
+    return sel_bits;
+  }
+}
+
+/*
+ * The loop of the kernel in one precision mode. The last incomplete
+ * vector is classified through temporary arrays, its lanes after the
+ * end are not selected.
+ */
+static inline __attribute__((always_inline)) size_t
+QE_COUNT_LOOP(const double *a, const double *b, const double *c,
+              int *msg_id, unsigned int classes, size_t *idx, size_t n,
+              int prec) {
+  qe_vd want[6];
+  int nwant = 0;
+  size_t i, k = 0, rest;
+
+  for (int m = QE_ERR_OVERFLOW; m <= QE_OK_CPLX_RES; m++)
+    if (classes & QE_CLASS(m))
+      want[nwant++] = V_SET1((double)m);
+  if (idx == NULL)
+    nwant = 0;
+
+  for (i = 0; i + QE_W <= n; i += QE_W) {
+    int *m = (msg_id != NULL) ? msg_id + i : NULL;
+    unsigned int bits =
+        QE_COUNT_LANES(a + i, b + i, c + i, m, prec, classes, want, nwant);
+
+    /* The writes stay below idx + i + QE_W, so inside the array. */
+    if (idx != NULL) {
+#if defined(V_COMPRESS_IDX)
+      V_COMPRESS_IDX(idx + k, bits, i);
+      k += (size_t)__builtin_popcount(bits);
+#else
+      for (int j = 0; j < QE_W; j++) {
+        idx[k] = i + (size_t)j;
+        k += (bits >> j) & 1;
+      }
+#endif
+    }
+  }
+
+  rest = n - i;
+  if (rest > 0) {
+    double ta[QE_W] = {0}, tb[QE_W] = {0}, tc[QE_W] = {0};
+    int tm[QE_W];
+    unsigned int bits;
+
+    for (size_t j = 0; j < rest; j++) {
+      ta[j] = a[i + j];
+      tb[j] = b[i + j];
+      tc[j] = c[i + j];
+    }
+
+    bits = QE_COUNT_LANES(ta, tb, tc, tm, prec, classes, want, nwant);
+
+    for (size_t j = 0; j < rest; j++) {
+      if (msg_id != NULL)
+        msg_id[i + j] = tm[j];
+      if ((idx != NULL) && ((bits >> j) & 1))
+        idx[k++] = i + j;
+    }
+  }
+
+  return k;
+}
+
+/*
+ * The kernel. The msg_id are written if msg_id is not NULL, the
+ * indices of the classes if idx is not NULL; returns their number.
+ */
+size_t QE_COUNT(const double *a, const double *b, const double *c,
+                int *msg_id, unsigned int classes, size_t *idx, size_t n,
+                int prec) {
+  if (prec == QE_PREC_DOUBLE)
+    return QE_COUNT_LOOP(a, b, c, msg_id, classes, idx, n, QE_PREC_DOUBLE);
+  return QE_COUNT_LOOP(a, b, c, msg_id, classes, idx, n, QE_PREC_EXTENDED);
+}
+
+#if defined(QE_COUNT_IN)
+
+/*
+ * The function evaluates the equations at the end x of the interval
+ * (side is -1 for lo and 1 for hi). f gets f(x) and rf the lanes
+ * where its sign is certain for the computed roots; xv gets
+ * -b - 2 * a * x, the vertex is above x where xv * a > 0, and rv
+ * gets the lanes where its sign is certain. At an infinite end f and
+ * xv only have the signs of the limits.
+ */
+static inline __attribute__((always_inline)) void
+QE_COUNT_END(qe_vd va, qe_vd vb, qe_vd vc, qe_vd t, double x, int side,
+             qe_vd *f, qe_vm *rf, qe_vd *xv, qe_vm *rv) {
+  const qe_vd zero = V_SET1(0.0);
+  qe_vd vx, ax, af, tx;
+
+  if (isinf(x)) {
+    *f = V_SEL(V_CMPEQ(va, zero), V_MUL(vb, V_SET1(x)), va);
+    *xv = V_MUL(va, V_SET1((side * x > 0) ? -side : side));
+    *rf = *rv = V_CMPEQ(zero, zero);
+    return;
+  }
+
+  vx = V_SET1(x);
+  ax = V_ABS(vx);
+  tx = V_MUL(V_MUL(V_SET1(2.0), va), vx);
+
+  /*
+   * f(x) by Horner's scheme, its rounding errors are below 2^-50 * F,
+   * F = |a| * x^2 + |b * x| + |c|. The products of the signs below do
+   * not underflow if |f(x)| > 2^-500.
+   */
+  *f = V_ADD(V_MUL(V_ADD(V_MUL(va, vx), vb), vx), vc);
+  af = V_ABS(*f);
+  *rf = M_AND(M_AND(V_CMPGT(af, V_SET1(0x1p-500)),
+                    V_CMPGT(af, V_MUL(V_SET1(0x1p-44),
+                                      V_ADD(V_MUL(V_ADD(V_MUL(V_ABS(va), ax),
+                                                        V_ABS(vb)),
+                                                  ax),
+                                            V_ABS(vc))))),
+              M_OR(V_CMPEQ(va, zero), V_CMPGT(V_ABS(V_MUL(va, *f)),
+                                              V_MUL(V_SET1(0x1p-44), t))));
+
+  *xv = V_SUB(V_NEG(vb), tx);
+  *rv = V_CMPGT(V_ABS(*xv),
+                V_MUL(V_SET1(0x1p-48), V_ADD(V_ABS(vb), V_ABS(tx))));
+}
+
+/*
+ * The function returns the bits of the lanes of QE_W equations that
+ * have a root in [lo, hi] (lo <= hi). The uncertain lanes are decided
+ * by equation_has_root_in.
+ */
+static inline __attribute__((always_inline)) unsigned int
+QE_COUNT_IN_LANES(const double *a, const double *b, const double *c,
+                  double lo, double hi, int prec) {
+  const qe_vd zero = V_SET1(0.0);
+  qe_vd va, vb, vc, d, t, msg, flo, fhi, xlo, xhi;
+  qe_vm fb, za, two, one, sel, amb, rlo, rhi, rvlo, rvhi, diff, both, vin,
+      sep;
+  unsigned int bits, amb_bits;
+
+  va = V_LOADU(a);
+  vb = V_LOADU(b);
+  vc = V_LOADU(c);
+  msg = QE_COUNT_CLASS(va, vb, vc, prec, &fb, &d, &t);
+
+  za = V_CMPEQ(va, zero);
+  two = V_CMPEQ(msg, V_SET1((double)QE_OK_TWO_RES));
+  one = V_CMPEQ(msg, V_SET1((double)QE_OK_ONE_RES));
+
+  QE_COUNT_END(va, vb, vc, t, lo, -1, &flo, &rlo, &xlo, &rvlo);
+  QE_COUNT_END(va, vb, vc, t, hi, 1, &fhi, &rhi, &xhi, &rvhi);
+
+  /*
+   * The signs at the ends differ, or a * f is positive at both ends
+   * (the parabola opens upwards) and the vertex lies between them.
+   */
+  diff = V_CMPLT(V_MUL(flo, fhi), zero);
+  both = M_AND(V_CMPGT(V_MUL(va, flo), zero), V_CMPGT(V_MUL(va, fhi), zero));
+  vin = M_AND(V_CMPGT(V_MUL(va, xlo), zero), V_CMPLT(V_MUL(va, xhi), zero));
+  sep = M_AND(V_CMPLE(V_MUL(V_SET1(0x1p-40), t), d),
+              V_CMPLE(V_SET1(0x1p-800), t));
+
+  /*
+   * Two roots: one of them is inside if the signs differ, both are
+   * inside if g is positive at the ends and the vertex is inside.
+   * One root of a quadratic: the vertex. One root of a linear
+   * equation: the signs differ.
+   */
+  sel = M_OR(M_OR(M_AND(two, M_OR(diff, M_AND(both, vin))),
+                  M_AND(one, M_OR(M_AND(za, diff), M_AND(M_NOT(za), vin)))),
+             V_CMPEQ(msg, V_SET1((double)QE_OK_INF_RES)));
+  amb = M_OR(M_AND(two, M_NOT(M_AND(M_AND(rlo, rhi), sep))),
+             M_AND(M_OR(M_AND(two, both), M_AND(one, M_NOT(za))),
+                   M_NOT(M_AND(rvlo, rvhi))));
+  amb = M_OR(amb, M_AND(M_AND(one, za), M_NOT(M_AND(rlo, rhi))));
+
+  bits = M_BITS(sel);
+  amb_bits = M_BITS(M_OR(amb, fb));
+  if (amb_bits != 0)
+    for (int j = 0; j < QE_W; j++)
+      if ((amb_bits >> j) & 1) {
+        bits &= ~(1u << j);
+        bits |= (unsigned int)(equation_has_root_in(a[j], b[j], c[j], lo, hi,
+                                                    prec) != 0)
+                << j;
+      }
+
+  return bits;
+}
+
+/* The loop of the kernel in one precision mode, as QE_COUNT_LOOP. */
+static inline __attribute__((always_inline)) size_t
+QE_COUNT_IN_LOOP(const double *a, const double *b, const double *c,
+                 double lo, double hi, size_t *idx, size_t n, int prec) {
+  size_t i, k = 0, rest;
+
+  for (i = 0; i + QE_W <= n; i += QE_W) {
+    unsigned int bits = QE_COUNT_IN_LANES(a + i, b + i, c + i, lo, hi, prec);
+
+#if defined(V_COMPRESS_IDX)
+    V_COMPRESS_IDX(idx + k, bits, i);
+    k += (size_t)__builtin_popcount(bits);
+#else
+    for (int j = 0; j < QE_W; j++) {
+      idx[k] = i + (size_t)j;
+      k += (bits >> j) & 1;
+    }
+#endif
+  }
+
+  rest = n - i;
+  if (rest > 0) {
+    double ta[QE_W] = {0}, tb[QE_W] = {0}, tc[QE_W] = {0};
+    unsigned int bits;
+
+    for (size_t j = 0; j < rest; j++) {
+      ta[j] = a[i + j];
+      tb[j] = b[i + j];
+      tc[j] = c[i + j];
+    }
+
+    bits = QE_COUNT_IN_LANES(ta, tb, tc, lo, hi, prec);
+    for (size_t j = 0; j < rest; j++)
+      if ((bits >> j) & 1)
+        idx[k++] = i + j;
+  }
+
+  return k;
+}
+
+/*
+ * The kernel of select_equation_roots_in: writes the indices of the
+ * equations with a root in [lo, hi] to idx and returns their number.
+ */
+size_t QE_COUNT_IN(const double *a, const double *b, const double *c,
+                   double lo, double hi, size_t *idx, size_t n, int prec) {
+  if (!(lo <= hi))
+    return 0;
+  if (prec == QE_PREC_DOUBLE)
+    return QE_COUNT_IN_LOOP(a, b, c, lo, hi, idx, n, QE_PREC_DOUBLE);
+  return QE_COUNT_IN_LOOP(a, b, c, lo, hi, idx, n, QE_PREC_EXTENDED);
+}
+
+#endif
+
+#undef QE_COUNT_CLASS
+#undef QE_COUNT_LANES
+#undef QE_COUNT_IN_RANGE
+#undef QE_COUNT_LOOP
+#undef QE_COUNT_END
+#undef QE_COUNT_IN_LANES
+#undef QE_COUNT_IN_LOOP
@@ -0,0 +1,356 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the
+ * solve_equation_prec function and of the QE_PREC_DOUBLE
+ * mode (qe_solve_double).
+ *
+ * In addition, the file contains the solve_equation_complex
+ * function: the complex roots are computed in double
+ * precision in both modes (qe_complex_roots), and the
+ * classify_equation function.
+ *
+ * In this mode the equation is solved without long double.
+ * The discriminant b * b - 4 * a * c is computed by Kahan's
+ * method: if the products are close, they are split into a double
+ * and its exact rounding error (qe_two_prod), their difference is
+ * exact, and the errors are added to it.
+ * The roots are computed by the formula without cancellation:
+ *
+ *   q = -(b + sign(b) * sqrt(D)) / 2,   x = q / a,   x = c / q.
+ *
+ * If a parameter is huge or tiny, the equation is scaled by
+ * powers of two (solve_scaled), so no intermediate value
+ * overflows, and the overflow is detected by the roots themselves.
+ *
+-------------------------------------------------------------*/
+
+#include "qe_internal.h"
+#include "quadratic_equation.h"
+#include <stdlib.h>
+
+/*
+ * The function computes b * b - 4 * a * c by Kahan's method. If the
+ * difference of the rounded products is not much smaller than their
+ * sum, it is accurate already. Otherwise the rounding errors of the
+ * products are added to it. The parameters must not be huge or tiny.
+ */
+static inline double discriminant(double a, double b, double c) {
+  double p, dp, q, dq, d;
+
+  p = b * b;
+  q = 4.0 * a * c;
+  d = p - q;
+  if (3.0 * fabs(d) >= p + q)
+    return d;
+
+  qe_two_prod(b, b, &p, &dp);
+  qe_two_prod(4.0 * a, c, &q, &dq);
+
+  return (p - q) + (dp - dq);
+}
+
+/*
+ * Implementation of the solve_equation_prec function. In the
+ * QE_PREC_EXTENDED mode solve_equation itself is called.
+ */
+int solve_equation_prec(double a, double b, double c, double *res1,
+                        double *res2, int prec) {
+
+  if (prec != QE_PREC_DOUBLE)
+    return solve_equation(a, b, c, res1, res2);
+
+  /* Checking pointers for a non-NULL value. */
+  if ((res1 == NULL) || (res2 == NULL))
+    return QE_ERR_NULLPTR;
+
+  return qe_solve_double(a, b, c, res1, res2);
+}
+
+/*
+ * The function writes the roots of the equation with two roots:
+ * q / a and c / q, where q = -(b + sign(b) * sqrt(d)) / 2. If b is
+ * negative, q / a is res1, as in solve_equation. If c is zero,
+ * the root c / q is +0, also as in solve_equation.
+ */
+static inline void write_roots(double a, double b, double c, double d,
+                               double *res1, double *res2) {
+  double s, q, big, small;
+  int neg = (b < 0);
+
+  /* The sign of b is random on most data, the selects are masks. */
+  s = sqrt(d);
+  q = qe_select_double(neg, 0.5 * (s - b), -0.5 * (b + s));
+  big = q / a;
+  small = c / q + 0.0;
+
+  *res1 = qe_select_double(neg, big, small);
+  *res2 = qe_select_double(neg, small, big);
+}
+
+/*
+ * The function scales the equation with a non-zero `a`: a = sa * 2^ea,
+ * b = sb * 2^e and c = sc * 2^(2 * e - ea), where the larger of |sb|
+ * and sqrt(|sa * sc|) is close to 1. The roots of the equation are
+ * the roots of the scaled one multiplied by 2^(e - ea).
+ */
+static void scale_equation(double a, double b, double c, double *sa,
+                           double *sb, double *sc, int *ea, int *e) {
+  int ec = (c != 0) ? ilogb(c) : 0;
+
+  *ea = ilogb(a);
+  *e = (b != 0) ? ilogb(b) : ((*ea + ec) >> 1) + 1;
+  if ((c != 0) && (*e < ((*ea + ec) >> 1) + 1))
+    *e = ((*ea + ec) >> 1) + 1;
+
+  *sa = scalbn(a, -*ea);
+  *sb = scalbn(b, -*e);
+  *sc = scalbn(c, *ea - 2 * *e);
+}
+
+/*
+ * The function solves the equation with huge or tiny parameters.
+ * The equation is scaled by scale_equation, so no intermediate
+ * value overflows. The overflow is detected by the roots themselves.
+ *
+ * Such parameters are rare, the function is not inlined so that
+ * the usual path does not save registers for its library calls.
+ */
+__attribute__((noinline)) static int solve_scaled(double a, double b,
+                                                  double c, double *res1,
+                                                  double *res2) {
+  double sa, sb, sc, d, root;
+  int ea, ec, e;
+
+  ec = (c != 0) ? ilogb(c) : 0;
+  scale_equation(a, b, c, &sa, &sb, &sc, &ea, &e);
+
+  d = discriminant(sa, sb, sc);
+
+  if (d < 0)
+    return QE_OK_NO_RES;
+
+  /* The discriminant is zero, one root -b / (2 * a). */
+  if (d == 0) {
+    root = scalbn(-sb / (2.0 * sa), e - ea);
+    if (isinf(root))
+      return QE_ERR_OVERFLOW;
+
+    *res1 = *res2 = root;
+    return QE_OK_ONE_RES;
+  }
+
+  /*
+   * The roots are computed for the scaled equation, but c is taken
+   * as cm * 2^ec, so that the small root does not lose its bits if
+   * sc is subnormal.
+   */
+  write_roots(sa, sb, scalbn(c, -ec), d, res1, res2);
+  if (sb < 0) {
+    *res1 = scalbn(*res1, e - ea);
+    *res2 = scalbn(*res2, ec - e);
+  } else {
+    *res1 = scalbn(*res1, ec - e);
+    *res2 = scalbn(*res2, e - ea);
+  }
+
+  if (isinf(*res1) || isinf(*res2)) {
+    *res1 = *res2 = QE_STD_VAL_RES;
+    return QE_ERR_OVERFLOW;
+  }
+  return QE_OK_TWO_RES;
+}
+
+/*
+ * The function solves the equation in the QE_PREC_DOUBLE mode.
+ * The special cases are the same as in solve_equation.
+ */
+static inline __attribute__((always_inline)) int
+solve_double(double a, double b, double c, double *res1, double *res2) {
+  double d, root;
+
+  *res1 = *res2 = QE_STD_VAL_RES;
+
+  /* Infinite and NaN parameters are considered an overflow. */
+  if (!isfinite(a) || !isfinite(b) || !isfinite(c)) {
+    QE_STATS_BRANCH(QE_STATS_BR_NOT_FINITE);
+    return QE_ERR_OVERFLOW;
+  }
+
+  /* The special cases, as in solve_equation. */
+  if ((a == 0) && (b == 0)) {
+    QE_STATS_BRANCH((c == 0) ? QE_STATS_BR_ALL_ZERO : QE_STATS_BR_ONLY_C);
+    return (c == 0) ? QE_OK_INF_RES : QE_OK_NO_RES;
+  }
+
+  if ((c == 0) && ((a == 0) || (b == 0))) {
+    QE_STATS_BRANCH((a == 0) ? QE_STATS_BR_ONLY_B : QE_STATS_BR_ONLY_A);
+    *res1 = *res2 = 0;
+    return QE_OK_ONE_RES;
+  }
+
+  /* Only `a` is zero. */
+  if (a == 0) {
+    QE_STATS_BRANCH(QE_STATS_BR_LINEAR);
+    root = -c / b;
+    if (isinf(root))
+      return QE_ERR_OVERFLOW;
+
+    *res1 = *res2 = root;
+    return QE_OK_ONE_RES;
+  }
+
+  if (!qe_in_range(a) || !qe_in_range(b) || !qe_in_range(c)) {
+    QE_STATS_BRANCH(QE_STATS_BR_SCALED);
+    return solve_scaled(a, b, c, res1, res2);
+  }
+
+  d = discriminant(a, b, c);
+
+  if (d < 0) {
+    QE_STATS_BRANCH(QE_STATS_BR_DISC_NEG);
+    return QE_OK_NO_RES;
+  }
+
+  /* The discriminant is zero, one root -b / (2 * a). */
+  if (d == 0) {
+    QE_STATS_BRANCH(QE_STATS_BR_DISC_ZERO);
+    *res1 = *res2 = -b / (2.0 * a);
+    return QE_OK_ONE_RES;
+  }
+
+  QE_STATS_BRANCH(QE_STATS_BR_DISC_POS);
+  write_roots(a, b, c, d, res1, res2);
+  return QE_OK_TWO_RES;
+}
+
+/*
+ * The function solves the equation in the QE_PREC_DOUBLE mode. If
+ * the library is built with QE_STATS, the call is counted.
+ */
+int qe_solve_double(double a, double b, double c, double *res1,
+                    double *res2) {
+#if defined(QE_STATS)
+  uint64_t start = qe_stats_begin();
+  int msg_id = solve_double(a, b, c, res1, res2);
+
+  qe_stats_end(start, msg_id);
+  return msg_id;
+#else
+  return solve_double(a, b, c, res1, res2);
+#endif
+}
+
+/*
+ * The function classifies the equation like qe_solve_double: the
+ * special cases are the same, and the sign of the discriminant is
+ * found in the same way, of the scaled equation if a parameter is
+ * huge or tiny.
+ */
+int qe_classify_double(double a, double b, double c) {
+  double sa, sb, sc, d;
+  int ea, e;
+
+  if (!isfinite(a) || !isfinite(b) || !isfinite(c))
+    return QE_ERR_OVERFLOW;
+
+  if ((a == 0) && (b == 0))
+    return (c == 0) ? QE_OK_INF_RES : QE_OK_NO_RES;
+
+  if ((a == 0) || ((b == 0) && (c == 0)))
+    return QE_OK_ONE_RES;
+
+  if (qe_in_range(a) && qe_in_range(b) && qe_in_range(c))
+    d = discriminant(a, b, c);
+  else {
+    scale_equation(a, b, c, &sa, &sb, &sc, &ea, &e);
+    d = discriminant(sa, sb, sc);
+  }
+
+  if (d < 0)
+    return QE_OK_NO_RES;
+  return (d == 0) ? QE_OK_ONE_RES : QE_OK_TWO_RES;
+}
+
+/*
+ * Implementation of the classify_equation function. In the
+ * QE_PREC_EXTENDED mode the equation is classified like
+ * solve_equation.
+ */
+int classify_equation(double a, double b, double c, int prec) {
+  if (prec == QE_PREC_DOUBLE)
+    return qe_classify_double(a, b, c);
+  return qe_classify_extended(a, b, c);
+}
+
+/*
+ * The function computes the complex roots re +- i * im. The sign of
+ * the discriminant was found by the solver of the mode, here it may
+ * be computed differently near zero, so |D| is taken. The real part
+ * is +0 rather than -0 if b is zero.
+ */
+int qe_complex_roots(double a, double b, double c, double *re, double *im) {
+  double sa, sb, sc, d, ma, mb;
+  int ea, e, fa, fb;
+
+  if (qe_in_range(a) && qe_in_range(b) && qe_in_range(c)) {
+    d = discriminant(a, b, c);
+    *re = -b / (2.0 * a) + 0.0;
+    *im = sqrt(fabs(d)) / fabs(2.0 * a);
+    return QE_OK_CPLX_RES;
+  }
+
+  /*
+   * The common scale of b keeps b * b and 4 * a * c in range, but
+   * sb underflows if b is much smaller than sqrt(|a * c|). The real
+   * part takes the exponents of a and b separately.
+   */
+  scale_equation(a, b, c, &sa, &sb, &sc, &ea, &e);
+  d = discriminant(sa, sb, sc);
+  ma = frexp(a, &fa);
+  mb = frexp(b, &fb);
+  *re = scalbn(-mb / (2.0 * ma), fb - fa) + 0.0;
+  *im = scalbn(sqrt(fabs(d)) / fabs(2.0 * sa), e - ea);
+
+  if (isinf(*re) || isinf(*im)) {
+    *re = *im = QE_STD_VAL_RES;
+    return QE_ERR_OVERFLOW;
+  }
+  return QE_OK_CPLX_RES;
+}
+
+/*
+ * The function solves the equation like solve_equation_complex. The
+ * real roots are found by the solver of the mode. Its QE_OK_NO_RES
+ * with a non-zero `a` means a negative discriminant (or a not finite
+ * parameter in the QE_PREC_EXTENDED mode, then nothing changes).
+ */
+int qe_solve_complex(double a, double b, double c, double *res1,
+                     double *res2, double *im, int prec) {
+  int msg_id;
+
+  msg_id = (prec == QE_PREC_DOUBLE) ? qe_solve_double(a, b, c, res1, res2)
+                                    : solve_equation(a, b, c, res1, res2);
+  *im = 0;
+
+  if ((msg_id == QE_OK_NO_RES) && (a != 0) && isfinite(a) && isfinite(b) &&
+      isfinite(c)) {
+    msg_id = qe_complex_roots(a, b, c, res1, im);
+    *res2 = *res1;
+  }
+
+  return msg_id;
+}
+
+/*
+ * Implementation of the solve_equation_complex function
+ * that solves the equation on the complex plane.
+ */
+int solve_equation_complex(double a, double b, double c, double *res1,
+                           double *res2, double *im, int prec) {
+
+  /* Checking pointers for a non-NULL value. */
+  if ((res1 == NULL) || (res2 == NULL) || (im == NULL))
+    return QE_ERR_NULLPTR;
+
+  return qe_solve_complex(a, b, c, res1, res2, im, prec);
+}
@@ -0,0 +1,437 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the declarations that are shared
+ * between the source files of the library, but are not
+ * a part of its public interface.
+ *
+ * These are the batch kernels generated from qe_kernel.h and
+ * qe_kernel_double.h for every supported instruction set, the
+ * double precision and complex solvers shared by them and small
+ * helpers.
+ *
+-------------------------------------------------------------*/
+
+#ifndef QE_INTERNAL_H
+#define QE_INTERNAL_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * The function returns t if m is not zero and f otherwise.
+ * The value is selected by a bit mask, without branches.
+ */
+static inline double qe_select_double(int m, double t, double f) {
+  uint64_t mask = -(uint64_t)(m != 0), ut, uf;
+
+  memcpy(&ut, &t, sizeof(ut));
+  memcpy(&uf, &f, sizeof(uf));
+  ut = (ut & mask) | (uf & ~mask);
+  memcpy(&t, &ut, sizeof(t));
+  return t;
+}
+
+/*
+ * The function computes p and e such that p + e == x * y exactly
+ * (if the product is far from overflow and underflow). With a fused
+ * multiply-add it is one instruction, otherwise Dekker's algorithm
+ * with Veltkamp's splitting is used.
+ */
+static inline void qe_two_prod(double x, double y, double *p, double *e) {
+#if defined(FP_FAST_FMA)
+  *p = x * y;
+  *e = fma(x, y, -*p);
+#else
+  const double split = 134217729.0;
+  double t, xh, xl, yh, yl;
+
+  t = split * x;
+  xh = t - (t - x);
+  xl = x - xh;
+  t = split * y;
+  yh = t - (t - y);
+  yl = y - yh;
+
+  *p = x * y;
+  *e = (((xh * yh - *p) + xh * yl) + xl * yh) + xl * yl;
+#endif
+}
+
+/*
+ * The function checks that the parameter is zero or lies in the
+ * range where the equation can be solved in the QE_PREC_DOUBLE mode
+ * without scaling (the same range is used by the batch kernels).
+ */
+static inline int qe_in_range(double x) {
+  double ax = fabs(x);
+
+  return (x == 0) || ((ax >= 0x1p-450) && (ax <= 0x1p+450));
+}
+
+#if defined(QE_STATS)
+#include "qe_stats.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/*
+ * The counters of one thread (qe_stats.c). Only the thread writes
+ * them, so a counter is incremented by a plain load and store.
+ */
+typedef struct qe_stats_counters {
+  uint64_t calls;
+  uint64_t status[QE_STATS_STATUSES];
+  uint64_t branch[QE_STATS_BRANCHES];
+  uint64_t latency[QE_STATS_BUCKETS];
+  uint64_t samples, cycles;
+  struct qe_stats_counters *next; /* The list of all the counters. */
+  int used;                       /* Whether a thread owns them. */
+} qe_stats_counters;
+
+/* The counters of the calling thread, NULL before its first call. */
+extern __thread qe_stats_counters *qe_stats_thread;
+
+/* The function gives the calling thread its counters. */
+qe_stats_counters *qe_stats_attach(void);
+
+/* The function adds one to a counter of the calling thread. */
+static inline void qe_stats_inc(uint64_t *counter) {
+  __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + 1,
+                   __ATOMIC_RELAXED);
+}
+
+/* The function returns the counters of the calling thread. */
+static inline qe_stats_counters *qe_stats_get(void) {
+  qe_stats_counters *s = qe_stats_thread;
+
+  return (s != NULL) ? s : qe_stats_attach();
+}
+
+/*
+ * The function counts a call of a solver. It returns the time stamp
+ * counter if the call is sampled and 0 otherwise.
+ */
+static inline uint64_t qe_stats_begin(void) {
+  qe_stats_counters *s = qe_stats_get();
+  uint64_t calls = s->calls;
+
+  __atomic_store_n(&s->calls, calls + 1, __ATOMIC_RELAXED);
+#if defined(__x86_64__) || defined(__i386__)
+  if ((calls & (QE_STATS_SAMPLE_PERIOD - 1)) == 0)
+    return __rdtsc() | 1;
+#endif
+  return 0;
+}
+
+/* The function counts the msg_id and the time of a call. */
+static inline void qe_stats_end(uint64_t start, int msg_id) {
+  qe_stats_counters *s = qe_stats_thread;
+
+  qe_stats_inc(&s->status[msg_id - QE_ERR_NULLPTR]);
+#if defined(__x86_64__) || defined(__i386__)
+  if (start != 0) {
+    uint64_t cycles = __rdtsc() - start;
+    int bucket = (cycles == 0) ? 0 : 64 - __builtin_clzll(cycles);
+
+    if (bucket >= QE_STATS_BUCKETS)
+      bucket = QE_STATS_BUCKETS - 1;
+    qe_stats_inc(&s->latency[bucket]);
+    qe_stats_inc(&s->samples);
+    __atomic_store_n(&s->cycles,
+                     __atomic_load_n(&s->cycles, __ATOMIC_RELAXED) + cycles,
+                     __ATOMIC_RELAXED);
+  }
+#endif
+}
+
+/* Counts a branch of a solver. */
+#define QE_STATS_BRANCH(br) qe_stats_inc(&qe_stats_thread->branch[br])
+#else
+#define QE_STATS_BRANCH(br) ((void)0)
+#endif
+
+/*
+ * The function solves the equation in the QE_PREC_DOUBLE mode.
+ * The pointers are already checked for a non-NULL value.
+ */
+int qe_solve_double(double a, double b, double c, double *res1, double *res2);
+
+/*
+ * The functions classify the equation like classify_equation in the
+ * QE_PREC_EXTENDED and the QE_PREC_DOUBLE mode.
+ */
+int qe_classify_extended(double a, double b, double c);
+int qe_classify_double(double a, double b, double c);
+
+/*
+ * The function computes the complex roots re +- i * im of the
+ * equation with finite parameters, a non-zero `a` and a negative
+ * discriminant (see solve_equation_complex). Returns
+ * QE_OK_CPLX_RES or QE_ERR_OVERFLOW.
+ */
+int qe_complex_roots(double a, double b, double c, double *re, double *im);
+
+/*
+ * The function solves the equation like solve_equation_complex.
+ * The pointers are already checked for a non-NULL value.
+ */
+int qe_solve_complex(double a, double b, double c, double *res1,
+                     double *res2, double *im, int prec);
+
+/*
+ * The type of the batch kernels. The kernel solves n equations,
+ * the pointers are already checked for a non-NULL value. If im is
+ * NULL, the equations are solved like solve_equation_prec,
+ * otherwise like solve_equation_complex.
+ */
+typedef void (*qe_batch_kernel)(const double *a, const double *b,
+                                const double *c, double *res1, double *res2,
+                                double *im, int *msg_id, size_t n);
+
+/* Batch kernels for every instruction set. */
+void qe_batch_kernel_generic(const double *a, const double *b,
+                             const double *c, double *res1, double *res2,
+                             double *im, int *msg_id, size_t n);
+
+#if defined(QE_HAVE_X86_KERNELS)
+void qe_batch_kernel_sse2(const double *a, const double *b, const double *c,
+                          double *res1, double *res2, double *im, int *msg_id,
+                          size_t n);
+void qe_batch_kernel_avx2(const double *a, const double *b, const double *c,
+                          double *res1, double *res2, double *im, int *msg_id,
+                          size_t n);
+void qe_batch_kernel_avx512(const double *a, const double *b,
+                            const double *c, double *res1, double *res2,
+                            double *im, int *msg_id, size_t n);
+#endif
+
+/* Batch kernels of the QE_PREC_DOUBLE mode. */
+void qe_batch_kernel_generic_double(const double *a, const double *b,
+                                    const double *c, double *res1,
+                                    double *res2, double *im, int *msg_id,
+                                    size_t n);
+
+#if defined(QE_HAVE_X86_KERNELS)
+void qe_batch_kernel_sse2_double(const double *a, const double *b,
+                                 const double *c, double *res1, double *res2,
+                                 double *im, int *msg_id, size_t n);
+void qe_batch_kernel_avx2_double(const double *a, const double *b,
+                                 const double *c, double *res1, double *res2,
+                                 double *im, int *msg_id, size_t n);
+void qe_batch_kernel_avx512_double(const double *a, const double *b,
+                                   const double *c, double *res1,
+                                   double *res2, double *im, int *msg_id,
+                                   size_t n);
+#endif
+
+/*
+ * The shared parameters of the fixed kernels: the equations
+ * a * x^2 + b[i] * x + c[i] = 0, or a * x^2 + b * x + c[i] = 0
+ * if fixed_b is set (then the array b is not used).
+ */
+typedef struct {
+  double a;
+  double b;
+  int fixed_b;
+} qe_fixed;
+
+/*
+ * The type of the fixed kernels (QE_KERNEL_fixed of qe_kernel.h and
+ * qe_kernel_double.h). The kernel solves n equations like the batch
+ * kernel of its precision mode, the pointers are already checked.
+ */
+typedef void (*qe_fixed_kernel)(const qe_fixed *fx, const double *b,
+                                const double *c, double *res1, double *res2,
+                                int *msg_id, size_t n);
+
+#if defined(QE_HAVE_X86_KERNELS)
+void qe_batch_kernel_sse2_fixed(const qe_fixed *fx, const double *b,
+                                const double *c, double *res1, double *res2,
+                                int *msg_id, size_t n);
+void qe_batch_kernel_avx2_fixed(const qe_fixed *fx, const double *b,
+                                const double *c, double *res1, double *res2,
+                                int *msg_id, size_t n);
+void qe_batch_kernel_avx512_fixed(const qe_fixed *fx, const double *b,
+                                  const double *c, double *res1,
+                                  double *res2, int *msg_id, size_t n);
+void qe_batch_kernel_sse2_double_fixed(const qe_fixed *fx, const double *b,
+                                       const double *c, double *res1,
+                                       double *res2, int *msg_id, size_t n);
+void qe_batch_kernel_avx2_double_fixed(const qe_fixed *fx, const double *b,
+                                       const double *c, double *res1,
+                                       double *res2, int *msg_id, size_t n);
+void qe_batch_kernel_avx512_double_fixed(const qe_fixed *fx, const double *b,
+                                         const double *c, double *res1,
+                                         double *res2, int *msg_id, size_t n);
+#endif
+
+/*
+ * The type of the classification kernels (qe_count.h). The kernel
+ * classifies n equations like classify_equation, writes the msg_id
+ * if msg_id is not NULL and the indices of the equations whose
+ * msg_id is in classes if idx is not NULL. Returns the number of
+ * the indices. The other pointers are already checked.
+ */
+typedef size_t (*qe_count_kernel)(const double *a, const double *b,
+                                  const double *c, int *msg_id,
+                                  unsigned int classes, size_t *idx, size_t n,
+                                  int prec);
+
+/* Classification kernels for every instruction set. */
+size_t qe_count_generic(const double *a, const double *b, const double *c,
+                        int *msg_id, unsigned int classes, size_t *idx,
+                        size_t n, int prec);
+
+#if defined(QE_HAVE_X86_KERNELS)
+size_t qe_count_sse2(const double *a, const double *b, const double *c,
+                     int *msg_id, unsigned int classes, size_t *idx, size_t n,
+                     int prec);
+size_t qe_count_avx2(const double *a, const double *b, const double *c,
+                     int *msg_id, unsigned int classes, size_t *idx, size_t n,
+                     int prec);
+size_t qe_count_avx512(const double *a, const double *b, const double *c,
+                       int *msg_id, unsigned int classes, size_t *idx,
+                       size_t n, int prec);
+#endif
+
+/*
+ * The type of the kernels of the root range queries (qe_count.h).
+ * The kernel writes the indices of the equations for which
+ * equation_has_root_in is true to idx and returns their number.
+ */
+typedef size_t (*qe_count_in_kernel)(const double *a, const double *b,
+                                     const double *c, double lo, double hi,
+                                     size_t *idx, size_t n, int prec);
+
+/* Range query kernels for every instruction set. */
+size_t qe_count_in_generic(const double *a, const double *b, const double *c,
+                           double lo, double hi, size_t *idx, size_t n,
+                           int prec);
+
+#if defined(QE_HAVE_X86_KERNELS)
+size_t qe_count_in_sse2(const double *a, const double *b, const double *c,
+                        double lo, double hi, size_t *idx, size_t n,
+                        int prec);
+size_t qe_count_in_avx2(const double *a, const double *b, const double *c,
+                        double lo, double hi, size_t *idx, size_t n,
+                        int prec);
+size_t qe_count_in_avx512(const double *a, const double *b, const double *c,
+                          double lo, double hi, size_t *idx, size_t n,
+                          int prec);
+#endif
+
+/*
+ * The parameters of the polishing of the roots (the function
+ * solve_equation_batch_polish). The roots of QE_OK_TWO_RES are
+ * polished if the discriminant is close to 0,
+ * |b * b - 4 * a * c| <= QE_POLISH_NEAR * b * b, or if one root
+ * is lost in cancellation, |4 * a * c| <= QE_POLISH_FAR * b * b.
+ * The parameters must lie from QE_POLISH_MIN to QE_POLISH_MAX in
+ * absolute value, then the roots lie from QE_POLISH_MIN^2 to
+ * QE_POLISH_MAX^2 (or are 0 if lost), and the residuals are computed
+ * without overflow and underflow. QE_POLISH_STEPS is the number of
+ * the steps of the root larger in absolute value (the other one is
+ * found from it by Vieta's formula).
+ */
+#define QE_POLISH_NEAR 0x1p-26
+#define QE_POLISH_FAR 0x1p-1
+#define QE_POLISH_MIN 0x1p-150
+#define QE_POLISH_MAX 0x1p+150
+#define QE_POLISH_STEPS 1
+
+/*
+ * The function polishes the roots of an equation with a parameter
+ * out of [QE_POLISH_MIN, QE_POLISH_MAX], where the residuals could
+ * overflow or underflow: if the equation is ill-conditioned (tested
+ * in long double), its roots are replaced by the ones of
+ * qe_solve_double, which scales the equation by powers of two.
+ */
+void qe_polish_scaled(double a, double b, double c, double *res1,
+                      double *res2);
+
+/*
+ * The number of the equations gathered at once by the vector
+ * polishing kernels (a multiple of the number of the lanes).
+ */
+#define QE_POLISH_CHUNK 256
+
+/*
+ * The type of the polishing kernels. The kernel polishes the roots
+ * of n equations solved by the batch kernel of the
+ * QE_PREC_EXTENDED mode, the pointers are already checked.
+ */
+typedef void (*qe_polish_kernel)(const double *a, const double *b,
+                                 const double *c, double *res1, double *res2,
+                                 const int *msg_id, size_t n);
+
+/* Polishing kernels for every instruction set. */
+void qe_polish_generic(const double *a, const double *b, const double *c,
+                       double *res1, double *res2, const int *msg_id,
+                       size_t n);
+
+#if defined(QE_HAVE_X86_KERNELS)
+void qe_polish_sse2(const double *a, const double *b, const double *c,
+                    double *res1, double *res2, const int *msg_id, size_t n);
+void qe_polish_avx2(const double *a, const double *b, const double *c,
+                    double *res1, double *res2, const int *msg_id, size_t n);
+void qe_polish_avx512(const double *a, const double *b, const double *c,
+                      double *res1, double *res2, const int *msg_id, size_t n);
+#endif
+
+/*
+ * The parameters of the float kernels (qe_kernel_float.h). The
+ * parameters of the lanes solved in float lie from QE_FLOAT_MIN to
+ * QE_FLOAT_MAX in absolute value, then neither the products nor the
+ * roots overflow or become subnormal. The discriminant d is computed
+ * with an error of at most QE_FLOAT_DERR * (b * b + |4 * a * c|).
+ */
+#define QE_FLOAT_MIN 0x1p-50f
+#define QE_FLOAT_MAX 0x1p+50f
+#define QE_FLOAT_DERR 0x1p-22f
+
+/*
+ * The number of equations given to a float kernel at a time. The
+ * equations it cannot solve in float are gathered into tiles of
+ * this size and solved again by the double kernels.
+ */
+#define QE_FLOAT_TILE 512
+
+/*
+ * The type of the float kernels. The kernel solves n equations like
+ * solve_equation_batch_float, k is the factor of the test of the
+ * error (see qe_kernel_float.h). The indices of the equations that
+ * must be solved again are written to idx (room for n of them), and
+ * their number is returned. The pointers are already checked.
+ */
+typedef size_t (*qe_float_kernel)(const float *a, const float *b,
+                                  const float *c, float *res1, float *res2,
+                                  int *msg_id, size_t n, float k,
+                                  size_t *idx);
+
+/* Float kernels for every instruction set. */
+size_t qe_float_kernel_generic(const float *a, const float *b,
+                               const float *c, float *res1, float *res2,
+                               int *msg_id, size_t n, float k, size_t *idx);
+
+#if defined(QE_HAVE_X86_KERNELS)
+size_t qe_float_kernel_sse2(const float *a, const float *b, const float *c,
+                            float *res1, float *res2, int *msg_id, size_t n,
+                            float k, size_t *idx);
+size_t qe_float_kernel_avx2(const float *a, const float *b, const float *c,
+                            float *res1, float *res2, int *msg_id, size_t n,
+                            float k, size_t *idx);
+size_t qe_float_kernel_avx512(const float *a, const float *b, const float *c,
+                              float *res1, float *res2, int *msg_id,
+                              size_t n, float k, size_t *idx);
+#endif
+
+/*
+ * The default pool of the parallel functions (qe_pool.c), one thread
+ * per available processor, created at the first call. Returns NULL
+ * if the threads could not be created.
+ */
+struct qe_pool *qe_pool_default(void);
+
+#endif
@@ -0,0 +1,469 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the template of the batch kernel that
+ * solves several quadratic equations at once. It is included
+ * by the files of every instruction set after the macros
+ * describing the vector operations are defined:
+ *
+ *   QE_KERNEL               - name of the generated kernel
+ *   QE_W                    - number of lanes in a vector
+ *   qe_vd, qe_vm            - vector of doubles, mask of lanes
+ *   V_SET1, V_LOADU,        - broadcast, load and store
+ *   V_STOREU, V_STORE_MSG,    (V_STORE_MSG and V_LOAD_MSG
+ *   V_LOAD_MSG                convert to and from int)
+ *   V_ADD, V_SUB, V_MUL,    - arithmetic
+ *   V_DIV, V_SQRT, V_MIN,
+ *   V_ABS, V_NEG
+ *   V_EXPO                  - 2^floor(log2|x|), 0 for subnormals
+ *   V_TWO_PROD(p, e, x, y)  - p + e == x * y exactly
+ *   V_CMPEQ, V_CMPLT,       - comparisons (false for NaN)
+ *   V_CMPLE, V_CMPGT
+ *   M_AND, M_OR, M_NOT      - operations on masks
+ *   M_NONE                  - mask without lanes
+ *   M_BITS                  - mask as an integer, bit j is lane j
+ *   V_SEL(m, t, f)          - t in the lanes of m, f otherwise
+ *
+ * The msg_id and the roots are selected by the branch-free
+ * classification core (qe_classify.h).
+ *
+ * The kernel works in double precision, but its results are
+ * bit-identical to the results of solve_equation, which works
+ * in long double. For this, every value is computed together
+ * with its rounding error (error-free transformations), and the
+ * kernel checks that rounding to the 64-bit mantissa of long
+ * double and then to double gives the same result as rounding
+ * directly to double. The lanes for which this cannot be
+ * guaranteed (a value is too close to the middle between two
+ * doubles, the parameters are huge, tiny or not finite) are
+ * solved by solve_equation itself. On ordinary data there are
+ * about one percent of such lanes.
+ *
+ * If the array im is given, the lanes with a negative discriminant
+ * get the complex roots of qe_complex_roots, computed by the same
+ * formulas, and the fallback is qe_solve_complex. The kernel calls
+ * the lanes function with im and with NULL in separate loops, so
+ * the real-only kernel does not pay for the complex roots.
+ *
+ * The template also generates the kernel of the equations that
+ * share `a` (and possibly `b`), QE_KERNEL_fixed. The lanes function
+ * takes the shared values as vectors computed once per batch: the
+ * checks of `a`, 2 * a, 4 * a, the reciprocal of 2 * a and, for a
+ * shared `b`, the exact b * b. The operations on them are the same,
+ * so the results are still bit-identical to solve_equation, but no
+ * lane divides: the reciprocal was the only division of a lane.
+ * If `a` is a power of two (monic equations above all), the division
+ * of the exact numerators by 2 * a is exact too: the root is the
+ * rounded numerator times the reciprocal, and the checks of QE_DIV,
+ * which send the ties of the numerators to solve_equation, are
+ * skipped.
+ *
+-------------------------------------------------------------*/
+
+#include "qe_classify.h"
+#include "quadratic_equation.h"
+
+#define QE_CAT_(x, y) x##y
+#define QE_CAT(x, y) QE_CAT_(x, y)
+#define QE_LANES QE_CAT(QE_KERNEL, _lanes)
+#define QE_DIV QE_CAT(QE_KERNEL, _div)
+#define QE_IN_RANGE QE_CAT(QE_KERNEL, _in_range)
+#define QE_SHARED QE_CAT(QE_KERNEL, _shared)
+#define QE_FIXED_LOOP QE_CAT(QE_KERNEL, _fixed_loop)
+
+/* p + e == x + y exactly (TwoSum by Knuth). */
+#define QE_TWO_SUM(s, e, x, y)                                                 \
+  do {                                                                         \
+    qe_vd _x = (x), _y = (y), _bb;                                             \
+    (s) = V_ADD(_x, _y);                                                       \
+    _bb = V_SUB((s), _x);                                                      \
+    (e) = V_ADD(V_SUB(_x, V_SUB((s), _bb)), V_SUB(_y, _bb));                   \
+  } while (0)
+
+/*
+ * The function checks that the parameter is zero or lies in the
+ * range where none of the intermediate values of the kernel can
+ * overflow or become subnormal.
+ */
+static inline qe_vm QE_IN_RANGE(qe_vd x) {
+  qe_vd ax = V_ABS(x);
+
+  return M_OR(V_CMPEQ(x, V_SET1(0.0)),
+              M_AND(V_CMPLE(V_SET1(0x1p-240), ax),
+                    V_CMPLE(ax, V_SET1(0x1p+240))));
+}
+
+/*
+ * The function divides nh + nl (which has no more than 64
+ * significant bits) by d, inv is 1 / d. The result is the double
+ * nearest to the exact quotient. The lanes where it may differ from
+ * the quotient rounded first to long double are added to *amb.
+ */
+static inline qe_vd QE_DIV(qe_vd nh, qe_vd nl, qe_vd d, qe_vd inv,
+                           qe_vm *amb) {
+  const qe_vd zero = V_SET1(0.0);
+  qe_vd q0, q, ph, pl, rem, corr, e, uq;
+  qe_vm near;
+
+  /*
+   * The approximate quotient is corrected by the exact
+   * remainder nh - q0 * d plus the low part.
+   */
+  q0 = V_MUL(nh, inv);
+  V_TWO_PROD(ph, pl, q0, d);
+  rem = V_ADD(V_SUB(V_SUB(nh, ph), pl), nl);
+  corr = V_MUL(rem, inv);
+  q = V_SEL(V_CMPEQ(rem, zero), q0, V_ADD(q0, corr));
+
+  /*
+   * The distance from the exact quotient to q must not be too close
+   * to the half of the unit in the last place. Below a power of two
+   * the doubles are twice as dense, such quotients are always checked
+   * by solve_equation (they are exact in practice, then e is zero).
+   */
+  e = V_SUB(corr, V_SUB(q, q0));
+  uq = V_EXPO(q);
+  near = M_OR(V_CMPLE(V_ABS(V_SUB(V_ABS(e), V_MUL(uq, V_SET1(0x1p-53)))),
+                      V_MUL(uq, V_SET1(0x1p-61))),
+              V_CMPEQ(V_ABS(q), uq));
+  *amb = M_OR(*amb, M_AND(M_NOT(V_CMPEQ(e, zero)), near));
+  return q;
+}
+
+/*
+ * The values shared by the equations of the fixed kernel: `a` is
+ * not zero and lies in the range of QE_IN_RANGE, the values of `b`
+ * are used only if it is shared.
+ */
+typedef struct {
+  double a, b;          /* For the lanes solved by solve_equation. */
+  qe_vd va, a2, a4, inv; /* a, 2 * a, 4 * a and 1 / (2 * a). */
+  qe_vd vb, mb, ab;      /* b, -b and |b|. */
+  qe_vd p, dp;           /* b * b == p + dp. */
+  qe_vm zb, inb;         /* b is zero, b lies in the range. */
+} QE_SHARED;
+
+/*
+ * The function solves QE_W equations. The lanes that cannot be
+ * solved in double precision are passed to solve_equation. The
+ * results are written only after that, so res1 and res2 may point
+ * to the same memory as a and b.
+ *
+ * If shared is 1, `a` is taken from sh instead of the array a, if
+ * it is 2, `b` is also taken from sh. pow2 is set if the shared `a`
+ * is a power of two. The calls pass constants, so the unused
+ * branches are removed.
+ */
+static inline __attribute__((always_inline)) void
+QE_LANES(const double *a, const double *b, const double *c, double *res1,
+         double *res2, double *im, int *msg_id, int shared, int pow2,
+         const QE_SHARED *sh) {
+  const qe_vd zero = V_SET1(0.0);
+  qe_vd va, vb, vc, mb, a2, a4, den, inv;
+  qe_vd p, dp, q, dq, s1, e1, dh, dl, ud, err, s, ab;
+  qe_vd n1h, n1l, n2h, n2l;
+  qe_vd r0, r1q, r2q, r1, r2, msg, vim = zero;
+  qe_vm za, zb, zc, quad, lin, one, exact_d, dpos, dzero;
+  qe_vm amb_d, amb0, amb12, fb;
+  unsigned int bits;
+
+  va = shared ? sh->va : V_LOADU(a);
+  vb = (shared == 2) ? sh->vb : V_LOADU(b);
+  vc = V_LOADU(c);
+  mb = (shared == 2) ? sh->mb : V_NEG(vb);
+
+  za = shared ? M_NONE : V_CMPEQ(va, zero);
+  zb = (shared == 2) ? sh->zb : V_CMPEQ(vb, zero);
+  zc = V_CMPEQ(vc, zero);
+
+  /* The equation is solved through the discriminant. */
+  quad = M_AND(M_NOT(za), M_NOT(M_AND(zb, zc)));
+
+  /* Only `a` is zero. */
+  lin = M_AND(za, M_AND(M_NOT(zb), M_NOT(zc)));
+
+  /* Parameters outside the safe range are solved by solve_equation. */
+  if (shared)
+    fb = M_NOT(
+        M_AND((shared == 2) ? sh->inb : QE_IN_RANGE(vb), QE_IN_RANGE(vc)));
+  else
+    fb = M_NOT(
+        M_AND(M_AND(QE_IN_RANGE(va), QE_IN_RANGE(vb)), QE_IN_RANGE(vc)));
+
+  /*
+   * The discriminant b * b - 4 * a * c as the sum dh + dl,
+   * where dh is the double nearest to its exact value.
+   */
+  a4 = shared ? sh->a4 : V_MUL(V_SET1(4.0), va);
+  a2 = shared ? sh->a2 : V_ADD(va, va);
+  if (shared == 2) {
+    p = sh->p;
+    dp = sh->dp;
+  } else
+    V_TWO_PROD(p, dp, vb, vb);
+  V_TWO_PROD(q, dq, a4, vc);
+  QE_TWO_SUM(s1, e1, p, V_NEG(q));
+  QE_TWO_SUM(dh, dl, s1, V_SUB(V_ADD(e1, dp), dq));
+
+  /*
+   * If both products and their difference are exact, long double
+   * gets the same discriminant. Otherwise its value may differ from
+   * the exact one by err, and the result of rounding it to double is
+   * known only if dh + dl is farther than err from the middle
+   * between two doubles (powers of two are always checked by
+   * solve_equation, like in QE_DIV).
+   */
+  exact_d = M_AND(M_AND(V_CMPEQ(dp, zero), V_CMPEQ(dq, zero)),
+                  V_CMPEQ(e1, zero));
+  ud = V_EXPO(dh);
+  err = V_MUL(V_SET1(0x1p-62), V_ADD(p, V_ABS(q)));
+  amb_d = M_AND(M_NOT(exact_d),
+                M_OR(M_OR(V_CMPEQ(ud, zero), V_CMPEQ(V_ABS(dh), ud)),
+                     V_CMPLE(V_ABS(V_SUB(V_ABS(dl),
+                                         V_MUL(ud, V_SET1(0x1p-53)))),
+                             err)));
+
+  dpos = V_CMPGT(dh, zero);
+  dzero = M_AND(exact_d, V_CMPEQ(dh, zero));
+
+  /*
+   * The numerators -b + sqrt(D) and -b - sqrt(D) as exact sums.
+   * Long double keeps them exactly if they fit into 64 bits, this
+   * is so if the exponents of b and sqrt(D) differ by at most 8.
+   */
+  s = V_SQRT(dh);
+  QE_TWO_SUM(n1h, n1l, mb, s);
+  QE_TWO_SUM(n2h, n2l, mb, V_NEG(s));
+  ab = (shared == 2) ? sh->ab : V_ABS(vb);
+  amb12 = M_AND(M_NOT(M_AND(V_CMPEQ(n1l, zero), V_CMPEQ(n2l, zero))),
+                M_OR(V_CMPLT(s, V_MUL(ab, V_SET1(0x1p-8))),
+                     V_CMPLT(ab, V_MUL(s, V_SET1(0x1p-8)))));
+
+  inv = shared ? sh->inv : V_DIV(V_SET1(1.0), a2);
+  if (pow2) {
+    r1q = V_MUL(n1h, inv);
+    r2q = V_MUL(n2h, inv);
+  } else {
+    r1q = QE_DIV(n1h, n1l, a2, inv, &amb12);
+    r2q = QE_DIV(n2h, n2l, a2, inv, &amb12);
+  }
+
+  /*
+   * The single root: -c / b for the linear equation and -b / (2 * a)
+   * if the discriminant is zero. The lanes never need both, so they
+   * share one division. Such lanes are rare on ordinary data.
+   */
+  one = M_OR(lin, M_AND(quad, dzero));
+  amb0 = M_NONE;
+  r0 = zero;
+  if (pow2)
+    r0 = V_MUL(mb, inv);
+  else if (shared)
+    r0 = QE_DIV(mb, zero, a2, inv, &amb0);
+  else if (M_BITS(one) != 0) {
+    den = V_SEL(lin, vb, a2);
+    r0 = QE_DIV(V_SEL(lin, V_NEG(vc), mb), zero, den,
+                V_DIV(V_SET1(1.0), den), &amb0);
+  }
+
+  /*
+   * Selection of the msg_id and the roots for every lane. The
+   * overflows cannot occur in the lanes that are not passed
+   * to solve_equation.
+   */
+  msg = qe_classify(za, zb, zc, dpos, dzero, M_NONE, M_NONE, r0, r1q, r2q, &r1,
+                    &r2);
+
+  /*
+   * The complex roots -b / (2 * a) +- i * sqrt(-D) / |2 * a|, with
+   * the discriminant by Kahan's method, as in qe_complex_roots. Its
+   * sign may differ from the sign of dh near zero, so |D| is taken.
+   */
+  if (im != NULL) {
+    qe_vm cplx = M_AND(quad, M_NOT(M_OR(dpos, dzero)));
+    qe_vd d, re;
+
+    d = V_SUB(p, q);
+    d = V_SEL(V_CMPLE(V_ADD(p, q), V_MUL(V_SET1(3.0), V_ABS(d))), d,
+              V_ADD(d, V_SUB(dp, dq)));
+    re = V_ADD(V_DIV(mb, a2), zero);
+    vim = V_SEL(cplx, V_DIV(V_SQRT(V_ABS(d)), V_ABS(a2)), zero);
+    r1 = V_SEL(cplx, re, r1);
+    r2 = V_SEL(cplx, re, r2);
+    msg = V_SEL(cplx, V_SET1(QE_OK_CPLX_RES), msg);
+  }
+
+  fb = M_OR(fb, M_AND(one, amb0));
+  fb = M_OR(fb, M_AND(quad, M_OR(amb_d, M_AND(dpos, amb12))));
+
+  bits = M_BITS(fb);
+  if (bits == 0) {
+    V_STOREU(res1, r1);
+    V_STOREU(res2, r2);
+    if (im != NULL)
+      V_STOREU(im, vim);
+    V_STORE_MSG(msg_id, msg);
+  } else {
+    double t1[QE_W], t2[QE_W], ti[QE_W];
+    int tm[QE_W];
+
+    V_STOREU(t1, r1);
+    V_STOREU(t2, r2);
+    V_STOREU(ti, vim);
+    V_STORE_MSG(tm, msg);
+
+    for (int j = 0; j < QE_W; j++)
+      if ((bits >> j) & 1) {
+        double aj = shared ? sh->a : a[j], bj = (shared == 2) ? sh->b : b[j];
+
+        tm[j] = (im != NULL) ? qe_solve_complex(aj, bj, c[j], &t1[j], &t2[j],
+                                                &ti[j], QE_PREC_EXTENDED)
+                             : solve_equation(aj, bj, c[j], &t1[j], &t2[j]);
+      }
+
+    for (int j = 0; j < QE_W; j++) {
+      res1[j] = t1[j];
+      res2[j] = t2[j];
+      if (im != NULL)
+        im[j] = ti[j];
+      msg_id[j] = tm[j];
+    }
+  }
+}
+
+/*
+ * The kernel. The last incomplete vector is solved
+ * through temporary arrays filled with zeros.
+ */
+void QE_KERNEL(const double *a, const double *b, const double *c,
+               double *res1, double *res2, double *im, int *msg_id,
+               size_t n) {
+  size_t i, rest;
+
+  if (im == NULL)
+    for (i = 0; i + QE_W <= n; i += QE_W)
+      QE_LANES(a + i, b + i, c + i, res1 + i, res2 + i, NULL, msg_id + i, 0,
+               0, NULL);
+  else
+    for (i = 0; i + QE_W <= n; i += QE_W)
+      QE_LANES(a + i, b + i, c + i, res1 + i, res2 + i, im + i, msg_id + i, 0,
+               0, NULL);
+
+  rest = n - i;
+  if (rest > 0) {
+    double ta[QE_W] = {0}, tb[QE_W] = {0}, tc[QE_W] = {0};
+    double t1[QE_W], t2[QE_W], ti[QE_W];
+    int tm[QE_W];
+
+    for (size_t j = 0; j < rest; j++) {
+      ta[j] = a[i + j];
+      tb[j] = b[i + j];
+      tc[j] = c[i + j];
+    }
+
+    QE_LANES(ta, tb, tc, t1, t2, (im != NULL) ? ti : NULL, tm, 0, 0, NULL);
+
+    for (size_t j = 0; j < rest; j++) {
+      res1[i + j] = t1[j];
+      res2[i + j] = t2[j];
+      if (im != NULL)
+        im[i + j] = ti[j];
+      msg_id[i + j] = tm[j];
+    }
+  }
+}
+
+/*
+ * The loop of the fixed kernel. ta and tb hold QE_W copies of `a`
+ * and `b`, tb is used instead of the array b if b is NULL. The last
+ * incomplete vector is solved through temporary arrays.
+ */
+static inline __attribute__((always_inline)) void
+QE_FIXED_LOOP(const QE_SHARED *sh, int shared, int pow2, const double *ta,
+              const double *tb, const double *b, const double *c,
+              double *res1, double *res2, int *msg_id, size_t n) {
+  size_t i, rest;
+
+  for (i = 0; i + QE_W <= n; i += QE_W)
+    QE_LANES(ta, (b != NULL) ? b + i : tb, c + i, res1 + i, res2 + i, NULL,
+             msg_id + i, shared, pow2, sh);
+
+  rest = n - i;
+  if (rest > 0) {
+    double tb2[QE_W] = {0}, tc[QE_W] = {0}, t1[QE_W], t2[QE_W];
+    int tm[QE_W];
+
+    for (size_t j = 0; j < rest; j++) {
+      tb2[j] = (b != NULL) ? b[i + j] : tb[j];
+      tc[j] = c[i + j];
+    }
+
+    QE_LANES(ta, tb2, tc, t1, t2, NULL, tm, shared, pow2, sh);
+
+    for (size_t j = 0; j < rest; j++) {
+      res1[i + j] = t1[j];
+      res2[i + j] = t2[j];
+      msg_id[i + j] = tm[j];
+    }
+  }
+}
+
+/*
+ * The fixed kernel: the equations fx->a * x^2 + b[i] * x + c[i] = 0,
+ * or with fx->b instead of b[i] if fx->fixed_b is set. A zero, huge
+ * or tiny `a` is passed to the lanes function as an array, like in
+ * QE_KERNEL, and so is a shared `b` outside the range.
+ */
+void QE_CAT(QE_KERNEL, _fixed)(const qe_fixed *fx, const double *b,
+                               const double *c, double *res1, double *res2,
+                               int *msg_id, size_t n) {
+  double ta[QE_W], tb[QE_W], aa = fabs(fx->a), ab = fabs(fx->b);
+  int e, shared;
+  QE_SHARED sh;
+
+  for (int j = 0; j < QE_W; j++) {
+    ta[j] = fx->a;
+    tb[j] = fx->b;
+  }
+  if (fx->fixed_b)
+    b = NULL;
+
+  if (!((aa >= 0x1p-240) && (aa <= 0x1p+240))) {
+    QE_FIXED_LOOP(NULL, 0, 0, ta, tb, b, c, res1, res2, msg_id, n);
+    return;
+  }
+
+  sh.a = fx->a;
+  sh.b = fx->b;
+  sh.va = V_SET1(fx->a);
+  sh.a2 = V_SET1(2.0 * fx->a);
+  sh.a4 = V_SET1(4.0 * fx->a);
+  sh.inv = V_SET1(1.0 / (2.0 * fx->a));
+  sh.vb = V_SET1(fx->b);
+  sh.mb = V_SET1(-fx->b);
+  sh.ab = V_SET1(ab);
+  V_TWO_PROD(sh.p, sh.dp, sh.vb, sh.vb);
+  sh.zb = V_CMPEQ(sh.vb, V_SET1(0.0));
+  sh.inb = QE_IN_RANGE(sh.vb);
+
+  shared = ((b == NULL) &&
+            ((fx->b == 0) || ((ab >= 0x1p-240) && (ab <= 0x1p+240))))
+               ? 2
+               : 1;
+
+  if (frexp(aa, &e) == 0.5) {
+    if (shared == 2)
+      QE_FIXED_LOOP(&sh, 2, 1, ta, tb, NULL, c, res1, res2, msg_id, n);
+    else
+      QE_FIXED_LOOP(&sh, 1, 1, ta, tb, b, c, res1, res2, msg_id, n);
+  } else if (shared == 2)
+    QE_FIXED_LOOP(&sh, 2, 0, ta, tb, NULL, c, res1, res2, msg_id, n);
+  else
+    QE_FIXED_LOOP(&sh, 1, 0, ta, tb, b, c, res1, res2, msg_id, n);
+}
+
+#undef QE_LANES
+#undef QE_DIV
+#undef QE_IN_RANGE
+#undef QE_SHARED
+#undef QE_FIXED_LOOP
+#undef QE_TWO_SUM
@@ -0,0 +1,309 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the template of the batch kernel of the
+ * QE_PREC_DOUBLE mode. It is included by the files of every
+ * instruction set after qe_kernel.h, with QE_KERNEL redefined
+ * to the name of the generated kernel. The other macros are
+ * the same (see qe_kernel.h).
+ *
+ * The kernel repeats the calculations of qe_solve_double in
+ * the same order, so its results are bit-identical to it. The
+ * lanes with huge, tiny or not finite parameters, which need
+ * scaling, are solved by qe_solve_double itself. If the array
+ * im is given, the complex roots are computed as in qe_kernel.h.
+ *
+ * The fixed kernel of the equations that share `a` (and possibly
+ * `b`) is generated as in qe_kernel.h. Here the root q / a needs a
+ * division, so it is computed as q * (1 / a) and may differ from
+ * the root of qe_solve_double by one unit in the last place (if `a`
+ * is not a power of two), as in the sweeps of qe_sweep.h. The
+ * other results are the same.
+ *
+-------------------------------------------------------------*/
+
+#include "qe_classify.h"
+#include "quadratic_equation.h"
+
+#ifndef QE_CAT
+#define QE_CAT_(x, y) x##y
+#define QE_CAT(x, y) QE_CAT_(x, y)
+#endif
+
+#define QE_LANES QE_CAT(QE_KERNEL, _lanes)
+#define QE_IN_RANGE QE_CAT(QE_KERNEL, _in_range)
+#define QE_SHARED QE_CAT(QE_KERNEL, _shared)
+#define QE_FIXED_LOOP QE_CAT(QE_KERNEL, _fixed_loop)
+
+/*
+ * The function checks that the parameter is zero or lies in the
+ * range where the equation can be solved without scaling.
+ */
+static inline qe_vm QE_IN_RANGE(qe_vd x) {
+  qe_vd ax = V_ABS(x);
+
+  return M_OR(V_CMPEQ(x, V_SET1(0.0)),
+              M_AND(V_CMPLE(V_SET1(0x1p-450), ax),
+                    V_CMPLE(ax, V_SET1(0x1p+450))));
+}
+
+/*
+ * The values shared by the equations of the fixed kernel: `a` is
+ * not zero and lies in the range of QE_IN_RANGE, the values of `b`
+ * are used only if it is shared.
+ */
+typedef struct {
+  double a, b;         /* For the lanes solved by qe_solve_double. */
+  qe_vd va, a4;        /* a and 4 * a. */
+  qe_vd inva, inv2a;   /* 1 / a and 1 / (2 * a). */
+  qe_vd vb, p, dp;     /* b and b * b == p + dp. */
+  qe_vm zb, inb, bneg; /* b is zero, lies in the range, is negative. */
+} QE_SHARED;
+
+/*
+ * The function solves QE_W equations. The results are written
+ * only after the lanes that need scaling are solved, so res1 and
+ * res2 may point to the same memory as a and b.
+ *
+ * If shared is 1, `a` is taken from sh instead of the array a, if
+ * it is 2, `b` is also taken from sh (as in qe_kernel.h).
+ */
+static inline __attribute__((always_inline)) void
+QE_LANES(const double *a, const double *b, const double *c, double *res1,
+         double *res2, double *im, int *msg_id, int shared,
+         const QE_SHARED *sh) {
+  const qe_vd zero = V_SET1(0.0);
+  qe_vd va, vb, vc, p, dp, q, dq, d, s, big, small, r0, r1, r2, msg, den;
+  qe_vd sd, vim = zero;
+  qe_vm za, zb, zc, lin, one, dpos, dzero, bneg, fb;
+  unsigned int bits;
+
+  va = shared ? sh->va : V_LOADU(a);
+  vb = (shared == 2) ? sh->vb : V_LOADU(b);
+  vc = V_LOADU(c);
+
+  za = shared ? M_NONE : V_CMPEQ(va, zero);
+  zb = (shared == 2) ? sh->zb : V_CMPEQ(vb, zero);
+  zc = V_CMPEQ(vc, zero);
+
+  /* Only `a` is zero. */
+  lin = M_AND(za, M_AND(M_NOT(zb), M_NOT(zc)));
+
+  /* Parameters outside the range are solved by qe_solve_double. */
+  if (shared)
+    fb = M_NOT(
+        M_AND((shared == 2) ? sh->inb : QE_IN_RANGE(vb), QE_IN_RANGE(vc)));
+  else
+    fb = M_NOT(
+        M_AND(M_AND(QE_IN_RANGE(va), QE_IN_RANGE(vb)), QE_IN_RANGE(vc)));
+
+  /*
+   * The discriminant by Kahan's method. The compensated value is
+   * taken only where qe_solve_double computes it.
+   */
+  if (shared == 2) {
+    p = sh->p;
+    dp = sh->dp;
+  } else
+    V_TWO_PROD(p, dp, vb, vb);
+  V_TWO_PROD(q, dq, shared ? sh->a4 : V_MUL(V_SET1(4.0), va), vc);
+  d = V_SUB(p, q);
+  d = V_SEL(V_CMPLE(V_ADD(p, q), V_MUL(V_SET1(3.0), V_ABS(d))), d,
+            V_ADD(d, V_SUB(dp, dq)));
+  dpos = V_CMPGT(d, zero);
+  dzero = V_CMPEQ(d, zero);
+
+  /*
+   * The roots q / a and c / q, the order depends on the sign of b.
+   * The root of |D| is also the imaginary part of the complex roots.
+   */
+  sd = V_SQRT(V_ABS(d));
+  s = V_SEL(dpos, sd, zero);
+  bneg = (shared == 2) ? sh->bneg : V_CMPLT(vb, zero);
+  q = V_SEL(bneg, V_MUL(V_SET1(0.5), V_SUB(s, vb)),
+            V_MUL(V_SET1(-0.5), V_ADD(vb, s)));
+  big = shared ? V_MUL(q, sh->inva) : V_DIV(q, va);
+  small = V_ADD(V_DIV(vc, q), zero);
+  r1 = V_SEL(bneg, big, small);
+  r2 = V_SEL(bneg, small, big);
+
+  /*
+   * The single root -c / b if only `a` is zero, or -b / (2 * a)
+   * if the discriminant is zero. Such lanes are rare.
+   */
+  one = M_OR(lin, M_AND(M_NOT(za), dzero));
+  r0 = zero;
+  if (shared)
+    r0 = V_MUL(V_NEG(vb), sh->inv2a);
+  else if (M_BITS(one) != 0) {
+    den = V_SEL(lin, vb, V_MUL(V_SET1(2.0), va));
+    r0 = V_DIV(V_NEG(V_SEL(lin, vc, vb)), den);
+  }
+
+  /*
+   * In the range the roots cannot overflow. The masks of the
+   * cases that do not occur in a lane are ignored by qe_classify.
+   */
+  msg = qe_classify(za, zb, zc, dpos, dzero, M_NONE, M_NONE, r0, r1, r2, &r1,
+                    &r2);
+
+  /* The complex roots, as in qe_complex_roots. */
+  if (im != NULL) {
+    qe_vm cplx = M_AND(M_NOT(za), M_NOT(M_OR(dpos, dzero)));
+    qe_vd a2 = V_MUL(V_SET1(2.0), va), re;
+
+    re = V_ADD(V_DIV(V_NEG(vb), a2), zero);
+    vim = V_SEL(cplx, V_DIV(sd, V_ABS(a2)), zero);
+    r1 = V_SEL(cplx, re, r1);
+    r2 = V_SEL(cplx, re, r2);
+    msg = V_SEL(cplx, V_SET1(QE_OK_CPLX_RES), msg);
+  }
+
+  bits = M_BITS(fb);
+  if (bits == 0) {
+    V_STOREU(res1, r1);
+    V_STOREU(res2, r2);
+    if (im != NULL)
+      V_STOREU(im, vim);
+    V_STORE_MSG(msg_id, msg);
+  } else {
+    double t1[QE_W], t2[QE_W], ti[QE_W];
+    int tm[QE_W];
+
+    V_STOREU(t1, r1);
+    V_STOREU(t2, r2);
+    V_STOREU(ti, vim);
+    V_STORE_MSG(tm, msg);
+
+    for (int j = 0; j < QE_W; j++)
+      if ((bits >> j) & 1) {
+        double aj = shared ? sh->a : a[j], bj = (shared == 2) ? sh->b : b[j];
+
+        tm[j] = (im != NULL) ? qe_solve_complex(aj, bj, c[j], &t1[j], &t2[j],
+                                                &ti[j], QE_PREC_DOUBLE)
+                             : qe_solve_double(aj, bj, c[j], &t1[j], &t2[j]);
+      }
+
+    for (int j = 0; j < QE_W; j++) {
+      res1[j] = t1[j];
+      res2[j] = t2[j];
+      if (im != NULL)
+        im[j] = ti[j];
+      msg_id[j] = tm[j];
+    }
+  }
+}
+
+/*
+ * The kernel. The last incomplete vector is solved
+ * through temporary arrays filled with zeros.
+ */
+void QE_KERNEL(const double *a, const double *b, const double *c,
+               double *res1, double *res2, double *im, int *msg_id,
+               size_t n) {
+  size_t i, rest;
+
+  if (im == NULL)
+    for (i = 0; i + QE_W <= n; i += QE_W)
+      QE_LANES(a + i, b + i, c + i, res1 + i, res2 + i, NULL, msg_id + i, 0,
+               NULL);
+  else
+    for (i = 0; i + QE_W <= n; i += QE_W)
+      QE_LANES(a + i, b + i, c + i, res1 + i, res2 + i, im + i, msg_id + i, 0,
+               NULL);
+
+  rest = n - i;
+  if (rest > 0) {
+    double ta[QE_W] = {0}, tb[QE_W] = {0}, tc[QE_W] = {0};
+    double t1[QE_W], t2[QE_W], ti[QE_W];
+    int tm[QE_W];
+
+    for (size_t j = 0; j < rest; j++) {
+      ta[j] = a[i + j];
+      tb[j] = b[i + j];
+      tc[j] = c[i + j];
+    }
+
+    QE_LANES(ta, tb, tc, t1, t2, (im != NULL) ? ti : NULL, tm, 0, NULL);
+
+    for (size_t j = 0; j < rest; j++) {
+      res1[i + j] = t1[j];
+      res2[i + j] = t2[j];
+      if (im != NULL)
+        im[i + j] = ti[j];
+      msg_id[i + j] = tm[j];
+    }
+  }
+}
+
+/* The loop of the fixed kernel, as in qe_kernel.h. */
+static inline __attribute__((always_inline)) void
+QE_FIXED_LOOP(const QE_SHARED *sh, int shared, const double *ta,
+              const double *tb, const double *b, const double *c,
+              double *res1, double *res2, int *msg_id, size_t n) {
+  size_t i, rest;
+
+  for (i = 0; i + QE_W <= n; i += QE_W)
+    QE_LANES(ta, (b != NULL) ? b + i : tb, c + i, res1 + i, res2 + i, NULL,
+             msg_id + i, shared, sh);
+
+  rest = n - i;
+  if (rest > 0) {
+    double tb2[QE_W] = {0}, tc[QE_W] = {0}, t1[QE_W], t2[QE_W];
+    int tm[QE_W];
+
+    for (size_t j = 0; j < rest; j++) {
+      tb2[j] = (b != NULL) ? b[i + j] : tb[j];
+      tc[j] = c[i + j];
+    }
+
+    QE_LANES(ta, tb2, tc, t1, t2, NULL, tm, shared, sh);
+
+    for (size_t j = 0; j < rest; j++) {
+      res1[i + j] = t1[j];
+      res2[i + j] = t2[j];
+      msg_id[i + j] = tm[j];
+    }
+  }
+}
+
+/* The fixed kernel of the QE_PREC_DOUBLE mode, as in qe_kernel.h. */
+void QE_CAT(QE_KERNEL, _fixed)(const qe_fixed *fx, const double *b,
+                               const double *c, double *res1, double *res2,
+                               int *msg_id, size_t n) {
+  double ta[QE_W], tb[QE_W];
+  QE_SHARED sh;
+
+  for (int j = 0; j < QE_W; j++) {
+    ta[j] = fx->a;
+    tb[j] = fx->b;
+  }
+  if (fx->fixed_b)
+    b = NULL;
+
+  if ((fx->a == 0) || !qe_in_range(fx->a)) {
+    QE_FIXED_LOOP(NULL, 0, ta, tb, b, c, res1, res2, msg_id, n);
+    return;
+  }
+
+  sh.a = fx->a;
+  sh.b = fx->b;
+  sh.va = V_SET1(fx->a);
+  sh.a4 = V_SET1(4.0 * fx->a);
+  sh.inva = V_SET1(1.0 / fx->a);
+  sh.inv2a = V_SET1(0.5 / fx->a);
+  sh.vb = V_SET1(fx->b);
+  V_TWO_PROD(sh.p, sh.dp, sh.vb, sh.vb);
+  sh.zb = V_CMPEQ(sh.vb, V_SET1(0.0));
+  sh.inb = QE_IN_RANGE(sh.vb);
+  sh.bneg = V_CMPLT(sh.vb, V_SET1(0.0));
+
+  if ((b == NULL) && qe_in_range(fx->b))
+    QE_FIXED_LOOP(&sh, 2, ta, tb, NULL, c, res1, res2, msg_id, n);
+  else
+    QE_FIXED_LOOP(&sh, 1, ta, tb, b, c, res1, res2, msg_id, n);
+}
+
+#undef QE_LANES
+#undef QE_IN_RANGE
+#undef QE_SHARED
+#undef QE_FIXED_LOOP
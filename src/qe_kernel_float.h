@@ -0,0 +1,147 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the template of the float kernel of the
+ * solve_equation_batch_float function. It is included by the
+ * files of every instruction set after the macros describing
+ * the vector operations on floats are defined:
+ *
+ *   QE_FLOAT_KERNEL         - name of the generated kernel
+ *   QE_FW                   - number of lanes in a vector
+ *   qe_vf, qe_vfm           - vector of floats, mask of lanes
+ *   F_SET1, F_LOADU,        - broadcast, load and store
+ *   F_STOREU, F_STORE_MSG     (F_STORE_MSG converts to int)
+ *   F_ADD, F_SUB, F_MUL,    - arithmetic
+ *   F_DIV, F_SQRT, F_ABS
+ *   F_CMPLT, F_CMPLE        - comparisons (false for NaN)
+ *   FM_AND, FM_OR           - operations on masks
+ *   FM_BITS                 - mask as an integer, bit j is lane j
+ *   F_SEL(m, t, f)          - t in the lanes of m, f otherwise
+ *
+ * The kernel solves only the equations with parameters from
+ * QE_FLOAT_MIN to QE_FLOAT_MAX in absolute value, whose
+ * discriminant is certainly positive or negative. With
+ * u = 2^-24, the rounded discriminant d differs from the exact
+ * one D by at most E = QE_FLOAT_DERR * (b * b + |4 * a * c|), so
+ * D has the sign of d if |d| > E, and the relative error of d is
+ * at most E / (d - E). The square root halves it, and the sum
+ * -(b + sign(b) * sqrt(d)) / 2 and the divisions of the roots
+ * q / a and c / q add a rounding each, so the relative error of
+ * the roots is at most 0.6 * E / (d - E) + 3 * u. The lane is
+ * kept if E <= k * (d - E), where k = (tol - 4 * u) / 0.65 (at
+ * most 0.5) is computed once per batch. The indices of the other
+ * lanes are returned to solve_equation_batch_float, which solves
+ * them again in double.
+ *
+-------------------------------------------------------------*/
+
+#include "quadratic_equation.h"
+
+#ifndef QE_CAT
+#define QE_CAT_(x, y) x##y
+#define QE_CAT(x, y) QE_CAT_(x, y)
+#endif
+
+#define QE_FLOAT_LANES QE_CAT(QE_FLOAT_KERNEL, _lanes)
+#define QE_FLOAT_IN_RANGE QE_CAT(QE_FLOAT_KERNEL, _in_range)
+
+/*
+ * The function checks that the absolute value of the parameter
+ * lies from QE_FLOAT_MIN to QE_FLOAT_MAX (so it is not zero).
+ */
+static inline qe_vfm QE_FLOAT_IN_RANGE(qe_vf x) {
+  qe_vf ax = F_ABS(x);
+
+  return FM_AND(F_CMPLE(F_SET1(QE_FLOAT_MIN), ax),
+                F_CMPLE(ax, F_SET1(QE_FLOAT_MAX)));
+}
+
+/*
+ * The function solves QE_FW equations and returns the mask of the
+ * lanes that must be solved again (bit j is lane j).
+ */
+static inline __attribute__((always_inline)) unsigned int
+QE_FLOAT_LANES(const float *a, const float *b, const float *c, float *res1,
+               float *res2, int *msg_id, qe_vf k) {
+  const qe_vf zero = F_SET1(0.0f);
+  qe_vf va, vb, vc, p, r, d, e, s, q, big, small, r1, r2, msg;
+  qe_vfm in, two, none, bneg;
+
+  va = F_LOADU(a);
+  vb = F_LOADU(b);
+  vc = F_LOADU(c);
+  in = FM_AND(FM_AND(QE_FLOAT_IN_RANGE(va), QE_FLOAT_IN_RANGE(vb)),
+              QE_FLOAT_IN_RANGE(vc));
+
+  /* The discriminant and the bound of its error. */
+  p = F_MUL(vb, vb);
+  r = F_MUL(F_MUL(F_SET1(4.0f), va), vc);
+  d = F_SUB(p, r);
+  e = F_MUL(F_ADD(p, F_ABS(r)), F_SET1(QE_FLOAT_DERR));
+  two = FM_AND(in, F_CMPLE(e, F_MUL(F_SUB(d, e), k)));
+  none = FM_AND(in, F_CMPLT(d, F_SUB(zero, e)));
+
+  /* The roots q / a and c / q, as in qe_solve_double. */
+  s = F_SQRT(F_ABS(d));
+  bneg = F_CMPLT(vb, zero);
+  q = F_SEL(bneg, F_MUL(F_SET1(0.5f), F_SUB(s, vb)),
+            F_MUL(F_SET1(-0.5f), F_ADD(vb, s)));
+  big = F_DIV(q, va);
+  small = F_DIV(vc, q);
+  r1 = F_SEL(two, F_SEL(bneg, big, small), zero);
+  r2 = F_SEL(two, F_SEL(bneg, small, big), zero);
+  msg = F_SEL(two, F_SET1((float)QE_OK_TWO_RES),
+              F_SET1((float)QE_OK_NO_RES));
+
+  F_STOREU(res1, r1);
+  F_STOREU(res2, r2);
+  F_STORE_MSG(msg_id, msg);
+
+  return ~(unsigned int)FM_BITS(FM_OR(two, none)) & ((1u << QE_FW) - 1);
+}
+
+/*
+ * The kernel. The last incomplete vector is solved through
+ * temporary arrays filled with the equation x^2 + x + 1 = 0,
+ * which is solved in float.
+ */
+size_t QE_FLOAT_KERNEL(const float *a, const float *b, const float *c,
+                       float *res1, float *res2, int *msg_id, size_t n,
+                       float k, size_t *idx) {
+  const qe_vf vk = F_SET1(k);
+  size_t i, rest, count = 0;
+  unsigned int bits;
+
+  for (i = 0; i + QE_FW <= n; i += QE_FW) {
+    bits = QE_FLOAT_LANES(a + i, b + i, c + i, res1 + i, res2 + i, msg_id + i,
+                          vk);
+    for (; bits != 0; bits &= bits - 1)
+      idx[count++] = i + (size_t)__builtin_ctz(bits);
+  }
+
+  rest = n - i;
+  if (rest > 0) {
+    float ta[QE_FW], tb[QE_FW], tc[QE_FW], t1[QE_FW], t2[QE_FW];
+    int tm[QE_FW];
+
+    for (size_t j = 0; j < QE_FW; j++) {
+      ta[j] = (j < rest) ? a[i + j] : 1.0f;
+      tb[j] = (j < rest) ? b[i + j] : 1.0f;
+      tc[j] = (j < rest) ? c[i + j] : 1.0f;
+    }
+
+    bits = QE_FLOAT_LANES(ta, tb, tc, t1, t2, tm, vk) & ((1u << rest) - 1);
+    for (; bits != 0; bits &= bits - 1)
+      idx[count++] = i + (size_t)__builtin_ctz(bits);
+
+    for (size_t j = 0; j < rest; j++) {
+      res1[i + j] = t1[j];
+      res2[i + j] = t2[j];
+      msg_id[i + j] = tm[j];
+    }
+  }
+
+  return count;
+}
+
+#undef QE_FLOAT_LANES
+#undef QE_FLOAT_IN_RANGE
@@ -0,0 +1,221 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the writer of
+ * results (qe_out). The formats are described in qe_out.h.
+ *
+ * A row is formatted straight into the current buffer; when
+ * there is no room for a row of the longest kind, the next
+ * buffer is taken, and when all of them are taken, they are
+ * written by one writev call. So the buffers are not filled to
+ * the last byte, but nothing is copied to join them. A partial
+ * write (a pipe or a socket) is continued from the byte where
+ * it stopped.
+ *
+-------------------------------------------------------------*/
+
+#define _DEFAULT_SOURCE
+
+#include "qe_out.h"
+#include "qe_text.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/* The longest row: two numbers, "-2", two commas and '\n'. */
+#define QE_OUT_MAX_ROW (2 * QE_TEXT_MAX_FORMAT + 8)
+
+struct qe_out {
+  int fd;
+  int format;
+  int failed;
+  int cur;                    /* The buffer being filled. */
+  size_t len[QE_OUT_BUFFERS]; /* The bytes of every buffer. */
+  char *buf[QE_OUT_BUFFERS];
+};
+
+/*
+ * Implementation of the qe_out_create function. The buffers are
+ * allocated at once.
+ */
+qe_out *qe_out_create(int fd, int format) {
+  qe_out *out;
+  char *mem;
+
+  if ((format != QE_OUT_TEXT) && (format != QE_OUT_BINARY))
+    return NULL;
+
+  out = calloc(1, sizeof(*out));
+  mem = malloc((size_t)QE_OUT_BUFFERS * QE_OUT_BUFFER);
+  if (!out || !mem) {
+    free(out);
+    free(mem);
+    return NULL;
+  }
+
+  out->fd = fd;
+  out->format = format;
+  for (int i = 0; i < QE_OUT_BUFFERS; i++)
+    out->buf[i] = mem + (size_t)i * QE_OUT_BUFFER;
+  return out;
+}
+
+/*
+ * Implementation of the qe_out_flush function. The buffers are
+ * written by writev until all the bytes are written.
+ */
+int qe_out_flush(qe_out *out) {
+  struct iovec iov[QE_OUT_BUFFERS];
+  int first = 0, count = 0;
+
+  if (out->failed)
+    return -1;
+
+  for (int i = 0; i <= out->cur; i++)
+    if (out->len[i] > 0) {
+      iov[count].iov_base = out->buf[i];
+      iov[count++].iov_len = out->len[i];
+    }
+
+  while (first < count) {
+    ssize_t done = writev(out->fd, iov + first, count - first);
+
+    if (done < 0) {
+      if (errno == EINTR)
+        continue;
+      out->failed = 1;
+      return -1;
+    }
+
+    /* The written buffers are skipped, a partial one is moved. */
+    while ((first < count) && ((size_t)done >= iov[first].iov_len))
+      done -= (ssize_t)iov[first++].iov_len;
+    if (first < count) {
+      iov[first].iov_base = (char *)iov[first].iov_base + done;
+      iov[first].iov_len -= (size_t)done;
+    }
+  }
+
+  memset(out->len, 0, sizeof(out->len));
+  out->cur = 0;
+  return 0;
+}
+
+/*
+ * The function returns the place for at least room bytes in the
+ * current buffer, taking the next one or flushing if needed.
+ * Returns NULL if writing failed.
+ */
+static char *reserve(qe_out *out, size_t room) {
+  if (QE_OUT_BUFFER - out->len[out->cur] < room) {
+    if ((out->cur + 1 < QE_OUT_BUFFERS) && (out->len[out->cur] > 0))
+      out->cur++;
+    else if (qe_out_flush(out))
+      return NULL;
+  }
+
+  return out->buf[out->cur] + out->len[out->cur];
+}
+
+/* The function writes v in the little-endian byte order. */
+static inline void put_le64(char *p, uint64_t v) {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+  v = __builtin_bswap64(v);
+#endif
+  memcpy(p, &v, sizeof(v));
+}
+
+/* The function writes v in the little-endian byte order. */
+static inline void put_le32(char *p, uint32_t v) {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+  v = __builtin_bswap32(v);
+#endif
+  memcpy(p, &v, sizeof(v));
+}
+
+/*
+ * Implementation of the qe_out_rows function. The rows are
+ * formatted into the buffers one after another.
+ */
+int qe_out_rows(qe_out *out, const double *res1, const double *res2,
+                const int *msg_id, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    char *p = reserve(out, QE_OUT_MAX_ROW), *start = p;
+
+    if (p == NULL)
+      return -1;
+
+    if (out->format == QE_OUT_BINARY) {
+      uint64_t r1, r2;
+
+      memcpy(&r1, &res1[i], sizeof(r1));
+      memcpy(&r2, &res2[i], sizeof(r2));
+      put_le64(p, r1);
+      put_le64(p + 8, r2);
+      put_le32(p + 16, (uint32_t)msg_id[i]);
+      p += QE_OUT_ROW;
+    } else {
+      /* msg_id is from -2 to 4, other values are written too. */
+      int m = msg_id[i];
+      unsigned int u = (m < 0) ? 0u - (unsigned int)m : (unsigned int)m;
+      char digits[12];
+      int len = 0;
+
+      p += qe_format_double(res1[i], p);
+      *p++ = ',';
+      p += qe_format_double(res2[i], p);
+      *p++ = ',';
+      if (m < 0)
+        *p++ = '-';
+      do {
+        digits[len++] = (char)('0' + u % 10);
+        u /= 10;
+      } while (u != 0);
+      while (len > 0)
+        *p++ = digits[--len];
+      *p++ = '\n';
+    }
+
+    out->len[out->cur] += (size_t)(p - start);
+  }
+
+  return 0;
+}
+
+/*
+ * Implementation of the qe_out_write function. Long data are
+ * split between the buffers.
+ */
+int qe_out_write(qe_out *out, const void *data, size_t len) {
+  const char *src = data;
+
+  while (len > 0) {
+    char *p = reserve(out, 1);
+    size_t m = QE_OUT_BUFFER - out->len[out->cur];
+
+    if (p == NULL)
+      return -1;
+    if (m > len)
+      m = len;
+    memcpy(p, src, m);
+    out->len[out->cur] += m;
+    src += m;
+    len -= m;
+  }
+
+  return 0;
+}
+
+/* Implementation of the qe_out_close function. */
+int qe_out_close(qe_out *out) {
+  int res;
+
+  if (out == NULL)
+    return -1;
+
+  res = qe_out_flush(out);
+  free(out->buf[0]);
+  free(out);
+  return res;
+}
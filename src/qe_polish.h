@@ -0,0 +1,227 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the template of the polishing kernel of
+ * the solve_equation_batch_polish function. It is included by
+ * the files of every instruction set after the batch kernels,
+ * with QE_POLISH defined to the name of the generated kernel
+ * (the other macros are described in qe_kernel.h).
+ *
+ * The kernel corrects the roots of the ill-conditioned
+ * equations (see QE_POLISH_STEPS in qe_internal.h). Only
+ * such equations are polished, gathered into full vectors. The
+ * equations with a parameter out of range are passed to
+ * qe_polish_scaled one by one.
+ * The operations are the ones
+ * of qe_polish_generic in the same order, so the results are
+ * bit-identical to it.
+ *
+-------------------------------------------------------------*/
+
+#include "quadratic_equation.h"
+#include <float.h>
+
+#ifndef QE_CAT
+#define QE_CAT_(x, y) x##y
+#define QE_CAT(x, y) QE_CAT_(x, y)
+#endif
+
+#define QE_POLISH_TWO_SUM QE_CAT(QE_POLISH, _two_sum)
+#define QE_POLISH_RESIDUAL QE_CAT(QE_POLISH, _residual)
+#define QE_POLISH_STEP QE_CAT(QE_POLISH, _step)
+#define QE_POLISH_LANES QE_CAT(QE_POLISH, _lanes)
+#define QE_POLISH_IN_RANGE QE_CAT(QE_POLISH, _in_range)
+#define QE_POLISH_FLAGS QE_CAT(QE_POLISH, _flags)
+
+/*
+ * The function checks that the absolute value of x lies from
+ * QE_POLISH_MIN to QE_POLISH_MAX.
+ */
+static inline qe_vm QE_POLISH_IN_RANGE(qe_vd x) {
+  qe_vd ax = V_ABS(x);
+
+  return M_AND(V_CMPLE(V_SET1(QE_POLISH_MIN), ax),
+               V_CMPLE(ax, V_SET1(QE_POLISH_MAX)));
+}
+
+/* The function computes s and e such that s + e == x + y exactly. */
+static inline void QE_POLISH_TWO_SUM(qe_vd x, qe_vd y, qe_vd *s, qe_vd *e) {
+  qe_vd t;
+
+  *s = V_ADD(x, y);
+  t = V_SUB(*s, x);
+  *e = V_ADD(V_SUB(x, V_SUB(*s, t)), V_SUB(y, t));
+}
+
+/*
+ * The function returns a * x^2 + b * x + c computed by Horner's
+ * scheme with the rounding errors of every step (compensated
+ * Horner's scheme), as accurately as in twice the precision.
+ */
+static inline qe_vd QE_POLISH_RESIDUAL(qe_vd a, qe_vd b, qe_vd c, qe_vd x) {
+  qe_vd p, pe, s, se, err;
+
+  V_TWO_PROD(p, pe, a, x);
+  QE_POLISH_TWO_SUM(p, b, &s, &se);
+  err = V_ADD(pe, se);
+  V_TWO_PROD(p, pe, s, x);
+  QE_POLISH_TWO_SUM(p, c, &s, &se);
+  err = V_ADD(V_MUL(err, x), V_ADD(pe, se));
+  return V_ADD(s, err);
+}
+
+/*
+ * The function computes the correction of the root x with the
+ * residual f, the derivative fp and the root s of the discriminant
+ * taken with the sign of the root (see polish_step in qe_batch.c).
+ */
+static inline qe_vd QE_POLISH_STEP(qe_vd a2, qe_vd x, qe_vd f, qe_vd fp,
+                                   qe_vd s) {
+  qe_vm near = V_CMPLE(V_MUL(s, fp), V_SET1(0.0));
+
+  return V_ADD(x, V_DIV(V_SEL(near, V_SUB(s, fp), V_MUL(V_SET1(-2.0), f)),
+                        V_SEL(near, a2, V_ADD(fp, s))));
+}
+
+/*
+ * The function returns the mask of the equations of QE_W that
+ * need polishing (see QE_POLISH_STEPS in qe_internal.h). The mask
+ * of the pairs of roots with a parameter out of range is written
+ * to scaled.
+ */
+static inline qe_vm QE_POLISH_FLAGS(const double *a, const double *b,
+                                    const double *c, const int *msg_id,
+                                    unsigned int *scaled) {
+  qe_vd va, vb, vc, p, q;
+  qe_vm two, in, mask;
+
+  va = V_LOADU(a);
+  vb = V_LOADU(b);
+  vc = V_LOADU(c);
+
+  /* Only the pairs of roots, with the parameters in range. */
+  two = V_CMPEQ(V_LOAD_MSG(msg_id), V_SET1(QE_OK_TWO_RES));
+  in = M_AND(M_AND(QE_POLISH_IN_RANGE(va), QE_POLISH_IN_RANGE(vb)),
+             QE_POLISH_IN_RANGE(vc));
+  mask = M_AND(two, in);
+  *scaled = M_BITS(two) & ~M_BITS(in);
+
+  /* A discriminant close to 0, or b * b >> |4 * a * c|. */
+  p = V_MUL(vb, vb);
+  q = V_MUL(V_MUL(V_SET1(4.0), va), vc);
+  return M_AND(
+      mask, M_OR(V_CMPLE(V_ABS(V_SUB(p, q)), V_MUL(V_SET1(QE_POLISH_NEAR), p)),
+                 V_CMPLE(V_ABS(q), V_MUL(V_SET1(QE_POLISH_FAR), p))));
+}
+
+/* The function polishes the roots of QE_W equations (polish_pair). */
+static inline __attribute__((always_inline)) void
+QE_POLISH_LANES(const double *a, const double *b, const double *c,
+                double *res1, double *res2) {
+  const qe_vd zero = V_SET1(0.0);
+  qe_vd va, vb, vc, x1, x2, x, y, sign, a2;
+  qe_vm first;
+
+  va = V_LOADU(a);
+  vb = V_LOADU(b);
+  vc = V_LOADU(c);
+  x1 = V_LOADU(res1);
+  x2 = V_LOADU(res2);
+
+  first = V_CMPLE(V_ABS(x2), V_ABS(x1));
+  x = V_SEL(first, x1, x2);
+  sign = V_SEL(first, V_SET1(1.0), V_SET1(-1.0));
+  a2 = V_MUL(V_SET1(2.0), va);
+
+  for (int k = 0; k < QE_POLISH_STEPS; k++) {
+    qe_vd f, p, pe, fp, d, s;
+
+    f = QE_POLISH_RESIDUAL(va, vb, vc, x);
+    V_TWO_PROD(p, pe, a2, x);
+    fp = V_ADD(V_ADD(p, vb), pe);
+    d = V_SUB(V_MUL(fp, fp), V_MUL(V_MUL(V_SET1(4.0), va), f));
+    s = V_MUL(sign, V_SQRT(V_SEL(V_CMPLT(d, zero), zero, d)));
+
+    y = QE_POLISH_STEP(a2, x, f, fp, s);
+    x = V_SEL(V_CMPLE(V_ABS(y), V_SET1(DBL_MAX)), y, x);
+  }
+
+  y = V_DIV(vc, V_MUL(va, x));
+  V_STOREU(res1, V_SEL(first, x, y));
+  V_STOREU(res2, V_SEL(first, y, x));
+}
+
+/*
+ * The kernel. The equations that need polishing are found a vector
+ * at a time, copied to the arrays on the stack one after another
+ * and polished there, so every vector of the polishing is full.
+ * The last vector is padded with copies of the last equation. The
+ * last incomplete vector of the arrays is polished by
+ * qe_polish_generic.
+ */
+void QE_POLISH(const double *a, const double *b, const double *c,
+               double *res1, double *res2, const int *msg_id, size_t n) {
+  double ta[QE_POLISH_CHUNK], tb[QE_POLISH_CHUNK], tc[QE_POLISH_CHUNK];
+  double t1[QE_POLISH_CHUNK], t2[QE_POLISH_CHUNK];
+  size_t idx[QE_POLISH_CHUNK], end = n - n % QE_W;
+
+  for (size_t i0 = 0; i0 < end; i0 += QE_POLISH_CHUNK) {
+    size_t m = (end - i0 < QE_POLISH_CHUNK) ? end - i0 : QE_POLISH_CHUNK;
+    size_t k = 0;
+
+    for (size_t i = i0; i < i0 + m; i += QE_W) {
+      unsigned int scaled, bits = M_BITS(
+          QE_POLISH_FLAGS(a + i, b + i, c + i, msg_id + i, &scaled));
+
+      for (; scaled != 0; scaled &= scaled - 1) {
+        size_t j = i + (size_t)__builtin_ctz(scaled);
+
+        qe_polish_scaled(a[j], b[j], c[j], &res1[j], &res2[j]);
+      }
+
+      if (bits == (1u << QE_W) - 1) {
+        QE_POLISH_LANES(a + i, b + i, c + i, res1 + i, res2 + i);
+        continue;
+      }
+
+      if (bits == 0)
+        continue;
+
+      for (size_t j = 0; j < QE_W; j++) {
+        idx[k] = i + j;
+        k += (bits >> j) & 1;
+      }
+    }
+
+    if (k == 0)
+      continue;
+
+    for (size_t j = 0; j < k + (QE_W - k % QE_W) % QE_W; j++) {
+      size_t i = idx[(j < k) ? j : k - 1];
+
+      ta[j] = a[i];
+      tb[j] = b[i];
+      tc[j] = c[i];
+      t1[j] = res1[i];
+      t2[j] = res2[i];
+    }
+
+    for (size_t j = 0; j < k; j += QE_W)
+      QE_POLISH_LANES(ta + j, tb + j, tc + j, t1 + j, t2 + j);
+
+    for (size_t j = 0; j < k; j++) {
+      res1[idx[j]] = t1[j];
+      res2[idx[j]] = t2[j];
+    }
+  }
+
+  if (end < n)
+    qe_polish_generic(a + end, b + end, c + end, res1 + end, res2 + end,
+                      msg_id + end, n - end);
+}
+
+#undef QE_POLISH_TWO_SUM
+#undef QE_POLISH_RESIDUAL
+#undef QE_POLISH_STEP
+#undef QE_POLISH_LANES
+#undef QE_POLISH_IN_RANGE
+#undef QE_POLISH_FLAGS
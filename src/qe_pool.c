@@ -0,0 +1,326 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the pool of worker
+ * threads (qe_pool) and of the solve_equation_batch_parallel
+ * function.
+ *
+ * The threads are created once and sleep on a condition
+ * variable between jobs. A job of n chunks is split into equal
+ * ranges, one per thread. Every range has its own cursor, the
+ * next chunk to process, which is advanced atomically. A thread
+ * takes the chunks of its own range and then the chunks of the
+ * ranges of other threads (work stealing), so the threads that
+ * got cheaper chunks or started later do not hold the job.
+ *
+-------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include "qe_internal.h"
+#include "qe_pool.h"
+#include "quadratic_equation.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+/*
+ * The range of chunks of one thread. The cursors of different
+ * threads are in different cache lines, so taking a chunk does
+ * not slow down the other threads.
+ */
+typedef struct {
+  size_t next; /* The next chunk, advanced atomically. */
+  size_t end;  /* The end of the range. */
+  char pad[64 - 2 * sizeof(size_t)];
+} qe_range;
+
+/* The argument of a worker thread. */
+typedef struct {
+  qe_pool *pool;
+  int id;
+} qe_worker;
+
+/* The worker of the current thread, NULL for other threads. */
+static __thread const qe_worker *qe_self;
+
+struct qe_pool {
+  int nthreads;
+  pthread_t *threads;
+  qe_worker *workers;
+  qe_range *ranges;
+
+  /* The current job, protected by lock. */
+  pthread_mutex_t lock;
+  pthread_cond_t start;
+  pthread_cond_t done;
+  unsigned long generation; /* The number of the current job. */
+  int active;               /* Threads that have not finished it. */
+  int stop;
+  qe_pool_task fn;
+  void *ctx;
+
+  /* Serializes the jobs of different callers. */
+  pthread_mutex_t run_lock;
+};
+
+/*
+ * The function processes the chunks of the job: first of the
+ * range of the thread id, then of the ranges of the other threads.
+ */
+static void run_chunks(qe_pool *pool, int id, qe_pool_task fn, void *ctx) {
+  for (int k = 0; k < pool->nthreads; k++) {
+    qe_range *r = &pool->ranges[(id + k) % pool->nthreads];
+    size_t chunk;
+
+    while ((chunk = __atomic_fetch_add(&r->next, 1, __ATOMIC_RELAXED)) <
+           r->end)
+      fn(ctx, chunk);
+  }
+}
+
+/* The function of a worker thread. */
+static void *worker_main(void *arg) {
+  qe_worker *w = arg;
+  qe_pool *pool = w->pool;
+  unsigned long seen = 0;
+  qe_pool_task fn;
+  void *ctx;
+
+  qe_self = w;
+  for (;;) {
+    pthread_mutex_lock(&pool->lock);
+    while (!pool->stop && (pool->generation == seen))
+      pthread_cond_wait(&pool->start, &pool->lock);
+
+    if (pool->stop) {
+      pthread_mutex_unlock(&pool->lock);
+      return NULL;
+    }
+
+    seen = pool->generation;
+    fn = pool->fn;
+    ctx = pool->ctx;
+    pthread_mutex_unlock(&pool->lock);
+
+    run_chunks(pool, w->id, fn, ctx);
+
+    pthread_mutex_lock(&pool->lock);
+    if (--pool->active == 0)
+      pthread_cond_signal(&pool->done);
+    pthread_mutex_unlock(&pool->lock);
+  }
+}
+
+/*
+ * The function creates a pool of nthreads threads, if pin is not
+ * zero, they are bound to the available processors one by one.
+ */
+qe_pool *qe_pool_create(int nthreads, int pin) {
+  cpu_set_t avail;
+  qe_pool *pool;
+  int ncpu = 0, cpu = -1;
+
+  if (sched_getaffinity(0, sizeof(avail), &avail) == 0)
+    ncpu = CPU_COUNT(&avail);
+  if (nthreads <= 0)
+    nthreads = (ncpu > 0) ? ncpu : 1;
+
+  pool = calloc(1, sizeof(*pool));
+  if (pool == NULL)
+    return NULL;
+
+  pool->threads = calloc(nthreads, sizeof(pthread_t));
+  pool->workers = calloc(nthreads, sizeof(qe_worker));
+  if ((pool->threads == NULL) || (pool->workers == NULL) ||
+      (posix_memalign((void **)&pool->ranges, 64,
+                      nthreads * sizeof(qe_range)) != 0)) {
+    free(pool->threads);
+    free(pool->workers);
+    free(pool);
+    return NULL;
+  }
+
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_mutex_init(&pool->run_lock, NULL);
+  pthread_cond_init(&pool->start, NULL);
+  pthread_cond_init(&pool->done, NULL);
+
+  for (int i = 0; i < nthreads; i++) {
+    pthread_attr_t attr;
+    cpu_set_t set;
+    int err;
+
+    pool->ranges[i].next = pool->ranges[i].end = 0;
+    pool->workers[i].pool = pool;
+    pool->workers[i].id = i;
+
+    pthread_attr_init(&attr);
+
+    /* The next available processor, in a cycle. */
+    if (pin && (ncpu > 0)) {
+      do
+        cpu = (cpu + 1) % CPU_SETSIZE;
+      while (!CPU_ISSET(cpu, &avail));
+
+      CPU_ZERO(&set);
+      CPU_SET(cpu, &set);
+      pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+    }
+
+    err = pthread_create(&pool->threads[i], &attr, worker_main,
+                         &pool->workers[i]);
+    pthread_attr_destroy(&attr);
+
+    if (err != 0) {
+      pool->nthreads = i;
+      qe_pool_destroy(pool);
+      return NULL;
+    }
+  }
+
+  pool->nthreads = nthreads;
+  return pool;
+}
+
+/* The function stops the threads of the pool and frees it. */
+void qe_pool_destroy(qe_pool *pool) {
+
+  if (pool == NULL)
+    return;
+
+  pthread_mutex_lock(&pool->lock);
+  pool->stop = 1;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (int i = 0; i < pool->nthreads; i++)
+    pthread_join(pool->threads[i], NULL);
+
+  pthread_mutex_destroy(&pool->lock);
+  pthread_mutex_destroy(&pool->run_lock);
+  pthread_cond_destroy(&pool->start);
+  pthread_cond_destroy(&pool->done);
+
+  free(pool->threads);
+  free(pool->workers);
+  free(pool->ranges);
+  free(pool);
+}
+
+/* The function returns the number of threads of the pool. */
+int qe_pool_size(const qe_pool *pool) { return pool->nthreads; }
+
+/* The function returns the number of the calling thread in the pool. */
+int qe_pool_thread_index(const qe_pool *pool) {
+  if ((qe_self != NULL) && (qe_self->pool == pool))
+    return qe_self->id;
+  return pool->nthreads;
+}
+
+/*
+ * The function runs a job of nchunks chunks on the threads of
+ * the pool and waits for it to finish. A worker of the pool that
+ * runs a job (from a task) would wait for itself on run_lock, so
+ * it processes the chunks in order itself.
+ */
+void qe_pool_run(qe_pool *pool, size_t nchunks, qe_pool_task fn, void *ctx) {
+  size_t per, extra, pos = 0;
+
+  if (nchunks == 0)
+    return;
+
+  /*
+   * Waking the threads would take longer than one chunk, and a
+   * worker of the pool can not wait for the other workers.
+   */
+  if ((nchunks == 1) || (qe_pool_thread_index(pool) < pool->nthreads)) {
+    for (size_t i = 0; i < nchunks; i++)
+      fn(ctx, i);
+    return;
+  }
+
+  pthread_mutex_lock(&pool->run_lock);
+
+  /* Equal ranges, the first `extra` ones are one chunk longer. */
+  per = nchunks / pool->nthreads;
+  extra = nchunks % pool->nthreads;
+  for (int i = 0; i < pool->nthreads; i++) {
+    pool->ranges[i].next = pos;
+    pos += per + ((size_t)i < extra);
+    pool->ranges[i].end = pos;
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  pool->fn = fn;
+  pool->ctx = ctx;
+  pool->active = pool->nthreads;
+  pool->generation++;
+  pthread_cond_broadcast(&pool->start);
+
+  while (pool->active > 0)
+    pthread_cond_wait(&pool->done, &pool->lock);
+  pthread_mutex_unlock(&pool->lock);
+
+  pthread_mutex_unlock(&pool->run_lock);
+}
+
+/* The default pool, created at the first call that needs it. */
+static qe_pool *qe_default_pool;
+static pthread_once_t qe_default_once = PTHREAD_ONCE_INIT;
+
+static void create_default_pool(void) {
+  qe_default_pool = qe_pool_create(0, 0);
+}
+
+/* The function returns the default pool, or NULL if it failed. */
+qe_pool *qe_pool_default(void) {
+  pthread_once(&qe_default_once, create_default_pool);
+  return qe_default_pool;
+}
+
+/* The job of solve_equation_batch_parallel. */
+typedef struct {
+  const double *a, *b, *c;
+  double *res1, *res2;
+  int *msg_id;
+  size_t n;
+  int prec;
+} qe_batch_job;
+
+/* The function solves one chunk of the equations. */
+static void solve_chunk(void *ctx, size_t chunk) {
+  qe_batch_job *job = ctx;
+  size_t i = chunk * QE_POOL_CHUNK;
+  size_t len = (job->n - i < QE_POOL_CHUNK) ? job->n - i : QE_POOL_CHUNK;
+
+  solve_equation_batch_prec(job->a + i, job->b + i, job->c + i,
+                            job->res1 + i, job->res2 + i, job->msg_id + i,
+                            len, job->prec);
+}
+
+/*
+ * Implementation of the solve_equation_batch_parallel function. If
+ * the default pool could not be created, the equations are solved
+ * in the calling thread.
+ */
+int solve_equation_batch_parallel(qe_pool *pool, const double *a,
+                                  const double *b, const double *c,
+                                  double *res1, double *res2, int *msg_id,
+                                  size_t n, int prec) {
+  qe_batch_job job = {a, b, c, res1, res2, msg_id, n, prec};
+
+  /* Checking pointers for a non-NULL value. */
+  if ((a == NULL) || (b == NULL) || (c == NULL) || (res1 == NULL) ||
+      (res2 == NULL) || (msg_id == NULL))
+    return QE_ERR_NULLPTR;
+
+  if (pool == NULL)
+    pool = qe_pool_default();
+
+  if (pool == NULL)
+    return solve_equation_batch_prec(a, b, c, res1, res2, msg_id, n, prec);
+
+  qe_pool_run(pool, (n + QE_POOL_CHUNK - 1) / QE_POOL_CHUNK, solve_chunk,
+              &job);
+  return QE_BATCH_OK;
+}
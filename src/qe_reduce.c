@@ -0,0 +1,463 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the fused batch
+ * functions, which solve the equations and reduce their results
+ * (solve_equation_batch_reduce and its parallel variant).
+ *
+ * The equations are solved by the batch kernels in tiles of
+ * QE_REDUCE_TILE equations into arrays on the stack (10 KB, in
+ * the L1 cache). The counts pass over the msg_id of the tile. The
+ * real roots of the tile are compacted into a dense array, so the
+ * reducers of the roots (the minimum and the maximum, the sum and
+ * the histogram) run only over the roots, specialized for the
+ * selected ones, with their accumulators in local variables. A
+ * histogram of up to QE_REDUCE_LOCAL bins is counted in 32-bit
+ * counters on the stack. So the roots never reach the memory, and
+ * the reducers that are not selected cost nothing.
+ *
+ * The parallel variant gives every thread of the pool its own
+ * partial qe_reduce (and bins), found by qe_pool_thread_index, so
+ * the threads do not share cache lines; the partial results are
+ * merged after the job.
+ *
+-------------------------------------------------------------*/
+
+#include "qe_internal.h"
+#include "qe_reduce.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The function adds x to the compensated sum (*s, *err). The
+ * rounding error of the addition is found by Knuth's TwoSum,
+ * which needs no comparison of the magnitudes.
+ */
+static inline void sum_add(double *s, double *err, double x) {
+  double t = *s + x, bp = t - *s;
+
+  *err += (*s - (t - bp)) + (x - bp);
+  *s = t;
+}
+
+/*
+ * The function adds x to the minimum *lo and the maximum *hi. A NaN
+ * fails both comparisons and is ignored.
+ */
+static inline void minmax_add(double *lo, double *hi, double x) {
+  *lo = (x < *lo) ? x : *lo;
+  *hi = (x > *hi) ? x : *hi;
+}
+
+/*
+ * The function returns the larger of two roots, ignoring a NaN as
+ * fmax does (NaN for two NaN). The first comparison becomes maxsd,
+ * which gives x1 if it is NaN.
+ */
+static inline double larger(double x1, double x2) {
+  double y = (x2 > x1) ? x2 : x1;
+
+  return (y == y) ? y : x2;
+}
+
+/*
+ * The function checks the reducers of r. In case of an error,
+ * it returns 1.
+ */
+static int check_reduce(const qe_reduce *r) {
+  return (r->what & QE_REDUCE_HIST) &&
+         ((r->bins == NULL) || (r->nbins == 0) ||
+          (r->nbins > UINT32_MAX) || !(r->hist_lo < r->hist_hi));
+}
+
+/* Implementation of the qe_reduce_reset function. */
+void qe_reduce_reset(qe_reduce *r) {
+  memset(r->counts, 0, sizeof(r->counts));
+  r->nroots = 0;
+  r->min_root = INFINITY;
+  r->max_root = -INFINITY;
+  r->sum_larger = 0;
+  r->sum_err = 0;
+  r->below = 0;
+  r->above = 0;
+  if ((r->what & QE_REDUCE_HIST) && (r->bins != NULL))
+    memset(r->bins, 0, r->nbins * sizeof(r->bins[0]));
+}
+
+/* Implementation of the qe_reduce_merge function. */
+void qe_reduce_merge(qe_reduce *dst, const qe_reduce *src) {
+  for (int i = 0; i < QE_REDUCE_STATUSES; i++)
+    dst->counts[i] += src->counts[i];
+
+  dst->nroots += src->nroots;
+  if (src->min_root < dst->min_root)
+    dst->min_root = src->min_root;
+  if (src->max_root > dst->max_root)
+    dst->max_root = src->max_root;
+
+  sum_add(&dst->sum_larger, &dst->sum_err, src->sum_larger);
+  dst->sum_err += src->sum_err;
+
+  dst->below += src->below;
+  dst->above += src->above;
+  if ((dst->what & QE_REDUCE_HIST) && (src->what & QE_REDUCE_HIST))
+    for (size_t i = 0; i < dst->nbins; i++)
+      dst->bins[i] += src->bins[i];
+}
+
+/* The reducers of the roots, which share the pass over a tile. */
+#define QE_REDUCE_ROOTS (QE_REDUCE_MINMAX | QE_REDUCE_SUM | QE_REDUCE_HIST)
+
+/*
+ * A histogram of at most QE_REDUCE_LOCAL bins is counted by
+ * reduce_range in a local one of 32-bit counters, in two copies of
+ * QE_REDUCE_SLOTS slots (for the even and the odd roots, so the
+ * increments of one bin do not wait for each other). Slot 0 counts
+ * the roots below the range, slots 1 to nbins the bins, slot
+ * nbins + 1 the roots above the range and slot nbins + 2 the NaN
+ * roots. It is added to the bins of r after every QE_REDUCE_FLUSH
+ * equations, before a counter could overflow.
+ */
+#define QE_REDUCE_LOCAL 1024
+#define QE_REDUCE_SLOTS (QE_REDUCE_LOCAL + 3)
+#define QE_REDUCE_FLUSH ((size_t)1 << 30)
+
+/*
+ * The function adds the roots of a tile of m equations to the
+ * reducers of r selected by `what`. It is inlined with a constant
+ * `what`, so the reducers that are not selected cost nothing.
+ *
+ * The first pass compacts the tile without branches that depend on
+ * the data: both roots of a lane are written at the end of roots,
+ * and the end moves by the number of its roots (0, 1 or 2), so the
+ * lanes without roots are dropped; the larger root of a lane with
+ * roots goes to big in the same way. The reducers then run over the
+ * dense arrays with four sets of accumulators, so the lanes without
+ * roots cost nothing, and an addition or a comparison does not wait
+ * for the last one. The histogram is counted in local if it is not
+ * NULL: the slot of a root (below, a bin, above or NaN) is selected
+ * by the products of the comparisons, not by branches.
+ */
+static inline __attribute__((always_inline)) void
+reduce_roots(qe_reduce *r, uint32_t *local, const double *res1,
+             const double *res2, const int *msg_id, size_t m,
+             unsigned int what) {
+  double roots[2 * QE_REDUCE_TILE + 2], big[QE_REDUCE_TILE + 1];
+  uint32_t bin[2 * QE_REDUCE_TILE];
+  size_t nr = 0, nb = 0, i;
+
+  for (i = 0; i < m; i++) {
+    double x1 = res1[i], x2 = res2[i];
+    int two = (msg_id[i] == QE_OK_TWO_RES);
+    int one = (msg_id[i] == QE_OK_ONE_RES);
+
+    if (what & (QE_REDUCE_MINMAX | QE_REDUCE_HIST)) {
+      /*
+       * One store of both roots: a store of x2 followed by a store
+       * of the next x1 to the same slot is much slower.
+       */
+      double pair[2] = {x1, x2};
+
+      memcpy(roots + nr, pair, sizeof(pair));
+      nr += (size_t)(2 * two + one);
+    }
+    if (what & QE_REDUCE_SUM) {
+      /* A lane whose roots are both NaN adds nothing. */
+      double y = larger(x1, x2);
+
+      big[nb] = y;
+      nb += (size_t)((two | one) & (y == y));
+    }
+  }
+
+  if (what & QE_REDUCE_MINMAX) {
+    double lo0 = r->min_root, lo1 = INFINITY, lo2 = INFINITY, lo3 = INFINITY;
+    double hi0 = r->max_root, hi1 = -INFINITY, hi2 = -INFINITY;
+    double hi3 = -INFINITY;
+
+    for (i = 0; i + 3 < nr; i += 4) {
+      minmax_add(&lo0, &hi0, roots[i]);
+      minmax_add(&lo1, &hi1, roots[i + 1]);
+      minmax_add(&lo2, &hi2, roots[i + 2]);
+      minmax_add(&lo3, &hi3, roots[i + 3]);
+    }
+    for (; i < nr; i++)
+      minmax_add(&lo0, &hi0, roots[i]);
+
+    /* The infinities of the empty sets change nothing. */
+    minmax_add(&lo0, &hi0, lo1);
+    minmax_add(&lo2, &hi2, lo3);
+    minmax_add(&lo0, &hi0, hi1);
+    minmax_add(&lo2, &hi2, hi3);
+    minmax_add(&lo0, &hi0, lo2);
+    minmax_add(&lo0, &hi0, hi2);
+    r->min_root = lo0;
+    r->max_root = hi0;
+    r->nroots += nr;
+  }
+
+  if (what & QE_REDUCE_SUM) {
+    double s0 = r->sum_larger, s1 = 0, s2 = 0, s3 = 0;
+    double err0 = r->sum_err, err1 = 0, err2 = 0, err3 = 0;
+
+    for (i = 0; i + 3 < nb; i += 4) {
+      sum_add(&s0, &err0, big[i]);
+      sum_add(&s1, &err1, big[i + 1]);
+      sum_add(&s2, &err2, big[i + 2]);
+      sum_add(&s3, &err3, big[i + 3]);
+    }
+    for (; i < nb; i++)
+      sum_add(&s0, &err0, big[i]);
+
+    sum_add(&s0, &err0, s1);
+    sum_add(&s2, &err2, s3);
+    sum_add(&s0, &err0, s2);
+    r->sum_larger = s0;
+    r->sum_err = err0 + err1 + err2 + err3;
+  }
+
+  if ((what & QE_REDUCE_HIST) && (local != NULL)) {
+    double lo = r->hist_lo, hi = r->hist_hi;
+    double scale = (double)r->nbins / (hi - lo);
+    double last = (double)r->nbins;
+    double first = last / last; /* Not a constant: maxsd, no branch. */
+    int nb1 = (int)r->nbins + 1, nb2 = (int)r->nbins + 2;
+
+    for (i = 0; i < nr; i++) {
+      double x = roots[i], y = (x - lo) * scale + 1;
+      int k;
+
+      /*
+       * The bin is clamped to 1..nbins, since the rounding may give
+       * nbins + 1 for x just below hi; then the products select the
+       * slot (the ternary operators become branches here).
+       */
+      y = (y < last) ? y : last;
+      y = (y > first) ? y : first;
+      k = (int)y * ((x >= lo) & (x < hi)) + nb1 * (x >= hi) + nb2 * (x != x);
+      local[(i & 1) * QE_REDUCE_SLOTS + k]++;
+    }
+  } else if (what & QE_REDUCE_HIST) {
+    double lo = r->hist_lo, hi = r->hist_hi;
+    double scale = (double)r->nbins / (hi - lo);
+    double last = (double)(r->nbins - 1);
+    double first = 0 * last; /* Not a constant: maxsd, no branch. */
+    unsigned long long below = 0, above = 0;
+    size_t nbin = 0;
+
+    for (i = 0; i < nr; i++) {
+      double x = roots[i], y = (x - lo) * scale;
+
+      /*
+       * The index of a root out of the range is clamped too (it is
+       * written, but not kept), and the rounding may give nbins for
+       * x just below hi.
+       */
+      y = (y > first) ? y : first;
+      y = (y < last) ? y : last;
+      below += (unsigned int)(x < lo);
+      above += (unsigned int)(x >= hi);
+      bin[nbin] = (uint32_t)y;
+      nbin += (size_t)((x >= lo) & (x < hi));
+    }
+
+    for (i = 0; i < nbin; i++)
+      r->bins[bin[i]]++;
+    r->below += below;
+    r->above += above;
+  }
+}
+
+/*
+ * The function adds the results of a tile of m equations to the
+ * reducers of r: the counts in their own pass, the reducers of the
+ * roots over the compacted roots, specialized for the selected ones.
+ */
+static void reduce_tile(qe_reduce *r, uint32_t *local, const double *res1,
+                        const double *res2, const int *msg_id, size_t m) {
+  if (r->what & QE_REDUCE_COUNTS) {
+    /* Four sets of counters, so an increment does not wait for the last. */
+    unsigned int counts[4][QE_REDUCE_STATUSES] = {{0}};
+
+    for (size_t i = 0; i < m; i++)
+      counts[i % 4][msg_id[i] - QE_ERR_NULLPTR]++;
+    for (int k = 0; k < QE_REDUCE_STATUSES; k++)
+      r->counts[k] += (unsigned long long)counts[0][k] + counts[1][k] +
+                      counts[2][k] + counts[3][k];
+  }
+
+  switch (r->what & QE_REDUCE_ROOTS) {
+  case QE_REDUCE_MINMAX:
+    reduce_roots(r, local, res1, res2, msg_id, m,
+                 QE_REDUCE_MINMAX);
+    break;
+  case QE_REDUCE_SUM:
+    reduce_roots(r, local, res1, res2, msg_id, m,
+                 QE_REDUCE_SUM);
+    break;
+  case QE_REDUCE_HIST:
+    reduce_roots(r, local, res1, res2, msg_id, m,
+                 QE_REDUCE_HIST);
+    break;
+  case QE_REDUCE_MINMAX | QE_REDUCE_SUM:
+    reduce_roots(r, local, res1, res2, msg_id, m,
+                 QE_REDUCE_MINMAX | QE_REDUCE_SUM);
+    break;
+  case QE_REDUCE_MINMAX | QE_REDUCE_HIST:
+    reduce_roots(r, local, res1, res2, msg_id, m,
+                 QE_REDUCE_MINMAX | QE_REDUCE_HIST);
+    break;
+  case QE_REDUCE_SUM | QE_REDUCE_HIST:
+    reduce_roots(r, local, res1, res2, msg_id, m,
+                 QE_REDUCE_SUM | QE_REDUCE_HIST);
+    break;
+  case QE_REDUCE_ROOTS:
+    reduce_roots(r, local, res1, res2, msg_id, m,
+                 QE_REDUCE_ROOTS);
+    break;
+  }
+}
+
+/*
+ * The function adds the local histogram to the bins of r and
+ * clears it.
+ */
+static void flush_local(qe_reduce *r, uint32_t *local) {
+  const uint32_t *odd = local + QE_REDUCE_SLOTS;
+  size_t nb = r->nbins;
+
+  r->below += (unsigned long long)local[0] + odd[0];
+  for (size_t k = 0; k < nb; k++)
+    r->bins[k] += (unsigned long long)local[k + 1] + odd[k + 1];
+  r->above += (unsigned long long)local[nb + 1] + odd[nb + 1];
+
+  memset(local, 0, (nb + 3) * sizeof(local[0]));
+  memset(local + QE_REDUCE_SLOTS, 0, (nb + 3) * sizeof(local[0]));
+}
+
+/*
+ * The function solves n equations by tiles and reduces them
+ * into r, the pointers are already checked.
+ */
+static void reduce_range(const double *a, const double *b, const double *c,
+                         qe_reduce *r, size_t n, int prec) {
+  double res1[QE_REDUCE_TILE], res2[QE_REDUCE_TILE];
+  int msg_id[QE_REDUCE_TILE];
+  uint32_t slots[2 * QE_REDUCE_SLOTS], *local = NULL;
+
+  if ((r->what & QE_REDUCE_HIST) && (r->nbins <= QE_REDUCE_LOCAL)) {
+    local = slots;
+    memset(local, 0, (r->nbins + 3) * sizeof(local[0]));
+    memset(local + QE_REDUCE_SLOTS, 0, (r->nbins + 3) * sizeof(local[0]));
+  }
+
+  for (size_t i = 0; i < n; i += QE_REDUCE_TILE) {
+    size_t m = (n - i < QE_REDUCE_TILE) ? n - i : QE_REDUCE_TILE;
+
+    solve_equation_batch_prec(a + i, b + i, c + i, res1, res2, msg_id, m,
+                              prec);
+    reduce_tile(r, local, res1, res2, msg_id, m);
+    if ((local != NULL) && ((i + m) % QE_REDUCE_FLUSH == 0))
+      flush_local(r, local);
+  }
+
+  if (local != NULL)
+    flush_local(r, local);
+}
+
+/*
+ * Implementation of the solve_equation_batch_reduce function.
+ */
+int solve_equation_batch_reduce(const double *a, const double *b,
+                                const double *c, qe_reduce *r, size_t n,
+                                int prec) {
+
+  /* Checking pointers for a non-NULL value. */
+  if ((a == NULL) || (b == NULL) || (c == NULL) || (r == NULL) ||
+      check_reduce(r))
+    return QE_ERR_NULLPTR;
+
+  reduce_range(a, b, c, r, n, prec);
+  return QE_BATCH_OK;
+}
+
+/*
+ * A partial result of a thread, padded so that the partial
+ * results of different threads do not share a cache line.
+ */
+typedef struct {
+  qe_reduce r;
+  char pad[64];
+} qe_reduce_part;
+
+/* The job of solve_equation_batch_reduce_parallel. */
+typedef struct {
+  const double *a, *b, *c;
+  qe_pool *pool;
+  qe_reduce_part *parts; /* qe_pool_size(pool) + 1 partial results. */
+  size_t n;
+  int prec;
+} qe_reduce_job;
+
+/* The function reduces one chunk into the partial result of the thread. */
+static void reduce_chunk(void *ctx, size_t chunk) {
+  qe_reduce_job *job = ctx;
+  qe_reduce *r = &job->parts[qe_pool_thread_index(job->pool)].r;
+  size_t i = chunk * QE_POOL_CHUNK;
+  size_t len = (job->n - i < QE_POOL_CHUNK) ? job->n - i : QE_POOL_CHUNK;
+
+  reduce_range(job->a + i, job->b + i, job->c + i, r, len, job->prec);
+}
+
+/*
+ * Implementation of the solve_equation_batch_reduce_parallel
+ * function. If the default pool or the partial results could not
+ * be created, the equations are reduced in the calling thread.
+ */
+int solve_equation_batch_reduce_parallel(qe_pool *pool, const double *a,
+                                         const double *b, const double *c,
+                                         qe_reduce *r, size_t n, int prec) {
+  qe_reduce_job job = {a, b, c, pool, NULL, n, prec};
+  unsigned long long *bins = NULL;
+  size_t nparts, nbins;
+
+  /* Checking pointers for a non-NULL value. */
+  if ((a == NULL) || (b == NULL) || (c == NULL) || (r == NULL) ||
+      check_reduce(r))
+    return QE_ERR_NULLPTR;
+
+  if (pool == NULL)
+    job.pool = pool = qe_pool_default();
+  if ((pool == NULL) || (n <= QE_POOL_CHUNK)) {
+    reduce_range(a, b, c, r, n, prec);
+    return QE_BATCH_OK;
+  }
+
+  nparts = (size_t)qe_pool_size(pool) + 1;
+  nbins = (r->what & QE_REDUCE_HIST) ? r->nbins : 0;
+  job.parts = malloc(nparts * sizeof(qe_reduce_part));
+  if (nbins > 0)
+    bins = calloc(nparts * nbins, sizeof(bins[0]));
+  if ((job.parts == NULL) || ((nbins > 0) && (bins == NULL))) {
+    free(job.parts);
+    free(bins);
+    reduce_range(a, b, c, r, n, prec);
+    return QE_BATCH_OK;
+  }
+
+  for (size_t k = 0; k < nparts; k++) {
+    job.parts[k].r = *r;
+    job.parts[k].r.bins = (bins != NULL) ? bins + k * nbins : NULL;
+    qe_reduce_reset(&job.parts[k].r);
+  }
+
+  qe_pool_run(pool, (n + QE_POOL_CHUNK - 1) / QE_POOL_CHUNK, reduce_chunk,
+              &job);
+
+  for (size_t k = 0; k < nparts; k++)
+    qe_reduce_merge(r, &job.parts[k].r);
+
+  free(job.parts);
+  free(bins);
+  return QE_BATCH_OK;
+}
@@ -0,0 +1,68 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the qe_served
+ * daemon, which solves the equations of local clients. The
+ * protocol and the client functions are described in
+ * qe_served.h, the server is in qe_server.c.
+ *
+ * Usage: qe_served socket
+ *
+ * The daemon listens on the Unix domain socket until it gets
+ * SIGINT or SIGTERM, then it removes the socket file.
+ *
+-------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "qe_served.h"
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+
+/* The server stopped by the signal handler. */
+static qe_server *qe_served_server;
+
+/* The handler of SIGINT and SIGTERM. */
+static void handle_stop(int sig) {
+  (void)sig;
+  qe_server_stop(qe_served_server);
+}
+
+/*
+ * The main function creates the server, runs it until a signal
+ * comes and removes the socket.
+ */
+int main(int argc, char *argv[]) {
+  struct sigaction sa;
+  int res;
+
+  if (argc != 2) {
+    fprintf(stderr, "Usage: %s socket\n", argv[0]);
+    return 1;
+  }
+
+  qe_served_server = qe_server_create(argv[1]);
+  if (qe_served_server == NULL) {
+    fprintf(stderr, "qe_served: can not listen on %s: %s.\n", argv[1],
+            strerror(errno));
+    return 1;
+  }
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = handle_stop;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+
+  /* The replies to the clients that are gone must not kill it. */
+  sa.sa_handler = SIG_IGN;
+  sigaction(SIGPIPE, &sa, NULL);
+
+  res = qe_server_run(qe_served_server);
+  if (res != 0)
+    perror("qe_served");
+
+  qe_server_destroy(qe_served_server);
+  return (res != 0);
+}
@@ -0,0 +1,625 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the server of the
+ * qe_served daemon (qe_server). The protocol is described in
+ * qe_served.h.
+ *
+ * The server runs a level-triggered epoll loop in one thread.
+ * A round of the loop reads what the clients sent, takes the
+ * complete frames one per client in turn (so a client with many
+ * frames does not hold the others) until QE_SERVER_ROUND
+ * equations are taken, solves them by solve_equation_batch_prec,
+ * one batch per precision mode, and writes the replies. If
+ * frames are left for the next round, the next epoll_wait does
+ * not sleep. The bounded round keeps the latency of a small
+ * frame predictable however large the frames of others are.
+ *
+ * A client is not read while its buffer holds a complete frame
+ * that was not taken, and its frames are not taken while more
+ * than QE_SERVER_OUT_LIMIT bytes of its replies wait to be sent,
+ * so the memory of a client that does not read is bounded.
+ *
+-------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include "qe_served.h"
+#include "quadratic_equation.h"
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/* The maximum number of equations solved in one round of the loop. */
+#define QE_SERVER_ROUND 65536
+
+/* The bytes of replies that may wait before the frames are not taken. */
+#define QE_SERVER_OUT_LIMIT (4 << 20)
+
+/* The minimum size of the buffers of a client. */
+#define QE_SERVER_BUF_SIZE 65536
+
+/* The number of events taken by one epoll_wait. */
+#define QE_SERVER_EVENTS 256
+
+/* A byte buffer. */
+typedef struct {
+  char *data;
+  size_t len; /* The bytes in the buffer. */
+  size_t off; /* The bytes already consumed. */
+  size_t cap;
+} qe_buf;
+
+/*
+ * A connection of a client. The connections are in the list of
+ * the server, the ones with frames to take are also in the ready
+ * list, and the closed ones wait in the dead list for the end of
+ * the round (a frame or an event of the round may refer to them).
+ */
+typedef struct qe_conn {
+  int fd;
+  unsigned int events; /* The events registered in epoll. */
+  int ready;           /* Whether it is in the ready list. */
+  int eof;             /* The client closed its side. */
+  int dead;            /* Whether it is in the dead list. */
+  qe_buf in, out;
+  struct qe_conn *prev, *next; /* The list of the server. */
+  struct qe_conn *next_ready;
+  struct qe_conn *next_dead;
+} qe_conn;
+
+/* A frame taken in the current round. */
+typedef struct {
+  qe_conn *conn;
+  int prec;
+  size_t start; /* The first equation in the batch of the mode. */
+  size_t n;
+} qe_frame;
+
+/* The equations of one precision mode in the current round. */
+typedef struct {
+  double a[QE_SERVER_ROUND], b[QE_SERVER_ROUND], c[QE_SERVER_ROUND];
+  double res1[QE_SERVER_ROUND], res2[QE_SERVER_ROUND];
+  int msg_id[QE_SERVER_ROUND];
+  size_t n;
+} qe_batch;
+
+struct qe_server {
+  int listen_fd;
+  int epoll_fd;
+  int stop_fd; /* An eventfd written by qe_server_stop. */
+  char *path;
+  int bound; /* The socket file at path was created by this server. */
+
+  qe_conn *conns;
+  qe_conn *ready, *ready_tail;
+  qe_conn *dead;
+
+  qe_frame frames[QE_SERVER_ROUND];
+  size_t nframes;
+  qe_batch batch[2]; /* Indexed by the precision mode. */
+};
+
+/*
+ * The function makes room for len more bytes in the buffer. Returns 0
+ * if there is no memory.
+ */
+static int buf_reserve(qe_buf *b, size_t len) {
+  size_t cap = (b->cap > 0) ? b->cap : QE_SERVER_BUF_SIZE;
+  char *data;
+
+  if (b->cap - b->len >= len)
+    return 1;
+
+  /* The consumed bytes are dropped first. */
+  if (b->off > 0) {
+    memmove(b->data, b->data + b->off, b->len - b->off);
+    b->len -= b->off;
+    b->off = 0;
+    if (b->cap - b->len >= len)
+      return 1;
+  }
+
+  while (cap - b->len < len)
+    cap *= 2;
+  data = realloc(b->data, cap);
+  if (data == NULL)
+    return 0;
+
+  b->data = data;
+  b->cap = cap;
+  return 1;
+}
+
+/*
+ * The function returns the size of the first frame in the input
+ * buffer if it is complete, 0 if it is not, or -1 if it is
+ * malformed. The header is written to *h.
+ */
+static long frame_size(const qe_conn *conn, qe_served_header *h) {
+  size_t avail = conn->in.len - conn->in.off;
+
+  if (avail < sizeof(*h))
+    return 0;
+
+  memcpy(h, conn->in.data + conn->in.off, sizeof(*h));
+  if ((h->magic != QE_SERVED_MAGIC) || (h->n > QE_SERVED_MAX_BATCH))
+    return -1;
+
+  if (avail < sizeof(*h) + h->n * sizeof(qe_served_eq))
+    return 0;
+  return (long)(sizeof(*h) + h->n * sizeof(qe_served_eq));
+}
+
+/* The function checks whether a frame of the connection can be taken. */
+static int conn_has_frame(const qe_conn *conn) {
+  qe_served_header h;
+
+  return !conn->dead &&
+         (conn->out.len - conn->out.off < QE_SERVER_OUT_LIMIT) &&
+         (frame_size(conn, &h) > 0);
+}
+
+/* The function closes the connection, it is freed after the round. */
+static void conn_kill(qe_server *srv, qe_conn *conn) {
+  if (conn->dead)
+    return;
+
+  epoll_ctl(srv->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+  close(conn->fd);
+
+  if (conn->prev != NULL)
+    conn->prev->next = conn->next;
+  else
+    srv->conns = conn->next;
+  if (conn->next != NULL)
+    conn->next->prev = conn->prev;
+
+  conn->dead = 1;
+  conn->next_dead = srv->dead;
+  srv->dead = conn;
+}
+
+/*
+ * The function puts the connection into the ready list if it has a
+ * frame to take, registers the events it waits for, or closes it if
+ * the client is gone and nothing is left to do. The connection waits
+ * for input while its buffer has no complete frame, and for output
+ * while there are replies to send.
+ */
+static void conn_update(qe_server *srv, qe_conn *conn) {
+  struct epoll_event ev;
+  unsigned int events = 0;
+  qe_served_header h;
+  long size;
+
+  if (conn->dead)
+    return;
+
+  size = frame_size(conn, &h);
+  if (size < 0) {
+    conn_kill(srv, conn);
+    return;
+  }
+
+  if (!conn->ready && conn_has_frame(conn)) {
+    conn->ready = 1;
+    conn->next_ready = NULL;
+    if (srv->ready_tail != NULL)
+      srv->ready_tail->next_ready = conn;
+    else
+      srv->ready = conn;
+    srv->ready_tail = conn;
+  }
+
+  if (!conn->eof && (size == 0))
+    events |= EPOLLIN;
+  if (conn->out.len > conn->out.off)
+    events |= EPOLLOUT;
+
+  if (conn->eof && (size == 0) && !(events & EPOLLOUT)) {
+    conn_kill(srv, conn);
+    return;
+  }
+
+  if (events == conn->events)
+    return;
+
+  ev.events = events;
+  ev.data.ptr = conn;
+  epoll_ctl(srv->epoll_fd, EPOLL_CTL_MOD, conn->fd, &ev);
+  conn->events = events;
+}
+
+/* The function sends the replies of the connection that fit. */
+static void conn_flush(qe_server *srv, qe_conn *conn) {
+  while (!conn->dead && (conn->out.len > conn->out.off)) {
+    ssize_t k = send(conn->fd, conn->out.data + conn->out.off,
+                     conn->out.len - conn->out.off, MSG_NOSIGNAL);
+
+    if (k > 0)
+      conn->out.off += (size_t)k;
+    else if ((k < 0) && (errno == EINTR))
+      continue;
+    else if ((k < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+      return;
+    else
+      conn_kill(srv, conn);
+  }
+
+  conn->out.len = conn->out.off = 0;
+}
+
+/*
+ * The function reads what the client sent, until the buffer holds a
+ * complete frame. The buffer grows only to hold the first frame.
+ */
+static void conn_read(qe_server *srv, qe_conn *conn) {
+  for (;;) {
+    qe_served_header h;
+    long size = frame_size(conn, &h);
+    size_t want = QE_SERVER_BUF_SIZE;
+    ssize_t k;
+
+    if (size != 0)
+      return;
+
+    /* The rest of the incomplete frame. */
+    if (conn->in.len - conn->in.off >= sizeof(h))
+      want = sizeof(h) + h.n * sizeof(qe_served_eq) -
+             (conn->in.len - conn->in.off);
+
+    if (!buf_reserve(&conn->in, want)) {
+      conn_kill(srv, conn);
+      return;
+    }
+
+    k = recv(conn->fd, conn->in.data + conn->in.len,
+             conn->in.cap - conn->in.len, 0);
+    if (k > 0)
+      conn->in.len += (size_t)k;
+    else if ((k < 0) && (errno == EINTR))
+      continue;
+    else if ((k < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+      return;
+    else if (k == 0) {
+      conn->eof = 1;
+      return;
+    } else {
+      conn_kill(srv, conn);
+      return;
+    }
+  }
+}
+
+/* The function accepts the new connections. */
+static void accept_clients(qe_server *srv) {
+  for (;;) {
+    struct epoll_event ev;
+    qe_conn *conn;
+    int fd =
+        accept4(srv->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+    if ((fd < 0) && (errno == EINTR))
+      continue;
+    if (fd < 0)
+      return;
+
+    conn = calloc(1, sizeof(*conn));
+    if (conn == NULL) {
+      close(fd);
+      continue;
+    }
+
+    conn->fd = fd;
+    conn->events = EPOLLIN;
+    ev.events = EPOLLIN;
+    ev.data.ptr = conn;
+    if (epoll_ctl(srv->epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+      close(fd);
+      free(conn);
+      continue;
+    }
+
+    conn->next = srv->conns;
+    if (srv->conns != NULL)
+      srv->conns->prev = conn;
+    srv->conns = conn;
+  }
+}
+
+/*
+ * The function takes the frames of the ready connections, one per
+ * connection in turn, while the round has room. A frame larger than
+ * the room is left for the next round, unless the round is empty.
+ */
+static void take_frames(qe_server *srv) {
+  size_t total = 0;
+  qe_conn *conn;
+  int taken = 1;
+
+  srv->nframes = 0;
+  srv->batch[0].n = srv->batch[1].n = 0;
+
+  while (taken) {
+    taken = 0;
+
+    for (conn = srv->ready; conn != NULL; conn = conn->next_ready) {
+      qe_served_header h;
+      const char *p;
+      qe_batch *batch;
+      qe_frame *f;
+      long size;
+
+      if ((srv->nframes == QE_SERVER_ROUND) || !conn_has_frame(conn))
+        continue;
+
+      size = frame_size(conn, &h);
+      if ((total > 0) && (total + h.n > QE_SERVER_ROUND))
+        continue;
+
+      f = &srv->frames[srv->nframes++];
+      f->conn = conn;
+      f->prec = (h.prec == QE_PREC_DOUBLE) ? QE_PREC_DOUBLE : QE_PREC_EXTENDED;
+      batch = &srv->batch[f->prec];
+      f->start = batch->n;
+      f->n = h.n;
+
+      p = conn->in.data + conn->in.off + sizeof(h);
+      for (size_t j = 0; j < h.n; j++) {
+        qe_served_eq eq;
+
+        memcpy(&eq, p + j * sizeof(eq), sizeof(eq));
+        batch->a[f->start + j] = eq.a;
+        batch->b[f->start + j] = eq.b;
+        batch->c[f->start + j] = eq.c;
+      }
+
+      batch->n += h.n;
+      total += h.n;
+      conn->in.off += (size_t)size;
+      taken = 1;
+    }
+  }
+}
+
+/*
+ * The function writes the replies of the frames of the round and
+ * sends them.
+ */
+static void write_replies(qe_server *srv) {
+  for (size_t i = 0; i < srv->nframes; i++) {
+    const qe_frame *f = &srv->frames[i];
+    const qe_batch *batch = &srv->batch[f->prec];
+    qe_conn *conn = f->conn;
+    qe_served_header h = {QE_SERVED_MAGIC, (uint32_t)f->n, 0, 0};
+    char *p;
+
+    if (conn->dead)
+      continue;
+    if (!buf_reserve(&conn->out, sizeof(h) + f->n * sizeof(qe_served_res))) {
+      conn_kill(srv, conn);
+      continue;
+    }
+
+    p = conn->out.data + conn->out.len;
+    memcpy(p, &h, sizeof(h));
+    p += sizeof(h);
+    for (size_t j = 0; j < f->n; j++) {
+      qe_served_res r;
+
+      r.res1 = batch->res1[f->start + j];
+      r.res2 = batch->res2[f->start + j];
+      r.msg_id = batch->msg_id[f->start + j];
+      r.reserved = 0;
+      memcpy(p + j * sizeof(r), &r, sizeof(r));
+    }
+    conn->out.len += sizeof(h) + f->n * sizeof(qe_served_res);
+  }
+
+  for (size_t i = 0; i < srv->nframes; i++)
+    conn_flush(srv, srv->frames[i].conn);
+}
+
+/*
+ * The function makes the ready list again after the round: the
+ * connections leave it and come back by conn_update if they still
+ * have frames to take.
+ */
+static void update_ready(qe_server *srv) {
+  qe_conn *conn = srv->ready, *next;
+
+  srv->ready = srv->ready_tail = NULL;
+  for (; conn != NULL; conn = next) {
+    next = conn->next_ready;
+    conn->ready = 0;
+    conn_update(srv, conn);
+  }
+}
+
+/* The function frees the connections closed in the round. */
+static void free_dead(qe_server *srv) {
+  while (srv->dead != NULL) {
+    qe_conn *conn = srv->dead;
+
+    srv->dead = conn->next_dead;
+    free(conn->in.data);
+    free(conn->out.data);
+    free(conn);
+  }
+}
+
+/*
+ * The function removes a stale socket file at the address: one that
+ * nobody listens on, so a connection to it is refused. Returns -1
+ * with errno EADDRINUSE if a server accepts connections on it (or
+ * its queue is full); any other file is left for bind to fail on.
+ */
+static int remove_stale(const struct sockaddr_un *addr) {
+  struct stat st;
+  int fd, res;
+
+  if ((lstat(addr->sun_path, &st) != 0) || !S_ISSOCK(st.st_mode))
+    return 0;
+
+  fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0)
+    return -1;
+
+  res = connect(fd, (const struct sockaddr *)addr, sizeof(*addr));
+  if ((res != 0) && (errno == ECONNREFUSED)) {
+    unlink(addr->sun_path);
+    res = 0;
+  } else
+    res = -1;
+
+  close(fd);
+  if (res != 0)
+    errno = EADDRINUSE;
+  return res;
+}
+
+/*
+ * The function creates the server listening on the socket path. Only
+ * a stale socket file left at the path is removed: the socket of a
+ * running server makes the creation fail with EADDRINUSE, and any
+ * other file makes bind fail.
+ */
+qe_server *qe_server_create(const char *path) {
+  struct sockaddr_un addr;
+  struct epoll_event ev;
+  qe_server *srv;
+
+  if ((path == NULL) || (strlen(path) >= sizeof(addr.sun_path)))
+    return NULL;
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+  if (remove_stale(&addr) != 0)
+    return NULL;
+
+  srv = calloc(1, sizeof(*srv));
+  if (srv == NULL)
+    return NULL;
+  srv->listen_fd = srv->epoll_fd = srv->stop_fd = -1;
+
+  srv->path = strdup(path);
+  srv->listen_fd =
+      socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  srv->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  srv->stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if ((srv->path == NULL) || (srv->listen_fd < 0) || (srv->epoll_fd < 0) ||
+      (srv->stop_fd < 0) ||
+      (bind(srv->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)) {
+    qe_server_destroy(srv);
+    return NULL;
+  }
+
+  /* From here the socket file is removed by qe_server_destroy. */
+  srv->bound = 1;
+  if (listen(srv->listen_fd, SOMAXCONN) != 0) {
+    qe_server_destroy(srv);
+    return NULL;
+  }
+
+  /* The listening socket and the eventfd are told by the pointers. */
+  ev.events = EPOLLIN;
+  ev.data.ptr = &srv->listen_fd;
+  if (epoll_ctl(srv->epoll_fd, EPOLL_CTL_ADD, srv->listen_fd, &ev) == 0) {
+    ev.data.ptr = &srv->stop_fd;
+    if (epoll_ctl(srv->epoll_fd, EPOLL_CTL_ADD, srv->stop_fd, &ev) == 0)
+      return srv;
+  }
+
+  qe_server_destroy(srv);
+  return NULL;
+}
+
+/*
+ * The function runs the event loop until qe_server_stop is called
+ * (also if it was called before the run).
+ */
+int qe_server_run(qe_server *srv) {
+  struct epoll_event events[QE_SERVER_EVENTS];
+
+  for (;;) {
+    int n = epoll_wait(srv->epoll_fd, events, QE_SERVER_EVENTS,
+                       (srv->ready != NULL) ? 0 : -1);
+
+    if ((n < 0) && (errno != EINTR))
+      return -1;
+
+    for (int i = 0; i < n; i++) {
+      void *ptr = events[i].data.ptr;
+      qe_conn *conn = ptr;
+
+      if (ptr == &srv->listen_fd) {
+        accept_clients(srv);
+        continue;
+      }
+
+      if (ptr == &srv->stop_fd) {
+        uint64_t value;
+
+        if (read(srv->stop_fd, &value, sizeof(value)) > 0)
+          return 0;
+        continue;
+      }
+
+      if (events[i].events & EPOLLOUT)
+        conn_flush(srv, conn);
+      if (!conn->dead && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+        conn_read(srv, conn);
+      conn_update(srv, conn);
+    }
+
+    take_frames(srv);
+    for (int prec = QE_PREC_EXTENDED; prec <= QE_PREC_DOUBLE; prec++) {
+      qe_batch *batch = &srv->batch[prec];
+
+      solve_equation_batch_prec(batch->a, batch->b, batch->c, batch->res1,
+                                batch->res2, batch->msg_id, batch->n, prec);
+    }
+    write_replies(srv);
+    update_ready(srv);
+    free_dead(srv);
+  }
+}
+
+/* The function makes qe_server_run return (async-signal-safe). */
+void qe_server_stop(qe_server *srv) {
+  uint64_t one = 1;
+  ssize_t k = write(srv->stop_fd, &one, sizeof(one));
+
+  (void)k;
+}
+
+/* The function closes the connections and frees the server. */
+void qe_server_destroy(qe_server *srv) {
+
+  if (srv == NULL)
+    return;
+
+  while (srv->conns != NULL)
+    conn_kill(srv, srv->conns);
+  free_dead(srv);
+
+  if (srv->listen_fd >= 0)
+    close(srv->listen_fd);
+  if (srv->bound)
+    unlink(srv->path);
+  if (srv->epoll_fd >= 0)
+    close(srv->epoll_fd);
+  if (srv->stop_fd >= 0)
+    close(srv->stop_fd);
+
+  free(srv->path);
+  free(srv);
+}
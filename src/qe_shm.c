@@ -0,0 +1,381 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the shared-memory
+ * channel (qe_shm).
+ *
+ * The region starts with a header page, followed by the arrays
+ * a, b, c, res1, res2 and msg_id, each on its own page. The header
+ * holds two counters used as futexes: the doorbell, incremented by
+ * the producer for every batch, and the answer, set by the solver
+ * to the doorbell value of the batch it has solved. A waiting side
+ * spins on the counter for a while, then sets its waiting flag and
+ * sleeps in FUTEX_WAIT; the other side calls FUTEX_WAKE only if
+ * the flag is set. The counter and the flag are written and read
+ * in sequentially consistent order on both sides, so a wake-up is
+ * never lost (as in the sleeping of the qe_async threads).
+ *
+ * The futexes are not private: they are in memory shared by two
+ * processes.
+ *
+ * The shutdown sets the stop flag and rings the doorbell too. A
+ * batch submitted just before it may not be solved yet when the
+ * solver sees the flag, so the header keeps the doorbell value of
+ * the last batch, and the solver solves (drains) it before it
+ * returns. The producer waits for the answer of its batch, not for
+ * the last doorbell value, so the ring of the shutdown does not
+ * make it wait for an answer that never comes.
+ *
+-------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include "qe_shm.h"
+#include "quadratic_equation.h"
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* The magic value of the header: "QESH". */
+#define QE_SHM_MAGIC 0x48534551u
+
+/* The alignment of the arrays in the region. */
+#define QE_SHM_PAGE 4096
+
+/*
+ * The header of the region. The fields written by the producer,
+ * the doorbell and the answer are in different cache lines.
+ */
+typedef struct {
+  uint32_t magic;
+  uint32_t stop; /* Set by qe_shm_shutdown. */
+  uint64_t capacity;
+  uint64_t n;     /* The size of the submitted batch. */
+  int32_t prec;       /* The precision mode of the batch. */
+  int32_t status;     /* The result of the batch, set by the solver. */
+  uint32_t submitted; /* The doorbell value of the last batch. */
+  char pad[28];
+
+  uint32_t doorbell;     /* The number of submitted batches. */
+  uint32_t solver_waits; /* The solver sleeps on the doorbell. */
+  char pad_doorbell[56];
+
+  uint32_t answer;         /* The number of solved batches. */
+  uint32_t producer_waits; /* The producer sleeps on the answer. */
+  char pad_answer[56];
+} qe_shm_header;
+
+struct qe_shm {
+  int fd;
+  qe_shm_header *hdr;
+  size_t size; /* The size of the mapping. */
+  qe_shm_arrays arrays;
+  uint32_t seq;   /* The last doorbell value rung by this side. */
+  uint32_t batch; /* The doorbell value of the last submitted batch. */
+  int spin;       /* QE_SHM_SPIN, or 0 on a single processor. */
+};
+
+/* The function rounds size up to the alignment of the arrays. */
+static size_t page_round(size_t size) {
+  return (size + QE_SHM_PAGE - 1) & ~(size_t)(QE_SHM_PAGE - 1);
+}
+
+/*
+ * The function returns the size of the region for capacity
+ * equations, or 0 if it does not fit in size_t.
+ */
+static size_t region_size(size_t capacity) {
+  if (capacity > (SIZE_MAX / 2 - 7 * QE_SHM_PAGE) / (5 * sizeof(double)))
+    return 0;
+  return QE_SHM_PAGE + 5 * page_round(capacity * sizeof(double)) +
+         page_round(capacity * sizeof(int));
+}
+
+/*
+ * The function sets the pointers to the arrays of the mapping and
+ * the spinning of the waits: on a single processor the other side
+ * can not run while this one spins.
+ */
+static void set_arrays(qe_shm *shm, size_t capacity) {
+  size_t len = page_round(capacity * sizeof(double));
+  char *p = (char *)shm->hdr + QE_SHM_PAGE;
+
+  shm->arrays.a = (double *)p;
+  shm->arrays.b = (double *)(p + len);
+  shm->arrays.c = (double *)(p + 2 * len);
+  shm->arrays.res1 = (double *)(p + 3 * len);
+  shm->arrays.res2 = (double *)(p + 4 * len);
+  shm->arrays.msg_id = (int *)(p + 5 * len);
+  shm->arrays.capacity = capacity;
+  shm->spin = (sysconf(_SC_NPROCESSORS_ONLN) > 1) ? QE_SHM_SPIN : 0;
+}
+
+/* The function sleeps while the futex at addr is equal to val. */
+static void futex_wait(uint32_t *addr, uint32_t val) {
+  syscall(SYS_futex, addr, FUTEX_WAIT, val, NULL, NULL, 0);
+}
+
+/* The function wakes up the side sleeping on the futex at addr. */
+static void futex_wake(uint32_t *addr) {
+  syscall(SYS_futex, addr, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+/* The function tells the processor that the thread is spinning. */
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#endif
+}
+
+/*
+ * The function waits until the counter is not equal to val and
+ * returns its new value. The waiting flag tells the other side to
+ * wake it up.
+ */
+static uint32_t wait_change(uint32_t *counter, uint32_t *waits,
+                            uint32_t val, int spin) {
+  uint32_t cur;
+
+  for (int spins = 0; spins < spin; spins++) {
+    cur = __atomic_load_n(counter, __ATOMIC_ACQUIRE);
+    if (cur != val)
+      return cur;
+    cpu_relax();
+  }
+
+  for (;;) {
+    __atomic_store_n(waits, 1, __ATOMIC_SEQ_CST);
+    cur = __atomic_load_n(counter, __ATOMIC_SEQ_CST);
+    if (cur != val)
+      break;
+    futex_wait(counter, val);
+  }
+  __atomic_store_n(waits, 0, __ATOMIC_RELAXED);
+  return cur;
+}
+
+/*
+ * The function stores the new value of the counter and wakes up
+ * the other side if it sleeps.
+ */
+static void publish(uint32_t *counter, uint32_t *waits, uint32_t val) {
+  __atomic_store_n(counter, val, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(waits, __ATOMIC_SEQ_CST))
+    futex_wake(counter);
+}
+
+/* The function creates the memfd region and maps it. */
+qe_shm *qe_shm_create(size_t capacity) {
+  size_t size = region_size(capacity);
+  qe_shm *shm;
+
+  if (size == 0)
+    return NULL;
+
+  shm = calloc(1, sizeof(*shm));
+  if (shm == NULL)
+    return NULL;
+
+  shm->fd = memfd_create("qe_shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if ((shm->fd < 0) || (ftruncate(shm->fd, (off_t)size) != 0) ||
+      (fcntl(shm->fd, F_ADD_SEALS,
+             F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0))
+    goto fail;
+
+  shm->hdr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, shm->fd, 0);
+  if (shm->hdr == MAP_FAILED)
+    goto fail;
+  shm->size = size;
+
+  /* The memfd is filled with zeros, so the counters are zero. */
+  shm->hdr->capacity = capacity;
+  __atomic_store_n(&shm->hdr->magic, QE_SHM_MAGIC, __ATOMIC_RELEASE);
+  set_arrays(shm, capacity);
+  return shm;
+
+fail:
+  if (shm->fd >= 0)
+    close(shm->fd);
+  free(shm);
+  return NULL;
+}
+
+/*
+ * The function maps the region of another process. The size of the
+ * memfd must be sealed and large enough for the capacity in its
+ * header, so the mapping can not be cut by the other side.
+ */
+qe_shm *qe_shm_open(int fd) {
+  struct stat st;
+  size_t size, capacity;
+  qe_shm *shm;
+  int seals = fcntl(fd, F_GET_SEALS);
+
+  if ((seals < 0) || !(seals & F_SEAL_SHRINK) || (fstat(fd, &st) != 0) ||
+      (st.st_size < QE_SHM_PAGE))
+    return NULL;
+
+  shm = calloc(1, sizeof(*shm));
+  if (shm == NULL)
+    return NULL;
+
+  size = (size_t)st.st_size;
+  shm->hdr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (shm->hdr == MAP_FAILED) {
+    free(shm);
+    return NULL;
+  }
+
+  capacity = shm->hdr->capacity;
+  if ((__atomic_load_n(&shm->hdr->magic, __ATOMIC_ACQUIRE) != QE_SHM_MAGIC) ||
+      (region_size(capacity) == 0) || (region_size(capacity) > size)) {
+    munmap(shm->hdr, size);
+    free(shm);
+    return NULL;
+  }
+
+  shm->fd = fd;
+  shm->size = size;
+  shm->seq = __atomic_load_n(&shm->hdr->doorbell, __ATOMIC_ACQUIRE);
+  shm->batch = shm->seq;
+  set_arrays(shm, capacity);
+  return shm;
+}
+
+/* The function returns the descriptor of the region. */
+int qe_shm_fd(const qe_shm *shm) { return (shm == NULL) ? -1 : shm->fd; }
+
+/* The function returns the arrays of the region. */
+const qe_shm_arrays *qe_shm_get_arrays(const qe_shm *shm) {
+  return (shm == NULL) ? NULL : &shm->arrays;
+}
+
+/*
+ * Implementation of the qe_shm_submit function. The release order of
+ * the doorbell makes the arrays and the batch fields visible to the
+ * solver before it sees the new value.
+ */
+int qe_shm_submit(qe_shm *shm, size_t n, int prec) {
+  qe_shm_header *hdr;
+
+  if (shm == NULL)
+    return QE_ERR_NULLPTR;
+  if (n > shm->arrays.capacity)
+    return QE_SHM_ERR_SIZE;
+
+  hdr = shm->hdr;
+  if (__atomic_load_n(&hdr->stop, __ATOMIC_ACQUIRE))
+    return QE_SHM_ERR_SHUTDOWN;
+
+  hdr->n = n;
+  hdr->prec = prec;
+  shm->seq++;
+  shm->batch = shm->seq;
+  __atomic_store_n(&hdr->submitted, shm->batch, __ATOMIC_RELAXED);
+  publish(&hdr->doorbell, &hdr->solver_waits, shm->seq);
+  return QE_BATCH_OK;
+}
+
+/*
+ * Implementation of the qe_shm_wait function. The answer may be
+ * ahead of the batch by the ring of the shutdown, so the counters
+ * are compared by their difference (they wrap around).
+ */
+int qe_shm_wait(qe_shm *shm) {
+  qe_shm_header *hdr;
+  uint32_t answer;
+
+  if (shm == NULL)
+    return QE_ERR_NULLPTR;
+
+  hdr = shm->hdr;
+  answer = __atomic_load_n(&hdr->answer, __ATOMIC_ACQUIRE);
+  while ((int32_t)(answer - shm->batch) < 0)
+    answer = wait_change(&hdr->answer, &hdr->producer_waits, answer,
+                         shm->spin);
+
+  return hdr->status;
+}
+
+/*
+ * The function solves the submitted batch. The batch fields are
+ * read once: the producer is another process, so n is checked
+ * against the capacity of this mapping, not the one in the header.
+ */
+static int serve_batch(qe_shm *shm, qe_pool *pool) {
+  const qe_shm_arrays *ar = &shm->arrays;
+  size_t n = __atomic_load_n(&shm->hdr->n, __ATOMIC_RELAXED);
+  int prec = __atomic_load_n(&shm->hdr->prec, __ATOMIC_RELAXED);
+
+  if (n > ar->capacity)
+    return QE_SHM_ERR_SIZE;
+  if (pool != NULL)
+    return solve_equation_batch_parallel(pool, ar->a, ar->b, ar->c, ar->res1,
+                                         ar->res2, ar->msg_id, n, prec);
+  return solve_equation_batch_prec(ar->a, ar->b, ar->c, ar->res1, ar->res2,
+                                   ar->msg_id, n, prec);
+}
+
+/*
+ * Implementation of the qe_shm_serve function. The stop flag is
+ * written by the producer after the doorbell value of its last
+ * batch, so once the flag is seen, `submitted` tells whether that
+ * batch is still to be solved. The last answer covers the ring of
+ * the shutdown, so a waiting producer is always woken up.
+ */
+int qe_shm_serve(qe_shm *shm, qe_pool *pool) {
+  qe_shm_header *hdr;
+  uint32_t done;
+
+  if (shm == NULL)
+    return QE_ERR_NULLPTR;
+
+  hdr = shm->hdr;
+  done = __atomic_load_n(&hdr->answer, __ATOMIC_ACQUIRE);
+
+  for (;;) {
+    uint32_t bell = __atomic_load_n(&hdr->doorbell, __ATOMIC_ACQUIRE);
+
+    if (bell == done)
+      bell = wait_change(&hdr->doorbell, &hdr->solver_waits, done,
+                         shm->spin);
+
+    if (__atomic_load_n(&hdr->stop, __ATOMIC_ACQUIRE)) {
+      uint32_t last = __atomic_load_n(&hdr->submitted, __ATOMIC_RELAXED);
+
+      if ((int32_t)(last - done) > 0)
+        hdr->status = serve_batch(shm, pool);
+      bell = __atomic_load_n(&hdr->doorbell, __ATOMIC_ACQUIRE);
+      publish(&hdr->answer, &hdr->producer_waits, bell);
+      return 0;
+    }
+
+    hdr->status = serve_batch(shm, pool);
+    done = bell;
+    publish(&hdr->answer, &hdr->producer_waits, done);
+  }
+}
+
+/* Implementation of the qe_shm_shutdown function. */
+void qe_shm_shutdown(qe_shm *shm) {
+  if (shm == NULL)
+    return;
+
+  __atomic_store_n(&shm->hdr->stop, 1, __ATOMIC_RELEASE);
+  shm->seq++;
+  publish(&shm->hdr->doorbell, &shm->hdr->solver_waits, shm->seq);
+}
+
+/* The function unmaps the region and closes its descriptor. */
+void qe_shm_close(qe_shm *shm) {
+  if (shm == NULL)
+    return;
+
+  munmap(shm->hdr, shm->size);
+  close(shm->fd);
+  free(shm);
+}
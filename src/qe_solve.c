@@ -0,0 +1,513 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the qe_solve
+ * program, which solves the equations from text files.
+ *
+ * Every line of the input contains the parameters `a`, `b`,
+ * `c` separated by commas, semicolons, spaces or tabs. Empty
+ * lines and lines starting with '#' are skipped, as well as the
+ * first line of a file if it is not a row of numbers (a header).
+ * For every row the program writes the line "res1,res2,msg_id"
+ * (the msg_id values are described in quadratic_equation.h).
+ *
+ * Regular files are mapped into memory, other inputs (stdin,
+ * pipes) are read by blocks. The numbers are parsed by
+ * qe_parse_double and the equations are solved by
+ * solve_equation_batch_prec in chunks of QE_SOLVE_ROWS rows.
+ *
+ * Columnar files (qe_col.h) are recognized by their header and
+ * solved straight from the mapping, group by group; the stored
+ * results of a solved file are printed without solving.
+ *
+ * The results are written to stdout by qe_out (qe_out.h): the
+ * roots are formatted by qe_format_double and the buffers are
+ * written by writev, so the output keeps up with the solving.
+ *
+ * Usage: qe_solve [-d] [-c] [-b] [-i] [-o out] [file ...]
+ *
+ *   -d  the QE_PREC_DOUBLE precision mode;
+ *   -b  write the results in the binary format of qe_out.h
+ *       (20-byte little-endian rows) instead of the text lines;
+ *   -c  instead of the roots, print the number of equations
+ *       with every msg_id ("msg_id,count" lines);
+ *   -i  solve the columnar files in place: the results are
+ *       written into their result columns and not printed
+ *       (except the counts of -c);
+ *   -o  write the rows of all the inputs to the columnar file
+ *       out (with empty result columns) instead of solving them:
+ *       the converter from text to the columnar format.
+ *
+ * Without files, or for the file "-", stdin is read.
+ *
+-------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "qe_col.h"
+#include "qe_out.h"
+#include "qe_text.h"
+#include "quadratic_equation.h"
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* The number of rows solved at once. */
+#define QE_SOLVE_ROWS 65536
+
+/* The size of the blocks read from stdin. */
+#define QE_SOLVE_BLOCK (1 << 20)
+
+/* The state of the program. */
+typedef struct {
+  double *a, *b, *c, *res1, *res2;
+  int *msg_id;
+  size_t n; /* Rows parsed, but not solved yet. */
+
+  int prec;
+  int count_only;
+  int in_place;          /* Solve the columnar files in place (-i). */
+  qe_col_writer *writer; /* The columnar output (-o), or NULL. */
+  unsigned long long counts[6]; /* Equations with msg_id from -2 to 3. */
+
+  qe_out *out; /* The writer of the results to stdout. */
+
+  const char *name;   /* The name of the current input. */
+  unsigned long line; /* The number of the current line. */
+} qe_solver;
+
+/*
+ * The function writes the results of n rows (or counts them).
+ * In case of an error, it returns 1.
+ */
+static int output_rows(qe_solver *s, const double *res1, const double *res2,
+                       const int *msg_id, size_t n) {
+
+  if (!s->count_only) {
+    if (qe_out_rows(s->out, res1, res2, msg_id, n) == 0)
+      return 0;
+    perror("qe_solve");
+    return 1;
+  }
+
+  for (size_t i = 0; i < n; i++)
+    s->counts[msg_id[i] - QE_ERR_NULLPTR]++;
+
+  return 0;
+}
+
+/*
+ * The function solves the parsed rows and writes their results, or
+ * passes the rows to the columnar output. In case of an error, it
+ * returns 1.
+ */
+static int solve_rows(qe_solver *s) {
+  size_t n = s->n;
+
+  s->n = 0;
+  if (s->writer != NULL) {
+    if (qe_col_writer_append(s->writer, s->a, s->b, s->c, n) == 0)
+      return 0;
+    perror("qe_solve");
+    return 1;
+  }
+
+  solve_equation_batch_prec(s->a, s->b, s->c, s->res1, s->res2, s->msg_id, n,
+                            s->prec);
+  return output_rows(s, s->res1, s->res2, s->msg_id, n);
+}
+
+/* The function skips spaces and tabs. */
+static const char *skip_blanks(const char *p, const char *end) {
+  while ((p < end) && ((*p == ' ') || (*p == '\t')))
+    p++;
+  return p;
+}
+
+/*
+ * The function parses one row. Returns the pointer to the end of
+ * the line (the '\n' character or end), or NULL if it is malformed.
+ */
+static const char *parse_row(const char *p, const char *end, double x[3]) {
+
+  for (int i = 0; i < 3; i++) {
+    const char *q;
+
+    p = skip_blanks(p, end);
+    q = qe_parse_double(p, end, &x[i]);
+    if (q == NULL)
+      return NULL;
+
+    /* The numbers must be separated. */
+    p = skip_blanks(q, end);
+    if ((i < 2) && (p < end) && ((*p == ',') || (*p == ';')))
+      p++;
+    else if ((i < 2) && (p == q))
+      return NULL;
+  }
+
+  if ((p < end) && (*p == '\r'))
+    p++;
+  if ((p < end) && (*p != '\n'))
+    return NULL;
+  return p;
+}
+
+/*
+ * The function parses the complete lines of the text [p, end) and
+ * solves them. first_line is set if the text starts the input.
+ * In case of an error, it returns 1.
+ */
+static int parse_text(qe_solver *s, const char *p, const char *end,
+                      int first_line) {
+
+  while (p < end) {
+    const char *q = skip_blanks(p, end);
+    double x[3];
+
+    s->line++;
+
+    /* Empty lines and comments. */
+    if ((q == end) || (*q == '\n') || (*q == '\r') || (*q == '#')) {
+      q = memchr(q, '\n', (size_t)(end - q));
+      p = (q != NULL) ? q + 1 : end;
+      continue;
+    }
+
+    q = parse_row(q, end, x);
+    if (q == NULL) {
+      if (!first_line) {
+        fprintf(stderr, "qe_solve: %s:%lu: malformed row.\n", s->name,
+                s->line);
+        return 1;
+      }
+
+      /* The header of the file. */
+      q = memchr(p, '\n', (size_t)(end - p));
+      if (q == NULL)
+        q = end;
+    } else {
+      s->a[s->n] = x[0];
+      s->b[s->n] = x[1];
+      s->c[s->n] = x[2];
+      if ((++s->n == QE_SOLVE_ROWS) && solve_rows(s))
+        return 1;
+    }
+
+    first_line = 0;
+    p = (q < end) ? q + 1 : end;
+  }
+
+  return 0;
+}
+
+/*
+ * The function processes a regular file mapped into memory.
+ * Returns 0 on success, 1 on error, -1 if the file can not be mapped.
+ */
+static int process_mapped(qe_solver *s, int fd) {
+  struct stat st;
+  void *data;
+  int res;
+
+  if ((fstat(fd, &st) != 0) || !S_ISREG(st.st_mode))
+    return -1;
+  if (st.st_size == 0)
+    return 0;
+
+  data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (data == MAP_FAILED)
+    return -1;
+
+  posix_madvise(data, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+  res = parse_text(s, data, (const char *)data + st.st_size, 1);
+
+  munmap(data, (size_t)st.st_size);
+  return res;
+}
+
+/*
+ * The function reads the input by blocks. The incomplete last line
+ * of a block is moved to the beginning of the buffer, and the buffer
+ * grows if one line does not fit in it.
+ */
+static int process_stream(qe_solver *s, int fd) {
+  size_t size = QE_SOLVE_BLOCK, len = 0;
+  char *buf = malloc(size);
+  int first_line = 1, res = 0;
+  ssize_t got;
+
+  if (buf == NULL) {
+    fprintf(stderr, "qe_solve: out of memory.\n");
+    return 1;
+  }
+
+  while ((got = read(fd, buf + len, size - len)) != 0) {
+    char *last;
+
+    if (got < 0) {
+      perror("qe_solve");
+      res = 1;
+      break;
+    }
+    len += (size_t)got;
+
+    /* The end of the last complete line. */
+    last = buf + len;
+    while ((last > buf) && (last[-1] != '\n'))
+      last--;
+
+    if (last == buf) {
+      if (len == size) {
+        char *bigger = realloc(buf, size * 2);
+
+        if (bigger == NULL) {
+          fprintf(stderr, "qe_solve: out of memory.\n");
+          res = 1;
+          break;
+        }
+        buf = bigger;
+        size *= 2;
+      }
+      continue;
+    }
+
+    if (parse_text(s, buf, last, first_line)) {
+      res = 1;
+      break;
+    }
+    first_line = 0;
+
+    len -= (size_t)(last - buf);
+    memmove(buf, last, len);
+  }
+
+  /* The last line without '\n'. */
+  if ((res == 0) && (len > 0))
+    res = parse_text(s, buf, buf + len, first_line);
+
+  free(buf);
+  return res;
+}
+
+/* The function checks whether fd is a regular columnar file. */
+static int is_columnar(int fd) {
+  struct stat st;
+  uint32_t magic;
+
+  return (fstat(fd, &st) == 0) && S_ISREG(st.st_mode) &&
+         (pread(fd, &magic, sizeof(magic), 0) == sizeof(magic)) &&
+         (magic == QE_COL_MAGIC);
+}
+
+/*
+ * The function checks that the n stored msg_id of a group are the
+ * ones of solve_equation_batch_prec, so they can index the counts.
+ */
+static int stored_ok(const int *msg_id, size_t n) {
+  int ok = 1;
+
+  for (size_t i = 0; i < n; i++)
+    ok &= (msg_id[i] >= QE_ERR_NULLPTR) && (msg_id[i] <= QE_OK_INF_RES);
+
+  return ok;
+}
+
+/*
+ * The function processes a columnar file group by group: the rows
+ * are solved in the mapping in chunks of QE_SOLVE_ROWS, or their
+ * stored results are printed if the file was solved in the same
+ * precision mode. In case of an error, it returns 1.
+ */
+static int process_columnar(qe_solver *s, qe_col_file *f) {
+  const qe_col_header *hdr = qe_col_get_header(f);
+  int stored = (hdr->flags & QE_COL_SOLVED) && (hdr->prec == s->prec);
+  int res = 0;
+
+  /* The rows of the previous inputs are written first. */
+  if ((s->n > 0) && solve_rows(s))
+    return 1;
+
+  if (s->in_place) {
+    if (qe_col_solve(f, NULL, s->prec) != 0) {
+      fprintf(stderr, "qe_solve: %s: the file has no result columns.\n",
+              s->name);
+      return 1;
+    }
+    if (!s->count_only && (s->writer == NULL))
+      return 0;
+    stored = 1;
+  }
+
+  for (size_t g = 0; (g < qe_col_groups(f)) && !res; g++) {
+    qe_col_chunk ch;
+
+    qe_col_get_group(f, g, &ch);
+    if (s->writer != NULL) {
+      res = (qe_col_writer_append(s->writer, ch.a, ch.b, ch.c, ch.n) != 0);
+      if (res)
+        perror("qe_solve");
+    } else if (stored) {
+      res = !stored_ok(ch.msg_id, ch.n);
+      if (res)
+        fprintf(stderr, "qe_solve: %s: the file has invalid results.\n",
+                s->name);
+      else
+        res = output_rows(s, ch.res1, ch.res2, ch.msg_id, ch.n);
+    } else
+      for (size_t i = 0; (i < ch.n) && !res; i += QE_SOLVE_ROWS) {
+        size_t m = (ch.n - i < QE_SOLVE_ROWS) ? ch.n - i : QE_SOLVE_ROWS;
+
+        solve_equation_batch_prec(ch.a + i, ch.b + i, ch.c + i, s->res1,
+                                  s->res2, s->msg_id, m, s->prec);
+        res = output_rows(s, s->res1, s->res2, s->msg_id, m);
+      }
+    qe_col_release_group(f, g);
+  }
+
+  return res;
+}
+
+/*
+ * The function processes one input.
+ * In case of an error, it returns 1.
+ */
+static int process_input(qe_solver *s, const char *name) {
+  qe_col_file *f;
+  int fd, res;
+
+  s->line = 0;
+
+  if (strcmp(name, "-") == 0) {
+    s->name = "stdin";
+    return process_stream(s, STDIN_FILENO);
+  }
+
+  s->name = name;
+  fd = open(name, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "qe_solve: %s: ", name);
+    perror(NULL);
+    return 1;
+  }
+
+  /* A columnar file is recognized by its magic value. */
+  if (is_columnar(fd)) {
+    close(fd);
+    f = qe_col_open(name, s->in_place);
+    if (f == NULL) {
+      fprintf(stderr, "qe_solve: %s: ", name);
+      perror(NULL);
+      return 1;
+    }
+    res = process_columnar(s, f);
+    qe_col_close(f);
+    return res;
+  }
+  if (s->in_place) {
+    fprintf(stderr, "qe_solve: %s: not a columnar file.\n", name);
+    close(fd);
+    return 1;
+  }
+
+  res = process_mapped(s, fd);
+  if (res < 0)
+    res = process_stream(s, fd);
+
+  close(fd);
+  return res;
+}
+
+/*
+ * The main function parses the options and processes the inputs.
+ * It returns 0 if all the rows were solved, otherwise 1.
+ */
+int main(int argc, char *argv[]) {
+  qe_solver s;
+  int opt, res = 0, format = QE_OUT_TEXT;
+
+  memset(&s, 0, sizeof(s));
+  s.prec = QE_PREC_EXTENDED;
+
+  while ((opt = getopt(argc, argv, "dcbio:h")) != -1) {
+    switch (opt) {
+    case 'd':
+      s.prec = QE_PREC_DOUBLE;
+      break;
+    case 'c':
+      s.count_only = 1;
+      break;
+    case 'b':
+      format = QE_OUT_BINARY;
+      break;
+    case 'i':
+      s.in_place = 1;
+      break;
+    case 'o':
+      s.writer = qe_col_writer_create(optarg, QE_COL_RESULTS);
+      if (s.writer == NULL) {
+        fprintf(stderr, "qe_solve: %s: ", optarg);
+        perror(NULL);
+        return 1;
+      }
+      break;
+    default:
+      fprintf(stderr, "Usage: %s [-d] [-c] [-b] [-i] [-o out] [file ...]\n",
+              argv[0]);
+      return (opt == 'h') ? 0 : 1;
+    }
+  }
+
+  s.a = malloc(QE_SOLVE_ROWS * sizeof(double));
+  s.b = malloc(QE_SOLVE_ROWS * sizeof(double));
+  s.c = malloc(QE_SOLVE_ROWS * sizeof(double));
+  s.res1 = malloc(QE_SOLVE_ROWS * sizeof(double));
+  s.res2 = malloc(QE_SOLVE_ROWS * sizeof(double));
+  s.msg_id = malloc(QE_SOLVE_ROWS * sizeof(int));
+  s.out = qe_out_create(STDOUT_FILENO, format);
+  if (!s.a || !s.b || !s.c || !s.res1 || !s.res2 || !s.msg_id || !s.out) {
+    fprintf(stderr, "qe_solve: out of memory.\n");
+    return 1;
+  }
+
+  if (optind == argc)
+    res = process_input(&s, "-");
+  for (int i = optind; (i < argc) && !res; i++)
+    res = process_input(&s, argv[i]);
+
+  /* The rest of the rows are solved even after an error. */
+  if (solve_rows(&s))
+    res = 1;
+
+  if ((s.writer != NULL) && (qe_col_writer_close(s.writer) != 0)) {
+    perror("qe_solve");
+    res = 1;
+  }
+
+  if (s.count_only && (s.writer == NULL))
+    for (int id = QE_ERR_NULLPTR; id <= QE_OK_INF_RES; id++) {
+      char line[64];
+      int len = snprintf(line, sizeof(line), "%d,%llu\n", id,
+                         s.counts[id - QE_ERR_NULLPTR]);
+
+      qe_out_write(s.out, line, (size_t)len);
+    }
+
+  /* A failed write of the rows was already reported. */
+  if ((qe_out_close(s.out) != 0) && !res) {
+    perror("qe_solve");
+    res = 1;
+  }
+
+  free(s.a);
+  free(s.b);
+  free(s.c);
+  free(s.res1);
+  free(s.res2);
+  free(s.msg_id);
+  return res;
+}
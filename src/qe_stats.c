@@ -0,0 +1,153 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the statistics of
+ * the calls of the solvers (qe_stats.h).
+ *
+ * Every thread gets its own counters at its first call. The
+ * counters of all the threads are in a list that only grows:
+ * a new block is pushed to its head by compare-and-swap, and a
+ * snapshot walks it without locks. When a thread exits, its
+ * block is released (a destructor of a pthread key) and taken
+ * by the next new thread, so the counts of finished threads are
+ * kept and the list is as long as the largest number of threads
+ * that used the solvers at once.
+ *
+ * Without QE_STATS only the functions of the interface are
+ * compiled, and they return zeros.
+ *
+-------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "qe_internal.h"
+#include "qe_stats.h"
+#include <string.h>
+
+#if defined(QE_STATS)
+#include <pthread.h>
+#include <stdlib.h>
+
+__thread qe_stats_counters *qe_stats_thread;
+
+/* The list of the counters of all the threads. */
+static qe_stats_counters *stats_list;
+
+/* The key whose destructor releases the counters of a thread. */
+static pthread_key_t stats_key;
+static pthread_once_t stats_once = PTHREAD_ONCE_INIT;
+
+/* The function releases the counters of an exiting thread. */
+static void release_counters(void *p) {
+  qe_stats_counters *s = p;
+
+  __atomic_store_n(&s->used, 0, __ATOMIC_RELEASE);
+}
+
+/* The function creates the key of the counters. */
+static void create_key(void) {
+  pthread_key_create(&stats_key, release_counters);
+}
+
+/*
+ * Implementation of the qe_stats_attach function. A released block
+ * is taken if there is one, otherwise a new one is added to the list.
+ * If the memory cannot be allocated, the thread shares a static
+ * block (its counts may then be lost, but the solvers work).
+ */
+qe_stats_counters *qe_stats_attach(void) {
+  static qe_stats_counters shared;
+  qe_stats_counters *s;
+  void *mem;
+
+  pthread_once(&stats_once, create_key);
+
+  for (s = __atomic_load_n(&stats_list, __ATOMIC_ACQUIRE); s != NULL;
+       s = s->next) {
+    int unused = 0;
+
+    if (__atomic_compare_exchange_n(&s->used, &unused, 1, 0,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      break;
+  }
+
+  if (s == NULL) {
+    if (posix_memalign(&mem, 64, sizeof(*s)) != 0) {
+      qe_stats_thread = &shared;
+      return &shared;
+    }
+    s = mem;
+    memset(s, 0, sizeof(*s));
+    s->used = 1;
+    s->next = __atomic_load_n(&stats_list, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&stats_list, &s->next, s, 0,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+      ;
+  }
+
+  pthread_setspecific(stats_key, s);
+  qe_stats_thread = s;
+  return s;
+}
+
+/* The function adds the counter to the sum. */
+static void add(unsigned long long *sum, const uint64_t *counter) {
+  *sum += __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+/* The function sets n counters to zero. */
+static void zero(uint64_t *counters, int n) {
+  for (int i = 0; i < n; i++)
+    __atomic_store_n(&counters[i], 0, __ATOMIC_RELAXED);
+}
+#endif
+
+/* Implementation of the qe_stats_enabled function. */
+int qe_stats_enabled(void) {
+#if defined(QE_STATS)
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+/* Implementation of the qe_stats_snapshot function. */
+void qe_stats_snapshot(qe_stats *stats) {
+
+  if (stats == NULL)
+    return;
+
+  memset(stats, 0, sizeof(*stats));
+
+#if defined(QE_STATS)
+  stats->enabled = 1;
+
+  for (const qe_stats_counters *s =
+           __atomic_load_n(&stats_list, __ATOMIC_ACQUIRE);
+       s != NULL; s = s->next) {
+    add(&stats->calls, &s->calls);
+    for (int i = 0; i < QE_STATS_STATUSES; i++)
+      add(&stats->status[i], &s->status[i]);
+    for (int i = 0; i < QE_STATS_BRANCHES; i++)
+      add(&stats->branch[i], &s->branch[i]);
+    for (int i = 0; i < QE_STATS_BUCKETS; i++)
+      add(&stats->latency[i], &s->latency[i]);
+    add(&stats->samples, &s->samples);
+    add(&stats->cycles, &s->cycles);
+  }
+#endif
+}
+
+/* Implementation of the qe_stats_reset function. */
+void qe_stats_reset(void) {
+#if defined(QE_STATS)
+  for (qe_stats_counters *s = __atomic_load_n(&stats_list, __ATOMIC_ACQUIRE);
+       s != NULL; s = s->next) {
+    zero(&s->calls, 1);
+    zero(s->status, QE_STATS_STATUSES);
+    zero(s->branch, QE_STATS_BRANCHES);
+    zero(s->latency, QE_STATS_BUCKETS);
+    zero(&s->samples, 1);
+    zero(&s->cycles, 1);
+  }
+#endif
+}
@@ -0,0 +1,336 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the sweeps
+ * (qe_sweep.h): the equations where only `c` or only `b`
+ * changes, and the equations with a shared `a`.
+ *
+ * On x86 they are solved by the fixed kernels (qe_kernel.h and
+ * qe_kernel_double.h), which take the shared parameters as
+ * vectors computed once per batch. The sweeps over a range of `c`
+ * and over `b` fill the changing or the fixed parameter in blocks
+ * on the stack and pass them to the same kernels.
+ *
+ * The generic kernels are below. The calculations are the ones of
+ * solve_equation in the QE_PREC_EXTENDED mode and of
+ * qe_solve_double in the QE_PREC_DOUBLE mode, in the same order,
+ * so the discriminant and its sign are exactly the same. The only
+ * difference is that the roots are multiplied by the reciprocal of
+ * 2 * a (of a in the QE_PREC_DOUBLE mode) computed once, which
+ * changes them by at most one unit in the last place.
+ *
+ * Seeding the roots by Newton's method from the roots of the
+ * previous equation is not used: a step needs a division by
+ * 2 * a * x + b, which costs as much as the square root it
+ * would save.
+ *
+-------------------------------------------------------------*/
+
+#include "qe_internal.h"
+#include "qe_sweep.h"
+#include <float.h>
+#include <math.h>
+
+/*
+ * The number of equations of the sweeps over a range of `c` and
+ * over `b` passed to the fixed kernel at once. The block of the
+ * parameter stays in the cache.
+ */
+#define QE_SWEEP_BLOCK 512
+
+/* The terms of a sweep that do not depend on the changing parameter. */
+typedef struct {
+  double a;
+  int prec;
+  int fast; /* Whether `a` allows the calculations below. */
+
+  /* QE_PREC_EXTENDED: b * b, 4 * a, 1 / (2 * a). */
+  long double bb, a4, inv2a;
+
+  /* QE_PREC_DOUBLE: b * b with its error, 4 * a, 1 / a. */
+  double p, dp, a4d, inva, inv2ad;
+} qe_sweep;
+
+/*
+ * The function computes the terms of the sweep. If `b` changes, it
+ * is 0 and its terms are not used.
+ */
+static void sweep_init(qe_sweep *s, double a, double b, int prec) {
+
+  s->a = a;
+  s->prec = (prec == QE_PREC_DOUBLE) ? QE_PREC_DOUBLE : QE_PREC_EXTENDED;
+
+  if (s->prec == QE_PREC_EXTENDED) {
+    s->fast = (a != 0) && isfinite(a);
+    s->a4 = 4.0 * (long double)a;
+    s->bb = (long double)b * b;
+    s->inv2a = 1.0L / (2.0 * (long double)a);
+  } else {
+    s->fast = (a != 0) && qe_in_range(a) && qe_in_range(b);
+    s->a4d = 4.0 * a;
+    qe_two_prod(b, b, &s->p, &s->dp);
+    s->inva = 1.0 / a;
+    s->inv2ad = 0.5 * s->inva;
+  }
+}
+
+/*
+ * The function solves one equation of the sweep in the
+ * QE_PREC_EXTENDED mode, like solve_equation. `c` changes,
+ * and `b` changes too if vary_b is set.
+ */
+static inline int solve_extended(const qe_sweep *s, double b, double c,
+                                 int vary_b, double *res1, double *res2) {
+  long double discriminant, _b = b, _res1, _res2;
+  double sqrt_d;
+
+  discriminant = (vary_b ? _b * _b : s->bb) - s->a4 * c;
+
+  *res1 = *res2 = QE_STD_VAL_RES;
+
+  if (discriminant > 0) {
+    sqrt_d = sqrt((double)discriminant);
+    _res1 = (-_b + sqrt_d) * s->inv2a;
+    _res2 = (-_b - sqrt_d) * s->inv2a;
+    if ((fabsl(_res1) > DBL_MAX) || (fabsl(_res2) > DBL_MAX))
+      return QE_ERR_OVERFLOW;
+
+    *res1 = _res1;
+    *res2 = _res2;
+    return QE_OK_TWO_RES;
+  }
+
+  if (discriminant == 0) {
+    _res1 = -_b * s->inv2a;
+    if (fabsl(_res1) > DBL_MAX)
+      return QE_ERR_OVERFLOW;
+
+    *res1 = *res2 = _res1;
+    return QE_OK_ONE_RES;
+  }
+
+  return QE_OK_NO_RES;
+}
+
+/*
+ * The function solves one equation of the sweep in the
+ * QE_PREC_DOUBLE mode, like qe_solve_double with parameters
+ * in range. The discriminant is computed by Kahan's method,
+ * b * b and its error are already known if `b` is fixed.
+ */
+static inline int solve_double(const qe_sweep *s, double b, double c,
+                               int vary_b, double *res1, double *res2) {
+  double p, dp, q, dq, d, sqrt_d;
+
+  p = vary_b ? b * b : s->p;
+  q = s->a4d * c;
+  d = p - q;
+  if (3.0 * fabs(d) < p + q) {
+    if (vary_b)
+      qe_two_prod(b, b, &p, &dp);
+    else
+      dp = s->dp;
+    qe_two_prod(s->a4d, c, &q, &dq);
+    d = (p - q) + (dp - dq);
+  }
+
+  *res1 = *res2 = QE_STD_VAL_RES;
+
+  if (d < 0)
+    return QE_OK_NO_RES;
+
+  if (d == 0) {
+    *res1 = *res2 = -b * s->inv2ad;
+    return QE_OK_ONE_RES;
+  }
+
+  /*
+   * The roots q / a and c / q, as in write_roots of qe_double.c.
+   * In a sweep the sign of b rarely changes, so it is a branch.
+   */
+  sqrt_d = sqrt(d);
+  if (b < 0) {
+    q = 0.5 * (sqrt_d - b);
+    *res1 = q * s->inva;
+    *res2 = c / q + 0.0;
+  } else {
+    q = -0.5 * (b + sqrt_d);
+    *res1 = c / q + 0.0;
+    *res2 = q * s->inva;
+  }
+  return QE_OK_TWO_RES;
+}
+
+/*
+ * The function solves one equation of the sweep. The zero, infinite
+ * and NaN parameters, and in the QE_PREC_DOUBLE mode the huge and tiny
+ * ones, are passed to solve_equation_prec with its special cases.
+ */
+static inline int solve_point(const qe_sweep *s, double b, double c,
+                              int vary_b, double *res1, double *res2) {
+
+  if (s->prec == QE_PREC_EXTENDED) {
+    if (s->fast && (b != 0) && (c != 0) && isfinite(b) && isfinite(c))
+      return solve_extended(s, b, c, vary_b, res1, res2);
+  } else if (s->fast && (b != 0) && (c != 0) && qe_in_range(b) &&
+             qe_in_range(c))
+    return solve_double(s, b, c, vary_b, res1, res2);
+
+  return solve_equation_prec(s->a, b, c, res1, res2, s->prec);
+}
+
+/*
+ * The generic fixed kernel. The equations are solved one by one,
+ * the terms of the shared parameters are computed once.
+ */
+static void fixed_generic(const qe_fixed *fx, const double *b,
+                          const double *c, double *res1, double *res2,
+                          int *msg_id, size_t n, int prec) {
+  qe_sweep s;
+
+  sweep_init(&s, fx->a, fx->fixed_b ? fx->b : 0, prec);
+  if (fx->fixed_b)
+    for (size_t i = 0; i < n; i++)
+      msg_id[i] = solve_point(&s, fx->b, c[i], 0, &res1[i], &res2[i]);
+  else
+    for (size_t i = 0; i < n; i++)
+      msg_id[i] = solve_point(&s, b[i], c[i], 1, &res1[i], &res2[i]);
+}
+
+/* The generic fixed kernel of the QE_PREC_EXTENDED mode. */
+static void qe_fixed_generic(const qe_fixed *fx, const double *b,
+                             const double *c, double *res1, double *res2,
+                             int *msg_id, size_t n) {
+  fixed_generic(fx, b, c, res1, res2, msg_id, n, QE_PREC_EXTENDED);
+}
+
+/* The generic fixed kernel of the QE_PREC_DOUBLE mode. */
+static void qe_fixed_generic_double(const qe_fixed *fx, const double *b,
+                                    const double *c, double *res1,
+                                    double *res2, int *msg_id, size_t n) {
+  fixed_generic(fx, b, c, res1, res2, msg_id, n, QE_PREC_DOUBLE);
+}
+
+/*
+ * The fixed kernels indexed by the identifier of the instruction
+ * set, as the batch kernels of qe_batch.c.
+ */
+static const qe_fixed_kernel qe_fixed_kernels[] = {
+#if defined(QE_HAVE_X86_KERNELS)
+    qe_fixed_generic, qe_batch_kernel_sse2_fixed, qe_batch_kernel_avx2_fixed,
+    qe_batch_kernel_avx512_fixed
+#else
+    qe_fixed_generic, qe_fixed_generic, qe_fixed_generic, qe_fixed_generic
+#endif
+};
+
+/* The same for the QE_PREC_DOUBLE mode. */
+static const qe_fixed_kernel qe_fixed_kernels_double[] = {
+#if defined(QE_HAVE_X86_KERNELS)
+    qe_fixed_generic_double, qe_batch_kernel_sse2_double_fixed,
+    qe_batch_kernel_avx2_double_fixed, qe_batch_kernel_avx512_double_fixed
+#else
+    qe_fixed_generic_double, qe_fixed_generic_double, qe_fixed_generic_double,
+    qe_fixed_generic_double
+#endif
+};
+
+/* The function returns the fixed kernel of the precision mode. */
+static qe_fixed_kernel fixed_kernel(int prec) {
+  int isa = qe_batch_get_isa();
+
+  return (prec == QE_PREC_DOUBLE) ? qe_fixed_kernels_double[isa]
+                                  : qe_fixed_kernels[isa];
+}
+
+/* Implementation of the solve_equation_batch_fixed_a function. */
+int solve_equation_batch_fixed_a(double a, const double *b, const double *c,
+                                 double *res1, double *res2, int *msg_id,
+                                 size_t n, int prec) {
+  qe_fixed fx = {a, 0, 0};
+
+  /* Checking pointers for a non-NULL value. */
+  if ((n != 0) && ((b == NULL) || (c == NULL) || (res1 == NULL) ||
+                   (res2 == NULL) || (msg_id == NULL)))
+    return QE_ERR_NULLPTR;
+
+  fixed_kernel(prec)(&fx, b, c, res1, res2, msg_id, n);
+  return QE_BATCH_OK;
+}
+
+/* Implementation of the solve_equation_batch_monic function. */
+int solve_equation_batch_monic(const double *b, const double *c,
+                               double *res1, double *res2, int *msg_id,
+                               size_t n, int prec) {
+  return solve_equation_batch_fixed_a(1.0, b, c, res1, res2, msg_id, n, prec);
+}
+
+/* Implementation of the solve_equation_sweep_c function. */
+int solve_equation_sweep_c(double a, double b, const double *c,
+                           double *res1, double *res2, int *msg_id, size_t n,
+                           int prec) {
+  qe_fixed fx = {a, b, 1};
+
+  /* Checking pointers for a non-NULL value. */
+  if ((n != 0) && ((c == NULL) || (res1 == NULL) || (res2 == NULL) ||
+                   (msg_id == NULL)))
+    return QE_ERR_NULLPTR;
+
+  fixed_kernel(prec)(&fx, NULL, c, res1, res2, msg_id, n);
+  return QE_BATCH_OK;
+}
+
+/*
+ * Implementation of the solve_equation_sweep_c_range function. The
+ * values of `c` are computed by blocks.
+ */
+int solve_equation_sweep_c_range(double a, double b, double c0, double dc,
+                                 double *res1, double *res2, int *msg_id,
+                                 size_t n, int prec) {
+  qe_fixed fx = {a, b, 1};
+  qe_fixed_kernel kernel;
+  double c[QE_SWEEP_BLOCK];
+
+  /* Checking pointers for a non-NULL value. */
+  if ((n != 0) && ((res1 == NULL) || (res2 == NULL) || (msg_id == NULL)))
+    return QE_ERR_NULLPTR;
+
+  kernel = fixed_kernel(prec);
+  for (size_t i = 0; i < n; i += QE_SWEEP_BLOCK) {
+    size_t m = (n - i < QE_SWEEP_BLOCK) ? n - i : QE_SWEEP_BLOCK;
+
+    for (size_t j = 0; j < m; j++)
+      c[j] = c0 + (double)(i + j) * dc;
+    kernel(&fx, NULL, c, res1 + i, res2 + i, msg_id + i, m);
+  }
+
+  return QE_BATCH_OK;
+}
+
+/*
+ * Implementation of the solve_equation_sweep_b function. The fixed
+ * `c` is passed to the kernel of a shared `a` as a block of copies.
+ */
+int solve_equation_sweep_b(double a, const double *b, double c,
+                           double *res1, double *res2, int *msg_id, size_t n,
+                           int prec) {
+  qe_fixed fx = {a, 0, 0};
+  qe_fixed_kernel kernel;
+  double cc[QE_SWEEP_BLOCK];
+
+  /* Checking pointers for a non-NULL value. */
+  if ((n != 0) && ((b == NULL) || (res1 == NULL) || (res2 == NULL) ||
+                   (msg_id == NULL)))
+    return QE_ERR_NULLPTR;
+
+  for (size_t j = 0; j < QE_SWEEP_BLOCK; j++)
+    cc[j] = c;
+
+  kernel = fixed_kernel(prec);
+  for (size_t i = 0; i < n; i += QE_SWEEP_BLOCK) {
+    size_t m = (n - i < QE_SWEEP_BLOCK) ? n - i : QE_SWEEP_BLOCK;
+
+    kernel(&fx, b + i, cc, res1 + i, res2 + i, msg_id + i, m);
+  }
+
+  return QE_BATCH_OK;
+}
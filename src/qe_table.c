@@ -0,0 +1,324 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the table of
+ * equations with incremental solving (qe_table).
+ *
+ * The parameters and the results are kept in separate arrays,
+ * as the batch kernels read and write them. The dirty equations
+ * are marked in a bitmap of 64-bit words, and every word of a
+ * second bitmap (the summary) marks the dirty words of a block of
+ * QE_TABLE_BLOCK equations. So a refresh scans the n / QE_TABLE_BLOCK
+ * words of the summary and reads only the dirty words of the marked
+ * blocks: its cost is O(n / QE_TABLE_BLOCK) plus the number of the
+ * changes.
+ *
+ * A word with many dirty bits is solved in place, from its first
+ * dirty equation to its last one (the clean equations between them
+ * get the same results again). The dirty equations of the other
+ * words are gathered into tiles of QE_TABLE_TILE equations on the
+ * stack, solved by the batch kernels and scattered back.
+ *
+ * Every block owns its summary word, its dirty words and its
+ * equations, so the parallel refresh gives the blocks with dirty
+ * equations to the threads of the pool without any locks.
+ *
+-------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "qe_table.h"
+#include "qe_internal.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The dirty words of a block, a bit of its summary word each. */
+#define QE_TABLE_WORDS (QE_TABLE_BLOCK / 64)
+
+/* The number of scattered equations solved at once. */
+#define QE_TABLE_TILE 512
+
+/*
+ * The number of dirty equations from which a word is solved in
+ * place: then the contiguous kernels cost less than the gathering
+ * and scattering of the equations.
+ */
+#define QE_TABLE_DENSE 24
+
+struct qe_table {
+  size_t n;
+  int prec;
+  size_t ndirty;     /* The number of dirty equations. */
+  double *a, *b, *c; /* The parameters. */
+  double *res1, *res2;
+  int *msg_id;
+  uint64_t *dirty;   /* A bit per equation. */
+  uint64_t *summary; /* A bit per word of dirty. */
+  size_t nblocks;    /* The number of words of summary. */
+  size_t *blocks;    /* The blocks of a parallel refresh. */
+};
+
+/* The function returns 1 if x and y have the same bits. */
+static inline int same_bits(double x, double y) {
+  return memcmp(&x, &y, sizeof(x)) == 0;
+}
+
+/* Implementation of the qe_table_create function. */
+qe_table *qe_table_create(size_t n, int prec) {
+  size_t nwords = (n + 63) / 64;
+  qe_table *table;
+
+  if ((n == 0) || (n > SIZE_MAX / (2 * sizeof(double))))
+    return NULL;
+
+  table = calloc(1, sizeof(*table));
+  if (table == NULL)
+    return NULL;
+
+  table->n = n;
+  table->prec = prec;
+  table->nblocks = (n + QE_TABLE_BLOCK - 1) / QE_TABLE_BLOCK;
+  table->a = calloc(n, sizeof(double));
+  table->b = calloc(n, sizeof(double));
+  table->c = calloc(n, sizeof(double));
+  table->res1 = calloc(n, sizeof(double));
+  table->res2 = calloc(n, sizeof(double));
+  table->msg_id = malloc(n * sizeof(int));
+  table->dirty = malloc(nwords * sizeof(uint64_t));
+  table->summary = malloc(table->nblocks * sizeof(uint64_t));
+  table->blocks = malloc(table->nblocks * sizeof(size_t));
+  if ((table->a == NULL) || (table->b == NULL) || (table->c == NULL) ||
+      (table->res1 == NULL) || (table->res2 == NULL) ||
+      (table->msg_id == NULL) || (table->dirty == NULL) ||
+      (table->summary == NULL) || (table->blocks == NULL)) {
+    qe_table_destroy(table);
+    return NULL;
+  }
+
+  /* All the equations are dirty, the bits past n are not set. */
+  for (size_t i = 0; i < n; i++)
+    table->msg_id[i] = QE_ERR_NULLPTR;
+  memset(table->dirty, 0xff, nwords * sizeof(uint64_t));
+  if (n % 64 != 0)
+    table->dirty[nwords - 1] = (UINT64_C(1) << (n % 64)) - 1;
+  memset(table->summary, 0xff, table->nblocks * sizeof(uint64_t));
+  if (nwords % QE_TABLE_WORDS != 0)
+    table->summary[table->nblocks - 1] =
+        (UINT64_C(1) << (nwords % QE_TABLE_WORDS)) - 1;
+  table->ndirty = n;
+
+  return table;
+}
+
+/* Implementation of the qe_table_destroy function. */
+void qe_table_destroy(qe_table *table) {
+  if (table == NULL)
+    return;
+
+  free(table->a);
+  free(table->b);
+  free(table->c);
+  free(table->res1);
+  free(table->res2);
+  free(table->msg_id);
+  free(table->dirty);
+  free(table->summary);
+  free(table->blocks);
+  free(table);
+}
+
+/* Implementation of the qe_table_size function. */
+size_t qe_table_size(const qe_table *table) {
+  return (table != NULL) ? table->n : 0;
+}
+
+/* Implementation of the qe_table_dirty function. */
+size_t qe_table_dirty(const qe_table *table) {
+  return (table != NULL) ? table->ndirty : 0;
+}
+
+/*
+ * The function sets the parameters of the i-th equation and marks
+ * it dirty if they change, i is already checked.
+ */
+static inline void set_one(qe_table *table, size_t i, double a, double b,
+                           double c) {
+  uint64_t bit = UINT64_C(1) << (i % 64);
+  size_t w = i / 64;
+
+  if (same_bits(table->a[i], a) && same_bits(table->b[i], b) &&
+      same_bits(table->c[i], c))
+    return;
+
+  table->a[i] = a;
+  table->b[i] = b;
+  table->c[i] = c;
+  if ((table->dirty[w] & bit) == 0) {
+    table->dirty[w] |= bit;
+    table->summary[i / QE_TABLE_BLOCK] |= UINT64_C(1) << (w % QE_TABLE_WORDS);
+    table->ndirty++;
+  }
+}
+
+/* Implementation of the qe_table_set function. */
+int qe_table_set(qe_table *table, size_t i, double a, double b, double c) {
+  if ((table == NULL) || (i >= table->n))
+    return QE_ERR_NULLPTR;
+
+  set_one(table, i, a, b, c);
+  return QE_BATCH_OK;
+}
+
+/* Implementation of the qe_table_set_range function. */
+int qe_table_set_range(qe_table *table, size_t first, const double *a,
+                       const double *b, const double *c, size_t m) {
+
+  /* Checking pointers for a non-NULL value. */
+  if ((table == NULL) || (a == NULL) || (b == NULL) || (c == NULL) ||
+      (first > table->n) || (m > table->n - first))
+    return QE_ERR_NULLPTR;
+
+  for (size_t i = 0; i < m; i++)
+    set_one(table, first + i, a[i], b[i], c[i]);
+  return QE_BATCH_OK;
+}
+
+/* Implementation of the qe_table_get function. */
+int qe_table_get(const qe_table *table, size_t i, double *res1,
+                 double *res2) {
+  if ((table == NULL) || (res1 == NULL) || (res2 == NULL) || (i >= table->n))
+    return QE_ERR_NULLPTR;
+
+  *res1 = table->res1[i];
+  *res2 = table->res2[i];
+  return table->msg_id[i];
+}
+
+/* Implementation of the qe_table_results function. */
+void qe_table_results(const qe_table *table, const double **res1,
+                      const double **res2, const int **msg_id) {
+  if (table == NULL)
+    return;
+
+  if (res1 != NULL)
+    *res1 = table->res1;
+  if (res2 != NULL)
+    *res2 = table->res2;
+  if (msg_id != NULL)
+    *msg_id = table->msg_id;
+}
+
+/* A tile of gathered equations. */
+typedef struct {
+  double a[QE_TABLE_TILE], b[QE_TABLE_TILE], c[QE_TABLE_TILE];
+  double res1[QE_TABLE_TILE], res2[QE_TABLE_TILE];
+  int msg_id[QE_TABLE_TILE];
+  size_t idx[QE_TABLE_TILE];
+  size_t m;
+} qe_table_tile;
+
+/* The function solves the gathered equations and scatters the results. */
+static void flush_tile(qe_table *table, qe_table_tile *tile) {
+  solve_equation_batch_prec(tile->a, tile->b, tile->c, tile->res1,
+                            tile->res2, tile->msg_id, tile->m, table->prec);
+  for (size_t k = 0; k < tile->m; k++) {
+    size_t i = tile->idx[k];
+
+    table->res1[i] = tile->res1[k];
+    table->res2[i] = tile->res2[k];
+    table->msg_id[i] = tile->msg_id[k];
+  }
+  tile->m = 0;
+}
+
+/*
+ * The function solves the dirty equations of the block s and makes
+ * them clean. The gathered equations that are left in the tile are
+ * solved by the caller.
+ */
+static void refresh_block(qe_table *table, size_t s, qe_table_tile *tile) {
+  uint64_t words = table->summary[s];
+
+  table->summary[s] = 0;
+  while (words != 0) {
+    size_t w = s * QE_TABLE_WORDS + (size_t)__builtin_ctzll(words);
+    uint64_t bits = table->dirty[w];
+
+    words &= words - 1;
+    table->dirty[w] = 0;
+
+    if (__builtin_popcountll(bits) >= QE_TABLE_DENSE) {
+      size_t i = w * 64 + (size_t)__builtin_ctzll(bits);
+      size_t len = w * 64 + 64 - (size_t)__builtin_clzll(bits) - i;
+
+      solve_equation_batch_prec(table->a + i, table->b + i, table->c + i,
+                                table->res1 + i, table->res2 + i,
+                                table->msg_id + i, len, table->prec);
+      continue;
+    }
+
+    for (; bits != 0; bits &= bits - 1) {
+      size_t i = w * 64 + (size_t)__builtin_ctzll(bits);
+
+      tile->idx[tile->m] = i;
+      tile->a[tile->m] = table->a[i];
+      tile->b[tile->m] = table->b[i];
+      tile->c[tile->m] = table->c[i];
+      if (++tile->m == QE_TABLE_TILE)
+        flush_tile(table, tile);
+    }
+  }
+}
+
+/* Implementation of the qe_table_refresh function. */
+size_t qe_table_refresh(qe_table *table) {
+  qe_table_tile tile;
+  size_t count;
+
+  if (table == NULL)
+    return 0;
+
+  tile.m = 0;
+  for (size_t s = 0; s < table->nblocks; s++)
+    if (table->summary[s] != 0)
+      refresh_block(table, s, &tile);
+  if (tile.m > 0)
+    flush_tile(table, &tile);
+
+  count = table->ndirty;
+  table->ndirty = 0;
+  return count;
+}
+
+/* The function refreshes the k-th block with dirty equations. */
+static void refresh_chunk(void *ctx, size_t k) {
+  qe_table *table = ctx;
+  qe_table_tile tile;
+
+  tile.m = 0;
+  refresh_block(table, table->blocks[k], &tile);
+  if (tile.m > 0)
+    flush_tile(table, &tile);
+}
+
+/* Implementation of the qe_table_refresh_parallel function. */
+size_t qe_table_refresh_parallel(qe_table *table, qe_pool *pool) {
+  size_t nblocks = 0, count;
+
+  if (table == NULL)
+    return 0;
+
+  if (pool == NULL)
+    pool = qe_pool_default();
+  if ((pool == NULL) || (table->ndirty <= QE_POOL_CHUNK))
+    return qe_table_refresh(table);
+
+  for (size_t s = 0; s < table->nblocks; s++)
+    if (table->summary[s] != 0)
+      table->blocks[nblocks++] = s;
+  qe_pool_run(pool, nblocks, refresh_chunk, table);
+
+  count = table->ndirty;
+  table->ndirty = 0;
+  return count;
+}
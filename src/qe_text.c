@@ -0,0 +1,610 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the
+ * qe_parse_double function.
+ *
+ * The digits are converted eight at a time: eight characters
+ * are loaded as one 64-bit word, checked to be digits and
+ * combined into a number with three multiplications (SWAR,
+ * SIMD within a register). If the number has no more than 19
+ * digits, its mantissa fits in 53 bits and its
+ * decimal exponent is from -22 to 22, the mantissa and the
+ * power of ten are exact doubles, and one multiplication or
+ * division gives the correctly rounded result (Clinger's fast
+ * path). The numbers of up to 19 digits are computed in the
+ * same way in x87 long double, with a check for the double
+ * rounding. This covers the numbers written by people and by
+ * printf. The other numbers are passed to strtod.
+ *
+ * The file also contains the qe_format_double function, which
+ * writes the shortest decimal number that reads back as the same
+ * double. The digits are found by Grisu3 with 64-bit integers
+ * and a table of 87 powers of ten; the numbers that Grisu3 can
+ * not decide are written by printf and checked by strtod.
+ *
+-------------------------------------------------------------*/
+
+#include "qe_text.h"
+#include <ctype.h>
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The x87 long double, its 64-bit mantissa holds any number
+ * of 19 digits and the powers of ten up to 10^27 exactly.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && (LDBL_MANT_DIG == 64)
+#define QE_TEXT_X87
+static const long double pow10_ld[28] = {
+    1e0L,  1e1L,  1e2L,  1e3L,  1e4L,  1e5L,  1e6L,  1e7L,  1e8L,  1e9L,
+    1e10L, 1e11L, 1e12L, 1e13L, 1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L,
+    1e20L, 1e21L, 1e22L, 1e23L, 1e24L, 1e25L, 1e26L, 1e27L};
+#endif
+
+/* The powers of ten that are exact doubles. */
+static const double pow10_tab[23] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+/*
+ * The function checks whether the eight characters of the word
+ * are all digits. Every byte must be from 0x30 to 0x39: its high
+ * half is 3, and it stays 3 after adding 6.
+ */
+static inline int is_eight_digits(uint64_t v) {
+  return (((v & 0xF0F0F0F0F0F0F0F0ULL) |
+           (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+          0x3333333333333333ULL);
+}
+
+/*
+ * The function converts eight digits (the first one in the lowest
+ * byte) to a number: pairs, then quartets, then the whole word.
+ */
+static inline uint32_t parse_eight_digits(uint64_t v) {
+  const uint64_t mask = 0x000000FF000000FFULL;
+  const uint64_t mul1 = 100 + (1000000ULL << 32);
+  const uint64_t mul2 = 1 + (10000ULL << 32);
+
+  v -= 0x3030303030303030ULL;
+  v = (v * 10) + (v >> 8);
+  v = (((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32;
+  return (uint32_t)v;
+}
+
+/*
+ * The function loads eight characters as a word with the
+ * first character in the lowest byte.
+ */
+static inline uint64_t load_eight(const char *p) {
+  uint64_t v;
+
+  memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+  v = __builtin_bswap64(v);
+#endif
+  return v;
+}
+
+/*
+ * The function reads the digits from p and adds them to the
+ * mantissa *m. If there are more than 19 digits, *m overflows,
+ * but such numbers do not take the fast path. Returns the
+ * pointer after the digits.
+ */
+static const char *read_digits(const char *p, const char *end, uint64_t *m) {
+  while ((end - p >= 8) && is_eight_digits(load_eight(p))) {
+    *m = *m * 100000000 + parse_eight_digits(load_eight(p));
+    p += 8;
+  }
+
+  while ((p < end) && (*p >= '0') && (*p <= '9')) {
+    *m = *m * 10 + (uint64_t)(*p - '0');
+    p++;
+  }
+
+  return p;
+}
+
+/*
+ * The function parses the number with strtod. The text is
+ * copied, because it may not end with a zero byte. strtod skips
+ * the leading white space (the end of the line too), so an empty
+ * token or a token starting with a space is not a number.
+ */
+static const char *parse_slow(const char *p, const char *end, double *x) {
+  char buf[QE_TEXT_MAX_NUMBER + 1];
+  size_t len = (size_t)(end - p);
+  char *stop;
+
+  if ((len == 0) || isspace((unsigned char)*p))
+    return NULL;
+  if (len > QE_TEXT_MAX_NUMBER)
+    len = QE_TEXT_MAX_NUMBER;
+  memcpy(buf, p, len);
+  buf[len] = '\0';
+
+  *x = strtod(buf, &stop);
+  if (stop == buf)
+    return NULL;
+  return p + (stop - buf);
+}
+
+/*
+ * Implementation of the qe_parse_double function. The numbers
+ * outside the fast path are parsed again by strtod.
+ */
+const char *qe_parse_double(const char *p, const char *end, double *x) {
+  const char *start = p, *digits;
+  uint64_t m = 0;
+  int neg = 0, exp10 = 0, ndigits, nfrac = 0;
+
+  if ((p < end) && ((*p == '-') || (*p == '+'))) {
+    neg = (*p == '-');
+    p++;
+  }
+
+  /* The integer part and the fraction. */
+  digits = p;
+  p = read_digits(p, end, &m);
+  ndigits = (int)(p - digits);
+  if ((p < end) && (*p == '.')) {
+    const char *frac = ++p;
+
+    p = read_digits(p, end, &m);
+    nfrac = (int)(p - frac);
+    ndigits += nfrac;
+  }
+
+  /* No digits: "inf", "nan" or not a number. */
+  if (ndigits == 0)
+    return parse_slow(start, end, x);
+
+  /* The exponent, it is limited to stay far from int overflow. */
+  if ((p < end) && ((*p == 'e') || (*p == 'E'))) {
+    const char *q = p + 1;
+    int eneg = 0, e = 0;
+
+    if ((q < end) && ((*q == '-') || (*q == '+'))) {
+      eneg = (*q == '-');
+      q++;
+    }
+    if ((q < end) && (*q >= '0') && (*q <= '9')) {
+      while ((q < end) && (*q >= '0') && (*q <= '9')) {
+        if (e < 100000)
+          e = e * 10 + (*q - '0');
+        q++;
+      }
+      exp10 = eneg ? -e : e;
+      p = q;
+    }
+  }
+
+  /* Hexadecimal numbers and too long tokens. */
+  if (((p < end) && ((*p == 'x') || (*p == 'X'))) ||
+      (p - start > QE_TEXT_MAX_NUMBER))
+    return parse_slow(start, end, x);
+
+  exp10 -= nfrac;
+
+  if ((m == 0) && (ndigits <= 19)) {
+    *x = neg ? -0.0 : 0.0;
+    return p;
+  }
+
+  /* Clinger's fast path: both factors are exact doubles. */
+  if ((ndigits <= 19) && (m <= (1ULL << 53)) && (exp10 >= -22) &&
+      (exp10 <= 22)) {
+    double d = (double)m;
+
+    d = (exp10 < 0) ? d / pow10_tab[-exp10] : d * pow10_tab[exp10];
+    *x = neg ? -d : d;
+    return p;
+  }
+
+#if defined(QE_TEXT_X87)
+  /*
+   * The numbers of 17 - 19 digits (printf("%.17g") writes them):
+   * the result is rounded to the 64-bit mantissa of long double and
+   * then to double. The second rounding gives the correctly rounded
+   * result unless the first one has hit the middle between two
+   * doubles: the low 11 bits of the mantissa are 10000000000.
+   */
+  if ((ndigits <= 19) && (exp10 >= -27) && (exp10 <= 27)) {
+    long double r = (long double)m;
+    uint64_t mant;
+
+    r = (exp10 < 0) ? r / pow10_ld[-exp10] : r * pow10_ld[exp10];
+    memcpy(&mant, &r, sizeof(mant));
+    if ((mant & 0x7FF) != 0x400) {
+      double d = (double)r;
+
+      *x = neg ? -d : d;
+      return p;
+    }
+  }
+#endif
+
+  return parse_slow(start, end, x);
+}
+
+/*
+ * The powers of ten 10^k for k from -348 to 340 with the step 8,
+ * rounded to 64-bit significands: 10^k ~ f * 2^e.
+ */
+static const struct {
+  uint64_t f;
+  int16_t e;
+  int16_t k;
+} cached_pow10[] = {
+    {0xFA8FD5A0081C0288ULL, -1220, -348},
+    {0xBAAEE17FA23EBF76ULL, -1193, -340},
+    {0x8B16FB203055AC76ULL, -1166, -332},
+    {0xCF42894A5DCE35EAULL, -1140, -324},
+    {0x9A6BB0AA55653B2DULL, -1113, -316},
+    {0xE61ACF033D1A45DFULL, -1087, -308},
+    {0xAB70FE17C79AC6CAULL, -1060, -300},
+    {0xFF77B1FCBEBCDC4FULL, -1034, -292},
+    {0xBE5691EF416BD60CULL, -1007, -284},
+    {0x8DD01FAD907FFC3CULL, -980, -276},
+    {0xD3515C2831559A83ULL, -954, -268},
+    {0x9D71AC8FADA6C9B5ULL, -927, -260},
+    {0xEA9C227723EE8BCBULL, -901, -252},
+    {0xAECC49914078536DULL, -874, -244},
+    {0x823C12795DB6CE57ULL, -847, -236},
+    {0xC21094364DFB5637ULL, -821, -228},
+    {0x9096EA6F3848984FULL, -794, -220},
+    {0xD77485CB25823AC7ULL, -768, -212},
+    {0xA086CFCD97BF97F4ULL, -741, -204},
+    {0xEF340A98172AACE5ULL, -715, -196},
+    {0xB23867FB2A35B28EULL, -688, -188},
+    {0x84C8D4DFD2C63F3BULL, -661, -180},
+    {0xC5DD44271AD3CDBAULL, -635, -172},
+    {0x936B9FCEBB25C996ULL, -608, -164},
+    {0xDBAC6C247D62A584ULL, -582, -156},
+    {0xA3AB66580D5FDAF6ULL, -555, -148},
+    {0xF3E2F893DEC3F126ULL, -529, -140},
+    {0xB5B5ADA8AAFF80B8ULL, -502, -132},
+    {0x87625F056C7C4A8BULL, -475, -124},
+    {0xC9BCFF6034C13053ULL, -449, -116},
+    {0x964E858C91BA2655ULL, -422, -108},
+    {0xDFF9772470297EBDULL, -396, -100},
+    {0xA6DFBD9FB8E5B88FULL, -369, -92},
+    {0xF8A95FCF88747D94ULL, -343, -84},
+    {0xB94470938FA89BCFULL, -316, -76},
+    {0x8A08F0F8BF0F156BULL, -289, -68},
+    {0xCDB02555653131B6ULL, -263, -60},
+    {0x993FE2C6D07B7FACULL, -236, -52},
+    {0xE45C10C42A2B3B06ULL, -210, -44},
+    {0xAA242499697392D3ULL, -183, -36},
+    {0xFD87B5F28300CA0EULL, -157, -28},
+    {0xBCE5086492111AEBULL, -130, -20},
+    {0x8CBCCC096F5088CCULL, -103, -12},
+    {0xD1B71758E219652CULL, -77, -4},
+    {0x9C40000000000000ULL, -50, 4},
+    {0xE8D4A51000000000ULL, -24, 12},
+    {0xAD78EBC5AC620000ULL, 3, 20},
+    {0x813F3978F8940984ULL, 30, 28},
+    {0xC097CE7BC90715B3ULL, 56, 36},
+    {0x8F7E32CE7BEA5C70ULL, 83, 44},
+    {0xD5D238A4ABE98068ULL, 109, 52},
+    {0x9F4F2726179A2245ULL, 136, 60},
+    {0xED63A231D4C4FB27ULL, 162, 68},
+    {0xB0DE65388CC8ADA8ULL, 189, 76},
+    {0x83C7088E1AAB65DBULL, 216, 84},
+    {0xC45D1DF942711D9AULL, 242, 92},
+    {0x924D692CA61BE758ULL, 269, 100},
+    {0xDA01EE641A708DEAULL, 295, 108},
+    {0xA26DA3999AEF774AULL, 322, 116},
+    {0xF209787BB47D6B85ULL, 348, 124},
+    {0xB454E4A179DD1877ULL, 375, 132},
+    {0x865B86925B9BC5C2ULL, 402, 140},
+    {0xC83553C5C8965D3DULL, 428, 148},
+    {0x952AB45CFA97A0B3ULL, 455, 156},
+    {0xDE469FBD99A05FE3ULL, 481, 164},
+    {0xA59BC234DB398C25ULL, 508, 172},
+    {0xF6C69A72A3989F5CULL, 534, 180},
+    {0xB7DCBF5354E9BECEULL, 561, 188},
+    {0x88FCF317F22241E2ULL, 588, 196},
+    {0xCC20CE9BD35C78A5ULL, 614, 204},
+    {0x98165AF37B2153DFULL, 641, 212},
+    {0xE2A0B5DC971F303AULL, 667, 220},
+    {0xA8D9D1535CE3B396ULL, 694, 228},
+    {0xFB9B7CD9A4A7443CULL, 720, 236},
+    {0xBB764C4CA7A44410ULL, 747, 244},
+    {0x8BAB8EEFB6409C1AULL, 774, 252},
+    {0xD01FEF10A657842CULL, 800, 260},
+    {0x9B10A4E5E9913129ULL, 827, 268},
+    {0xE7109BFBA19C0C9DULL, 853, 276},
+    {0xAC2820D9623BF429ULL, 880, 284},
+    {0x80444B5E7AA7CF85ULL, 907, 292},
+    {0xBF21E44003ACDD2DULL, 933, 300},
+    {0x8E679C2F5E44FF8FULL, 960, 308},
+    {0xD433179D9C8CB841ULL, 986, 316},
+    {0x9E19DB92B4E31BA9ULL, 1013, 324},
+    {0xEB96BF6EBADF77D9ULL, 1039, 332},
+    {0xAF87023B9BF0EE6BULL, 1066, 340},
+};
+
+/* The powers of ten up to 10^9. */
+static const uint32_t pow10_u32[10] = {1,      10,      100,      1000,
+                                       10000,  100000,  1000000,  10000000,
+                                       100000000, 1000000000};
+
+/* A number f * 2^e with a 64-bit significand (a "do-it-yourself fp"). */
+typedef struct {
+  uint64_t f;
+  int e;
+} diy_fp;
+
+/*
+ * The function returns x * y with the significand rounded to the
+ * upper 64 bits of the product.
+ */
+static inline diy_fp diy_mul(diy_fp x, diy_fp y) {
+  const uint64_t m32 = 0xFFFFFFFFULL;
+  uint64_t a = x.f >> 32, b = x.f & m32, c = y.f >> 32, d = y.f & m32;
+  uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d, t;
+  diy_fp r;
+
+  t = (bd >> 32) + (ad & m32) + (bc & m32) + (1ULL << 31);
+  r.f = ac + (ad >> 32) + (bc >> 32) + (t >> 32);
+  r.e = x.e + y.e + 64;
+  return r;
+}
+
+/* The function shifts the significand so that its top bit is set. */
+static inline diy_fp diy_normalize(diy_fp x) {
+  int shift = __builtin_clzll(x.f);
+
+  x.f <<= shift;
+  x.e -= shift;
+  return x;
+}
+
+/*
+ * The function corrects the last digit of the Grisu result towards
+ * w and checks that the digits are the shortest ones closest to w
+ * (Loitsch's round_weed). All the values are scaled by the cached
+ * power; the results within unit of the boundaries are rejected.
+ */
+static int round_weed(char *buf, int len, uint64_t dist_high_w,
+                      uint64_t unsafe, uint64_t rest, uint64_t ten_kappa,
+                      uint64_t unit) {
+  uint64_t small_dist = dist_high_w - unit, big_dist = dist_high_w + unit;
+
+  while ((rest < small_dist) && (unsafe - rest >= ten_kappa) &&
+         ((rest + ten_kappa < small_dist) ||
+          (small_dist - rest >= rest + ten_kappa - small_dist))) {
+    buf[len - 1]--;
+    rest += ten_kappa;
+  }
+
+  if ((rest < big_dist) && (unsafe - rest >= ten_kappa) &&
+      ((rest + ten_kappa < big_dist) ||
+       (big_dist - rest > rest + ten_kappa - big_dist)))
+    return 0;
+
+  return (2 * unit <= rest) && (rest <= unsafe - 4 * unit);
+}
+
+/*
+ * The function finds the shortest digits of the positive finite
+ * double x by the Grisu3 algorithm (Loitsch, "Printing
+ * Floating-Point Numbers Quickly and Accurately with Integers"):
+ * x and the boundaries of its rounding interval are scaled by a
+ * cached power of ten into [2^-60, 2^-32) * 2^64, and the digits
+ * are generated from the upper boundary until they fall into the
+ * interval. The value is buf * 10^*exp10. Returns the number of
+ * digits, or 0 for the about 0.5% of the numbers that Grisu3 can
+ * not decide.
+ */
+static int grisu3(double x, char *buf, int *exp10) {
+  uint64_t bits, mant;
+  int be, idx, kappa, len = 0;
+  diy_fp v, w, m_plus, m_minus, c, low, high, too_low, too_high, one;
+  uint64_t unsafe, unit = 1, fractionals;
+  uint32_t integrals, divisor;
+  int min_e;
+
+  memcpy(&bits, &x, sizeof(bits));
+  mant = bits & ((1ULL << 52) - 1);
+  be = (int)((bits >> 52) & 0x7FF);
+  v.f = (be == 0) ? mant : (mant | (1ULL << 52));
+  v.e = (be == 0) ? -1074 : be - 1075;
+
+  /* The boundaries, the lower one is closer at a power of two. */
+  m_plus = diy_normalize((diy_fp){(v.f << 1) + 1, v.e - 1});
+  if ((mant == 0) && (be > 1))
+    m_minus = (diy_fp){(v.f << 2) - 1, v.e - 2};
+  else
+    m_minus = (diy_fp){(v.f << 1) - 1, v.e - 1};
+  m_minus.f <<= m_minus.e - m_plus.e;
+  m_minus.e = m_plus.e;
+  w = diy_normalize(v);
+
+  /* The cached power that brings the exponent into [-60, -32]. */
+  min_e = -60 - (w.e + 64);
+  /* 78913 / 2^18 is log10(2), the estimate is corrected below. */
+  idx = (348 + (((min_e + 63) * 78913) >> 18)) / 8 + 1;
+  while ((idx > 0) && (cached_pow10[idx].e > -32 - (w.e + 64)))
+    idx--;
+  while (cached_pow10[idx].e < min_e)
+    idx++;
+  c = (diy_fp){cached_pow10[idx].f, cached_pow10[idx].e};
+
+  w = diy_mul(w, c);
+  low = diy_mul(m_minus, c);
+  high = diy_mul(m_plus, c);
+
+  /* The digits of too_high, the unsafe interval covers the errors. */
+  too_low = (diy_fp){low.f - unit, low.e};
+  too_high = (diy_fp){high.f + unit, high.e};
+  unsafe = too_high.f - too_low.f;
+  one = (diy_fp){1ULL << -w.e, w.e};
+  integrals = (uint32_t)(too_high.f >> -one.e);
+  fractionals = too_high.f & (one.f - 1);
+
+  /*
+   * The digits of the integral part are found at once by divisions
+   * by the constant 10 (a division by a variable is slow), then
+   * taken from the first one while the rest is not small enough.
+   */
+  kappa = 0;
+  for (uint32_t m = integrals; m != 0; m /= 10)
+    buf[kappa++] = (char)('0' + m % 10);
+  for (int i = 0; i < kappa / 2; i++) {
+    char d = buf[i];
+
+    buf[i] = buf[kappa - 1 - i];
+    buf[kappa - 1 - i] = d;
+  }
+
+  while (kappa > 0) {
+    uint64_t rest;
+
+    kappa--;
+    divisor = pow10_u32[kappa];
+    integrals -= (uint32_t)(buf[len++] - '0') * divisor;
+    rest = ((uint64_t)integrals << -one.e) + fractionals;
+    if (rest < unsafe) {
+      *exp10 = -cached_pow10[idx].k + kappa;
+      return round_weed(buf, len, too_high.f - w.f, unsafe, rest,
+                        (uint64_t)divisor << -one.e, unit)
+                 ? len
+                 : 0;
+    }
+  }
+
+  for (;;) {
+    fractionals *= 10;
+    unit *= 10;
+    unsafe *= 10;
+    buf[len++] = (char)('0' + (fractionals >> -one.e));
+    fractionals &= one.f - 1;
+    kappa--;
+    if (fractionals < unsafe) {
+      *exp10 = -cached_pow10[idx].k + kappa;
+      return round_weed(buf, len, (too_high.f - w.f) * unit, unsafe,
+                        fractionals, one.f, unit)
+                 ? len
+                 : 0;
+    }
+  }
+}
+
+/*
+ * The function finds the digits of the positive finite double x
+ * by printf when Grisu3 fails: the correctly rounded numbers of 15,
+ * 16 and 17 digits are checked by strtod. If a number of at most
+ * 15 digits reads back as x, it is the 15-digit one with the zeros
+ * removed, so the result is the shortest.
+ */
+static int digits_slow(double x, char *buf, int *exp10) {
+  char text[40];
+  int len = 0, e;
+
+  for (int prec = 15; prec <= 17; prec++) {
+    snprintf(text, sizeof(text), "%.*e", prec - 1, x);
+    if ((strtod(text, NULL) == x) || (prec == 17))
+      break;
+  }
+
+  /* "d.ddde+XX": the digits without the point, then the exponent. */
+  for (const char *p = text; *p != 'e'; p++)
+    if (*p != '.')
+      buf[len++] = *p;
+  e = atoi(strchr(text, 'e') + 1);
+  while ((len > 1) && (buf[len - 1] == '0'))
+    len--;
+
+  *exp10 = e - len + 1;
+  return len;
+}
+
+/*
+ * The function writes the digits buf * 10^exp10 as printf("%g")
+ * would lay them out for 17 digits of precision: with a fixed point
+ * if the exponent of the first digit is from -4 to 16, otherwise in
+ * the exponential form with at least two digits of the exponent.
+ */
+static int layout(char *out, const char *buf, int len, int exp10) {
+  int x = len + exp10 - 1, n = 0;
+
+  if ((x >= -4) && (x < 17)) {
+    if (x < 0) {
+      out[n++] = '0';
+      out[n++] = '.';
+      for (int i = 0; i < -x - 1; i++)
+        out[n++] = '0';
+      memcpy(out + n, buf, (size_t)len);
+      return n + len;
+    }
+    if (x >= len - 1) {
+      memcpy(out, buf, (size_t)len);
+      memset(out + len, '0', (size_t)(x - len + 1));
+      return x + 1;
+    }
+    memcpy(out, buf, (size_t)(x + 1));
+    out[x + 1] = '.';
+    memcpy(out + x + 2, buf + x + 1, (size_t)(len - x - 1));
+    return len + 1;
+  }
+
+  out[n++] = buf[0];
+  if (len > 1) {
+    out[n++] = '.';
+    memcpy(out + n, buf + 1, (size_t)(len - 1));
+    n += len - 1;
+  }
+  out[n++] = 'e';
+  out[n++] = (x < 0) ? '-' : '+';
+  if (x < 0)
+    x = -x;
+  if (x >= 100)
+    out[n++] = (char)('0' + x / 100);
+  out[n++] = (char)('0' + x / 10 % 10);
+  out[n++] = (char)('0' + x % 10);
+  return n;
+}
+
+/*
+ * Implementation of the qe_format_double function. The integers
+ * below 2^53 are written directly, the other numbers by Grisu3.
+ */
+int qe_format_double(double x, char *out) {
+  char buf[24];
+  int n = 0, len, exp10;
+
+  if (signbit(x))
+    out[n++] = '-';
+  x = fabs(x);
+
+  if (isnan(x) || isinf(x)) {
+    memcpy(out + n, isnan(x) ? "nan" : "inf", 3);
+    return n + 3;
+  }
+
+  if ((x < 0x1p53) && (x == (double)(uint64_t)x)) {
+    uint64_t m = (uint64_t)x;
+
+    len = 0;
+    do {
+      buf[len++] = (char)('0' + m % 10);
+      m /= 10;
+    } while (m != 0);
+    for (int i = 0; i < len; i++)
+      out[n + i] = buf[len - 1 - i];
+    return n + len;
+  }
+
+  len = grisu3(x, buf, &exp10);
+  if (len == 0)
+    len = digits_slow(x, buf, &exp10);
+
+  return n + layout(out + n, buf, len, exp10);
+}
@@ -8,12 +8,15 @@
  * of the function. The msg_id definitions are in
  * the quadratic_equation.h file.
  *
- * In addition, the file contains overflow checking
- * function (check_overflow) and a function for decrypting
- * msg_id (get_solve_equation_msg).
+ * In addition, the file contains the branch-free variant
+ * of the function (solve_equation_branchless), the classification
+ * of the equation without its roots (qe_classify_extended),
+ * overflow checking function (check_overflow) and a function for
+ * decrypting msg_id (get_solve_equation_msg).
  *
 -------------------------------------------------------------*/
 
+#include "qe_internal.h"
 #include "quadratic_equation.h"
 #include <float.h>
 #include <math.h>
@@ -26,6 +29,22 @@
  */
 static int check_overflow(long double res);
 
+/*
+ * Macros for the branch-free classification core (qe_classify.h).
+ * Here it processes one equation, the roots are already rounded
+ * to double (the overflow is checked before, in long double).
+ */
+typedef double qe_vd;
+typedef int qe_vm;
+
+#define V_SET1(x) ((double)(x))
+#define V_SEL(m, t, f) qe_select_double((m), (t), (f))
+#define M_AND(x, y) ((x) & (y))
+#define M_OR(x, y) ((x) | (y))
+#define M_NOT(x) (!(x))
+
+#include "qe_classify.h"
+
 /*
  * The function returns a pointer to a string
  * that decrypts the passed msg_id.
@@ -33,8 +52,7 @@ static int check_overflow(long double res);
 char *get_solve_equation_msg(int msg_id);
 
 /*
- * Implementation of the solve_equation function that solves
- * the quadratic equation.
+ * The function solves the quadratic equation, see solve_equation.
  *
  * If the equation has two different roots, then it will be written
  * in res1 and res2. If the equation has one root, then it will be
@@ -44,7 +62,8 @@ char *get_solve_equation_msg(int msg_id);
  * or an overflow has occurred, the standard value is written to
  * res1 and res2, which is set in the quadratic_equation.h file.
  */
-int solve_equation(double a, double b, double c, double *res1, double *res2) {
+static inline __attribute__((always_inline)) int
+solve(double a, double b, double c, double *res1, double *res2) {
 
   /*
    * Variables to be used in calculations. The long double data type
@@ -68,19 +87,23 @@ int solve_equation(double a, double b, double c, double *res1, double *res2) {
 
   /* Checking for the infinity of roots. */
   if ((a == 0) && (b == 0) && (c == 0)) {
+    QE_STATS_BRANCH(QE_STATS_BR_ALL_ZERO);
     return QE_OK_INF_RES;
 
     /* If only `c` is not zero, the equation has no roots. */
   } else if ((a == 0) && (b == 0) && (c != 0)) {
+    QE_STATS_BRANCH(QE_STATS_BR_ONLY_C);
     return QE_OK_NO_RES;
 
     /* If only `b` is not zero, the equation has one root, res = 0. */
   } else if ((a == 0) && (b != 0) && (c == 0)) {
+    QE_STATS_BRANCH(QE_STATS_BR_ONLY_B);
     *res1 = *res2 = 0;
     return QE_OK_ONE_RES;
 
     /* If only `a` is not zero, the equation has one root, res = 0. */
   } else if ((a != 0) && (b == 0) && (c == 0)) {
+    QE_STATS_BRANCH(QE_STATS_BR_ONLY_A);
     *res1 = *res2 = 0;
     return QE_OK_ONE_RES;
 
@@ -89,6 +112,7 @@ int solve_equation(double a, double b, double c, double *res1, double *res2) {
      * be solved using the simple formula given below.
      */
   } else if ((a == 0) && (b != 0) && (c != 0)) {
+    QE_STATS_BRANCH(QE_STATS_BR_LINEAR);
     _b = b;
     _c = c;
 
@@ -122,6 +146,7 @@ int solve_equation(double a, double b, double c, double *res1, double *res2) {
      * is greater than zero.
      */
     if (discriminant > 0) {
+      QE_STATS_BRANCH(QE_STATS_BR_DISC_POS);
       _res1 = (-_b + sqrt(discriminant)) / (2.0 * _a);
       _res2 = (-_b - sqrt(discriminant)) / (2.0 * _a);
 
@@ -139,6 +164,7 @@ int solve_equation(double a, double b, double c, double *res1, double *res2) {
 
       /* Solving the equation if the discriminant is zero. */
     } else if (discriminant == 0) {
+      QE_STATS_BRANCH(QE_STATS_BR_DISC_ZERO);
       _res1 = (-_b) / (2.0 * _a);
       _res2 = _res1;
 
@@ -158,15 +184,117 @@ int solve_equation(double a, double b, double c, double *res1, double *res2) {
        * If the discriminant is less than zero,
        * the equation has no roots.
        *
-       * In future versions, it is possible to
-       * expand the library's capabilities and calculate
-       * roots on the complex plane with a negative discriminant.
+       * The roots on the complex plane are calculated
+       * by the solve_equation_complex function.
        */
-    } else
+    } else {
+      QE_STATS_BRANCH(QE_STATS_BR_DISC_NEG);
       return QE_OK_NO_RES;
+    }
   }
 }
 
+/*
+ * Implementation of the solve_equation function that solves
+ * the quadratic equation. If the library is built with QE_STATS,
+ * the call is counted (qe_stats.h).
+ */
+int solve_equation(double a, double b, double c, double *res1, double *res2) {
+#if defined(QE_STATS)
+  uint64_t start = qe_stats_begin();
+  int msg_id = solve(a, b, c, res1, res2);
+
+  qe_stats_end(start, msg_id);
+  return msg_id;
+#else
+  return solve(a, b, c, res1, res2);
+#endif
+}
+
+/*
+ * The function classifies the equation like solve_equation: the
+ * special cases are the same, and the discriminant is computed in
+ * long double by the same operations, so its sign is the same.
+ */
+int qe_classify_extended(double a, double b, double c) {
+  long double discriminant, _a = a, _b = b, _c = c;
+
+  if (a == 0) {
+    if (b == 0)
+      return (c == 0) ? QE_OK_INF_RES : QE_OK_NO_RES;
+    return QE_OK_ONE_RES;
+  }
+
+  if ((b == 0) && (c == 0))
+    return QE_OK_ONE_RES;
+
+  discriminant = _b * _b - 4.0 * _a * _c;
+
+  if (discriminant > 0)
+    return QE_OK_TWO_RES;
+  return (discriminant == 0) ? QE_OK_ONE_RES : QE_OK_NO_RES;
+}
+
+/*
+ * Implementation of the solve_equation_branchless function. The
+ * calculations are the same as in solve_equation, but they are
+ * performed for all the cases, and the msg_id and the roots are
+ * selected by the classification core.
+ */
+int solve_equation_branchless(double a, double b, double c, double *res1,
+                              double *res2) {
+  long double discriminant, _a, _b, _c, _res0, _res1, _res2;
+  double sqrt_d, r0, r1, r2, msg;
+  int za, zb, zc, lin, dpos, dzero, ovf0, ovf12;
+
+  /* Checking pointers for a non-NULL value. */
+  if ((res1 == NULL) || (res2 == NULL))
+    return QE_ERR_NULLPTR;
+
+  /* Masks of the zero parameters and of the linear equation. */
+  za = (a == 0);
+  zb = (b == 0);
+  zc = (c == 0);
+  lin = za & !zb & !zc;
+
+  /*
+   * The divisors that are not needed in the case of the equation
+   * are replaced by 1 (`a` by 0.5), and the negative discriminant
+   * by 0, so that no division by zero or invalid operation occurs.
+   */
+  _a = qe_select_double(za, 0.5, a);
+  _b = b;
+  _c = c;
+
+  discriminant = _b * _b - 4.0 * _a * _c;
+  dpos = (discriminant > 0);
+  dzero = (discriminant == 0);
+  sqrt_d = sqrt(qe_select_double(dpos, discriminant, 0));
+
+  _res0 = -_c / qe_select_double(zb, 1, b);
+  _res1 = (-_b + sqrt_d) / (2.0 * _a);
+  _res2 = (-_b - sqrt_d) / (2.0 * _a);
+
+  /*
+   * The same check as check_overflow, with one comparison. If the
+   * discriminant is zero, _res1 is the single root -b / (2 * a).
+   */
+  ovf12 = (fabsl(_res1) > DBL_MAX);
+  ovf0 = (lin & (fabsl(_res0) > DBL_MAX)) | ((lin ^ 1) & ovf12);
+  ovf12 |= (fabsl(_res2) > DBL_MAX);
+
+  r1 = _res1;
+  r2 = _res2;
+  r0 = qe_select_double(lin, _res0, r1);
+
+  msg = qe_classify(za, zb, zc, dpos, dzero, ovf0, ovf12, r0, r1, r2, &r1,
+                    &r2);
+
+  *res1 = r1;
+  *res2 = r2;
+  return (int)msg;
+}
+
 /*
  * The function returns a pointer to a string
  * that decrypts the passed msg_id.
@@ -174,6 +302,9 @@ int solve_equation(double a, double b, double c, double *res1, double *res2) {
 char *get_solve_equation_msg(int msg_id) {
   switch (msg_id) {
 
+  case QE_OK_CPLX_RES:
+    return "The equation is solved. Two complex solutions found.";
+
   case QE_OK_INF_RES:
     return "The equation is solved. An infinite number of solutions have been "
            "found.";
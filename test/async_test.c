@@ -0,0 +1,373 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the tests for the
+ * asynchronous queue of equations (qe_async).
+ *
+ * The test "async0" checks the pool of requests, "async1"
+ * checks that qe_async_destroy solves the submitted requests.
+ * The other tests submit random equations from several producer
+ * threads, take the results by callbacks or by polling and
+ * check that every equation is solved exactly once and that the
+ * results are bit-identical to the results of
+ * solve_equation_batch_prec.
+ *
+-------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include "qe_async.h"
+#include "quadratic_equation.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, solves the equations through
+ * the queue and compares the results. In case of an error,
+ * it returns 1.
+ */
+static int check(int test_num);
+
+/* The function checks the acquiring and releasing of requests. */
+static int check_pool(void);
+
+/* The function checks that the submitted requests are solved. */
+static int check_destroy(void);
+
+/*
+ * A structure that describes a test: the queue and the
+ * equations that are solved through it.
+ */
+typedef struct {
+  int nthreads;     /* Solver threads of the queue. */
+  int nproducers;   /* Threads that submit the equations. */
+  size_t nrequests; /* Requests of the queue. */
+  int callback;     /* Whether the results come to a callback. */
+  size_t size;      /* The number of equations. */
+  int prec;         /* Precision mode. */
+  char *name;       /* Name of the test. */
+  char *test_id;    /* The test ID is needed to select a structure. */
+} test_param;
+
+/* An array of test_param type structures. */
+test_param test_param_arr[] = {
+    {.nthreads = 1,
+     .nproducers = 1,
+     .nrequests = 64,
+     .callback = 0,
+     .size = 100003,
+     .prec = QE_PREC_EXTENDED,
+     .name = "One solver, one producer, polling.",
+     .test_id = "async2"},
+
+    {.nthreads = 4,
+     .nproducers = 3,
+     .nrequests = 256,
+     .callback = 1,
+     .size = 1000003,
+     .prec = QE_PREC_DOUBLE,
+     .name = "Four solvers, three producers, callbacks.",
+     .test_id = "async3"},
+
+    {.nthreads = 2,
+     .nproducers = 4,
+     .nrequests = 1000,
+     .callback = 0,
+     .size = 300007,
+     .prec = QE_PREC_EXTENDED,
+     .name = "Two solvers, four producers, polling.",
+     .test_id = "async4"},
+
+    {.nthreads = 3,
+     .nproducers = 2,
+     .nrequests = 1,
+     .callback = 1,
+     .size = 10007,
+     .prec = QE_PREC_EXTENDED,
+     .name = "A pool of one request.",
+     .test_id = "async5"}};
+
+/*
+ * The main function receives one parameter as input.
+ * It is needed to compare with test_id and select
+ * the desired test.
+ */
+int main(int argc, char *argv[]) {
+
+  /*
+   * The value returned by the main function. In case of a
+   * failed test, the unchanged value of 1 will be returned.
+   */
+  int res = 1;
+
+  /* The number of elements in the test_param_arr array. */
+  int size = sizeof(test_param_arr) / sizeof(test_param_arr[0]);
+
+  /* Checking for the number of passed parameters in main. */
+  if (argc != 2) {
+    printf("[ERROR]: The wrong number of arguments was passed.\n");
+    exit(res);
+  }
+
+  if (strcmp(argv[1], "async0") == 0)
+    res = check_pool();
+
+  if (strcmp(argv[1], "async1") == 0)
+    res = check_destroy();
+
+  /*
+   * Search for the desired structure by the test_id
+   * parameter received by the main function.
+   */
+  for (int i = 0; i < size; i++)
+    if (strcmp(argv[1], test_param_arr[i].test_id) == 0)
+      res = check(i);
+
+  return res;
+}
+
+/*
+ * The equations and the results of the current test. The user
+ * pointer of a request points to its `a`, so the number of the
+ * equation is found from it.
+ */
+static struct {
+  double *a, *b, *c, *res1, *res2;
+  int *msg_id, *count;
+  size_t n;
+  size_t done; /* The number of the solved equations. */
+} eqs;
+
+/* The function saves the results of the solved request. */
+static void save_result(qe_request *req) {
+  size_t i = (size_t)((double *)req->user - eqs.a);
+
+  eqs.res1[i] = req->res1;
+  eqs.res2[i] = req->res2;
+  eqs.msg_id[i] = req->msg_id;
+  __atomic_fetch_add(&eqs.count[i], 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&eqs.done, 1, __ATOMIC_RELEASE);
+}
+
+/* The argument of a producer thread. */
+typedef struct {
+  qe_async *q;
+  int id;
+  int nproducers;
+  int callback;
+} producer_arg;
+
+/*
+ * A producer thread: submits every nproducers-th equation. If
+ * there is no free request, it waits for the solvers.
+ */
+static void *producer_main(void *p) {
+  producer_arg *arg = p;
+
+  for (size_t i = arg->id; i < eqs.n; i += arg->nproducers) {
+    qe_request *req;
+
+    while ((req = qe_async_acquire(arg->q)) == NULL)
+      sched_yield();
+
+    req->a = eqs.a[i];
+    req->b = eqs.b[i];
+    req->c = eqs.c[i];
+    req->done = arg->callback ? save_result : NULL;
+    req->user = &eqs.a[i];
+    qe_async_submit(arg->q, req);
+  }
+  return NULL;
+}
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, solves the equations through
+ * the queue and compares the results. In case of an error,
+ * it returns 1.
+ */
+static int check(int test_num) {
+  test_param *t = &test_param_arr[test_num];
+  size_t n = t->size;
+  double *true_res1, *true_res2;
+  int *true_msg_id;
+  producer_arg args[8];
+  pthread_t threads[8];
+  qe_async *q;
+  int res = 0;
+
+  printf("TEST_ASYNC_%d (%s): ", test_num, t->name);
+
+  eqs.n = n;
+  eqs.done = 0;
+  eqs.a = malloc(n * sizeof(double));
+  eqs.b = malloc(n * sizeof(double));
+  eqs.c = malloc(n * sizeof(double));
+  eqs.res1 = malloc(n * sizeof(double));
+  eqs.res2 = malloc(n * sizeof(double));
+  eqs.msg_id = malloc(n * sizeof(int));
+  eqs.count = calloc(n, sizeof(int));
+  true_res1 = malloc(n * sizeof(double));
+  true_res2 = malloc(n * sizeof(double));
+  true_msg_id = malloc(n * sizeof(int));
+  if (!eqs.a || !eqs.b || !eqs.c || !eqs.res1 || !eqs.res2 || !eqs.msg_id ||
+      !eqs.count || !true_res1 || !true_res2 || !true_msg_id) {
+    printf("[ERROR]: Out of memory.\n");
+    exit(1);
+  }
+
+  /* Random parameters from -1 to 1, every tenth `a` is zero. */
+  for (size_t i = 0; i < n; i++) {
+    eqs.a[i] = (i % 10 == 0) ? 0 : 2.0 * rand() / RAND_MAX - 1.0;
+    eqs.b[i] = 2.0 * rand() / RAND_MAX - 1.0;
+    eqs.c[i] = 2.0 * rand() / RAND_MAX - 1.0;
+  }
+
+  q = qe_async_create(t->nthreads, t->nrequests, t->prec);
+  if (q == NULL) {
+    printf("[ERROR]: The queue was not created.\n");
+    exit(1);
+  }
+
+  for (int i = 0; i < t->nproducers; i++) {
+    args[i].q = q;
+    args[i].id = i;
+    args[i].nproducers = t->nproducers;
+    args[i].callback = t->callback;
+    pthread_create(&threads[i], NULL, producer_main, &args[i]);
+  }
+
+  /* The results come to the callbacks or are polled here. */
+  while (__atomic_load_n(&eqs.done, __ATOMIC_ACQUIRE) < n) {
+    qe_request *req = t->callback ? NULL : qe_async_poll(q);
+
+    if (req == NULL) {
+      sched_yield();
+      continue;
+    }
+
+    save_result(req);
+    qe_async_release(q, req);
+  }
+
+  for (int i = 0; i < t->nproducers; i++)
+    pthread_join(threads[i], NULL);
+  qe_async_destroy(q);
+
+  solve_equation_batch_prec(eqs.a, eqs.b, eqs.c, true_res1, true_res2,
+                            true_msg_id, n, t->prec);
+
+  for (size_t i = 0; (i < n) && !res; i++)
+    if (eqs.count[i] != 1) {
+      printf("[ERROR]: The equation %zu was solved %d times.\n", i,
+             eqs.count[i]);
+      res = 1;
+    } else if ((eqs.msg_id[i] != true_msg_id[i]) ||
+               (memcmp(&eqs.res1[i], &true_res1[i], sizeof(double)) != 0) ||
+               (memcmp(&eqs.res2[i], &true_res2[i], sizeof(double)) != 0)) {
+      printf("[ERROR]:\n");
+      printf("\tEquation %zu: a = %A   b = %A   c = %A\n", i, eqs.a[i],
+             eqs.b[i], eqs.c[i]);
+      printf("\tReceived answer: res1 = %A   res2 = %A   msg[%d]\n",
+             eqs.res1[i], eqs.res2[i], eqs.msg_id[i]);
+      printf("\tExpected answer: res1 = %A   res2 = %A   msg[%d]\n",
+             true_res1[i], true_res2[i], true_msg_id[i]);
+      res = 1;
+    }
+
+  free(eqs.a);
+  free(eqs.b);
+  free(eqs.c);
+  free(eqs.res1);
+  free(eqs.res2);
+  free(eqs.msg_id);
+  free(eqs.count);
+  free(true_res1);
+  free(true_res2);
+  free(true_msg_id);
+
+  if (!res)
+    printf("[OK].\n");
+  return res;
+}
+
+/* The function checks the acquiring and releasing of requests. */
+static int check_pool(void) {
+  qe_async *q = qe_async_create(2, 5, QE_PREC_EXTENDED);
+  qe_request *reqs[8];
+  int res = 0;
+
+  printf("TEST_ASYNC (The pool of requests): ");
+  if (q == NULL) {
+    printf("[ERROR]: The queue was not created.\n");
+    return 1;
+  }
+
+  /* 5 is rounded up to 8 requests, all different. */
+  for (int i = 0; i < 8; i++) {
+    reqs[i] = qe_async_acquire(q);
+    for (int j = 0; j < i; j++)
+      if ((reqs[i] == NULL) || (reqs[i] == reqs[j]))
+        res = 1;
+  }
+
+  if (qe_async_acquire(q) != NULL)
+    res = 1;
+
+  qe_async_release(q, reqs[3]);
+  if (qe_async_acquire(q) != reqs[3])
+    res = 1;
+
+  if (qe_async_poll(q) != NULL)
+    res = 1;
+
+  qe_async_destroy(q);
+  if (!res)
+    printf("[OK].\n");
+  else
+    printf("[ERROR]: A wrong request was acquired.\n");
+  return res;
+}
+
+/* The number of the correct results of async1. */
+static int ncorrect;
+
+/* The callback of async1: counts the correct results. */
+static void count_result(qe_request *req) {
+  if ((req->msg_id == QE_OK_TWO_RES) && (req->res1 == 2) && (req->res2 == 1))
+    __atomic_fetch_add(&ncorrect, 1, __ATOMIC_RELAXED);
+}
+
+/* The function checks that the submitted requests are solved. */
+static int check_destroy(void) {
+  qe_async *q = qe_async_create(3, 1000, QE_PREC_EXTENDED);
+
+  printf("TEST_ASYNC (Destroying with submitted requests): ");
+  if (q == NULL) {
+    printf("[ERROR]: The queue was not created.\n");
+    return 1;
+  }
+
+  /* The equation x^2 - 3x + 2 = 0 with the roots 2 and 1. */
+  for (int i = 0; i < 1000; i++) {
+    qe_request *req = qe_async_acquire(q);
+
+    req->a = 1;
+    req->b = -3;
+    req->c = 2;
+    req->done = count_result;
+    qe_async_submit(q, req);
+  }
+  qe_async_destroy(q);
+
+  if (ncorrect == 1000) {
+    printf("[OK].\n");
+    return 0;
+  }
+
+  printf("[ERROR]: %d of 1000 requests were solved.\n", ncorrect);
+  return 1;
+}
@@ -0,0 +1,235 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the tests for
+ * the solve_equation_batch function.
+ *
+ * Each test fills the arrays of parameters `a`, `b`, `c`
+ * with its own generator, solves them with every instruction
+ * set supported by the processor and checks that the results
+ * are bit-identical to the results of solve_equation.
+ *
+ * The tests are described in the test_param_arr array, the
+ * test_id of the desired test is passed to the main function.
+ *
+-------------------------------------------------------------*/
+
+#include "quadratic_equation.h"
+#include "test_gen.h"
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, generates the parameters and
+ * compares the results of the batch function with the results
+ * of solve_equation. In case of an error, it returns 1.
+ */
+static int check(int test_num);
+
+/*
+ * The function compares the results of one equation. It returns
+ * true if they match bit by bit, otherwise it prints an error.
+ */
+static int check_equation(double a, double b, double c, double res1,
+                          double res2, int msg_id, int isa);
+
+/*
+ * The generator of the parameters of the tests of solve_equation,
+ * the other generators are in test_gen.c.
+ */
+static void select_table(size_t i, double *a, double *b, double *c);
+
+/*
+ * A structure that describes a test: the generator of
+ * parameters and the number of equations in the batch.
+ */
+typedef struct {
+  gen_select select; /* Generator. */
+  size_t size;       /* The number of equations. */
+  char *name;        /* Name of the test. */
+  char *test_id;     /* The test ID is needed to select a structure. */
+} test_param;
+
+/* An array of test_param type structures. */
+test_param test_param_arr[] = {
+    {.select = select_table,
+     .size = 15,
+     .name = "Parameters of the tests of solve_equation.",
+     .test_id = "batch1"},
+
+    {.select = gen_uniform,
+     .size = 100003,
+     .name = "Random parameters from -1 to 1.",
+     .test_id = "batch2"},
+
+    {.select = gen_integer,
+     .size = 100003,
+     .name = "Random small integers, many of them are zero.",
+     .test_id = "batch3"},
+
+    {.select = gen_bits,
+     .size = 100003,
+     .name = "Random bit patterns (any exponent, infinities, NaN).",
+     .test_id = "batch4"},
+
+    {.select = gen_scaled,
+     .size = 100003,
+     .name = "Random parameters from 2^-300 to 2^300.",
+     .test_id = "batch5"},
+
+    {.select = gen_uniform,
+     .size = 7,
+     .name = "A batch shorter than any vector.",
+     .test_id = "batch6"}};
+
+/* Parameters of the tests of solve_equation (test.c). */
+static const double table[15][3] = {{0, 0, 0},
+                                    {0, 0, 1},
+                                    {0, 1, 0},
+                                    {1, 0, 0},
+                                    {0, 5, 3},
+                                    {0, 0.01, DBL_MAX - 1},
+                                    {1, 0, 1},
+                                    {1, 0, -16},
+                                    {-DBL_MAX + 1, 0, DBL_MAX - 1},
+                                    {10, 5, 0},
+                                    {10, DBL_MAX - 1, 0},
+                                    {1, 3, -70},
+                                    {-1.5625, 5, -4},
+                                    {5, 10, 100},
+                                    {1, DBL_MAX - 1, 1}};
+
+/*
+ * The main function receives one parameter as input.
+ * It is needed to compare with test_id and select
+ * the desired test. The test "batch0" checks
+ * the passing of null pointers.
+ */
+int main(int argc, char *argv[]) {
+
+  /*
+   * The value returned by the main function. In case of a
+   * failed test, the unchanged value of 1 will be returned.
+   */
+  int res = 1;
+
+  /* The number of elements in the test_param_arr array. */
+  int size = sizeof(test_param_arr) / sizeof(test_param_arr[0]);
+
+  /* Checking for the number of passed parameters in main. */
+  if (argc != 2) {
+    printf("[ERROR]: The wrong number of arguments was passed.\n");
+    exit(res);
+  }
+
+  if (strcmp(argv[1], "batch0") == 0) {
+    double x = 0;
+    int msg_id;
+
+    printf("TEST_BATCH (Null pointers): ");
+    if ((solve_equation_batch(&x, &x, &x, &x, NULL, &msg_id, 1) ==
+         QE_ERR_NULLPTR) &&
+        (solve_equation_batch(NULL, &x, &x, &x, &x, &msg_id, 1) ==
+         QE_ERR_NULLPTR)) {
+      printf("[OK].\n");
+      res = 0;
+    } else
+      printf("[ERROR]: QE_ERR_NULLPTR was expected.\n");
+  }
+
+  /*
+   * Search for the desired structure by the test_id
+   * parameter received by the main function.
+   */
+  for (int i = 0; i < size; i++)
+    if (strcmp(argv[1], test_param_arr[i].test_id) == 0)
+      res = check(i);
+
+  return res;
+}
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, generates the parameters and
+ * compares the results of the batch function with the results
+ * of solve_equation. In case of an error, it returns 1.
+ */
+static int check(int test_num) {
+  size_t n = test_param_arr[test_num].size;
+  double *a, *b, *c, *res1, *res2;
+  int *msg_id;
+  int res = 0;
+
+  printf("TEST_BATCH_%d (%s): ", test_num, test_param_arr[test_num].name);
+
+  a = gen_alloc(n * sizeof(double));
+  b = gen_alloc(n * sizeof(double));
+  c = gen_alloc(n * sizeof(double));
+  res1 = gen_alloc(n * sizeof(double));
+  res2 = gen_alloc(n * sizeof(double));
+  msg_id = gen_alloc(n * sizeof(int));
+  gen_fill(test_param_arr[test_num].select, a, b, c, n);
+
+  /*
+   * Every instruction set is checked. If the processor does
+   * not support one, the previous one is checked again.
+   */
+  for (int isa = QE_ISA_GENERIC; (isa <= QE_ISA_AVX512) && !res; isa++) {
+    int used = qe_batch_set_isa(isa);
+
+    if (solve_equation_batch(a, b, c, res1, res2, msg_id, n) != QE_BATCH_OK) {
+      printf("[ERROR]: QE_BATCH_OK was expected.\n");
+      res = 1;
+    }
+
+    for (size_t i = 0; (i < n) && !res; i++)
+      if (!check_equation(a[i], b[i], c[i], res1[i], res2[i], msg_id[i], used))
+        res = 1;
+  }
+
+  free(a);
+  free(b);
+  free(c);
+  free(res1);
+  free(res2);
+  free(msg_id);
+
+  if (!res)
+    printf("[OK].\n");
+  return res;
+}
+
+/*
+ * The function compares the results of one equation. It returns
+ * true if they match bit by bit, otherwise it prints an error.
+ */
+static int check_equation(double a, double b, double c, double res1,
+                          double res2, int msg_id, int isa) {
+  double true_res1, true_res2;
+  int true_msg_id;
+
+  true_msg_id = solve_equation(a, b, c, &true_res1, &true_res2);
+
+  if ((msg_id == true_msg_id) &&
+      (memcmp(&res1, &true_res1, sizeof(double)) == 0) &&
+      (memcmp(&res2, &true_res2, sizeof(double)) == 0))
+    return 1;
+
+  printf("[ERROR]:\n");
+  printf("\tInstruction set: %s\n", qe_batch_isa_name(isa));
+  printf("\tParameters passed: a = %A   b = %A   c = %A\n", a, b, c);
+  printf("\tReceived answer: res1 = %A   res2 = %A   msg[%d]\n", res1, res2,
+         msg_id);
+  printf("\tExpected answer: res1 = %A   res2 = %A   msg[%d]\n", true_res1,
+         true_res2, true_msg_id);
+  return 0;
+}
+
+/* The parameters of the tests of solve_equation, in a cycle. */
+static void select_table(size_t i, double *a, double *b, double *c) {
+  *a = table[i % 15][0];
+  *b = table[i % 15][1];
+  *c = table[i % 15][2];
+}
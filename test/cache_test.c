@@ -0,0 +1,353 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the tests for the
+ * cache of the results (qe_cache).
+ *
+ * Each of the tests "cache4" - "cache9" runs threads that solve
+ * equations from a common set of parameters through one cache,
+ * several rounds each, and checks that every result is
+ * bit-identical to the result of solve_equation_prec and that the
+ * counters add up. The test "cache0" checks the passing of null
+ * pointers, "cache1" - "cache3" check the eviction policies on a
+ * cache of one set.
+ *
+-------------------------------------------------------------*/
+
+#include "qe_cache.h"
+#include "quadratic_equation.h"
+#include "test_gen.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, runs the threads and checks
+ * their results. In case of an error, it returns 1.
+ */
+static int check(int test_num);
+
+/*
+ * The function checks an eviction policy on a cache of one set.
+ * In case of an error, it returns 1.
+ */
+static int check_policy(int policy);
+
+/*
+ * A structure that describes a test: the cache
+ * and the equations that are solved through it.
+ */
+typedef struct {
+  size_t capacity; /* The capacity of the cache. */
+  int policy;      /* The eviction policy. */
+  size_t nkeys;    /* The number of different equations. */
+  int rounds;      /* How many times every thread solves them. */
+  int nthreads;    /* The number of threads. */
+  int clear;       /* Whether the cache is cleared during the test. */
+  int random;      /* Parameters with random bits instead of integers. */
+  char *name;      /* Name of the test. */
+  char *test_id;   /* The test ID is needed to select a structure. */
+} test_param;
+
+/* An array of test_param type structures. */
+test_param test_param_arr[] = {
+    {.capacity = 1 << 16,
+     .policy = QE_CACHE_EVICT_CLOCK,
+     .nkeys = 5000,
+     .rounds = 4,
+     .nthreads = 1,
+     .random = 0,
+     .name = "All the equations fit, one thread.",
+     .test_id = "cache4"},
+
+    {.capacity = 1 << 16,
+     .policy = QE_CACHE_EVICT_CLOCK,
+     .nkeys = 20000,
+     .rounds = 3,
+     .nthreads = 1,
+     .random = 1,
+     .name = "Random bits (infinities, NaN, signed zeros).",
+     .test_id = "cache5"},
+
+    {.capacity = 1024,
+     .policy = QE_CACHE_EVICT_CLOCK,
+     .nkeys = 1000,
+     .rounds = 50,
+     .nthreads = 4,
+     .random = 0,
+     .name = "Four threads, a small cache, CLOCK eviction.",
+     .test_id = "cache6"},
+
+    {.capacity = 1024,
+     .policy = QE_CACHE_EVICT_FIFO,
+     .nkeys = 1000,
+     .rounds = 50,
+     .nthreads = 4,
+     .random = 1,
+     .name = "Four threads, a small cache, FIFO eviction.",
+     .test_id = "cache7"},
+
+    {.capacity = 64,
+     .policy = QE_CACHE_EVICT_CLOCK,
+     .nkeys = 100,
+     .rounds = 2000,
+     .nthreads = 4,
+     .random = 0,
+     .name = "Four threads writing the same entries.",
+     .test_id = "cache8"},
+
+    {.capacity = 4096,
+     .policy = QE_CACHE_EVICT_NONE,
+     .nkeys = 3000,
+     .rounds = 20,
+     .nthreads = 3,
+     .clear = 1,
+     .random = 0,
+     .name = "Three threads, the cache is cleared meanwhile.",
+     .test_id = "cache9"}};
+
+/*
+ * The main function receives one parameter as input.
+ * It is needed to compare with test_id and select
+ * the desired test.
+ */
+int main(int argc, char *argv[]) {
+
+  /*
+   * The value returned by the main function. In case of a
+   * failed test, the unchanged value of 1 will be returned.
+   */
+  int res = 1;
+
+  /* The number of elements in the test_param_arr array. */
+  int size = sizeof(test_param_arr) / sizeof(test_param_arr[0]);
+
+  /* Checking for the number of passed parameters in main. */
+  if (argc != 2) {
+    printf("[ERROR]: The wrong number of arguments was passed.\n");
+    exit(res);
+  }
+
+  if (strcmp(argv[1], "cache0") == 0) {
+    qe_cache *cache = qe_cache_create(16, QE_CACHE_EVICT_CLOCK);
+    double x;
+
+    printf("TEST_CACHE (Null pointers): ");
+    if ((cache != NULL) &&
+        (qe_cache_solve(cache, 1, 2, 1, &x, NULL, QE_PREC_EXTENDED) ==
+         QE_ERR_NULLPTR) &&
+        (qe_cache_create(16, 100) == NULL)) {
+      printf("[OK].\n");
+      res = 0;
+    } else
+      printf("[ERROR]: QE_ERR_NULLPTR was expected.\n");
+    qe_cache_destroy(cache);
+  }
+
+  if (strcmp(argv[1], "cache1") == 0)
+    res = check_policy(QE_CACHE_EVICT_CLOCK);
+
+  if (strcmp(argv[1], "cache2") == 0)
+    res = check_policy(QE_CACHE_EVICT_FIFO);
+
+  if (strcmp(argv[1], "cache3") == 0)
+    res = check_policy(QE_CACHE_EVICT_NONE);
+
+  /*
+   * Search for the desired structure by the test_id
+   * parameter received by the main function.
+   */
+  for (int i = 0; i < size; i++)
+    if (strcmp(argv[1], test_param_arr[i].test_id) == 0)
+      res = check(i);
+
+  return res;
+}
+
+/* The argument of a thread of the test. */
+typedef struct {
+  test_param *t;
+  qe_cache *cache;
+  const double *a, *b, *c;
+  int id;
+  int errors;
+  unsigned long long calls;
+} thread_arg;
+
+/*
+ * A thread of the test: solves all the equations in its own order
+ * in both precision modes and compares the results.
+ */
+static void *thread_main(void *p) {
+  thread_arg *arg = p;
+  size_t n = arg->t->nkeys;
+
+  for (int r = 0; r < arg->t->rounds; r++)
+    for (size_t k = 0; k < n; k++) {
+      size_t i = (k * 7919 + (size_t)arg->id * 104729 + (size_t)r) % n;
+      int prec = (i % 3 == 0) ? QE_PREC_DOUBLE : QE_PREC_EXTENDED;
+      double res1, res2, true_res1, true_res2;
+      int msg_id, true_msg_id;
+
+      msg_id = qe_cache_solve(arg->cache, arg->a[i], arg->b[i], arg->c[i],
+                              &res1, &res2, prec);
+      true_msg_id = solve_equation_prec(arg->a[i], arg->b[i], arg->c[i],
+                                        &true_res1, &true_res2, prec);
+      arg->calls++;
+
+      if ((msg_id != true_msg_id) ||
+          (memcmp(&res1, &true_res1, sizeof(double)) != 0) ||
+          (memcmp(&res2, &true_res2, sizeof(double)) != 0)) {
+        if (arg->errors++ == 0) {
+          printf("[ERROR]:\n");
+          printf("\tParameters passed: a = %A   b = %A   c = %A\n", arg->a[i],
+                 arg->b[i], arg->c[i]);
+          printf("\tReceived answer: res1 = %A   res2 = %A   msg[%d]\n", res1,
+                 res2, msg_id);
+          printf("\tExpected answer: res1 = %A   res2 = %A   msg[%d]\n",
+                 true_res1, true_res2, true_msg_id);
+        }
+      }
+
+      /* The thread 0 of the test with clearing clears the cache. */
+      if (arg->t->clear && (arg->id == 0) && (k % 1000 == 0))
+        qe_cache_clear(arg->cache);
+    }
+
+  return NULL;
+}
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, runs the threads and checks
+ * their results. In case of an error, it returns 1.
+ */
+static int check(int test_num) {
+  test_param *t = &test_param_arr[test_num];
+  thread_arg args[8];
+  pthread_t threads[8];
+  double *a, *b, *c;
+  qe_cache *cache;
+  qe_cache_stats stats;
+  unsigned long long calls = 0;
+  int res = 0;
+
+  printf("TEST_CACHE_%d (%s): ", test_num, t->name);
+
+  a = malloc(t->nkeys * sizeof(double));
+  b = malloc(t->nkeys * sizeof(double));
+  c = malloc(t->nkeys * sizeof(double));
+  cache = qe_cache_create(t->capacity, t->policy);
+  if (!a || !b || !c || !cache) {
+    printf("[ERROR]: Out of memory.\n");
+    exit(1);
+  }
+
+  /* Small integers give all the special cases of the equation. */
+  for (size_t i = 0; i < t->nkeys; i++) {
+    a[i] = t->random ? gen_random_bits() : (double)(rand() % 41 - 20);
+    b[i] = t->random ? gen_random_bits() : (double)(rand() % 41 - 20);
+    c[i] = t->random ? gen_random_bits() : (double)(rand() % 41 - 20);
+  }
+
+  for (int i = 0; i < t->nthreads; i++) {
+    args[i].t = t;
+    args[i].cache = cache;
+    args[i].a = a;
+    args[i].b = b;
+    args[i].c = c;
+    args[i].id = i;
+    args[i].errors = 0;
+    args[i].calls = 0;
+    pthread_create(&threads[i], NULL, thread_main, &args[i]);
+  }
+  for (int i = 0; i < t->nthreads; i++) {
+    pthread_join(threads[i], NULL);
+    calls += args[i].calls;
+    if (args[i].errors)
+      res = 1;
+  }
+
+  qe_cache_get_stats(cache, &stats);
+  if (!res && ((stats.hits + stats.misses != calls) ||
+               (stats.insertions > stats.misses) ||
+               (stats.evictions > stats.insertions) || (stats.hits == 0))) {
+    printf("[ERROR]: The counters do not add up:\n");
+    printf("\tcalls %llu, hits %llu, misses %llu, insertions %llu, "
+           "evictions %llu\n",
+           calls, stats.hits, stats.misses, stats.insertions,
+           stats.evictions);
+    res = 1;
+  }
+
+  qe_cache_destroy(cache);
+  free(a);
+  free(b);
+  free(c);
+
+  if (!res)
+    printf("[OK].\n");
+  return res;
+}
+
+/*
+ * The function checks an eviction policy on a cache of one set.
+ * In case of an error, it returns 1.
+ */
+static int check_policy(int policy) {
+  qe_cache *cache = qe_cache_create(QE_CACHE_WAYS, policy);
+  qe_cache_stats stats;
+  double res1, res2;
+  int hot_hits = 0, res = 0;
+
+  printf("TEST_CACHE (Eviction policy %d): ", policy);
+  if (cache == NULL) {
+    printf("[ERROR]: The cache was not created.\n");
+    return 1;
+  }
+
+  /*
+   * The equation 1, -3, 2 is solved between every two new ones.
+   * CLOCK keeps it, FIFO replaces it in turn, NONE keeps the
+   * first QE_CACHE_WAYS equations.
+   */
+  qe_cache_solve(cache, 1, -3, 2, &res1, &res2, QE_PREC_EXTENDED);
+  for (int i = 0; i < 100; i++) {
+    unsigned long long hits;
+
+    qe_cache_get_stats(cache, &stats);
+    hits = stats.hits;
+    qe_cache_solve(cache, 1, -3, 2, &res1, &res2, QE_PREC_EXTENDED);
+    if ((res1 != 2) || (res2 != 1))
+      res = 1;
+    qe_cache_get_stats(cache, &stats);
+    hot_hits += (stats.hits == hits + 1);
+
+    qe_cache_solve(cache, 1, i, 0.5, &res1, &res2, QE_PREC_EXTENDED);
+  }
+
+  qe_cache_get_stats(cache, &stats);
+  switch (policy) {
+  case QE_CACHE_EVICT_CLOCK:
+    res |= (hot_hits != 100) || (stats.evictions != 101 - QE_CACHE_WAYS);
+    break;
+  case QE_CACHE_EVICT_FIFO:
+    res |= (hot_hits == 100) ||
+           (stats.evictions != stats.misses - QE_CACHE_WAYS);
+    break;
+  default:
+    res |= (hot_hits != 100) || (stats.evictions != 0) ||
+           (stats.insertions != QE_CACHE_WAYS);
+  }
+
+  if (res) {
+    printf("[ERROR]: The equation was hit %d times of 100.\n", hot_hits);
+    printf("\tmisses %llu, insertions %llu, evictions %llu\n", stats.misses,
+           stats.insertions, stats.evictions);
+  } else
+    printf("[OK].\n");
+
+  qe_cache_destroy(cache);
+  return res;
+}
@@ -0,0 +1,284 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the tests for the
+ * classification of the equations (classify_equation,
+ * classify_equation_batch and classify_equation_select).
+ *
+ * Every test generates equations of its kind and, in both
+ * precision modes, checks that the msg_id of classify_equation
+ * is the msg_id of solve_equation_prec (QE_OK_TWO_RES or
+ * QE_OK_ONE_RES where the roots overflow), then that the batch
+ * function and the selection return the same classes with every
+ * instruction set. The test "classify0" checks the passing of
+ * null pointers.
+ *
+-------------------------------------------------------------*/
+
+#include "quadratic_equation.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The kinds of the generated equations. */
+#define KIND_UNIFORM 0  /* Parameters from -1 to 1. */
+#define KIND_INTEGER 1  /* Small integers, many zeros. */
+#define KIND_DOUBLE 2   /* Close to a double root. */
+#define KIND_EXPONENT 3 /* Exponents from -600 to 600. */
+#define KIND_SPECIAL 4  /* Infinities, NaN, zeros, huge and tiny values. */
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, classifies the equations in the
+ * given precision mode and compares the results with
+ * solve_equation_prec. In case of an error, it returns 1.
+ */
+static int check(int test_num, int prec);
+
+/* A structure that describes a test. */
+typedef struct {
+  int kind;             /* The kind of the equations. */
+  size_t size;          /* The number of equations. */
+  unsigned int classes; /* The classes selected. */
+  char *name;           /* Name of the test. */
+  char *test_id;        /* The test ID is needed to select a structure. */
+} test_param;
+
+/* An array of test_param type structures. */
+test_param test_param_arr[] = {
+    {.kind = KIND_UNIFORM,
+     .size = 100003,
+     .classes = QE_CLASS(QE_OK_TWO_RES),
+     .name = "Uniform parameters, the equations with two roots.",
+     .test_id = "classify1"},
+
+    {.kind = KIND_INTEGER,
+     .size = 50000,
+     .classes = QE_CLASS(QE_OK_ONE_RES) | QE_CLASS(QE_OK_INF_RES) |
+                QE_CLASS(QE_OK_NO_RES),
+     .name = "Small integers, linear and degenerate equations.",
+     .test_id = "classify2"},
+
+    {.kind = KIND_DOUBLE,
+     .size = 100001,
+     .classes = QE_CLASS(QE_OK_ONE_RES),
+     .name = "Near a double root, the exact sign of the discriminant.",
+     .test_id = "classify3"},
+
+    {.kind = KIND_EXPONENT,
+     .size = 60000,
+     .classes = QE_CLASS(QE_OK_NO_RES) | QE_CLASS(QE_OK_TWO_RES),
+     .name = "Huge and tiny parameters.",
+     .test_id = "classify4"},
+
+    {.kind = KIND_SPECIAL,
+     .size = 20000,
+     .classes = QE_CLASS(QE_ERR_OVERFLOW) | QE_CLASS(QE_OK_INF_RES),
+     .name = "Infinite and NaN parameters.",
+     .test_id = "classify5"},
+
+    {.kind = KIND_UNIFORM,
+     .size = 13,
+     .classes = QE_CLASS(QE_OK_NO_RES),
+     .name = "A batch shorter than a vector of every instruction set.",
+     .test_id = "classify6"}};
+
+/*
+ * The main function receives one parameter as input.
+ * It is needed to compare with test_id and select
+ * the desired test.
+ */
+int main(int argc, char *argv[]) {
+
+  /*
+   * The value returned by the main function. In case of a
+   * failed test, the unchanged value of 1 will be returned.
+   */
+  int res = 1;
+
+  /* The number of elements in the test_param_arr array. */
+  int size = sizeof(test_param_arr) / sizeof(test_param_arr[0]);
+
+  /* Checking for the number of passed parameters in main. */
+  if (argc != 2) {
+    printf("[ERROR]: The wrong number of arguments was passed.\n");
+    exit(res);
+  }
+
+  if (strcmp(argv[1], "classify0") == 0) {
+    double x = 1;
+    size_t idx, count;
+    int msg_id;
+
+    printf("TEST_CLASSIFY (Null pointers): ");
+    if ((classify_equation_batch(&x, NULL, &x, &msg_id, 1,
+                                 QE_PREC_EXTENDED) == QE_ERR_NULLPTR) &&
+        (classify_equation_batch(&x, &x, &x, NULL, 1, QE_PREC_DOUBLE) ==
+         QE_ERR_NULLPTR) &&
+        (classify_equation_select(&x, &x, &x, ~0u, NULL, &count, 1,
+                                  QE_PREC_EXTENDED) == QE_ERR_NULLPTR) &&
+        (classify_equation_select(NULL, &x, &x, ~0u, &idx, &count, 1,
+                                  QE_PREC_DOUBLE) == QE_ERR_NULLPTR) &&
+        (classify_equation_select(&x, &x, &x, ~0u, &idx, NULL, 1,
+                                  QE_PREC_DOUBLE) == QE_ERR_NULLPTR)) {
+      printf("[OK].\n");
+      res = 0;
+    } else
+      printf("[ERROR]: QE_ERR_NULLPTR was expected.\n");
+  }
+
+  /*
+   * Search for the desired structure by the test_id
+   * parameter received by the main function.
+   */
+  for (int i = 0; i < size; i++)
+    if (strcmp(argv[1], test_param_arr[i].test_id) == 0)
+      res = check(i, QE_PREC_EXTENDED) | check(i, QE_PREC_DOUBLE);
+
+  return res;
+}
+
+/* The function returns a random number from -1 to 1. */
+static double rand_unit(void) { return 2.0 * rand() / RAND_MAX - 1.0; }
+
+/* The function generates the i-th equation of the kind. */
+static void generate(int kind, size_t i, double *a, double *b, double *c) {
+  static const double special[] = {0,       -0.0,   INFINITY, -INFINITY,
+                                   NAN,     1e300,  -1e300,   1e-300,
+                                   DBL_MAX, DBL_MIN, 0x1p-1074, 1.5};
+  const size_t nspecial = sizeof(special) / sizeof(special[0]);
+  double r, s;
+
+  switch (kind) {
+  case KIND_UNIFORM:
+    *a = rand_unit();
+    *b = rand_unit();
+    *c = rand_unit();
+    break;
+  case KIND_INTEGER:
+    *a = rand() % 5 - 2;
+    *b = rand() % 5 - 2;
+    *c = rand() % 5 - 2;
+    break;
+  case KIND_DOUBLE:
+    /* a * (x - r)^2 with c moved by a few units in the last place. */
+    r = rand_unit();
+    *a = rand_unit();
+    *b = -2.0 * *a * r;
+    s = *a * r * r;
+    *c = s + (double)(rand() % 5 - 2) * ldexp(fabs(s), -52 - rand() % 12);
+    break;
+  case KIND_EXPONENT:
+    *a = ldexp(rand_unit(), rand() % 1201 - 600);
+    *b = ldexp(rand_unit(), rand() % 1201 - 600);
+    *c = ldexp(rand_unit(), rand() % 1201 - 600);
+    break;
+  default:
+    *a = (i % 3 == 0) ? special[rand() % nspecial] : rand_unit();
+    *b = (i % 3 == 1) ? special[rand() % nspecial] : rand_unit();
+    *c = special[rand() % nspecial];
+  }
+}
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, classifies the equations in the
+ * given precision mode and compares the results with
+ * solve_equation_prec. In case of an error, it returns 1.
+ */
+static int check(int test_num, int prec) {
+  test_param *t = &test_param_arr[test_num];
+  double *a, *b, *c;
+  int *true_msg_id, *msg_id, res = 0;
+  size_t *idx;
+
+  printf("TEST_CLASSIFY_%d (%s, %s): ", test_num, t->name,
+         (prec == QE_PREC_DOUBLE) ? "double" : "extended");
+
+  a = malloc(t->size * sizeof(double));
+  b = malloc(t->size * sizeof(double));
+  c = malloc(t->size * sizeof(double));
+  true_msg_id = malloc(t->size * sizeof(int));
+  msg_id = malloc(t->size * sizeof(int));
+  idx = malloc(t->size * sizeof(size_t));
+  if (!a || !b || !c || !true_msg_id || !msg_id || !idx) {
+    printf("[ERROR]: Out of memory.\n");
+    exit(1);
+  }
+
+  srand(test_num);
+  for (size_t i = 0; i < t->size; i++)
+    generate(t->kind, i, &a[i], &b[i], &c[i]);
+
+  for (size_t i = 0; (i < t->size) && !res; i++) {
+    double res1, res2;
+    int solved = solve_equation_prec(a[i], b[i], c[i], &res1, &res2, prec);
+    int m = classify_equation(a[i], b[i], c[i], prec);
+    int finite = isfinite(a[i]) && isfinite(b[i]) && isfinite(c[i]);
+
+    /* The roots are not computed, so they do not overflow. */
+    if ((m != solved) &&
+        !((solved == QE_ERR_OVERFLOW) &&
+          ((m == QE_OK_TWO_RES) || (m == QE_OK_ONE_RES)) &&
+          ((prec == QE_PREC_EXTENDED) || finite))) {
+      printf("[ERROR]:\n");
+      printf("\tParameters passed: a = %A   b = %A   c = %A\n", a[i], b[i],
+             c[i]);
+      printf("\tReceived msg[%d], solve_equation_prec gives msg[%d]\n", m,
+             solved);
+      res = 1;
+    }
+    true_msg_id[i] = m;
+  }
+
+  /*
+   * Every instruction set is checked. If the processor does
+   * not support one, the previous one is checked again.
+   */
+  for (int isa = QE_ISA_GENERIC; (isa <= QE_ISA_AVX512) && !res; isa++) {
+    size_t count = t->size + 1, k = 0;
+
+    qe_batch_set_isa(isa);
+    memset(msg_id, 0x55, t->size * sizeof(int));
+    classify_equation_batch(a, b, c, msg_id, t->size, prec);
+    for (size_t i = 0; (i < t->size) && !res; i++)
+      if (msg_id[i] != true_msg_id[i]) {
+        printf("[ERROR]:\n");
+        printf("\tInstruction set %d, equation %zu: a = %A   b = %A   "
+               "c = %A\n",
+               isa, i, a[i], b[i], c[i]);
+        printf("\tReceived msg[%d], expected msg[%d]\n", msg_id[i],
+               true_msg_id[i]);
+        res = 1;
+      }
+
+    classify_equation_select(a, b, c, t->classes, idx, &count, t->size,
+                             prec);
+    for (size_t i = 0; (i < t->size) && !res; i++)
+      if (t->classes & QE_CLASS(true_msg_id[i]))
+        if ((k >= count) || (idx[k++] != i)) {
+          printf("[ERROR]: Instruction set %d, the equation %zu was not "
+                 "selected.\n",
+                 isa, i);
+          res = 1;
+        }
+    if (!res && (k != count)) {
+      printf("[ERROR]: Instruction set %d, %zu equations selected, %zu "
+             "expected.\n",
+             isa, count, k);
+      res = 1;
+    }
+  }
+
+  free(a);
+  free(b);
+  free(c);
+  free(true_msg_id);
+  free(msg_id);
+  free(idx);
+
+  if (!res)
+    printf("[OK].\n");
+  return res;
+}
@@ -0,0 +1,363 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the tests for the
+ * columnar files of equations (qe_col).
+ *
+ * The test "col0" checks the passing of null pointers, a
+ * missing file, a file that is not columnar and the solving of
+ * a read-only file. The tests "col6" and "col7" write damaged
+ * files to the current directory (a file marked solved without
+ * the result columns, a solved file with a wrong msg_id), which
+ * qe_solve must reject. The other tests write random equations to a
+ * file in /tmp by parts of different sizes, check that the
+ * columns read from the mapping are the same, solve the file in
+ * place and check that the stored results are bit-identical to
+ * the results of solve_equation_batch_prec.
+ *
+-------------------------------------------------------------*/
+
+#include "qe_col.h"
+#include "qe_pool.h"
+#include "quadratic_equation.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, writes, reads and solves the
+ * file and compares the results. In case of an error, it
+ * returns 1.
+ */
+static int check(int test_num);
+
+/* The function checks the wrong arguments and files. */
+static int check_errors(void);
+
+/*
+ * The function writes a damaged file (col6 or col7) and checks
+ * that it is rejected or at least opened safely.
+ */
+static int check_damaged(int solved_only);
+
+/* A structure that describes a test: the file and its writing. */
+typedef struct {
+  size_t n;      /* Rows of the file. */
+  size_t part;   /* Rows passed to one qe_col_writer_append. */
+  int flags;     /* QE_COL_RESULTS or 0. */
+  int prec;      /* Precision mode. */
+  int nthreads;  /* Threads of the pool of qe_col_solve, 0 for none. */
+  char *name;    /* Name of the test. */
+  char *test_id; /* The test ID is needed to select a structure. */
+} test_param;
+
+/* An array of test_param type structures. */
+test_param test_param_arr[] = {
+    {.n = 0,
+     .part = 1,
+     .flags = QE_COL_RESULTS,
+     .prec = QE_PREC_EXTENDED,
+     .nthreads = 0,
+     .name = "An empty file.",
+     .test_id = "col1"},
+
+    {.n = 1000,
+     .part = 7,
+     .flags = QE_COL_RESULTS,
+     .prec = QE_PREC_DOUBLE,
+     .nthreads = 0,
+     .name = "One short group written by small parts.",
+     .test_id = "col2"},
+
+    {.n = QE_COL_GROUP,
+     .part = QE_COL_GROUP,
+     .flags = QE_COL_RESULTS,
+     .prec = QE_PREC_EXTENDED,
+     .nthreads = 0,
+     .name = "One full group.",
+     .test_id = "col3"},
+
+    {.n = 200003,
+     .part = 50000,
+     .flags = QE_COL_RESULTS,
+     .prec = QE_PREC_EXTENDED,
+     .nthreads = 2,
+     .name = "Several groups solved by a pool.",
+     .test_id = "col4"},
+
+    {.n = 70000,
+     .part = 70000,
+     .flags = 0,
+     .prec = QE_PREC_DOUBLE,
+     .nthreads = 0,
+     .name = "A file without the result columns.",
+     .test_id = "col5"}};
+
+/* The file of the test. */
+static char file_path[64];
+
+/*
+ * The main function receives one parameter as input.
+ * It is needed to compare with test_id and select
+ * the desired test.
+ */
+int main(int argc, char *argv[]) {
+
+  /*
+   * The value returned by the main function. In case of a
+   * failed test, the unchanged value of 1 will be returned.
+   */
+  int res = 1;
+
+  /* The number of elements in the test_param_arr array. */
+  int size = sizeof(test_param_arr) / sizeof(test_param_arr[0]);
+
+  /* Checking for the number of passed parameters in main. */
+  if (argc != 2) {
+    printf("[ERROR]: The wrong number of arguments was passed.\n");
+    exit(res);
+  }
+
+  snprintf(file_path, sizeof(file_path), "/tmp/qe_col_test_%d.qec",
+           (int)getpid());
+
+  if (strcmp(argv[1], "col0") == 0)
+    res = check_errors();
+  if (strcmp(argv[1], "col6") == 0)
+    res = check_damaged(1);
+  if (strcmp(argv[1], "col7") == 0)
+    res = check_damaged(0);
+
+  /*
+   * Search for the desired structure by the test_id
+   * parameter received by the main function.
+   */
+  for (int i = 0; i < size; i++)
+    if (strcmp(argv[1], test_param_arr[i].test_id) == 0)
+      res = check(i);
+
+  unlink(file_path);
+  return res;
+}
+
+/* The function checks the wrong arguments and files. */
+static int check_errors(void) {
+  double x = 1;
+  qe_col_writer *w;
+  qe_col_file *f;
+  qe_col_chunk ch;
+  FILE *text;
+  int ok;
+
+  printf("TEST_COL (Null pointers, wrong files, a read-only file): ");
+
+  ok = (qe_col_writer_create(NULL, 0) == NULL) &&
+       (qe_col_writer_append(NULL, &x, &x, &x, 1) == -1) &&
+       (qe_col_writer_close(NULL) == -1) && (qe_col_open(NULL, 0) == NULL) &&
+       (qe_col_open("/tmp/qe_col_test_missing.qec", 0) == NULL) &&
+       (qe_col_solve(NULL, NULL, QE_PREC_EXTENDED) == -1) &&
+       (qe_col_get_group(NULL, 0, &ch) == -1);
+
+  /* A text file of more than a page is not columnar. */
+  text = fopen(file_path, "w");
+  for (int i = 0; i < 1000; i++)
+    fprintf(text, "1,-3,2\n");
+  fclose(text);
+  ok = ok && (qe_col_open(file_path, 0) == NULL);
+
+  /* A read-only file is not solved, there is no second group. */
+  w = qe_col_writer_create(file_path, QE_COL_RESULTS);
+  ok = ok && (w != NULL) && (qe_col_writer_append(w, &x, &x, &x, 1) == 0) &&
+       (qe_col_writer_close(w) == 0);
+  f = qe_col_open(file_path, 0);
+  ok = ok && (f != NULL) && (qe_col_solve(f, NULL, QE_PREC_EXTENDED) == -1) &&
+       (qe_col_get_group(f, 0, &ch) == 0) && (ch.n == 1) && (ch.a[0] == 1) &&
+       (qe_col_get_group(f, 1, &ch) == -1);
+  qe_col_close(f);
+
+  if (ok)
+    printf("[OK].\n");
+  else
+    printf("[ERROR]: NULL and -1 were expected.\n");
+  return !ok;
+}
+
+/*
+ * The function writes a damaged file (col6 or col7) and checks
+ * that it is rejected or at least opened safely.
+ */
+static int check_damaged(int solved_only) {
+  const char *path = solved_only ? "col_solved_only.qec" : "col_bad_msg.qec";
+  double x[3] = {1, -3, 2};
+  qe_col_writer *w;
+  qe_col_file *f;
+  qe_col_chunk ch;
+  int ok;
+
+  printf("TEST_COL_%d (%s): ", solved_only ? 6 : 7,
+         solved_only ? "A solved file without the result columns."
+                     : "A solved file with a wrong msg_id.");
+
+  w = qe_col_writer_create(path, solved_only ? 0 : QE_COL_RESULTS);
+  ok = (w != NULL) && (qe_col_writer_append(w, x, x + 1, x + 2, 3) == 0) &&
+       (qe_col_writer_close(w) == 0);
+
+  if (ok && solved_only) {
+    /* The flags of the header are changed to QE_COL_SOLVED alone. */
+    FILE *file = fopen(path, "r+b");
+    uint32_t flags = QE_COL_SOLVED;
+
+    ok = (file != NULL) &&
+         (fseek(file, offsetof(qe_col_header, flags), SEEK_SET) == 0) &&
+         (fwrite(&flags, sizeof(flags), 1, file) == 1);
+    if (file != NULL)
+      ok = (fclose(file) == 0) && ok;
+    ok = ok && (qe_col_open(path, 0) == NULL);
+  } else if (ok) {
+    /* The file is solved, then a msg_id is overwritten. */
+    f = qe_col_open(path, 1);
+    ok = (f != NULL) && (qe_col_solve(f, NULL, QE_PREC_EXTENDED) == 0) &&
+         (qe_col_get_group(f, 0, &ch) == 0);
+    if (ok)
+      ch.msg_id[1] = 100000000;
+    qe_col_close(f);
+  }
+
+  if (ok)
+    printf("[OK].\n");
+  else
+    printf("[ERROR]: The damaged file was not written or not rejected.\n");
+  return !ok;
+}
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, writes, reads and solves the
+ * file and compares the results. In case of an error, it
+ * returns 1.
+ */
+static int check(int test_num) {
+  test_param *t = &test_param_arr[test_num];
+  double *a, *b, *c, *true_res1, *true_res2;
+  int *true_msg_id;
+  const qe_col_header *hdr;
+  qe_col_writer *w;
+  qe_col_file *f;
+  qe_pool *pool = NULL;
+  size_t row = 0;
+  int res = 0, expected;
+
+  printf("TEST_COL_%d (%s): ", test_num, t->name);
+
+  a = malloc((t->n + 1) * sizeof(double));
+  b = malloc((t->n + 1) * sizeof(double));
+  c = malloc((t->n + 1) * sizeof(double));
+  true_res1 = malloc((t->n + 1) * sizeof(double));
+  true_res2 = malloc((t->n + 1) * sizeof(double));
+  true_msg_id = malloc((t->n + 1) * sizeof(int));
+  if (!a || !b || !c || !true_res1 || !true_res2 || !true_msg_id) {
+    printf("[ERROR]: Out of memory.\n");
+    exit(1);
+  }
+
+  /* Random parameters from -1 to 1, every tenth `a` is zero. */
+  for (size_t i = 0; i < t->n; i++) {
+    a[i] = (i % 10 == 0) ? 0 : 2.0 * rand() / RAND_MAX - 1.0;
+    b[i] = 2.0 * rand() / RAND_MAX - 1.0;
+    c[i] = 2.0 * rand() / RAND_MAX - 1.0;
+  }
+  solve_equation_batch_prec(a, b, c, true_res1, true_res2, true_msg_id, t->n,
+                            t->prec);
+
+  w = qe_col_writer_create(file_path, t->flags);
+  for (size_t i = 0; (w != NULL) && (i < t->n); i += t->part) {
+    size_t m = (t->n - i < t->part) ? t->n - i : t->part;
+
+    if (qe_col_writer_append(w, a + i, b + i, c + i, m) != 0)
+      res = 1;
+  }
+  if ((w == NULL) || (qe_col_writer_close(w) != 0) || res) {
+    printf("[ERROR]: The file was not written.\n");
+    exit(1);
+  }
+
+  /* The columns and the header of the written file. */
+  f = qe_col_open(file_path, 1);
+  hdr = qe_col_get_header(f);
+  if ((f == NULL) || (hdr->n != t->n) || (hdr->flags != (uint32_t)t->flags)) {
+    printf("[ERROR]: A wrong header.\n");
+    exit(1);
+  }
+  for (size_t g = 0; g < qe_col_groups(f); g++) {
+    qe_col_chunk ch;
+
+    qe_col_get_group(f, g, &ch);
+    if ((memcmp(ch.a, a + row, ch.n * sizeof(double)) != 0) ||
+        (memcmp(ch.b, b + row, ch.n * sizeof(double)) != 0) ||
+        (memcmp(ch.c, c + row, ch.n * sizeof(double)) != 0)) {
+      printf("[ERROR]: The group %zu differs from the written rows.\n", g);
+      res = 1;
+    }
+    qe_col_release_group(f, g);
+    row += ch.n;
+  }
+  if (row != t->n) {
+    printf("[ERROR]: The groups have %zu rows.\n", row);
+    res = 1;
+  }
+
+  if (t->nthreads > 0)
+    pool = qe_pool_create(t->nthreads, 0);
+  expected = (t->flags & QE_COL_RESULTS) ? 0 : -1;
+  if (!res && (qe_col_solve(f, pool, t->prec) != expected)) {
+    printf("[ERROR]: A wrong result of qe_col_solve.\n");
+    res = 1;
+  }
+  qe_col_close(f);
+  if (pool != NULL)
+    qe_pool_destroy(pool);
+
+  /* The stored results, read from a new mapping. */
+  f = qe_col_open(file_path, 0);
+  hdr = qe_col_get_header(f);
+  if (!res && (t->flags & QE_COL_RESULTS) &&
+      (!(hdr->flags & QE_COL_SOLVED) || (hdr->prec != t->prec))) {
+    printf("[ERROR]: The header of the solved file is wrong.\n");
+    res = 1;
+  }
+
+  row = 0;
+  for (size_t g = 0; (g < qe_col_groups(f)) && !res; g++) {
+    qe_col_chunk ch;
+
+    qe_col_get_group(f, g, &ch);
+    for (size_t i = 0; (i < ch.n) && (ch.res1 != NULL) && !res; i++, row++)
+      if ((ch.msg_id[i] != true_msg_id[row]) ||
+          (memcmp(&ch.res1[i], &true_res1[row], sizeof(double)) != 0) ||
+          (memcmp(&ch.res2[i], &true_res2[row], sizeof(double)) != 0)) {
+        printf("[ERROR]:\n");
+        printf("\tRow %zu: a = %A   b = %A   c = %A\n", row, a[row], b[row],
+               c[row]);
+        printf("\tReceived answer: res1 = %A   res2 = %A   msg[%d]\n",
+               ch.res1[i], ch.res2[i], ch.msg_id[i]);
+        printf("\tExpected answer: res1 = %A   res2 = %A   msg[%d]\n",
+               true_res1[row], true_res2[row], true_msg_id[row]);
+        res = 1;
+      }
+  }
+  qe_col_close(f);
+
+  free(a);
+  free(b);
+  free(c);
+  free(true_res1);
+  free(true_res2);
+  free(true_msg_id);
+
+  if (!res)
+    printf("[OK].\n");
+  return res;
+}
@@ -0,0 +1,421 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the tests for
+ * the solve_equation_complex and solve_equation_batch_complex
+ * functions.
+ *
+ * The tests "cplx1" - "cplx10", "cplx17" and "cplx18" solve the
+ * equations with known roots in the given precision mode. The
+ * other tests fill the arrays of parameters with a generator,
+ * solve them with every instruction set and check that the
+ * results are bit-identical to the results of
+ * solve_equation_complex. The test "cplx0" checks the passing of
+ * null pointers.
+ *
+-------------------------------------------------------------*/
+
+#include "quadratic_equation.h"
+#include "test_gen.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The maximum relative difference of a part of a root
+ * from the expected value (a few units in the last place).
+ */
+#define CPLX_ACCUR 1e-15
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input and compares the expected values
+ * with those obtained from solve_equation_complex.
+ * In case of an error, it returns 1.
+ */
+static int check(int test_num);
+
+/*
+ * The function solves the generated batch with every instruction
+ * set and compares the results with solve_equation_complex.
+ * In case of an error, it returns 1.
+ */
+static int check_batch(int test_num);
+
+/*
+ * The function checks that the value differs from the
+ * expected one by no more than CPLX_ACCUR.
+ */
+static int check_value(double res, double true_res);
+
+/*
+ * The generator of the parameters with its own range of the
+ * exponents, the other generators are in test_gen.c.
+ */
+static void select_scaled(size_t i, double *a, double *b, double *c);
+
+/*
+ * A structure that describes a test. The tests with the
+ * generator of parameters compare the batch results, the other
+ * ones compare the results with the expected values.
+ */
+typedef struct {
+  double a;    /* Transmitted parameter. */
+  double b;    /* Transmitted parameter. */
+  double c;    /* Transmitted parameter. */
+  double res1; /* Expected response. */
+  double res2; /* Expected response. */
+  double im;   /* Expected response. */
+  int msg_id;  /* Expected response. */
+  int prec;    /* Precision mode. */
+  void (*select)(size_t i, double *a, double *b, double *c); /* Generator. */
+  size_t size;   /* The number of equations. */
+  char *name;    /* Name of the test. */
+  char *test_id; /* The test ID is needed to select a structure. */
+} test_param;
+
+/* An array of test_param type structures. */
+test_param test_param_arr[] = {
+    {.a = 1,
+     .b = 0,
+     .c = 1,
+     .res1 = 0,
+     .res2 = 0,
+     .im = 1,
+     .msg_id = QE_OK_CPLX_RES,
+     .prec = QE_PREC_EXTENDED,
+     .name = "The roots +i and -i.",
+     .test_id = "cplx1"},
+
+    {.a = 1,
+     .b = 2,
+     .c = 5,
+     .res1 = -1,
+     .res2 = -1,
+     .im = 2,
+     .msg_id = QE_OK_CPLX_RES,
+     .prec = QE_PREC_DOUBLE,
+     .name = "The roots -1 + 2i and -1 - 2i, double mode.",
+     .test_id = "cplx2"},
+
+    {.a = -2,
+     .b = 4,
+     .c = -10,
+     .res1 = 1,
+     .res2 = 1,
+     .im = 2,
+     .msg_id = QE_OK_CPLX_RES,
+     .prec = QE_PREC_EXTENDED,
+     .name = "Negative `a`, the imaginary part is positive.",
+     .test_id = "cplx3"},
+
+    {.a = 1,
+     .b = -3,
+     .c = 2,
+     .res1 = 2,
+     .res2 = 1,
+     .im = 0,
+     .msg_id = QE_OK_TWO_RES,
+     .prec = QE_PREC_EXTENDED,
+     .name = "Real roots, the imaginary part is zero.",
+     .test_id = "cplx4"},
+
+    {.a = 0,
+     .b = 0,
+     .c = 1,
+     .res1 = QE_STD_VAL_RES,
+     .res2 = QE_STD_VAL_RES,
+     .im = 0,
+     .msg_id = QE_OK_NO_RES,
+     .prec = QE_PREC_DOUBLE,
+     .name = "Only `c` is not zero, there are no roots.",
+     .test_id = "cplx5"},
+
+    {.a = 1e300,
+     .b = 0,
+     .c = 1e300,
+     .res1 = 0,
+     .res2 = 0,
+     .im = 1,
+     .msg_id = QE_OK_CPLX_RES,
+     .prec = QE_PREC_EXTENDED,
+     .name = "Huge parameters, the equation is scaled.",
+     .test_id = "cplx6"},
+
+    {.a = 1e-300,
+     .b = 0,
+     .c = 1e300,
+     .res1 = 0,
+     .res2 = 0,
+     .im = 1e300,
+     .msg_id = QE_OK_CPLX_RES,
+     .prec = QE_PREC_DOUBLE,
+     .name = "Tiny `a`, huge imaginary part.",
+     .test_id = "cplx7"},
+
+    {.a = 1e-300,
+     .b = 1e10,
+     .c = 1e300,
+     .res1 = QE_STD_VAL_RES,
+     .res2 = QE_STD_VAL_RES,
+     .im = QE_STD_VAL_RES,
+     .msg_id = QE_ERR_OVERFLOW,
+     .prec = QE_PREC_DOUBLE,
+     .name = "The real part is outside the double range.",
+     .test_id = "cplx8"},
+
+    {.a = NAN,
+     .b = 1,
+     .c = 1,
+     .res1 = QE_STD_VAL_RES,
+     .res2 = QE_STD_VAL_RES,
+     .im = 0,
+     .msg_id = QE_OK_NO_RES,
+     .prec = QE_PREC_EXTENDED,
+     .name = "A NaN parameter, as in solve_equation.",
+     .test_id = "cplx9"},
+
+    {.a = INFINITY,
+     .b = 1,
+     .c = 1,
+     .res1 = QE_STD_VAL_RES,
+     .res2 = QE_STD_VAL_RES,
+     .im = 0,
+     .msg_id = QE_ERR_OVERFLOW,
+     .prec = QE_PREC_DOUBLE,
+     .name = "An infinite parameter, as in solve_equation_prec.",
+     .test_id = "cplx10"},
+
+    {.select = gen_uniform,
+     .prec = QE_PREC_EXTENDED,
+     .size = 100003,
+     .name = "Batch: random parameters from -1 to 1.",
+     .test_id = "cplx11"},
+
+    {.select = gen_uniform,
+     .prec = QE_PREC_DOUBLE,
+     .size = 100003,
+     .name = "Batch: random parameters from -1 to 1, double mode.",
+     .test_id = "cplx12"},
+
+    {.select = gen_bits,
+     .prec = QE_PREC_EXTENDED,
+     .size = 100003,
+     .name = "Batch: random bit patterns (any exponent, infinities, NaN).",
+     .test_id = "cplx13"},
+
+    {.select = select_scaled,
+     .prec = QE_PREC_DOUBLE,
+     .size = 100003,
+     .name = "Batch: random parameters from 2^-600 to 2^600, double mode.",
+     .test_id = "cplx14"},
+
+    {.select = select_scaled,
+     .prec = QE_PREC_EXTENDED,
+     .size = 100003,
+     .name = "Batch: random parameters from 2^-600 to 2^600.",
+     .test_id = "cplx15"},
+
+    {.select = gen_uniform,
+     .prec = QE_PREC_EXTENDED,
+     .size = 7,
+     .name = "Batch: a batch shorter than any vector.",
+     .test_id = "cplx16"},
+
+    {.a = 0x1.78e753d10e54ap+443,
+     .b = -0x1.123845b725e9ap-436,
+     .c = 0x1.defbe0a4545a8p+1018,
+     .res1 = 0x1.7482adfdc55e5p-881,
+     .res2 = 0x1.7482adfdc55e5p-881,
+     .im = 0x1.9821b31cc748bp+287,
+     .msg_id = QE_OK_CPLX_RES,
+     .prec = QE_PREC_DOUBLE,
+     .name = "A tiny `b` in a scaled equation, double mode.",
+     .test_id = "cplx17"},
+
+    {.a = 0x1.78e753d10e54ap+443,
+     .b = -0x1.123845b725e9ap-436,
+     .c = 0x1.defbe0a4545a8p+1018,
+     .res1 = 0x1.7482adfdc55e5p-881,
+     .res2 = 0x1.7482adfdc55e5p-881,
+     .im = 0x1.9821b31cc748bp+287,
+     .msg_id = QE_OK_CPLX_RES,
+     .prec = QE_PREC_EXTENDED,
+     .name = "A tiny `b` in a scaled equation.",
+     .test_id = "cplx18"}};
+
+/*
+ * The main function receives one parameter as input.
+ * It is needed to compare with test_id and select
+ * the desired test.
+ */
+int main(int argc, char *argv[]) {
+
+  /*
+   * The value returned by the main function. In case of a
+   * failed test, the unchanged value of 1 will be returned.
+   */
+  int res = 1;
+
+  /* The number of elements in the test_param_arr array. */
+  int size = sizeof(test_param_arr) / sizeof(test_param_arr[0]);
+
+  /* Checking for the number of passed parameters in main. */
+  if (argc != 2) {
+    printf("[ERROR]: The wrong number of arguments was passed.\n");
+    exit(res);
+  }
+
+  if (strcmp(argv[1], "cplx0") == 0) {
+    double x = 0;
+    int msg_id;
+
+    printf("TEST_CPLX (Null pointers): ");
+    if ((solve_equation_complex(1, 0, 1, &x, &x, NULL, QE_PREC_DOUBLE) ==
+         QE_ERR_NULLPTR) &&
+        (solve_equation_batch_complex(&x, &x, &x, &x, &x, NULL, &msg_id, 1,
+                                      QE_PREC_EXTENDED) == QE_ERR_NULLPTR)) {
+      printf("[OK].\n");
+      res = 0;
+    } else
+      printf("[ERROR]: QE_ERR_NULLPTR was expected.\n");
+  }
+
+  /*
+   * Search for the desired structure by the test_id
+   * parameter received by the main function.
+   */
+  for (int i = 0; i < size; i++)
+    if (strcmp(argv[1], test_param_arr[i].test_id) == 0)
+      res = (test_param_arr[i].select != NULL) ? check_batch(i) : check(i);
+
+  return res;
+}
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input and compares the expected values
+ * with those obtained from solve_equation_complex.
+ * In case of an error, it returns 1.
+ */
+static int check(int test_num) {
+  test_param *t = &test_param_arr[test_num];
+  double res1, res2, im;
+  int msg_id;
+
+  printf("TEST_CPLX_%d (%s): ", test_num, t->name);
+
+  msg_id = solve_equation_complex(t->a, t->b, t->c, &res1, &res2, &im, t->prec);
+
+  if ((msg_id == t->msg_id) && check_value(res1, t->res1) &&
+      check_value(res2, t->res2) && check_value(im, t->im)) {
+    printf("[OK].\n");
+    return 0;
+  }
+
+  printf("[ERROR]:\n");
+  printf("\tParameters passed: a = %.17g   b = %.17g   c = %.17g\n", t->a,
+         t->b, t->c);
+  printf("\tReceived answer: res1 = %.17g   res2 = %.17g   im = %.17g   "
+         "msg[%d]\n",
+         res1, res2, im, msg_id);
+  printf("\tExpected answer: res1 = %.17g   res2 = %.17g   im = %.17g   "
+         "msg[%d]\n",
+         t->res1, t->res2, t->im, t->msg_id);
+  return 1;
+}
+
+/*
+ * The function checks that the value differs from the
+ * expected one by no more than CPLX_ACCUR.
+ */
+static int check_value(double res, double true_res) {
+
+  if (true_res == 0)
+    return (res == 0) && !signbit(res);
+
+  return fabs(res - true_res) <= CPLX_ACCUR * fabs(true_res);
+}
+
+/*
+ * The function solves the generated batch with every instruction
+ * set and compares the results with solve_equation_complex.
+ * In case of an error, it returns 1.
+ */
+static int check_batch(int test_num) {
+  test_param *t = &test_param_arr[test_num];
+  size_t n = t->size;
+  double *a, *b, *c, *res1, *res2, *im;
+  int *msg_id;
+  int res = 0;
+
+  printf("TEST_CPLX_%d (%s): ", test_num, t->name);
+
+  a = malloc(n * sizeof(double));
+  b = malloc(n * sizeof(double));
+  c = malloc(n * sizeof(double));
+  res1 = malloc(n * sizeof(double));
+  res2 = malloc(n * sizeof(double));
+  im = malloc(n * sizeof(double));
+  msg_id = malloc(n * sizeof(int));
+  if (!a || !b || !c || !res1 || !res2 || !im || !msg_id) {
+    printf("[ERROR]: Out of memory.\n");
+    exit(1);
+  }
+
+  for (size_t i = 0; i < n; i++)
+    t->select(i, &a[i], &b[i], &c[i]);
+
+  for (int isa = QE_ISA_GENERIC; (isa <= QE_ISA_AVX512) && !res; isa++) {
+    int used = qe_batch_set_isa(isa);
+
+    solve_equation_batch_complex(a, b, c, res1, res2, im, msg_id, n, t->prec);
+
+    for (size_t i = 0; (i < n) && !res; i++) {
+      double true_res1, true_res2, true_im;
+      int true_msg_id;
+
+      true_msg_id = solve_equation_complex(a[i], b[i], c[i], &true_res1,
+                                           &true_res2, &true_im, t->prec);
+
+      if ((msg_id[i] != true_msg_id) ||
+          (memcmp(&res1[i], &true_res1, sizeof(double)) != 0) ||
+          (memcmp(&res2[i], &true_res2, sizeof(double)) != 0) ||
+          (memcmp(&im[i], &true_im, sizeof(double)) != 0)) {
+        printf("[ERROR]:\n");
+        printf("\tInstruction set: %s\n", qe_batch_isa_name(used));
+        printf("\tParameters passed: a = %A   b = %A   c = %A\n", a[i], b[i],
+               c[i]);
+        printf("\tReceived answer: res1 = %A   res2 = %A   im = %A   "
+               "msg[%d]\n",
+               res1[i], res2[i], im[i], msg_id[i]);
+        printf("\tExpected answer: res1 = %A   res2 = %A   im = %A   "
+               "msg[%d]\n",
+               true_res1, true_res2, true_im, true_msg_id);
+        res = 1;
+      }
+    }
+  }
+
+  free(a);
+  free(b);
+  free(c);
+  free(res1);
+  free(res2);
+  free(im);
+  free(msg_id);
+
+  if (!res)
+    printf("[OK].\n");
+  return res;
+}
+
+/*
+ * Random parameters with random exponents, both inside
+ * and outside the range solved without scaling.
+ */
+static void select_scaled(size_t i, double *a, double *b, double *c) {
+  gen_uniform(i, a, b, c);
+  gen_scale(a, b, c, 600);
+}
@@ -0,0 +1,343 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the tests for the
+ * float batch function (solve_equation_batch_float).
+ *
+ * Every test generates float equations of its kind and, in both
+ * precision modes and with every instruction set, checks that
+ * the msg_id is the one of solve_equation_prec (QE_ERR_OVERFLOW
+ * where a root is out of the range of normal floats) and that every
+ * root is within the tolerance of the reference root: the root of
+ * QE_PREC_DOUBLE, or the root of solve_equation where the two modes
+ * give different msg_id. With a zero tolerance all the equations
+ * with two roots are solved again, so the roots must be the
+ * reference roots rounded to float. The test "float0" checks the
+ * passing of null pointers.
+ *
+-------------------------------------------------------------*/
+
+#include "quadratic_equation.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The kinds of the generated equations. */
+#define KIND_UNIFORM 0  /* Parameters from -1 to 1. */
+#define KIND_INTEGER 1  /* Small integers, many zeros. */
+#define KIND_DOUBLE 2   /* Close to a double root. */
+#define KIND_EXPONENT 3 /* Exponents from -70 to 70. */
+#define KIND_SPECIAL 4  /* Infinities, NaN, zeros, huge and tiny values. */
+#define KIND_ILL 5      /* b * b >> |4 * a * c|, a tiny smaller root. */
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, solves the equations in the
+ * given precision mode and compares the results with
+ * solve_equation_prec. In case of an error, it returns 1.
+ */
+static int check(int test_num, int prec);
+
+/* A structure that describes a test. */
+typedef struct {
+  int kind;      /* The kind of the equations. */
+  size_t size;   /* The number of equations. */
+  float tol;     /* The tolerance of the roots. */
+  char *name;    /* Name of the test. */
+  char *test_id; /* The test ID is needed to select a structure. */
+} test_param;
+
+/* An array of test_param type structures. */
+test_param test_param_arr[] = {
+    {.kind = KIND_UNIFORM,
+     .size = 100003,
+     .tol = 1e-5f,
+     .name = "Uniform parameters.",
+     .test_id = "float1"},
+
+    {.kind = KIND_UNIFORM,
+     .size = 50000,
+     .tol = 0,
+     .name = "A zero tolerance, all the roots solved again.",
+     .test_id = "float2"},
+
+    {.kind = KIND_INTEGER,
+     .size = 50000,
+     .tol = 1e-4f,
+     .name = "Small integers, linear and degenerate equations.",
+     .test_id = "float3"},
+
+    {.kind = KIND_DOUBLE,
+     .size = 100001,
+     .tol = 1e-3f,
+     .name = "Near a double root.",
+     .test_id = "float4"},
+
+    {.kind = KIND_EXPONENT,
+     .size = 60000,
+     .tol = 1e-5f,
+     .name = "Huge and tiny parameters, roots out of the float range.",
+     .test_id = "float5"},
+
+    {.kind = KIND_SPECIAL,
+     .size = 20000,
+     .tol = 1e-5f,
+     .name = "Infinite and NaN parameters.",
+     .test_id = "float6"},
+
+    {.kind = KIND_UNIFORM,
+     .size = 13,
+     .tol = 1e-2f,
+     .name = "A batch shorter than a vector of every instruction set.",
+     .test_id = "float7"},
+
+    {.kind = KIND_ILL,
+     .size = 50000,
+     .tol = 0,
+     .name = "Ill-conditioned equations solved again.",
+     .test_id = "float8"}};
+
+/*
+ * The main function receives one parameter as input.
+ * It is needed to compare with test_id and select
+ * the desired test.
+ */
+int main(int argc, char *argv[]) {
+
+  /*
+   * The value returned by the main function. In case of a
+   * failed test, the unchanged value of 1 will be returned.
+   */
+  int res = 1;
+
+  /* The number of elements in the test_param_arr array. */
+  int size = sizeof(test_param_arr) / sizeof(test_param_arr[0]);
+
+  /* Checking for the number of passed parameters in main. */
+  if (argc != 2) {
+    printf("[ERROR]: The wrong number of arguments was passed.\n");
+    exit(res);
+  }
+
+  if (strcmp(argv[1], "float0") == 0) {
+    float x = 1, res1, res2;
+    size_t nescalated = 7;
+    int msg_id;
+
+    printf("TEST_FLOAT (Null pointers): ");
+    if ((solve_equation_batch_float(NULL, &x, &x, &res1, &res2, &msg_id, 1,
+                                    1e-5f, QE_PREC_DOUBLE,
+                                    NULL) == QE_ERR_NULLPTR) &&
+        (solve_equation_batch_float(&x, &x, &x, &res1, NULL, &msg_id, 1,
+                                    1e-5f, QE_PREC_EXTENDED,
+                                    NULL) == QE_ERR_NULLPTR) &&
+        (solve_equation_batch_float(&x, &x, &x, &res1, &res2, NULL, 1, 1e-5f,
+                                    QE_PREC_DOUBLE,
+                                    &nescalated) == QE_ERR_NULLPTR) &&
+        (nescalated == 7) &&
+        (solve_equation_batch_float(&x, &x, &x, &res1, &res2, &msg_id, 0,
+                                    1e-5f, QE_PREC_DOUBLE,
+                                    &nescalated) == QE_BATCH_OK) &&
+        (nescalated == 0)) {
+      printf("[OK].\n");
+      res = 0;
+    } else
+      printf("[ERROR]: QE_ERR_NULLPTR was expected.\n");
+  }
+
+  /*
+   * Search for the desired structure by the test_id
+   * parameter received by the main function.
+   */
+  for (int i = 0; i < size; i++)
+    if (strcmp(argv[1], test_param_arr[i].test_id) == 0)
+      res = check(i, QE_PREC_EXTENDED) | check(i, QE_PREC_DOUBLE);
+
+  return res;
+}
+
+/* The function returns a random number from -1 to 1. */
+static float rand_unit(void) { return 2.0f * rand() / RAND_MAX - 1.0f; }
+
+/* The function generates the i-th equation of the kind. */
+static void generate(int kind, size_t i, float *a, float *b, float *c) {
+  static const float special[] = {0,       -0.0f,   INFINITY, -INFINITY,
+                                  NAN,     1e30f,   -1e30f,   1e-30f,
+                                  FLT_MAX, FLT_MIN, 0x1p-149f, 1.5f};
+  const size_t nspecial = sizeof(special) / sizeof(special[0]);
+  float r, s;
+
+  switch (kind) {
+  case KIND_UNIFORM:
+    *a = rand_unit();
+    *b = rand_unit();
+    *c = rand_unit();
+    break;
+  case KIND_INTEGER:
+    *a = (float)(rand() % 5 - 2);
+    *b = (float)(rand() % 5 - 2);
+    *c = (float)(rand() % 5 - 2);
+    break;
+  case KIND_DOUBLE:
+    /* a * (x - r)^2 with c moved by a few units in the last place. */
+    r = rand_unit();
+    *a = rand_unit();
+    *b = -2.0f * *a * r;
+    s = *a * r * r;
+    *c = s + (float)(rand() % 5 - 2) * ldexpf(fabsf(s), -23 - rand() % 8);
+    break;
+  case KIND_EXPONENT:
+    *a = ldexpf(rand_unit(), rand() % 141 - 70);
+    *b = ldexpf(rand_unit(), rand() % 141 - 70);
+    *c = ldexpf(rand_unit(), rand() % 141 - 70);
+    break;
+  case KIND_ILL:
+    *a = ldexpf(rand_unit(), -(rand() % 20));
+    *b = ldexpf(rand_unit(), 20 + rand() % 30);
+    *c = ldexpf(rand_unit(), -(rand() % 20));
+    break;
+  default:
+    *a = (i % 3 == 0) ? special[rand() % nspecial] : rand_unit();
+    *b = (i % 3 == 1) ? special[rand() % nspecial] : rand_unit();
+    *c = special[rand() % nspecial];
+  }
+}
+
+/*
+ * The function checks the root x of a lane: it must be the reference
+ * root rounded to float, or lie within tol of it (both may be NaN in
+ * QE_PREC_EXTENDED mode).
+ */
+static int root_ok(float x, double root, float tol) {
+  double bound = fmax(tol, 0x1p-24) * (1 + 0x1p-20) * fabs(root);
+
+  return (x == (float)root) || (isnan(x) && isnan(root)) ||
+         (fabs(x - root) <= bound);
+}
+
+/* The function checks that the root is out of the range of floats. */
+static int out_of_range(double root) {
+  return (fabs(root) > FLT_MAX) || ((root != 0) && (fabs(root) < FLT_MIN));
+}
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, solves the equations in the
+ * given precision mode and compares the results with
+ * solve_equation_prec. In case of an error, it returns 1.
+ */
+static int check(int test_num, int prec) {
+  test_param *t = &test_param_arr[test_num];
+  float *a, *b, *c, *res1, *res2;
+  double *ref1, *ref2, *mode1, *mode2;
+  int *true_msg_id, *msg_id, res = 0;
+
+  printf("TEST_FLOAT_%d (%s, %s): ", test_num, t->name,
+         (prec == QE_PREC_DOUBLE) ? "double" : "extended");
+
+  a = malloc(t->size * sizeof(float));
+  b = malloc(t->size * sizeof(float));
+  c = malloc(t->size * sizeof(float));
+  res1 = malloc(t->size * sizeof(float));
+  res2 = malloc(t->size * sizeof(float));
+  ref1 = malloc(t->size * sizeof(double));
+  ref2 = malloc(t->size * sizeof(double));
+  mode1 = malloc(t->size * sizeof(double));
+  mode2 = malloc(t->size * sizeof(double));
+  true_msg_id = malloc(t->size * sizeof(int));
+  msg_id = malloc(t->size * sizeof(int));
+  if (!a || !b || !c || !res1 || !res2 || !ref1 || !ref2 || !mode1 ||
+      !mode2 || !true_msg_id || !msg_id) {
+    printf("[ERROR]: Out of memory.\n");
+    exit(1);
+  }
+
+  srand(test_num);
+  for (size_t i = 0; i < t->size; i++) {
+    int m, m_double;
+
+    generate(t->kind, i, &a[i], &b[i], &c[i]);
+    m_double =
+        solve_equation_prec(a[i], b[i], c[i], &ref1[i], &ref2[i],
+                            QE_PREC_DOUBLE);
+    m = solve_equation_prec(a[i], b[i], c[i], &mode1[i], &mode2[i], prec);
+
+    /* The roots of solve_equation where the modes disagree. */
+    if (m != m_double) {
+      ref1[i] = mode1[i];
+      ref2[i] = mode2[i];
+    }
+
+    /* The roots out of the range of normal floats. */
+    if (((m == QE_OK_TWO_RES) || (m == QE_OK_ONE_RES)) &&
+        (out_of_range(ref1[i]) || out_of_range(ref2[i]))) {
+      m = QE_ERR_OVERFLOW;
+      ref1[i] = ref2[i] = QE_STD_VAL_RES;
+    }
+    true_msg_id[i] = m;
+  }
+
+  /*
+   * Every instruction set is checked. If the processor does
+   * not support one, the previous one is checked again.
+   */
+  for (int isa = QE_ISA_GENERIC; (isa <= QE_ISA_AVX512) && !res; isa++) {
+    size_t nescalated = t->size + 1;
+
+    qe_batch_set_isa(isa);
+    memset(msg_id, 0x55, t->size * sizeof(int));
+    solve_equation_batch_float(a, b, c, res1, res2, msg_id, t->size, t->tol,
+                               prec, &nescalated);
+
+    for (size_t i = 0; (i < t->size) && !res; i++) {
+      int two = (msg_id[i] == QE_OK_TWO_RES) || (msg_id[i] == QE_OK_ONE_RES);
+
+      if ((msg_id[i] != true_msg_id[i]) ||
+          (two && !(root_ok(res1[i], ref1[i], t->tol) &&
+                    root_ok(res2[i], ref2[i], t->tol))) ||
+          (!two && ((res1[i] != QE_STD_VAL_RES) ||
+                    (res2[i] != QE_STD_VAL_RES))) ||
+          ((t->tol == 0) && ((res1[i] != (float)ref1[i]) ||
+                             (res2[i] != (float)ref2[i])) &&
+           !isnan(ref1[i]))) {
+        printf("[ERROR]:\n");
+        printf("\tInstruction set %d, equation %zu: a = %A   b = %A   "
+               "c = %A\n",
+               isa, i, a[i], b[i], c[i]);
+        printf("\tReceived msg[%d] res1[%A] res2[%A],\n\texpected msg[%d] "
+               "res1[%A] res2[%A]\n",
+               msg_id[i], res1[i], res2[i], true_msg_id[i], ref1[i],
+               ref2[i]);
+        res = 1;
+      }
+    }
+
+    /* Most of the uniform equations are solved in float, by every kernel. */
+    if (!res && ((nescalated > t->size) ||
+                 ((t->kind == KIND_UNIFORM) && (t->tol > 0) &&
+                  (nescalated > t->size / 50 + 1)))) {
+      printf("[ERROR]: Instruction set %d: %zu of %zu equations were "
+             "solved again.\n",
+             isa, nescalated, t->size);
+      res = 1;
+    }
+  }
+  qe_batch_set_isa(QE_ISA_AVX512);
+
+  free(a);
+  free(b);
+  free(c);
+  free(res1);
+  free(res2);
+  free(ref1);
+  free(ref2);
+  free(mode1);
+  free(mode2);
+  free(true_msg_id);
+  free(msg_id);
+
+  if (!res)
+    printf("[OK].\n");
+  return res;
+}
@@ -0,0 +1,426 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the tests for the
+ * qe_format_double function and the writer of results (qe_out).
+ *
+ * Each test of the formatting writes random numbers of its kind
+ * and checks that the text reads back by strtod as the same
+ * double, that no shorter number printed by printf("%.*e") reads
+ * back as it, and that for the same number of digits the digits
+ * are the ones of printf (the closest ones). The test "format0"
+ * checks the special values and the layout of the numbers.
+ *
+ * The tests of the writer write random results to a file in /tmp
+ * through several rounds of the buffers and compare the text or
+ * the binary rows read back.
+ *
+-------------------------------------------------------------*/
+
+#include "qe_out.h"
+#include "qe_text.h"
+#include "quadratic_equation.h"
+#include <fcntl.h>
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* The kinds of the formatted numbers. */
+#define KIND_BITS 0      /* Random bits, all the exponents. */
+#define KIND_UNIFORM 1   /* From -1 to 1, as the roots of the tests. */
+#define KIND_SHORT 2     /* Decimal numbers of 1 to 15 digits. */
+#define KIND_SUBNORMAL 3 /* Subnormal numbers. */
+#define KIND_INTEGER 4   /* Integers around 2^53 and powers of ten. */
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, formats random numbers of the
+ * kind and checks the texts. In case of an error, it returns 1.
+ */
+static int check(int test_num);
+
+/*
+ * The function writes random results by qe_out in the format and
+ * compares the file with the expected rows. In case of an error,
+ * it returns 1.
+ */
+static int check_writer(int test_num);
+
+/* A structure that describes a test. */
+typedef struct {
+  int kind;      /* The kind of the numbers, or the format of qe_out. */
+  size_t size;   /* The number of numbers or rows. */
+  int writer;    /* A test of qe_out. */
+  char *name;    /* Name of the test. */
+  char *test_id; /* The test ID is needed to select a structure. */
+} test_param;
+
+/* An array of test_param type structures. */
+test_param test_param_arr[] = {
+    {.kind = KIND_BITS,
+     .size = 300000,
+     .writer = 0,
+     .name = "Random bits.",
+     .test_id = "format1"},
+
+    {.kind = KIND_UNIFORM,
+     .size = 300000,
+     .writer = 0,
+     .name = "Uniform numbers from -1 to 1.",
+     .test_id = "format2"},
+
+    {.kind = KIND_SHORT,
+     .size = 300000,
+     .writer = 0,
+     .name = "Short decimal numbers.",
+     .test_id = "format3"},
+
+    {.kind = KIND_SUBNORMAL,
+     .size = 200000,
+     .writer = 0,
+     .name = "Subnormal numbers.",
+     .test_id = "format4"},
+
+    {.kind = KIND_INTEGER,
+     .size = 200000,
+     .writer = 0,
+     .name = "Integers and powers of ten.",
+     .test_id = "format5"},
+
+    {.kind = QE_OUT_TEXT,
+     .size = 300000,
+     .writer = 1,
+     .name = "The text rows of qe_out.",
+     .test_id = "format6"},
+
+    {.kind = QE_OUT_BINARY,
+     .size = 300001,
+     .writer = 1,
+     .name = "The binary rows of qe_out.",
+     .test_id = "format7"}};
+
+/* The file of the writer tests. */
+static char file_path[64];
+
+/*
+ * The main function receives one parameter as input.
+ * It is needed to compare with test_id and select
+ * the desired test.
+ */
+int main(int argc, char *argv[]) {
+
+  /*
+   * The value returned by the main function. In case of a
+   * failed test, the unchanged value of 1 will be returned.
+   */
+  int res = 1;
+
+  /* The number of elements in the test_param_arr array. */
+  int size = sizeof(test_param_arr) / sizeof(test_param_arr[0]);
+
+  /* Checking for the number of passed parameters in main. */
+  if (argc != 2) {
+    printf("[ERROR]: The wrong number of arguments was passed.\n");
+    exit(res);
+  }
+
+  if (strcmp(argv[1], "format0") == 0) {
+    static const struct {
+      double x;
+      const char *text;
+    } cases[] = {{0, "0"},
+                 {-0.0, "-0"},
+                 {1, "1"},
+                 {-2, "-2"},
+                 {0.1, "0.1"},
+                 {-0.5, "-0.5"},
+                 {1.5e-7, "1.5e-07"},
+                 {1e-4, "0.0001"},
+                 {1e-5, "1e-05"},
+                 {123.456, "123.456"},
+                 {1e16, "10000000000000000"},
+                 {1e17, "1e+17"},
+                 {1e23, "1e+23"},
+                 {9007199254740993.0, "9007199254740992"},
+                 {DBL_MAX, "1.7976931348623157e+308"},
+                 {DBL_MIN, "2.2250738585072014e-308"},
+                 {0x1p-1074, "5e-324"},
+                 {INFINITY, "inf"},
+                 {-INFINITY, "-inf"},
+                 {NAN, "nan"}};
+    char text[QE_TEXT_MAX_FORMAT + 1];
+
+    printf("TEST_FORMAT (Special values and the layout): ");
+    res = 0;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+      int len = qe_format_double(cases[i].x, text);
+
+      text[len] = '\0';
+      if (strcmp(text, cases[i].text) != 0) {
+        printf("[ERROR]: \"%s\" was expected, \"%s\" was received.\n",
+               cases[i].text, text);
+        res = 1;
+      }
+    }
+    if ((qe_out_create(1, 2) != NULL) || (qe_out_close(NULL) != -1)) {
+      printf("[ERROR]: NULL and -1 were expected.\n");
+      res = 1;
+    }
+    if (!res)
+      printf("[OK].\n");
+  }
+
+  snprintf(file_path, sizeof(file_path), "/tmp/qe_format_test_%d.out",
+           (int)getpid());
+
+  /*
+   * Search for the desired structure by the test_id
+   * parameter received by the main function.
+   */
+  for (int i = 0; i < size; i++)
+    if (strcmp(argv[1], test_param_arr[i].test_id) == 0)
+      res = test_param_arr[i].writer ? check_writer(i) : check(i);
+
+  return res;
+}
+
+/* The function returns 64 random bits. */
+static uint64_t random_u64(void) {
+  uint64_t r = 0;
+
+  for (int i = 0; i < 4; i++)
+    r = (r << 16) ^ (uint64_t)(rand() & 0xFFFF);
+  return r;
+}
+
+/* The function generates a number of the kind. */
+static double generate(int kind) {
+  uint64_t bits = random_u64();
+  double x;
+
+  switch (kind) {
+  case KIND_BITS:
+    memcpy(&x, &bits, sizeof(x));
+    return isnan(x) ? 1.0 : x;
+  case KIND_UNIFORM:
+    return 2.0 * rand() / RAND_MAX - 1.0;
+  case KIND_SHORT:
+    /* m * 10^e with m of 1 to 15 digits. */
+    x = (double)(bits % 1000000000000000ULL) / pow(10, rand() % 15);
+    return x * pow(10, rand() % 41 - 20);
+  case KIND_SUBNORMAL:
+    bits &= (1ULL << 52) - 1;
+    memcpy(&x, &bits, sizeof(x));
+    return (rand() % 2) ? -x : x;
+  default:
+    if (rand() % 2)
+      return pow(10, rand() % 617 - 308);
+    return ldexp(1, 53 + rand() % 10) + (double)(rand() % 100 - 50);
+  }
+}
+
+/*
+ * The function returns the significant digits of a text of
+ * printf or qe_format_double (without the leading and trailing
+ * zeros, the sign, the point and the exponent).
+ */
+static void significant_digits(const char *text, char *digits) {
+  int len = 0;
+
+  for (const char *p = text; (*p != '\0') && (*p != 'e'); p++)
+    if ((*p >= '0') && (*p <= '9') && ((len > 0) || (*p != '0')))
+      digits[len++] = *p;
+  while ((len > 0) && (digits[len - 1] == '0'))
+    len--;
+  digits[len] = '\0';
+}
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, formats random numbers of the
+ * kind and checks the texts. In case of an error, it returns 1.
+ */
+static int check(int test_num) {
+  test_param *t = &test_param_arr[test_num];
+  int res = 0;
+
+  printf("TEST_FORMAT_%d (%s): ", test_num, t->name);
+
+  srand(test_num);
+  for (size_t i = 0; (i < t->size) && !res; i++) {
+    char text[QE_TEXT_MAX_FORMAT + 1], shortest[40], d1[24], d2[24];
+    double x = generate(t->kind), y;
+    int len = qe_format_double(x, text), prec;
+
+    text[len] = '\0';
+    y = strtod(text, NULL);
+    if ((len > QE_TEXT_MAX_FORMAT) || (memcmp(&x, &y, sizeof(x)) != 0)) {
+      printf("[ERROR]: %A was written as \"%s\".\n", x, text);
+      res = 1;
+      break;
+    }
+
+    /* The shortest number of printf that reads back as x. */
+    for (prec = 1; prec < 17; prec++) {
+      snprintf(shortest, sizeof(shortest), "%.*e", prec - 1, x);
+      if (strtod(shortest, NULL) == x)
+        break;
+    }
+    snprintf(shortest, sizeof(shortest), "%.*e", prec - 1, x);
+
+    significant_digits(text, d1);
+    significant_digits(shortest, d2);
+    if ((strlen(d1) > strlen(d2)) ||
+        ((strlen(d1) == strlen(d2)) && (strcmp(d1, d2) != 0))) {
+      printf("[ERROR]: %A was written as \"%s\", \"%s\" was expected.\n", x,
+             text, shortest);
+      res = 1;
+    }
+  }
+
+  if (!res)
+    printf("[OK].\n");
+  return res;
+}
+
+/* The function reads the whole file. Returns NULL in case of an error. */
+static char *read_file(size_t *size) {
+  FILE *f = fopen(file_path, "rb");
+  char *data;
+  long len;
+
+  if ((f == NULL) || (fseek(f, 0, SEEK_END) != 0) || ((len = ftell(f)) < 0))
+    return NULL;
+  rewind(f);
+  data = malloc((size_t)len + 1);
+  if ((data == NULL) || (fread(data, 1, (size_t)len, f) != (size_t)len)) {
+    fclose(f);
+    free(data);
+    return NULL;
+  }
+  data[len] = '\0';
+  fclose(f);
+
+  *size = (size_t)len;
+  return data;
+}
+
+/*
+ * The function writes random results by qe_out in the format and
+ * compares the file with the expected rows. In case of an error,
+ * it returns 1.
+ */
+static int check_writer(int test_num) {
+  test_param *t = &test_param_arr[test_num];
+  static const char header[] = "res1,res2,msg_id\n";
+  double *res1, *res2;
+  int *msg_id, fd, res = 0;
+  qe_out *out;
+  char *data, *p;
+  size_t size;
+
+  printf("TEST_FORMAT_%d (%s): ", test_num, t->name);
+
+  res1 = malloc(t->size * sizeof(double));
+  res2 = malloc(t->size * sizeof(double));
+  msg_id = malloc(t->size * sizeof(int));
+  if (!res1 || !res2 || !msg_id) {
+    printf("[ERROR]: Out of memory.\n");
+    exit(1);
+  }
+
+  srand(test_num);
+  for (size_t i = 0; i < t->size; i++) {
+    res1[i] = generate(i % 3 ? KIND_UNIFORM : KIND_BITS);
+    res2[i] = generate(KIND_SHORT);
+    msg_id[i] = rand() % 7 + QE_ERR_NULLPTR;
+  }
+
+  /* A header, then the rows by parts of different sizes. */
+  fd = open(file_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  out = qe_out_create(fd, t->kind);
+  if ((fd < 0) || (out == NULL)) {
+    printf("[ERROR]: The writer was not created.\n");
+    exit(1);
+  }
+  if (t->kind == QE_OUT_TEXT)
+    res = qe_out_write(out, header, sizeof(header) - 1);
+  for (size_t i = 0, m = 1; (i < t->size) && !res; i += m, m = m * 3 + 1) {
+    if (m > t->size - i)
+      m = t->size - i;
+    res = qe_out_rows(out, res1 + i, res2 + i, msg_id + i, m);
+  }
+  if ((qe_out_close(out) != 0) || res || (close(fd) != 0)) {
+    printf("[ERROR]: The rows were not written.\n");
+    exit(1);
+  }
+
+  data = read_file(&size);
+  if (data == NULL) {
+    printf("[ERROR]: The file was not read.\n");
+    exit(1);
+  }
+
+  p = data;
+  if (t->kind == QE_OUT_TEXT) {
+    if (strncmp(p, header, sizeof(header) - 1) != 0)
+      res = 1;
+    p += sizeof(header) - 1;
+  } else if (size != t->size * QE_OUT_ROW)
+    res = 1;
+  if (res)
+    printf("[ERROR]: A wrong header or size of the file.\n");
+
+  for (size_t i = 0; (i < t->size) && !res; i++) {
+    unsigned char *u = (unsigned char *)p;
+    uint64_t r1 = 0, r2 = 0;
+    uint32_t m = 0;
+    double x, y;
+    int id;
+
+    if (t->kind == QE_OUT_TEXT) {
+      x = strtod(p, &p);
+      y = strtod(p + 1, &p);
+      id = (int)strtol(p + 1, &p, 10);
+      res = (*p++ != '\n');
+    } else {
+      /* The little-endian rows, read byte by byte. */
+      for (int k = 7; k >= 0; k--) {
+        r1 = (r1 << 8) | u[k];
+        r2 = (r2 << 8) | u[8 + k];
+      }
+      for (int k = 3; k >= 0; k--)
+        m = (m << 8) | u[16 + k];
+      memcpy(&x, &r1, sizeof(x));
+      memcpy(&y, &r2, sizeof(y));
+      id = (int)m;
+      p += QE_OUT_ROW;
+    }
+
+    if (res || (memcmp(&x, &res1[i], sizeof(x)) != 0) ||
+        (memcmp(&y, &res2[i], sizeof(y)) != 0) || (id != msg_id[i])) {
+      printf("[ERROR]:\n");
+      printf("\tRow %zu: res1 = %A   res2 = %A   msg[%d]\n", i, x, y, id);
+      printf("\tExpected: res1 = %A   res2 = %A   msg[%d]\n", res1[i],
+             res2[i], msg_id[i]);
+      res = 1;
+    }
+  }
+  if (!res && (p != data + size)) {
+    printf("[ERROR]: %zu bytes after the rows.\n", (size_t)(data + size - p));
+    res = 1;
+  }
+
+  free(data);
+  free(res1);
+  free(res2);
+  free(msg_id);
+  unlink(file_path);
+
+  if (!res)
+    printf("[OK].\n");
+  return res;
+}
@@ -0,0 +1,184 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the tests for the
+ * solve_equation_inline function (QE_INLINE).
+ *
+ * Each test fills the parameters with its own generator and
+ * checks that the results of solve_equation_inline are
+ * bit-identical to the results of solve_equation. The test
+ * "inline0" checks all the combinations of the special values
+ * (zeros, infinities, NaN, the limits of the double range).
+ *
+-------------------------------------------------------------*/
+
+#define QE_INLINE
+
+#include "quadratic_equation.h"
+#include "test_gen.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, generates the parameters and
+ * compares the results with solve_equation. In case of an error,
+ * it returns 1.
+ */
+static int check(int test_num);
+
+/*
+ * The function compares the results of one equation. In case of
+ * an error, it prints them and returns 0.
+ */
+static int check_equation(double a, double b, double c);
+
+/*
+ * The generator of the parameters with its own range of the
+ * exponents, the other generators are in test_gen.c.
+ */
+static void select_scaled(size_t i, double *a, double *b, double *c);
+
+/*
+ * A structure that describes a test: the generator of
+ * parameters and the number of equations.
+ */
+typedef struct {
+  void (*select)(size_t i, double *a, double *b, double *c); /* Generator. */
+  size_t size;   /* The number of equations. */
+  char *name;    /* Name of the test. */
+  char *test_id; /* The test ID is needed to select a structure. */
+} test_param;
+
+/* An array of test_param type structures. */
+test_param test_param_arr[] = {
+    {.select = gen_integer,
+     .size = 100000,
+     .name = "Random small integers, all the msg_id values.",
+     .test_id = "inline1"},
+
+    {.select = gen_uniform,
+     .size = 100000,
+     .name = "Random parameters from -1 to 1.",
+     .test_id = "inline2"},
+
+    {.select = gen_bits,
+     .size = 100000,
+     .name = "Random bit patterns (any exponent, infinities, NaN).",
+     .test_id = "inline3"},
+
+    {.select = select_scaled,
+     .size = 100000,
+     .name = "Random parameters from 2^-1100 to 2^1000.",
+     .test_id = "inline4"}};
+
+/* The special values of the test "inline0". */
+static const double special_arr[] = {0.0,     -0.0,     1.0,     -1.0,
+                                     2.0,     0.5,      DBL_MAX, -DBL_MAX,
+                                     DBL_MIN, 4.9e-324, 1e200,   1e-200,
+                                     INFINITY, -INFINITY, NAN};
+
+/*
+ * The main function receives one parameter as input.
+ * It is needed to compare with test_id and select
+ * the desired test.
+ */
+int main(int argc, char *argv[]) {
+
+  /*
+   * The value returned by the main function. In case of a
+   * failed test, the unchanged value of 1 will be returned.
+   */
+  int res = 1;
+
+  /* The number of elements in the test_param_arr array. */
+  int size = sizeof(test_param_arr) / sizeof(test_param_arr[0]);
+
+  /* Checking for the number of passed parameters in main. */
+  if (argc != 2) {
+    printf("[ERROR]: The wrong number of arguments was passed.\n");
+    exit(res);
+  }
+
+  if (strcmp(argv[1], "inline0") == 0) {
+    int n = sizeof(special_arr) / sizeof(special_arr[0]);
+
+    printf("TEST_INLINE (Special values): ");
+    res = 0;
+    for (int i = 0; (i < n) && !res; i++)
+      for (int j = 0; (j < n) && !res; j++)
+        for (int k = 0; (k < n) && !res; k++)
+          res = !check_equation(special_arr[i], special_arr[j],
+                                special_arr[k]);
+    if (!res)
+      printf("[OK].\n");
+  }
+
+  /*
+   * Search for the desired structure by the test_id
+   * parameter received by the main function.
+   */
+  for (int i = 0; i < size; i++)
+    if (strcmp(argv[1], test_param_arr[i].test_id) == 0)
+      res = check(i);
+
+  return res;
+}
+
+/*
+ * The function compares the results of one equation. In case of
+ * an error, it prints them and returns 0.
+ */
+static int check_equation(double a, double b, double c) {
+  qe_result r = solve_equation_inline(a, b, c);
+  double res1, res2;
+  int msg_id = solve_equation(a, b, c, &res1, &res2);
+
+  if ((r.msg_id == msg_id) &&
+      (memcmp(&r.res1, &res1, sizeof(double)) == 0) &&
+      (memcmp(&r.res2, &res2, sizeof(double)) == 0))
+    return 1;
+
+  printf("[ERROR]:\n");
+  printf("\tParameters passed: a = %A   b = %A   c = %A\n", a, b, c);
+  printf("\tReceived answer: res1 = %A   res2 = %A   msg[%d]\n", r.res1,
+         r.res2, r.msg_id);
+  printf("\tExpected answer: res1 = %A   res2 = %A   msg[%d]\n", res1, res2,
+         msg_id);
+  return 0;
+}
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, generates the parameters and
+ * compares the results with solve_equation. In case of an error,
+ * it returns 1.
+ */
+static int check(int test_num) {
+  size_t n = test_param_arr[test_num].size;
+  double a, b, c;
+
+  printf("TEST_INLINE_%d (%s): ", test_num, test_param_arr[test_num].name);
+
+  for (size_t i = 0; i < n; i++) {
+    test_param_arr[test_num].select(i, &a, &b, &c);
+    if (!check_equation(a, b, c))
+      return 1;
+  }
+
+  printf("[OK].\n");
+  return 0;
+}
+
+/*
+ * Random parameters with random exponents, so the roots may
+ * overflow or be denormal.
+ */
+static void select_scaled(size_t i, double *a, double *b, double *c) {
+  gen_uniform(i, a, b, c);
+  *a = ldexp(*a, rand() % 2101 - 1100);
+  *b = ldexp(*b, rand() % 2101 - 1100);
+  *c = ldexp(*c, rand() % 2101 - 1100);
+}
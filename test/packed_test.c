@@ -0,0 +1,242 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the tests for
+ * the functions with the packed results
+ * (solve_equation_batch_packed, solve_equation_batch_inplace).
+ *
+ * Each test fills the arrays of parameters with a generator of
+ * test_gen.c, solves them with every instruction set in both
+ * precision modes and checks that the unpacked results are
+ * bit-identical to the results of solve_equation_batch_prec.
+ * The test "packed0" checks the passing of null pointers.
+ *
+-------------------------------------------------------------*/
+
+#include "quadratic_equation.h"
+#include "test_gen.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, generates the parameters and
+ * compares the packed results with solve_equation_batch_prec.
+ * In case of an error, it returns 1.
+ */
+static int check(int test_num);
+
+/*
+ * A structure that describes a test: the generator of
+ * parameters and the number of equations in the batch.
+ */
+typedef struct {
+  gen_select select; /* Generator. */
+  size_t size;       /* The number of equations. */
+  char *name;        /* Name of the test. */
+  char *test_id;     /* The test ID is needed to select a structure. */
+} test_param;
+
+/* An array of test_param type structures. */
+test_param test_param_arr[] = {
+    {.select = gen_integer,
+     .size = 100003,
+     .name = "Random small integers, all the msg_id values.",
+     .test_id = "packed1"},
+
+    {.select = gen_uniform,
+     .size = 100000,
+     .name = "Random parameters from -1 to 1.",
+     .test_id = "packed2"},
+
+    {.select = gen_bits,
+     .size = 100001,
+     .name = "Random bit patterns (any exponent, infinities, NaN).",
+     .test_id = "packed3"},
+
+    {.select = gen_scaled,
+     .size = 1025,
+     .name = "Random parameters from 2^-300 to 2^300.",
+     .test_id = "packed4"},
+
+    {.select = gen_integer,
+     .size = 3,
+     .name = "A batch of an odd number of equations.",
+     .test_id = "packed5"}};
+
+/*
+ * The main function receives one parameter as input.
+ * It is needed to compare with test_id and select
+ * the desired test.
+ */
+int main(int argc, char *argv[]) {
+
+  /*
+   * The value returned by the main function. In case of a
+   * failed test, the unchanged value of 1 will be returned.
+   */
+  int res = 1;
+
+  /* The number of elements in the test_param_arr array. */
+  int size = sizeof(test_param_arr) / sizeof(test_param_arr[0]);
+
+  /* Checking for the number of passed parameters in main. */
+  if (argc != 2) {
+    printf("[ERROR]: The wrong number of arguments was passed.\n");
+    exit(res);
+  }
+
+  if (strcmp(argv[1], "packed0") == 0) {
+    double x = 0, roots[2];
+    unsigned char status;
+    size_t nroots;
+
+    printf("TEST_PACKED (Null pointers): ");
+    if ((solve_equation_batch_packed(&x, &x, &x, roots, NULL, &status, 1,
+                                     QE_PREC_EXTENDED) == QE_ERR_NULLPTR) &&
+        (solve_equation_batch_packed(&x, &x, &x, roots, &nroots, NULL, 1,
+                                     QE_PREC_DOUBLE) == QE_ERR_NULLPTR) &&
+        (solve_equation_batch_inplace(&x, NULL, &x, &status, 1,
+                                      QE_PREC_EXTENDED) == QE_ERR_NULLPTR)) {
+      printf("[OK].\n");
+      res = 0;
+    } else
+      printf("[ERROR]: QE_ERR_NULLPTR was expected.\n");
+  }
+
+  /*
+   * Search for the desired structure by the test_id
+   * parameter received by the main function.
+   */
+  for (int i = 0; i < size; i++)
+    if (strcmp(argv[1], test_param_arr[i].test_id) == 0)
+      res = check(i);
+
+  return res;
+}
+
+/*
+ * The function compares the packed results of one equation with the
+ * expected ones. The roots that are not written must not be read.
+ */
+static int check_equation(const double *a, const double *b, const double *c,
+                          const double *roots, size_t *k, int msg_id,
+                          double res1, double res2, size_t i, int isa,
+                          int prec) {
+  double r1 = 0, r2 = 0;
+  int ok;
+
+  if (msg_id == QE_OK_TWO_RES) {
+    r1 = roots[(*k)++];
+    r2 = roots[(*k)++];
+  } else if (msg_id == QE_OK_ONE_RES)
+    r1 = r2 = roots[(*k)++];
+
+  ok = ((msg_id != QE_OK_TWO_RES) && (msg_id != QE_OK_ONE_RES)) ||
+       ((memcmp(&r1, &res1, sizeof(double)) == 0) &&
+        (memcmp(&r2, &res2, sizeof(double)) == 0));
+  if (ok)
+    return 1;
+
+  printf("[ERROR]:\n");
+  printf("\tInstruction set: %s, mode %d\n", qe_batch_isa_name(isa), prec);
+  printf("\tParameters passed: a = %A   b = %A   c = %A\n", a[i], b[i], c[i]);
+  printf("\tReceived answer: res1 = %A   res2 = %A   msg[%d]\n", r1, r2,
+         msg_id);
+  printf("\tExpected answer: res1 = %A   res2 = %A\n", res1, res2);
+  return 0;
+}
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, generates the parameters and
+ * compares the packed results with solve_equation_batch_prec.
+ * In case of an error, it returns 1.
+ */
+static int check(int test_num) {
+  size_t n = test_param_arr[test_num].size, nroots;
+  double *a, *b, *c, *res1, *res2, *roots, *ia, *ib;
+  unsigned char *status, *istatus;
+  int *msg_id;
+  int res = 0;
+
+  printf("TEST_PACKED_%d (%s): ", test_num, test_param_arr[test_num].name);
+
+  a = gen_alloc(n * sizeof(double));
+  b = gen_alloc(n * sizeof(double));
+  c = gen_alloc(n * sizeof(double));
+  ia = gen_alloc(n * sizeof(double));
+  ib = gen_alloc(n * sizeof(double));
+  res1 = gen_alloc(n * sizeof(double));
+  res2 = gen_alloc(n * sizeof(double));
+  roots = gen_alloc(2 * n * sizeof(double));
+  msg_id = gen_alloc(n * sizeof(int));
+  status = gen_alloc(QE_PACKED_SIZE(n));
+  istatus = gen_alloc(QE_PACKED_SIZE(n));
+  gen_fill(test_param_arr[test_num].select, a, b, c, n);
+
+  /*
+   * Every instruction set is checked. If the processor does
+   * not support one, the previous one is checked again.
+   */
+  for (int isa = QE_ISA_GENERIC; (isa <= QE_ISA_AVX512) && !res; isa++)
+    for (int prec = QE_PREC_EXTENDED; (prec <= QE_PREC_DOUBLE) && !res;
+         prec++) {
+      int used = qe_batch_set_isa(isa);
+      size_t k = 0;
+
+      memcpy(ia, a, n * sizeof(double));
+      memcpy(ib, b, n * sizeof(double));
+      solve_equation_batch_prec(a, b, c, res1, res2, msg_id, n, prec);
+      if ((solve_equation_batch_packed(a, b, c, roots, &nroots, status, n,
+                                       prec) != QE_BATCH_OK) ||
+          (solve_equation_batch_inplace(ia, ib, c, istatus, n, prec) !=
+           QE_BATCH_OK)) {
+        printf("[ERROR]: QE_BATCH_OK was expected.\n");
+        res = 1;
+      }
+
+      for (size_t i = 0; (i < n) && !res; i++) {
+        if ((QE_PACKED_STATUS(status, i) != msg_id[i]) ||
+            (QE_PACKED_STATUS(istatus, i) != msg_id[i])) {
+          printf("[ERROR]: msg[%d] and msg[%d] instead of msg[%d] of the "
+                 "equation %zu.\n",
+                 QE_PACKED_STATUS(status, i), QE_PACKED_STATUS(istatus, i),
+                 msg_id[i], i);
+          res = 1;
+        } else if (!check_equation(a, b, c, roots, &k, msg_id[i], res1[i],
+                                   res2[i], i, used, prec)) {
+          res = 1;
+        } else if ((memcmp(&ia[i], &res1[i], sizeof(double)) != 0) ||
+                   (memcmp(&ib[i], &res2[i], sizeof(double)) != 0)) {
+          printf("[ERROR]: The roots %A and %A instead of %A and %A of the "
+                 "equation %zu in place (%s, mode %d).\n",
+                 ia[i], ib[i], res1[i], res2[i], i, qe_batch_isa_name(used),
+                 prec);
+          res = 1;
+        }
+      }
+
+      if (!res && (k != nroots)) {
+        printf("[ERROR]: %zu roots were written, %zu were expected.\n",
+               nroots, k);
+        res = 1;
+      }
+    }
+
+  free(a);
+  free(b);
+  free(c);
+  free(ia);
+  free(ib);
+  free(res1);
+  free(res2);
+  free(roots);
+  free(msg_id);
+  free(status);
+  free(istatus);
+
+  if (!res)
+    printf("[OK].\n");
+  return res;
+}
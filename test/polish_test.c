@@ -0,0 +1,376 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the tests for
+ * the solve_equation_batch_polish function.
+ *
+ * The tests "polish1", "polish2" and "polish6" solve ill-conditioned
+ * equations (close roots, or roots of very different sizes) and
+ * check that the polished roots are within POLISH_ULPS units in
+ * the last place of the roots of the QE_PREC_DOUBLE mode, which
+ * are accurate (see test/prec_test.c); in "polish6" the parameters
+ * are out of the range of the residuals. The other tests check
+ * that the msg_id values are the ones of solve_equation_batch_prec,
+ * that the roots are not moved farther than by the error of
+ * solve_equation, and that every instruction set gives
+ * bit-identical results.
+ *
+-------------------------------------------------------------*/
+
+#include "quadratic_equation.h"
+#include "test_gen.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The maximum distance of the polished roots from the roots of
+ * the QE_PREC_DOUBLE mode, in units in the last place.
+ */
+#define POLISH_ULPS 4
+
+/*
+ * The maximum relative change of a root of a well-conditioned
+ * equation by the polishing. It grows with the condition number
+ * of the roots, see max_move.
+ */
+#define POLISH_MOVE 0x1p-50
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, generates the parameters and
+ * checks the polished results. In case of an error, it returns 1.
+ */
+static int check(int test_num);
+
+/* Generators of the parameters. */
+static void select_double_root(double *a, double *b, double *c);
+static void select_far(double *a, double *b, double *c);
+static void select_uniform(double *a, double *b, double *c);
+static void select_bits(double *a, double *b, double *c);
+static void select_scaled(double *a, double *b, double *c);
+
+/*
+ * A structure that describes a test: the generator of parameters,
+ * the number of equations and the precision mode.
+ */
+typedef struct {
+  void (*select)(double *a, double *b, double *c); /* Generator. */
+  int reference; /* Whether the roots are compared with QE_PREC_DOUBLE. */
+  size_t size;   /* The number of equations. */
+  int prec;      /* The precision mode. */
+  char *name;    /* Name of the test. */
+  char *test_id; /* The test ID is needed to select a structure. */
+} test_param;
+
+/* An array of test_param type structures. */
+test_param test_param_arr[] = {
+    {.select = select_double_root,
+     .reference = 1,
+     .size = 100003,
+     .prec = QE_PREC_EXTENDED,
+     .name = "Close roots, the discriminant is close to 0.",
+     .test_id = "polish1"},
+
+    {.select = select_far,
+     .reference = 1,
+     .size = 100003,
+     .prec = QE_PREC_EXTENDED,
+     .name = "Roots of very different sizes (b * b >> 4ac).",
+     .test_id = "polish2"},
+
+    {.select = select_uniform,
+     .size = 100003,
+     .prec = QE_PREC_EXTENDED,
+     .name = "Random parameters from -1 to 1.",
+     .test_id = "polish3"},
+
+    {.select = select_bits,
+     .size = 100003,
+     .prec = QE_PREC_EXTENDED,
+     .name = "Random bit patterns (any exponent, infinities, NaN).",
+     .test_id = "polish4"},
+
+    {.select = select_double_root,
+     .size = 100003,
+     .prec = QE_PREC_DOUBLE,
+     .name = "Close roots in the QE_PREC_DOUBLE mode.",
+     .test_id = "polish5"},
+
+    {.select = select_scaled,
+     .reference = 1,
+     .size = 100003,
+     .prec = QE_PREC_EXTENDED,
+     .name = "Ill-conditioned equations with huge or tiny parameters.",
+     .test_id = "polish6"}};
+
+/*
+ * The main function receives one parameter as input.
+ * It is needed to compare with test_id and select
+ * the desired test.
+ */
+int main(int argc, char *argv[]) {
+
+  /*
+   * The value returned by the main function. In case of a
+   * failed test, the unchanged value of 1 will be returned.
+   */
+  int res = 1;
+
+  /* The number of elements in the test_param_arr array. */
+  int size = sizeof(test_param_arr) / sizeof(test_param_arr[0]);
+
+  /* Checking for the number of passed parameters in main. */
+  if (argc != 2) {
+    printf("[ERROR]: The wrong number of arguments was passed.\n");
+    exit(res);
+  }
+
+  if (strcmp(argv[1], "polish0") == 0) {
+    double x = 0;
+    int msg_id;
+
+    printf("TEST_POLISH (Null pointers): ");
+    if ((solve_equation_batch_polish(&x, &x, &x, NULL, &x, &msg_id, 1,
+                                     QE_PREC_EXTENDED) == QE_ERR_NULLPTR) &&
+        (solve_equation_batch_polish(&x, &x, &x, &x, &x, NULL, 1,
+                                     QE_PREC_DOUBLE) == QE_ERR_NULLPTR)) {
+      printf("[OK].\n");
+      res = 0;
+    } else
+      printf("[ERROR]: QE_ERR_NULLPTR was expected.\n");
+  }
+
+  /*
+   * Search for the desired structure by the test_id
+   * parameter received by the main function.
+   */
+  for (int i = 0; i < size; i++)
+    if (strcmp(argv[1], test_param_arr[i].test_id) == 0)
+      res = check(i);
+
+  return res;
+}
+
+/* The function returns the distance from x to r in units in the last place. */
+static double ulps(double x, double r) {
+  return fabs(x - r) / (nextafter(fabs(r), INFINITY) - fabs(r));
+}
+
+/*
+ * The function returns the maximum relative change of the roots by
+ * the polishing: the relative error of the roots of solve_equation
+ * grows as b * b / |D| for close roots and as b * b / |4 * a * c|
+ * for the smaller root. A root that is lost completely (0) may
+ * change in any way.
+ */
+static double max_move(double a, double b, double c) {
+  double p = b * b, q = 4.0 * a * c;
+
+  return POLISH_MOVE * (1 + p / fabs(p - q) + p / fabs(q));
+}
+
+/*
+ * The function checks the polished results of one equation: res1
+ * and res2 are the polished roots, raw1 and raw2 the roots of
+ * solve_equation_batch_prec, r1 and r2 the roots of the
+ * QE_PREC_DOUBLE mode, same is set if both modes give the same
+ * msg_id. The roots must be within POLISH_ULPS of r1 and r2 (in the
+ * tests with the reference, if same is set), or not moved farther
+ * from the raw roots than by their error. It returns true if they
+ * are correct, otherwise it prints an error.
+ */
+static int check_equation(const test_param *test, double a, double b,
+                          double c, double r1, double r2, double res1,
+                          double res2, double raw1, double raw2, int same,
+                          int isa) {
+  double move = max_move(a, b, c);
+  int accurate, ok;
+
+  accurate = same && (ulps(res1, r1) <= POLISH_ULPS) &&
+             (ulps(res2, r2) <= POLISH_ULPS);
+  if (test->reference && same)
+    ok = accurate;
+  else
+    ok = accurate || (((res1 == raw1) || (raw1 == 0) ||
+                       (fabs(res1 - raw1) <= move * fabs(raw1))) &&
+                      ((res2 == raw2) || (raw2 == 0) ||
+                       (fabs(res2 - raw2) <= move * fabs(raw2))));
+
+  if (ok || (isnan(raw1) && isnan(res1) && isnan(raw2) && isnan(res2)))
+    return 1;
+
+  printf("[ERROR]:\n");
+  printf("\tInstruction set: %s, mode %d\n", qe_batch_isa_name(isa),
+         test->prec);
+  printf("\tParameters passed: a = %A   b = %A   c = %A\n", a, b, c);
+  printf("\tReceived answer: res1 = %A   res2 = %A\n", res1, res2);
+  if (test->reference && same)
+    printf("\tExpected answer: res1 = %A   res2 = %A\n", r1, r2);
+  else
+    printf("\tUnpolished answer: res1 = %A   res2 = %A\n", raw1, raw2);
+  return 0;
+}
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, generates the parameters and
+ * checks the polished results. In case of an error, it returns 1.
+ */
+static int check(int test_num) {
+  const test_param *test = &test_param_arr[test_num];
+  size_t n = test->size;
+  double *a, *b, *c, *r1, *r2, *res1, *res2, *raw1, *raw2, *gen1, *gen2;
+  int *msg_id, *raw_msg, *ref_msg;
+  int res = 0;
+
+  printf("TEST_POLISH_%d (%s): ", test_num, test->name);
+
+  a = malloc(n * sizeof(double));
+  b = malloc(n * sizeof(double));
+  c = malloc(n * sizeof(double));
+  r1 = malloc(n * sizeof(double));
+  r2 = malloc(n * sizeof(double));
+  res1 = malloc(n * sizeof(double));
+  res2 = malloc(n * sizeof(double));
+  raw1 = malloc(n * sizeof(double));
+  raw2 = malloc(n * sizeof(double));
+  gen1 = malloc(n * sizeof(double));
+  gen2 = malloc(n * sizeof(double));
+  msg_id = malloc(n * sizeof(int));
+  raw_msg = malloc(n * sizeof(int));
+  ref_msg = malloc(n * sizeof(int));
+  if (!a || !b || !c || !r1 || !r2 || !res1 || !res2 || !raw1 || !raw2 ||
+      !gen1 || !gen2 || !msg_id || !raw_msg || !ref_msg) {
+    printf("[ERROR]: Out of memory.\n");
+    exit(1);
+  }
+
+  for (size_t i = 0; i < n; i++)
+    test->select(&a[i], &b[i], &c[i]);
+
+  /* The reference roots. */
+  solve_equation_batch_prec(a, b, c, r1, r2, ref_msg, n, QE_PREC_DOUBLE);
+
+  /*
+   * Every instruction set is checked, and its results are compared
+   * with the results of the generic one bit by bit.
+   */
+  for (int isa = QE_ISA_GENERIC; (isa <= QE_ISA_AVX512) && !res; isa++) {
+    int used = qe_batch_set_isa(isa);
+
+    solve_equation_batch_prec(a, b, c, raw1, raw2, raw_msg, n, test->prec);
+    if (solve_equation_batch_polish(a, b, c, res1, res2, msg_id, n,
+                                    test->prec) != QE_BATCH_OK) {
+      printf("[ERROR]: QE_BATCH_OK was expected.\n");
+      res = 1;
+    }
+
+    for (size_t i = 0; (i < n) && !res; i++) {
+      if (msg_id[i] != raw_msg[i]) {
+        printf("[ERROR]: msg[%d] instead of msg[%d] of the equation %zu.\n",
+               msg_id[i], raw_msg[i], i);
+        res = 1;
+      } else if ((isa == QE_ISA_GENERIC) &&
+                 !check_equation(test, a[i], b[i], c[i], r1[i], r2[i],
+                                 res1[i], res2[i], raw1[i], raw2[i],
+                                 msg_id[i] == ref_msg[i], used)) {
+        res = 1;
+      } else if ((isa == QE_ISA_GENERIC) && (test->prec == QE_PREC_DOUBLE) &&
+                 ((memcmp(&res1[i], &raw1[i], sizeof(double)) != 0) ||
+                  (memcmp(&res2[i], &raw2[i], sizeof(double)) != 0))) {
+        printf("[ERROR]: The roots of the equation %zu were changed in the "
+               "QE_PREC_DOUBLE mode.\n",
+               i);
+        res = 1;
+      } else if ((isa != QE_ISA_GENERIC) &&
+                 ((memcmp(&res1[i], &gen1[i], sizeof(double)) != 0) ||
+                  (memcmp(&res2[i], &gen2[i], sizeof(double)) != 0))) {
+        printf("[ERROR]: The roots %A and %A instead of %A and %A of the "
+               "equation %zu (%s).\n",
+               res1[i], res2[i], gen1[i], gen2[i], i, qe_batch_isa_name(used));
+        res = 1;
+      }
+    }
+
+    if (isa == QE_ISA_GENERIC) {
+      memcpy(gen1, res1, n * sizeof(double));
+      memcpy(gen2, res2, n * sizeof(double));
+    }
+  }
+
+  free(a);
+  free(b);
+  free(c);
+  free(r1);
+  free(r2);
+  free(res1);
+  free(res2);
+  free(raw1);
+  free(raw2);
+  free(gen1);
+  free(gen2);
+  free(msg_id);
+  free(raw_msg);
+  free(ref_msg);
+
+  if (!res)
+    printf("[OK].\n");
+  return res;
+}
+
+/* The function returns a random double from -1 to 1. */
+static double random_sym(void) { return 2.0 * rand() / RAND_MAX - 1.0; }
+
+/*
+ * Equations a(x - r)^2 = 0 with `c` changed by a relative
+ * amount up to 1e-12: the discriminant is close to 0.
+ */
+static void select_double_root(double *a, double *b, double *c) {
+  double r = random_sym();
+
+  *a = random_sym();
+  *b = -2 * *a * r;
+  *c = *a * r * r * (1 + 1e-12 * random_sym());
+}
+
+/* b * b >> 4ac: one root is much smaller than the other one. */
+static void select_far(double *a, double *b, double *c) {
+  *a = random_sym();
+  *b = ((rand() % 2) ? -1 : 1) * (1e6 + 1e8 * (random_sym() + 1) / 2);
+  *c = random_sym();
+}
+
+/*
+ * The equations of select_double_root and select_far multiplied by
+ * 2^e with |e| from 200 to 800, and with the roots multiplied by
+ * 2^t with |t| up to 100, so some parameters are out of
+ * [2^-150, 2^150].
+ */
+static void select_scaled(double *a, double *b, double *c) {
+  int e = ((rand() % 2) ? -1 : 1) * (200 + rand() % 601);
+  int t = rand() % 201 - 100;
+
+  if (rand() % 2)
+    select_double_root(a, b, c);
+  else
+    select_far(a, b, c);
+
+  *a = ldexp(*a, e - t);
+  *b = ldexp(*b, e);
+  *c = ldexp(*c, e + t);
+}
+
+/* Random parameters from -1 to 1. */
+static void select_uniform(double *a, double *b, double *c) {
+  *a = random_sym();
+  *b = random_sym();
+  *c = random_sym();
+}
+
+/* Random bit patterns. */
+static void select_bits(double *a, double *b, double *c) {
+  *a = gen_random_bits();
+  *b = gen_random_bits();
+  *c = gen_random_bits();
+}
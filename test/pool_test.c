@@ -0,0 +1,365 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the tests for the
+ * pool of worker threads and the solve_equation_batch_parallel
+ * function.
+ *
+ * Each test creates a pool with the given number of threads,
+ * solves random equations in parallel and checks that the
+ * results are bit-identical to the results of
+ * solve_equation_batch_prec. The test "pool0" checks the
+ * passing of null pointers, "pool1" checks that every chunk of
+ * a job is processed exactly once, "pool2" runs jobs on one
+ * pool from two threads at once, and in "pool8" the tasks run
+ * jobs on their own pool.
+ *
+-------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include "qe_pool.h"
+#include "quadratic_equation.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, solves the equations in
+ * parallel and compares the results. In case of an error,
+ * it returns 1.
+ */
+static int check(int test_num);
+
+/* The function checks that every chunk is processed once. */
+static int check_chunks(void);
+
+/* The function runs jobs on one pool from two threads. */
+static int check_callers(void);
+
+/* The function runs jobs from the tasks of the same pool. */
+static int check_nested(void);
+
+/*
+ * A structure that describes a test: the pool and
+ * the equations that are solved on it.
+ */
+typedef struct {
+  int nthreads;  /* Threads of the pool, 0 - the default pool. */
+  int pin;       /* Whether the threads are bound to processors. */
+  size_t size;   /* The number of equations. */
+  int prec;      /* Precision mode. */
+  char *name;    /* Name of the test. */
+  char *test_id; /* The test ID is needed to select a structure. */
+} test_param;
+
+/* An array of test_param type structures. */
+test_param test_param_arr[] = {
+    {.nthreads = 0,
+     .pin = 0,
+     .size = 1000003,
+     .prec = QE_PREC_EXTENDED,
+     .name = "The default pool.",
+     .test_id = "pool3"},
+
+    {.nthreads = 4,
+     .pin = 0,
+     .size = 1000003,
+     .prec = QE_PREC_DOUBLE,
+     .name = "Four threads, the double precision mode.",
+     .test_id = "pool4"},
+
+    {.nthreads = 3,
+     .pin = 1,
+     .size = 100003,
+     .prec = QE_PREC_EXTENDED,
+     .name = "Three threads bound to processors.",
+     .test_id = "pool5"},
+
+    {.nthreads = 7,
+     .pin = 0,
+     .size = 5,
+     .prec = QE_PREC_EXTENDED,
+     .name = "A batch of one chunk.",
+     .test_id = "pool6"},
+
+    {.nthreads = 2,
+     .pin = 0,
+     .size = 0,
+     .prec = QE_PREC_EXTENDED,
+     .name = "An empty batch.",
+     .test_id = "pool7"}};
+
+/*
+ * The main function receives one parameter as input.
+ * It is needed to compare with test_id and select
+ * the desired test.
+ */
+int main(int argc, char *argv[]) {
+
+  /*
+   * The value returned by the main function. In case of a
+   * failed test, the unchanged value of 1 will be returned.
+   */
+  int res = 1;
+
+  /* The number of elements in the test_param_arr array. */
+  int size = sizeof(test_param_arr) / sizeof(test_param_arr[0]);
+
+  /* Checking for the number of passed parameters in main. */
+  if (argc != 2) {
+    printf("[ERROR]: The wrong number of arguments was passed.\n");
+    exit(res);
+  }
+
+  if (strcmp(argv[1], "pool0") == 0) {
+    double x = 0;
+    int msg_id;
+
+    printf("TEST_POOL (Null pointers): ");
+    if (solve_equation_batch_parallel(NULL, &x, &x, &x, &x, NULL, &msg_id, 1,
+                                      QE_PREC_EXTENDED) == QE_ERR_NULLPTR) {
+      printf("[OK].\n");
+      res = 0;
+    } else
+      printf("[ERROR]: QE_ERR_NULLPTR was expected.\n");
+  }
+
+  if (strcmp(argv[1], "pool1") == 0)
+    res = check_chunks();
+
+  if (strcmp(argv[1], "pool2") == 0)
+    res = check_callers();
+
+  if (strcmp(argv[1], "pool8") == 0)
+    res = check_nested();
+
+  /*
+   * Search for the desired structure by the test_id
+   * parameter received by the main function.
+   */
+  for (int i = 0; i < size; i++)
+    if (strcmp(argv[1], test_param_arr[i].test_id) == 0)
+      res = check(i);
+
+  return res;
+}
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, solves the equations in
+ * parallel and compares the results. In case of an error,
+ * it returns 1.
+ */
+static int check(int test_num) {
+  test_param *t = &test_param_arr[test_num];
+  size_t n = t->size;
+  double *a, *b, *c, *res1, *res2, *true_res1, *true_res2;
+  int *msg_id, *true_msg_id;
+  qe_pool *pool = NULL;
+  int res = 0;
+
+  printf("TEST_POOL_%d (%s): ", test_num, t->name);
+
+  a = malloc((n + 1) * sizeof(double));
+  b = malloc((n + 1) * sizeof(double));
+  c = malloc((n + 1) * sizeof(double));
+  res1 = malloc((n + 1) * sizeof(double));
+  res2 = malloc((n + 1) * sizeof(double));
+  true_res1 = malloc((n + 1) * sizeof(double));
+  true_res2 = malloc((n + 1) * sizeof(double));
+  msg_id = malloc((n + 1) * sizeof(int));
+  true_msg_id = malloc((n + 1) * sizeof(int));
+  if (!a || !b || !c || !res1 || !res2 || !true_res1 || !true_res2 ||
+      !msg_id || !true_msg_id) {
+    printf("[ERROR]: Out of memory.\n");
+    exit(1);
+  }
+
+  /* Random parameters from -1 to 1, every tenth `a` is zero. */
+  for (size_t i = 0; i < n; i++) {
+    a[i] = (i % 10 == 0) ? 0 : 2.0 * rand() / RAND_MAX - 1.0;
+    b[i] = 2.0 * rand() / RAND_MAX - 1.0;
+    c[i] = 2.0 * rand() / RAND_MAX - 1.0;
+  }
+
+  if (t->nthreads > 0) {
+    pool = qe_pool_create(t->nthreads, t->pin);
+    if ((pool == NULL) || (qe_pool_size(pool) != t->nthreads)) {
+      printf("[ERROR]: The pool was not created.\n");
+      exit(1);
+    }
+  }
+
+  solve_equation_batch_prec(a, b, c, true_res1, true_res2, true_msg_id, n,
+                            t->prec);
+  if (solve_equation_batch_parallel(pool, a, b, c, res1, res2, msg_id, n,
+                                    t->prec) != QE_BATCH_OK) {
+    printf("[ERROR]: QE_BATCH_OK was expected.\n");
+    res = 1;
+  }
+
+  for (size_t i = 0; (i < n) && !res; i++)
+    if ((msg_id[i] != true_msg_id[i]) ||
+        (memcmp(&res1[i], &true_res1[i], sizeof(double)) != 0) ||
+        (memcmp(&res2[i], &true_res2[i], sizeof(double)) != 0)) {
+      printf("[ERROR]:\n");
+      printf("\tEquation %zu: a = %A   b = %A   c = %A\n", i, a[i], b[i],
+             c[i]);
+      printf("\tReceived answer: res1 = %A   res2 = %A   msg[%d]\n", res1[i],
+             res2[i], msg_id[i]);
+      printf("\tExpected answer: res1 = %A   res2 = %A   msg[%d]\n",
+             true_res1[i], true_res2[i], true_msg_id[i]);
+      res = 1;
+    }
+
+  qe_pool_destroy(pool);
+  free(a);
+  free(b);
+  free(c);
+  free(res1);
+  free(res2);
+  free(true_res1);
+  free(true_res2);
+  free(msg_id);
+  free(true_msg_id);
+
+  if (!res)
+    printf("[OK].\n");
+  return res;
+}
+
+/* The number of chunks in the jobs of pool1 and pool2. */
+#define NCHUNKS 1000
+
+/*
+ * The task of pool1. The chunks have different cost, so the
+ * threads with the cheap ones steal from the others.
+ */
+static void count_chunk(void *ctx, size_t chunk) {
+  int *count = ctx;
+  volatile double x = 1;
+
+  for (size_t i = 0; i < (chunk % 7) * 1000; i++)
+    x = x * 1.0000001;
+
+  __atomic_fetch_add(&count[chunk], 1, __ATOMIC_RELAXED);
+}
+
+/* The function checks that every chunk is processed once. */
+static int check_chunks(void) {
+  static int count[NCHUNKS];
+  qe_pool *pool = qe_pool_create(4, 0);
+  int res = 0;
+
+  printf("TEST_POOL (Every chunk is processed once): ");
+  if (pool == NULL) {
+    printf("[ERROR]: The pool was not created.\n");
+    return 1;
+  }
+
+  /* Several jobs of different sizes on the same threads. */
+  for (size_t n = 1; (n <= NCHUNKS) && !res; n = n * 3 + 1) {
+    memset(count, 0, sizeof(count));
+    qe_pool_run(pool, n, count_chunk, count);
+
+    for (size_t i = 0; i < NCHUNKS; i++)
+      if (count[i] != (i < n)) {
+        printf("[ERROR]: The chunk %zu of %zu was processed %d times.\n", i,
+               n, count[i]);
+        res = 1;
+        break;
+      }
+  }
+
+  qe_pool_destroy(pool);
+  if (!res)
+    printf("[OK].\n");
+  return res;
+}
+
+/* The argument of a caller thread of pool2. */
+typedef struct {
+  qe_pool *pool;
+  int count[NCHUNKS];
+} caller_arg;
+
+/* A caller thread: runs 50 jobs on the common pool. */
+static void *caller_main(void *p) {
+  caller_arg *arg = p;
+
+  for (int i = 0; i < 50; i++)
+    qe_pool_run(arg->pool, NCHUNKS, count_chunk, arg->count);
+  return NULL;
+}
+
+/* The function runs jobs on one pool from two threads. */
+static int check_callers(void) {
+  static caller_arg args[2];
+  pthread_t threads[2];
+  qe_pool *pool = qe_pool_create(3, 0);
+  int res = 0;
+
+  printf("TEST_POOL (Jobs from two threads): ");
+  if (pool == NULL) {
+    printf("[ERROR]: The pool was not created.\n");
+    return 1;
+  }
+
+  for (int i = 0; i < 2; i++) {
+    args[i].pool = pool;
+    pthread_create(&threads[i], NULL, caller_main, &args[i]);
+  }
+  for (int i = 0; i < 2; i++)
+    pthread_join(threads[i], NULL);
+
+  for (int i = 0; i < 2; i++)
+    for (size_t j = 0; j < NCHUNKS; j++)
+      if (args[i].count[j] != 50)
+        res = 1;
+
+  qe_pool_destroy(pool);
+  if (!res)
+    printf("[OK].\n");
+  else
+    printf("[ERROR]: A chunk was lost or processed twice.\n");
+  return res;
+}
+
+/* The pool of pool8, used by the tasks. */
+static qe_pool *nested_pool;
+
+/* The task of pool8: runs a job of ten chunks on its own pool. */
+static void nested_chunk(void *ctx, size_t chunk) {
+  int *count = ctx;
+
+  qe_pool_run(nested_pool, 10, count_chunk, count + chunk * 10);
+}
+
+/* The function runs jobs from the tasks of the same pool. */
+static int check_nested(void) {
+  static int count[NCHUNKS];
+  int res = 0;
+
+  printf("TEST_POOL (Jobs run by the tasks of the pool): ");
+  nested_pool = qe_pool_create(3, 0);
+  if (nested_pool == NULL) {
+    printf("[ERROR]: The pool was not created.\n");
+    return 1;
+  }
+
+  qe_pool_run(nested_pool, NCHUNKS / 10, nested_chunk, count);
+  for (size_t i = 0; i < NCHUNKS; i++)
+    if (count[i] != 1) {
+      printf("[ERROR]: The chunk %zu was processed %d times.\n", i,
+             count[i]);
+      res = 1;
+      break;
+    }
+
+  qe_pool_destroy(nested_pool);
+  if (!res)
+    printf("[OK].\n");
+  return res;
+}
@@ -0,0 +1,385 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the tests for
+ * the QE_PREC_DOUBLE mode (solve_equation_prec and
+ * solve_equation_batch_prec).
+ *
+ * The tests "prec1" - "prec13" solve the equations with known
+ * roots, including the ones where the long double formula
+ * loses accuracy or overflows. The other tests fill the arrays
+ * of parameters with a generator, solve them with every
+ * instruction set and check that the results are bit-identical
+ * to the results of solve_equation_prec.
+ *
+-------------------------------------------------------------*/
+
+#include "quadratic_equation.h"
+#include "test_gen.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The maximum relative difference of a root from the
+ * expected value (a few units in the last place).
+ */
+#define PREC_ACCUR 1e-15
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input and compares the expected values
+ * with those obtained in the QE_PREC_DOUBLE mode.
+ * In case of an error, it returns 1.
+ */
+static int check(int test_num);
+
+/*
+ * The function solves the generated batch with every instruction
+ * set and compares the results with solve_equation_prec.
+ * In case of an error, it returns 1.
+ */
+static int check_batch(int test_num);
+
+/*
+ * The function checks that the root differs from the
+ * expected one by no more than PREC_ACCUR.
+ */
+static int check_root(double res, double true_res);
+
+/*
+ * The generator of the parameters with its own range of the
+ * exponents, the other generators are in test_gen.c.
+ */
+static void select_scaled(size_t i, double *a, double *b, double *c);
+
+/*
+ * A structure that describes a test. The tests with the
+ * generator of parameters compare the batch results, the other
+ * ones compare the results with the expected values.
+ */
+typedef struct {
+  double a;    /* Transmitted parameter. */
+  double b;    /* Transmitted parameter. */
+  double c;    /* Transmitted parameter. */
+  double res1; /* Expected response. */
+  double res2; /* Expected response. */
+  int msg_id;  /* Expected response. */
+  void (*select)(size_t i, double *a, double *b, double *c); /* Generator. */
+  size_t size;   /* The number of equations. */
+  char *name;    /* Name of the test. */
+  char *test_id; /* The test ID is needed to select a structure. */
+} test_param;
+
+/* An array of test_param type structures. */
+test_param test_param_arr[] = {
+    {.a = 1,
+     .b = -3,
+     .c = 2,
+     .res1 = 2,
+     .res2 = 1,
+     .msg_id = QE_OK_TWO_RES,
+     .name = "Two integer roots.",
+     .test_id = "prec1"},
+
+    {.a = 1,
+     .b = 1e8,
+     .c = 1,
+     .res1 = -1.00000000000000002e-8,
+     .res2 = -99999999.99999999,
+     .msg_id = QE_OK_TWO_RES,
+     .name = "The small root is computed without cancellation.",
+     .test_id = "prec2"},
+
+    {.a = 1,
+     .b = -2,
+     .c = 1,
+     .res1 = 1,
+     .res2 = 1,
+     .msg_id = QE_OK_ONE_RES,
+     .name = "The discriminant is zero.",
+     .test_id = "prec3"},
+
+    {.a = 1,
+     .b = 0,
+     .c = 1,
+     .res1 = QE_STD_VAL_RES,
+     .res2 = QE_STD_VAL_RES,
+     .msg_id = QE_OK_NO_RES,
+     .name = "The discriminant is negative.",
+     .test_id = "prec4"},
+
+    {.a = 0,
+     .b = 5,
+     .c = 3,
+     .res1 = -0.6,
+     .res2 = -0.6,
+     .msg_id = QE_OK_ONE_RES,
+     .name = "Only `a` is zero.",
+     .test_id = "prec5"},
+
+    {.a = 0,
+     .b = 0.01,
+     .c = DBL_MAX - 1,
+     .res1 = QE_STD_VAL_RES,
+     .res2 = QE_STD_VAL_RES,
+     .msg_id = QE_ERR_OVERFLOW,
+     .name = "Only `a` is zero. The root is outside the double range.",
+     .test_id = "prec6"},
+
+    {.a = -DBL_MAX + 1,
+     .b = 0,
+     .c = DBL_MAX - 1,
+     .res1 = -1,
+     .res2 = 1,
+     .msg_id = QE_OK_TWO_RES,
+     .name = "Huge parameters, the products overflow.",
+     .test_id = "prec7"},
+
+    {.a = 1,
+     .b = DBL_MAX - 1,
+     .c = 1,
+     .res1 = -1 / DBL_MAX,
+     .res2 = -DBL_MAX,
+     .msg_id = QE_OK_TWO_RES,
+     .name = "Both roots are in the double range, b * b is not.",
+     .test_id = "prec8"},
+
+    {.a = 1e-200,
+     .b = 1,
+     .c = 1,
+     .res1 = -1,
+     .res2 = -1e200,
+     .msg_id = QE_OK_TWO_RES,
+     .name = "Tiny `a`, the equation is scaled.",
+     .test_id = "prec9"},
+
+    {.a = 1e-300,
+     .b = 1e300,
+     .c = 1,
+     .res1 = QE_STD_VAL_RES,
+     .res2 = QE_STD_VAL_RES,
+     .msg_id = QE_ERR_OVERFLOW,
+     .name = "A root is outside the double range.",
+     .test_id = "prec10"},
+
+    {.a = INFINITY,
+     .b = 1,
+     .c = 1,
+     .res1 = QE_STD_VAL_RES,
+     .res2 = QE_STD_VAL_RES,
+     .msg_id = QE_ERR_OVERFLOW,
+     .name = "An infinite parameter.",
+     .test_id = "prec11"},
+
+    {.a = 1,
+     .b = NAN,
+     .c = 1,
+     .res1 = QE_STD_VAL_RES,
+     .res2 = QE_STD_VAL_RES,
+     .msg_id = QE_ERR_OVERFLOW,
+     .name = "A NaN parameter.",
+     .test_id = "prec12"},
+
+    {.a = 10,
+     .b = 5,
+     .c = 0,
+     .res1 = 0,
+     .res2 = -0.5,
+     .msg_id = QE_OK_TWO_RES,
+     .name = "Only `c` is zero.",
+     .test_id = "prec13"},
+
+    {.select = gen_uniform,
+     .size = 100003,
+     .name = "Batch: random parameters from -1 to 1.",
+     .test_id = "prec14"},
+
+    {.select = gen_integer,
+     .size = 100003,
+     .name = "Batch: random small integers, many of them are zero.",
+     .test_id = "prec15"},
+
+    {.select = gen_bits,
+     .size = 100003,
+     .name = "Batch: random bit patterns (any exponent, infinities, NaN).",
+     .test_id = "prec16"},
+
+    {.select = select_scaled,
+     .size = 100003,
+     .name = "Batch: random parameters from 2^-600 to 2^600.",
+     .test_id = "prec17"},
+
+    {.select = gen_uniform,
+     .size = 7,
+     .name = "Batch: a batch shorter than any vector.",
+     .test_id = "prec18"}};
+
+/*
+ * The main function receives one parameter as input.
+ * It is needed to compare with test_id and select
+ * the desired test. The test "prec0" checks
+ * the passing of null pointers.
+ */
+int main(int argc, char *argv[]) {
+
+  /*
+   * The value returned by the main function. In case of a
+   * failed test, the unchanged value of 1 will be returned.
+   */
+  int res = 1;
+
+  /* The number of elements in the test_param_arr array. */
+  int size = sizeof(test_param_arr) / sizeof(test_param_arr[0]);
+
+  /* Checking for the number of passed parameters in main. */
+  if (argc != 2) {
+    printf("[ERROR]: The wrong number of arguments was passed.\n");
+    exit(res);
+  }
+
+  if (strcmp(argv[1], "prec0") == 0) {
+    double x = 0;
+    int msg_id;
+
+    printf("TEST_PREC (Null pointers): ");
+    if ((solve_equation_prec(1, 2, 1, &x, NULL, QE_PREC_DOUBLE) ==
+         QE_ERR_NULLPTR) &&
+        (solve_equation_batch_prec(&x, &x, NULL, &x, &x, &msg_id, 1,
+                                   QE_PREC_DOUBLE) == QE_ERR_NULLPTR)) {
+      printf("[OK].\n");
+      res = 0;
+    } else
+      printf("[ERROR]: QE_ERR_NULLPTR was expected.\n");
+  }
+
+  /*
+   * Search for the desired structure by the test_id
+   * parameter received by the main function.
+   */
+  for (int i = 0; i < size; i++)
+    if (strcmp(argv[1], test_param_arr[i].test_id) == 0)
+      res = (test_param_arr[i].select != NULL) ? check_batch(i) : check(i);
+
+  return res;
+}
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input and compares the expected values
+ * with those obtained in the QE_PREC_DOUBLE mode.
+ * In case of an error, it returns 1.
+ */
+static int check(int test_num) {
+  test_param *t = &test_param_arr[test_num];
+  double res1, res2;
+  int msg_id;
+
+  printf("TEST_PREC_%d (%s): ", test_num, t->name);
+
+  msg_id = solve_equation_prec(t->a, t->b, t->c, &res1, &res2, QE_PREC_DOUBLE);
+
+  if ((msg_id == t->msg_id) && check_root(res1, t->res1) &&
+      check_root(res2, t->res2)) {
+    printf("[OK].\n");
+    return 0;
+  }
+
+  printf("[ERROR]:\n");
+  printf("\tParameters passed: a = %.17g   b = %.17g   c = %.17g\n", t->a,
+         t->b, t->c);
+  printf("\tReceived answer: res1 = %.17g   res2 = %.17g   msg[%d]\n", res1,
+         res2, msg_id);
+  printf("\tExpected answer: res1 = %.17g   res2 = %.17g   msg[%d]\n",
+         t->res1, t->res2, t->msg_id);
+  return 1;
+}
+
+/*
+ * The function checks that the root differs from the
+ * expected one by no more than PREC_ACCUR.
+ */
+static int check_root(double res, double true_res) {
+
+  if (true_res == 0)
+    return (res == 0) && !signbit(res);
+
+  return fabs(res - true_res) <= PREC_ACCUR * fabs(true_res);
+}
+
+/*
+ * The function solves the generated batch with every instruction
+ * set and compares the results with solve_equation_prec.
+ * In case of an error, it returns 1.
+ */
+static int check_batch(int test_num) {
+  size_t n = test_param_arr[test_num].size;
+  double *a, *b, *c, *res1, *res2;
+  int *msg_id;
+  int res = 0;
+
+  printf("TEST_PREC_%d (%s): ", test_num, test_param_arr[test_num].name);
+
+  a = malloc(n * sizeof(double));
+  b = malloc(n * sizeof(double));
+  c = malloc(n * sizeof(double));
+  res1 = malloc(n * sizeof(double));
+  res2 = malloc(n * sizeof(double));
+  msg_id = malloc(n * sizeof(int));
+  if (!a || !b || !c || !res1 || !res2 || !msg_id) {
+    printf("[ERROR]: Out of memory.\n");
+    exit(1);
+  }
+
+  for (size_t i = 0; i < n; i++)
+    test_param_arr[test_num].select(i, &a[i], &b[i], &c[i]);
+
+  for (int isa = QE_ISA_GENERIC; (isa <= QE_ISA_AVX512) && !res; isa++) {
+    int used = qe_batch_set_isa(isa);
+
+    solve_equation_batch_prec(a, b, c, res1, res2, msg_id, n, QE_PREC_DOUBLE);
+
+    for (size_t i = 0; (i < n) && !res; i++) {
+      double true_res1, true_res2;
+      int true_msg_id;
+
+      true_msg_id = solve_equation_prec(a[i], b[i], c[i], &true_res1,
+                                        &true_res2, QE_PREC_DOUBLE);
+
+      if ((msg_id[i] != true_msg_id) ||
+          (memcmp(&res1[i], &true_res1, sizeof(double)) != 0) ||
+          (memcmp(&res2[i], &true_res2, sizeof(double)) != 0)) {
+        printf("[ERROR]:\n");
+        printf("\tInstruction set: %s\n", qe_batch_isa_name(used));
+        printf("\tParameters passed: a = %A   b = %A   c = %A\n", a[i], b[i],
+               c[i]);
+        printf("\tReceived answer: res1 = %A   res2 = %A   msg[%d]\n",
+               res1[i], res2[i], msg_id[i]);
+        printf("\tExpected answer: res1 = %A   res2 = %A   msg[%d]\n",
+               true_res1, true_res2, true_msg_id);
+        res = 1;
+      }
+    }
+  }
+
+  free(a);
+  free(b);
+  free(c);
+  free(res1);
+  free(res2);
+  free(msg_id);
+
+  if (!res)
+    printf("[OK].\n");
+  return res;
+}
+
+/*
+ * Random parameters with random exponents, both inside
+ * and outside the range solved without scaling.
+ */
+static void select_scaled(size_t i, double *a, double *b, double *c) {
+  gen_uniform(i, a, b, c);
+  gen_scale(a, b, c, 600);
+}
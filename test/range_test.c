@@ -0,0 +1,307 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the tests for the
+ * root range queries (equation_has_root_in and
+ * select_equation_roots_in).
+ *
+ * Every test generates equations of its kind and, in both
+ * precision modes and with every instruction set, checks that
+ * select_equation_roots_in returns exactly the indices of the
+ * equations whose roots of solve_equation_prec lie in the
+ * interval. The test "range0" checks the passing of null
+ * pointers and empty intervals.
+ *
+-------------------------------------------------------------*/
+
+#include "quadratic_equation.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The kinds of the generated equations. */
+#define KIND_UNIFORM 0  /* Parameters from -1 to 1. */
+#define KIND_INTEGER 1  /* Small integers, many zeros. */
+#define KIND_ENDS 2     /* Roots a few units in the last place from lo, hi. */
+#define KIND_DOUBLE 3   /* Close to a double root. */
+#define KIND_EXPONENT 4 /* Exponents from -600 to 600. */
+#define KIND_SPECIAL 5  /* Infinities, NaN, zeros, huge and tiny values. */
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, selects the equations in the
+ * given precision mode and compares the result with the roots of
+ * solve_equation_prec. In case of an error, it returns 1.
+ */
+static int check(int test_num, int prec);
+
+/* A structure that describes a test. */
+typedef struct {
+  int kind;      /* The kind of the equations. */
+  size_t size;   /* The number of equations. */
+  double lo;     /* The lower end of the interval. */
+  double hi;     /* The upper end of the interval. */
+  char *name;    /* Name of the test. */
+  char *test_id; /* The test ID is needed to select a structure. */
+} test_param;
+
+/* An array of test_param type structures. */
+test_param test_param_arr[] = {
+    {.kind = KIND_UNIFORM,
+     .size = 100003,
+     .lo = -0.5,
+     .hi = 0.5,
+     .name = "Uniform parameters, [-0.5, 0.5].",
+     .test_id = "range1"},
+
+    {.kind = KIND_INTEGER,
+     .size = 50000,
+     .lo = -1,
+     .hi = 2,
+     .name = "Small integers, roots at the ends.",
+     .test_id = "range2"},
+
+    {.kind = KIND_ENDS,
+     .size = 100000,
+     .lo = -0.75,
+     .hi = 0.3,
+     .name = "Roots a few units in the last place from the ends.",
+     .test_id = "range3"},
+
+    {.kind = KIND_DOUBLE,
+     .size = 50001,
+     .lo = 0,
+     .hi = 1,
+     .name = "Near a double root.",
+     .test_id = "range4"},
+
+    {.kind = KIND_EXPONENT,
+     .size = 60000,
+     .lo = -1e-100,
+     .hi = 1e100,
+     .name = "Huge and tiny parameters.",
+     .test_id = "range5"},
+
+    {.kind = KIND_SPECIAL,
+     .size = 20000,
+     .lo = -2,
+     .hi = 1e-300,
+     .name = "Infinite and NaN parameters.",
+     .test_id = "range6"},
+
+    {.kind = KIND_UNIFORM,
+     .size = 30000,
+     .lo = -INFINITY,
+     .hi = -0.25,
+     .name = "An infinite lower end.",
+     .test_id = "range7"},
+
+    {.kind = KIND_INTEGER,
+     .size = 30000,
+     .lo = 0,
+     .hi = INFINITY,
+     .name = "An infinite upper end, the roots at zero.",
+     .test_id = "range8"},
+
+    {.kind = KIND_ENDS,
+     .size = 13,
+     .lo = 0.5,
+     .hi = 0.5,
+     .name = "A short batch and a point interval.",
+     .test_id = "range9"}};
+
+/*
+ * The main function receives one parameter as input.
+ * It is needed to compare with test_id and select
+ * the desired test.
+ */
+int main(int argc, char *argv[]) {
+
+  /*
+   * The value returned by the main function. In case of a
+   * failed test, the unchanged value of 1 will be returned.
+   */
+  int res = 1;
+
+  /* The number of elements in the test_param_arr array. */
+  int size = sizeof(test_param_arr) / sizeof(test_param_arr[0]);
+
+  /* Checking for the number of passed parameters in main. */
+  if (argc != 2) {
+    printf("[ERROR]: The wrong number of arguments was passed.\n");
+    exit(res);
+  }
+
+  if (strcmp(argv[1], "range0") == 0) {
+    double x = 0;
+    size_t idx, count = 1;
+
+    printf("TEST_RANGE (Null pointers, empty intervals): ");
+    if ((select_equation_roots_in(NULL, &x, &x, 0, 1, &idx, &count, 1,
+                                  QE_PREC_EXTENDED) == QE_ERR_NULLPTR) &&
+        (select_equation_roots_in(&x, &x, &x, 0, 1, NULL, &count, 1,
+                                  QE_PREC_DOUBLE) == QE_ERR_NULLPTR) &&
+        (select_equation_roots_in(&x, &x, &x, 0, 1, &idx, NULL, 1,
+                                  QE_PREC_DOUBLE) == QE_ERR_NULLPTR) &&
+        (select_equation_roots_in(&x, &x, &x, 1, 0, &idx, &count, 1,
+                                  QE_PREC_EXTENDED) == QE_BATCH_OK) &&
+        (count == 0) && (equation_has_root_in(0, 0, 0, 0, 0, 0) == 1) &&
+        (equation_has_root_in(0, 0, 0, NAN, 1, 0) == 0) &&
+        (equation_has_root_in(1, 0, -1, 1, 1, QE_PREC_DOUBLE) == 1)) {
+      printf("[OK].\n");
+      res = 0;
+    } else
+      printf("[ERROR]: QE_ERR_NULLPTR and empty intervals were expected.\n");
+  }
+
+  /*
+   * Search for the desired structure by the test_id
+   * parameter received by the main function.
+   */
+  for (int i = 0; i < size; i++)
+    if (strcmp(argv[1], test_param_arr[i].test_id) == 0)
+      res = check(i, QE_PREC_EXTENDED) | check(i, QE_PREC_DOUBLE);
+
+  return res;
+}
+
+/* The function returns a random number from -1 to 1. */
+static double rand_unit(void) { return 2.0 * rand() / RAND_MAX - 1.0; }
+
+/* The function generates the i-th equation of the kind. */
+static void generate(const test_param *t, size_t i, double *a, double *b,
+                     double *c) {
+  static const double special[] = {0,       -0.0,   INFINITY, -INFINITY,
+                                   NAN,     1e300,  -1e300,   1e-300,
+                                   DBL_MAX, DBL_MIN, 0x1p-1074, 1.5};
+  const size_t nspecial = sizeof(special) / sizeof(special[0]);
+  double r, s;
+
+  switch (t->kind) {
+  case KIND_UNIFORM:
+    *a = rand_unit();
+    *b = rand_unit();
+    *c = rand_unit();
+    break;
+  case KIND_INTEGER:
+    *a = rand() % 5 - 2;
+    *b = rand() % 5 - 2;
+    *c = rand() % 5 - 2;
+    break;
+  case KIND_ENDS:
+    /* a * (x - r) * (x - s) or b * (x - r), r is next to an end. */
+    r = (i % 2) ? t->lo : t->hi;
+    r += (double)(rand() % 9 - 4) * ldexp(fabs(r), -52);
+    s = 3 * rand_unit();
+    *a = (i % 5 == 0) ? 0 : rand_unit();
+    *b = (*a == 0) ? rand_unit() : -*a * (r + s);
+    *c = (*a == 0) ? -*b * r : *a * r * s;
+    break;
+  case KIND_DOUBLE:
+    /* a * (x - r)^2 with c moved by a few units in the last place. */
+    r = rand_unit();
+    *a = rand_unit();
+    *b = -2.0 * *a * r;
+    s = *a * r * r;
+    *c = s + (double)(rand() % 5 - 2) * ldexp(fabs(s), -52 - rand() % 12);
+    break;
+  case KIND_EXPONENT:
+    *a = ldexp(rand_unit(), rand() % 1201 - 600);
+    *b = ldexp(rand_unit(), rand() % 1201 - 600);
+    *c = ldexp(rand_unit(), rand() % 1201 - 600);
+    break;
+  default:
+    *a = (i % 3 == 0) ? special[rand() % nspecial] : rand_unit();
+    *b = (i % 3 == 1) ? special[rand() % nspecial] : rand_unit();
+    *c = special[rand() % nspecial];
+  }
+}
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, selects the equations in the
+ * given precision mode and compares the result with the roots of
+ * solve_equation_prec. In case of an error, it returns 1.
+ */
+static int check(int test_num, int prec) {
+  test_param *t = &test_param_arr[test_num];
+  double *a, *b, *c;
+  int *inside, res = 0;
+  size_t *idx;
+
+  printf("TEST_RANGE_%d (%s, %s): ", test_num, t->name,
+         (prec == QE_PREC_DOUBLE) ? "double" : "extended");
+
+  a = malloc(t->size * sizeof(double));
+  b = malloc(t->size * sizeof(double));
+  c = malloc(t->size * sizeof(double));
+  inside = malloc(t->size * sizeof(int));
+  idx = malloc(t->size * sizeof(size_t));
+  if (!a || !b || !c || !inside || !idx) {
+    printf("[ERROR]: Out of memory.\n");
+    exit(1);
+  }
+
+  srand(test_num);
+  for (size_t i = 0; i < t->size; i++) {
+    double res1, res2;
+    int msg_id;
+
+    generate(t, i, &a[i], &b[i], &c[i]);
+
+    /* The roots of solve_equation_prec, tested one by one. */
+    msg_id = solve_equation_prec(a[i], b[i], c[i], &res1, &res2, prec);
+    inside[i] = (msg_id == QE_OK_INF_RES) ||
+                (((msg_id == QE_OK_TWO_RES) || (msg_id == QE_OK_ONE_RES)) &&
+                 (((t->lo <= res1) && (res1 <= t->hi)) ||
+                  ((t->lo <= res2) && (res2 <= t->hi))));
+    if (equation_has_root_in(a[i], b[i], c[i], t->lo, t->hi, prec) !=
+        inside[i]) {
+      printf("[ERROR]: equation_has_root_in is wrong for the equation "
+             "%zu.\n",
+             i);
+      res = 1;
+      break;
+    }
+  }
+
+  /*
+   * Every instruction set is checked. If the processor does
+   * not support one, the previous one is checked again.
+   */
+  for (int isa = QE_ISA_GENERIC; (isa <= QE_ISA_AVX512) && !res; isa++) {
+    size_t count = t->size + 1, k = 0;
+
+    qe_batch_set_isa(isa);
+    select_equation_roots_in(a, b, c, t->lo, t->hi, idx, &count, t->size,
+                             prec);
+
+    for (size_t i = 0; (i < t->size) && !res; i++)
+      if (inside[i] && ((k >= count) || (idx[k++] != i))) {
+        printf("[ERROR]:\n");
+        printf("\tInstruction set %d, equation %zu: a = %A   b = %A   "
+               "c = %A\n",
+               isa, i, a[i], b[i], c[i]);
+        printf("\tIt has a root in [%A, %A], but was not selected.\n",
+               t->lo, t->hi);
+        res = 1;
+      }
+    if (!res && (k != count)) {
+      printf("[ERROR]: Instruction set %d, %zu equations selected, %zu "
+             "expected.\n",
+             isa, count, k);
+      res = 1;
+    }
+  }
+
+  free(a);
+  free(b);
+  free(c);
+  free(inside);
+  free(idx);
+
+  if (!res)
+    printf("[OK].\n");
+  return res;
+}
@@ -0,0 +1,419 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the tests for the
+ * fused batch functions (solve_equation_batch_reduce and
+ * solve_equation_batch_reduce_parallel).
+ *
+ * Every test generates equations of its kind, solves them by
+ * solve_equation_batch_prec and computes the aggregates of the
+ * results one by one. Then the equations are reduced by the fused
+ * functions, by parts of different sizes, and the aggregates must
+ * be the same: exactly, except the sum of the parallel variant,
+ * which is added in another order. The test "reduce0" checks the
+ * passing of null pointers and of a histogram without bins.
+ *
+-------------------------------------------------------------*/
+
+#include "qe_pool.h"
+#include "qe_reduce.h"
+#include "quadratic_equation.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The kinds of the generated equations. */
+#define KIND_UNIFORM 0  /* Parameters from -1 to 1. */
+#define KIND_INTEGER 1  /* Small integers, many zeros. */
+#define KIND_EXPONENT 2 /* Exponents from -600 to 600. */
+#define KIND_SPECIAL 3  /* Infinities, NaN, zeros, huge and tiny values. */
+
+/* All the reducers. */
+#define ALL_REDUCERS                                                       \
+  (QE_REDUCE_COUNTS | QE_REDUCE_MINMAX | QE_REDUCE_SUM | QE_REDUCE_HIST)
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, reduces the equations in the
+ * given precision mode and compares the aggregates with the ones
+ * of the solved arrays. In case of an error, it returns 1.
+ */
+static int check(int test_num, int prec);
+
+/* A structure that describes a test. */
+typedef struct {
+  int kind;          /* The kind of the equations. */
+  size_t size;       /* The number of equations. */
+  size_t part;       /* The equations passed to one call. */
+  unsigned int what; /* The reducers. */
+  double hist_lo;    /* The range of the histogram. */
+  double hist_hi;
+  size_t nbins;      /* The bins of the histogram. */
+  int nthreads;      /* Threads of the pool, 0 for the sequential function. */
+  char *name;        /* Name of the test. */
+  char *test_id;     /* The test ID is needed to select a structure. */
+} test_param;
+
+/* An array of test_param type structures. */
+test_param test_param_arr[] = {
+    {.kind = KIND_UNIFORM,
+     .size = 100003,
+     .part = 100003,
+     .what = ALL_REDUCERS,
+     .hist_lo = -4,
+     .hist_hi = 4,
+     .nbins = 64,
+     .nthreads = 0,
+     .name = "Uniform parameters, all the reducers.",
+     .test_id = "reduce1"},
+
+    {.kind = KIND_INTEGER,
+     .size = 50000,
+     .part = 777,
+     .what = QE_REDUCE_COUNTS | QE_REDUCE_HIST,
+     .hist_lo = -2,
+     .hist_hi = 2,
+     .nbins = 4,
+     .nthreads = 0,
+     .name = "Small integers by parts, roots at the edges of the bins.",
+     .test_id = "reduce2"},
+
+    {.kind = KIND_EXPONENT,
+     .size = 60000,
+     .part = 60000,
+     .what = QE_REDUCE_MINMAX | QE_REDUCE_SUM,
+     .hist_lo = 0,
+     .hist_hi = 0,
+     .nbins = 0,
+     .nthreads = 0,
+     .name = "Huge and tiny parameters.",
+     .test_id = "reduce3"},
+
+    {.kind = KIND_SPECIAL,
+     .size = 20000,
+     .part = 1000,
+     .what = ALL_REDUCERS,
+     .hist_lo = -1e300,
+     .hist_hi = 1e300,
+     .nbins = 7,
+     .nthreads = 0,
+     .name = "Infinite and NaN parameters.",
+     .test_id = "reduce4"},
+
+    {.kind = KIND_UNIFORM,
+     .size = 1000003,
+     .part = 1000003,
+     .what = ALL_REDUCERS,
+     .hist_lo = -1,
+     .hist_hi = 1,
+     .nbins = 1000,
+     .nthreads = 4,
+     .name = "A pool of 4 threads, all the reducers.",
+     .test_id = "reduce5"},
+
+    {.kind = KIND_EXPONENT,
+     .size = 300000,
+     .part = 70001,
+     .what = QE_REDUCE_COUNTS | QE_REDUCE_MINMAX,
+     .hist_lo = 0,
+     .hist_hi = 0,
+     .nbins = 0,
+     .nthreads = 3,
+     .name = "A pool of 3 threads by parts.",
+     .test_id = "reduce6"},
+
+    {.kind = KIND_INTEGER,
+     .size = 13,
+     .part = 13,
+     .what = ALL_REDUCERS,
+     .hist_lo = -3,
+     .hist_hi = 3,
+     .nbins = 3,
+     .nthreads = 2,
+     .name = "A batch shorter than a chunk of the pool.",
+     .test_id = "reduce7"},
+
+    {.kind = KIND_UNIFORM,
+     .size = 200000,
+     .part = 3001,
+     .what = QE_REDUCE_SUM | QE_REDUCE_HIST,
+     .hist_lo = -8,
+     .hist_hi = 8,
+     .nbins = 5000,
+     .nthreads = 0,
+     .name = "More bins than the local histogram holds, by parts.",
+     .test_id = "reduce8"}};
+
+/*
+ * The main function receives one parameter as input.
+ * It is needed to compare with test_id and select
+ * the desired test.
+ */
+int main(int argc, char *argv[]) {
+
+  /*
+   * The value returned by the main function. In case of a
+   * failed test, the unchanged value of 1 will be returned.
+   */
+  int res = 1;
+
+  /* The number of elements in the test_param_arr array. */
+  int size = sizeof(test_param_arr) / sizeof(test_param_arr[0]);
+
+  /* Checking for the number of passed parameters in main. */
+  if (argc != 2) {
+    printf("[ERROR]: The wrong number of arguments was passed.\n");
+    exit(res);
+  }
+
+  if (strcmp(argv[1], "reduce0") == 0) {
+    double x = 1;
+    unsigned long long bins[2];
+    qe_reduce r = {.what = QE_REDUCE_HIST, .hist_lo = 0, .hist_hi = 1,
+                   .nbins = 2, .bins = NULL};
+    int ok;
+
+    printf("TEST_REDUCE (Null pointers, a histogram without bins): ");
+    qe_reduce_reset(&r);
+    ok = (solve_equation_batch_reduce(&x, &x, &x, &r, 1, QE_PREC_DOUBLE) ==
+          QE_ERR_NULLPTR) &&
+         (solve_equation_batch_reduce_parallel(NULL, &x, &x, &x, &r, 1,
+                                               QE_PREC_EXTENDED) ==
+          QE_ERR_NULLPTR);
+
+    /* An empty range of the histogram. */
+    r.bins = bins;
+    r.hist_hi = 0;
+    ok = ok && (solve_equation_batch_reduce(&x, &x, &x, &r, 1,
+                                            QE_PREC_DOUBLE) == QE_ERR_NULLPTR);
+
+    r.hist_hi = 1;
+    ok = ok &&
+         (solve_equation_batch_reduce(NULL, &x, &x, &r, 1, QE_PREC_DOUBLE) ==
+          QE_ERR_NULLPTR) &&
+         (solve_equation_batch_reduce(&x, &x, &x, NULL, 1, QE_PREC_DOUBLE) ==
+          QE_ERR_NULLPTR) &&
+         (solve_equation_batch_reduce_parallel(NULL, &x, NULL, &x, &r, 1,
+                                               QE_PREC_DOUBLE) ==
+          QE_ERR_NULLPTR) &&
+         (solve_equation_batch_reduce(&x, &x, &x, &r, 0, QE_PREC_DOUBLE) ==
+          QE_BATCH_OK) &&
+         (r.min_root == INFINITY) && (r.max_root == -INFINITY);
+
+    if (ok) {
+      printf("[OK].\n");
+      res = 0;
+    } else
+      printf("[ERROR]: QE_ERR_NULLPTR was expected.\n");
+  }
+
+  /*
+   * Search for the desired structure by the test_id
+   * parameter received by the main function.
+   */
+  for (int i = 0; i < size; i++)
+    if (strcmp(argv[1], test_param_arr[i].test_id) == 0)
+      res = check(i, QE_PREC_EXTENDED) | check(i, QE_PREC_DOUBLE);
+
+  return res;
+}
+
+/* The function returns a random number from -1 to 1. */
+static double rand_unit(void) { return 2.0 * rand() / RAND_MAX - 1.0; }
+
+/* The function generates the i-th equation of the kind. */
+static void generate(int kind, size_t i, double *a, double *b, double *c) {
+  static const double special[] = {0,       -0.0,   INFINITY, -INFINITY,
+                                   NAN,     1e300,  -1e300,   1e-300,
+                                   DBL_MAX, DBL_MIN, 0x1p-1074, 1.5};
+  const size_t nspecial = sizeof(special) / sizeof(special[0]);
+
+  switch (kind) {
+  case KIND_UNIFORM:
+    *a = rand_unit();
+    *b = rand_unit();
+    *c = rand_unit();
+    break;
+  case KIND_INTEGER:
+    *a = rand() % 5 - 2;
+    *b = rand() % 5 - 2;
+    *c = rand() % 5 - 2;
+    break;
+  case KIND_EXPONENT:
+    *a = ldexp(rand_unit(), rand() % 1201 - 600);
+    *b = ldexp(rand_unit(), rand() % 1201 - 600);
+    *c = ldexp(rand_unit(), rand() % 1201 - 600);
+    break;
+  default:
+    *a = (i % 3 == 0) ? special[rand() % nspecial] : rand_unit();
+    *b = (i % 3 == 1) ? special[rand() % nspecial] : rand_unit();
+    *c = special[rand() % nspecial];
+  }
+}
+
+/*
+ * The function computes the aggregates of the solved equations one
+ * by one, as described in qe_reduce.h.
+ */
+static void reference(const test_param *t, const double *res1,
+                      const double *res2, const int *msg_id, qe_reduce *r,
+                      double *abs_sum) {
+  *abs_sum = 0;
+  for (size_t i = 0; i < t->size; i++) {
+    int nroots = (msg_id[i] == QE_OK_TWO_RES)   ? 2
+                 : (msg_id[i] == QE_OK_ONE_RES) ? 1
+                                                : 0;
+
+    r->counts[msg_id[i] - QE_ERR_NULLPTR]++;
+    if (nroots == 0)
+      continue;
+
+    r->nroots += (unsigned long long)nroots;
+    r->min_root = fmin(r->min_root, fmin(res1[i], res2[i]));
+    r->max_root = fmax(r->max_root, fmax(res1[i], res2[i]));
+    if (!isnan(fmax(res1[i], res2[i]))) {
+      r->sum_larger += fmax(res1[i], res2[i]);
+      *abs_sum += fabs(fmax(res1[i], res2[i]));
+    }
+
+    for (int k = 0; (k < nroots) && (t->nbins > 0); k++) {
+      double x = k ? res2[i] : res1[i];
+
+      if (isnan(x))
+        continue;
+      if (x < t->hist_lo)
+        r->below++;
+      else if (x >= t->hist_hi)
+        r->above++;
+      else {
+        /* The bin as defined in qe_reduce.h. */
+        double s = (double)t->nbins / (t->hist_hi - t->hist_lo);
+        size_t j = (size_t)((x - t->hist_lo) * s);
+
+        r->bins[(j < t->nbins) ? j : t->nbins - 1]++;
+      }
+    }
+  }
+}
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, reduces the equations in the
+ * given precision mode and compares the aggregates with the ones
+ * of the solved arrays. In case of an error, it returns 1.
+ */
+static int check(int test_num, int prec) {
+  test_param *t = &test_param_arr[test_num];
+  double *a, *b, *c, *res1, *res2, abs_sum;
+  unsigned long long *bins, *true_bins;
+  int *msg_id, res = 0;
+  qe_reduce r, ref;
+  qe_pool *pool = NULL;
+
+  printf("TEST_REDUCE_%d (%s, %s): ", test_num, t->name,
+         (prec == QE_PREC_DOUBLE) ? "double" : "extended");
+
+  a = malloc(t->size * sizeof(double));
+  b = malloc(t->size * sizeof(double));
+  c = malloc(t->size * sizeof(double));
+  res1 = malloc(t->size * sizeof(double));
+  res2 = malloc(t->size * sizeof(double));
+  msg_id = malloc(t->size * sizeof(int));
+  bins = malloc((t->nbins + 1) * sizeof(unsigned long long));
+  true_bins = malloc((t->nbins + 1) * sizeof(unsigned long long));
+  if (!a || !b || !c || !res1 || !res2 || !msg_id || !bins || !true_bins) {
+    printf("[ERROR]: Out of memory.\n");
+    exit(1);
+  }
+
+  srand(test_num);
+  for (size_t i = 0; i < t->size; i++)
+    generate(t->kind, i, &a[i], &b[i], &c[i]);
+  solve_equation_batch_prec(a, b, c, res1, res2, msg_id, t->size, prec);
+
+  ref.what = ALL_REDUCERS;
+  ref.hist_lo = t->hist_lo;
+  ref.hist_hi = t->hist_hi;
+  ref.nbins = t->nbins + 1;
+  ref.bins = true_bins;
+  qe_reduce_reset(&ref);
+  reference(t, res1, res2, msg_id, &ref, &abs_sum);
+
+  r.what = t->what;
+  r.hist_lo = t->hist_lo;
+  r.hist_hi = t->hist_hi;
+  r.nbins = t->nbins;
+  r.bins = bins;
+  qe_reduce_reset(&r);
+
+  if (t->nthreads > 0)
+    pool = qe_pool_create(t->nthreads, 0);
+  for (size_t i = 0; i < t->size; i += t->part) {
+    size_t m = (t->size - i < t->part) ? t->size - i : t->part;
+
+    if (((pool != NULL)
+             ? solve_equation_batch_reduce_parallel(pool, a + i, b + i, c + i,
+                                                    &r, m, prec)
+             : solve_equation_batch_reduce(a + i, b + i, c + i, &r, m,
+                                           prec)) != QE_BATCH_OK)
+      res = 1;
+  }
+  if (pool != NULL)
+    qe_pool_destroy(pool);
+
+  /* The aggregates of the selected reducers. */
+  if ((t->what & QE_REDUCE_COUNTS) &&
+      (memcmp(r.counts, ref.counts, sizeof(r.counts)) != 0)) {
+    printf("[ERROR]: The counts differ.\n");
+    res = 1;
+  }
+  if ((t->what & QE_REDUCE_MINMAX) &&
+      ((r.nroots != ref.nroots) || (r.min_root != ref.min_root) ||
+       (r.max_root != ref.max_root))) {
+    printf("[ERROR]: %llu roots from %A to %A, expected %llu from %A to "
+           "%A.\n",
+           r.nroots, r.min_root, r.max_root, ref.nroots, ref.min_root,
+           ref.max_root);
+    res = 1;
+  }
+  if ((t->what & QE_REDUCE_SUM) &&
+      (isfinite(ref.sum_larger)
+           ? !(fabs((r.sum_larger + r.sum_err) - ref.sum_larger) <=
+               1e-12 * abs_sum)
+           : ((r.sum_larger != ref.sum_larger) &&
+              !(isnan(r.sum_larger) && isnan(ref.sum_larger))))) {
+    printf("[ERROR]: The sum %A, expected %A.\n", r.sum_larger,
+           ref.sum_larger);
+    res = 1;
+  }
+  if ((t->what & QE_REDUCE_HIST) &&
+      ((r.below != ref.below) || (r.above != ref.above) ||
+       (memcmp(bins, true_bins, t->nbins * sizeof(bins[0])) != 0))) {
+    printf("[ERROR]: The histogram differs (%llu below, %llu above, "
+           "expected %llu and %llu).\n",
+           r.below, r.above, ref.below, ref.above);
+    res = 1;
+  }
+
+  /* The reducers that are not selected are left clear. */
+  if ((!(t->what & QE_REDUCE_COUNTS) && (r.counts[2] != 0)) ||
+      (!(t->what & QE_REDUCE_MINMAX) && (r.nroots != 0)) ||
+      (!(t->what & QE_REDUCE_SUM) && (r.sum_larger != 0))) {
+    printf("[ERROR]: A reducer that was not selected was written.\n");
+    res = 1;
+  }
+
+  free(a);
+  free(b);
+  free(c);
+  free(res1);
+  free(res2);
+  free(msg_id);
+  free(bins);
+  free(true_bins);
+
+  if (!res)
+    printf("[OK].\n");
+  return res;
+}
@@ -0,0 +1,461 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the tests for the
+ * server of the qe_served daemon and its client.
+ *
+ * Every test runs the server in a thread on a socket in /tmp.
+ * The test "served0" checks the passing of null pointers, a
+ * connection to a missing socket and a socket path taken by a
+ * regular file (it must be kept), "served1" sends frames by
+ * hand: several frames before the replies, an empty frame, a
+ * half-closed connection and a malformed frame, "served6" starts
+ * a second server on the socket of a running one (it must fail and
+ * keep the socket) and one on a stale socket. The other tests
+ * solve random equations from several client threads and check
+ * that the results are bit-identical to the results of
+ * solve_equation_batch_prec.
+ *
+-------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include "qe_served.h"
+#include "quadratic_equation.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, solves the equations through
+ * the server and compares the results. In case of an error,
+ * it returns 1.
+ */
+static int check(int test_num);
+
+/* The function checks the frames sent by hand. */
+static int check_frames(void);
+
+/* The function starts two servers on the same socket path. */
+static int check_second(void);
+
+/*
+ * A structure that describes a test: the clients and
+ * the equations that each of them solves.
+ */
+typedef struct {
+  int nclients;  /* Client threads, each with its own connection. */
+  size_t calls;  /* Calls of qe_client_solve of every client. */
+  size_t size;   /* Equations of every call. */
+  int prec;      /* Precision mode. */
+  char *name;    /* Name of the test. */
+  char *test_id; /* The test ID is needed to select a structure. */
+} test_param;
+
+/* An array of test_param type structures. */
+test_param test_param_arr[] = {
+    {.nclients = 1,
+     .calls = 1,
+     .size = 100003,
+     .prec = QE_PREC_EXTENDED,
+     .name = "One client, two frames.",
+     .test_id = "served2"},
+
+    {.nclients = 16,
+     .calls = 500,
+     .size = 7,
+     .prec = QE_PREC_DOUBLE,
+     .name = "Sixteen clients with small frames.",
+     .test_id = "served3"},
+
+    {.nclients = 4,
+     .calls = 2,
+     .size = 200003,
+     .prec = QE_PREC_EXTENDED,
+     .name = "Four clients with large frames.",
+     .test_id = "served4"},
+
+    {.nclients = 64,
+     .calls = 50,
+     .size = 1,
+     .prec = QE_PREC_EXTENDED,
+     .name = "Sixty-four clients with one equation.",
+     .test_id = "served5"}};
+
+/* The socket of the server of the test. */
+static char socket_path[64];
+
+/* The server thread. */
+static void *server_main(void *srv) {
+  if (qe_server_run(srv) != 0)
+    printf("[ERROR]: The event loop failed.\n");
+  return NULL;
+}
+
+/* The function starts the server in a thread. */
+static qe_server *start_server(pthread_t *thread) {
+  qe_server *srv;
+
+  snprintf(socket_path, sizeof(socket_path), "/tmp/qe_served_test_%d.sock",
+           (int)getpid());
+  srv = qe_server_create(socket_path);
+  if (srv == NULL) {
+    printf("[ERROR]: The server was not created.\n");
+    exit(1);
+  }
+
+  pthread_create(thread, NULL, server_main, srv);
+  return srv;
+}
+
+/* The function stops the server and waits for its thread. */
+static void stop_server(qe_server *srv, pthread_t thread) {
+  qe_server_stop(srv);
+  pthread_join(thread, NULL);
+  qe_server_destroy(srv);
+}
+
+/*
+ * The main function receives one parameter as input.
+ * It is needed to compare with test_id and select
+ * the desired test.
+ */
+int main(int argc, char *argv[]) {
+
+  /*
+   * The value returned by the main function. In case of a
+   * failed test, the unchanged value of 1 will be returned.
+   */
+  int res = 1;
+
+  /* The number of elements in the test_param_arr array. */
+  int size = sizeof(test_param_arr) / sizeof(test_param_arr[0]);
+
+  /* Checking for the number of passed parameters in main. */
+  if (argc != 2) {
+    printf("[ERROR]: The wrong number of arguments was passed.\n");
+    exit(res);
+  }
+
+  if (strcmp(argv[1], "served0") == 0) {
+    const char *file = "/tmp/qe_served_test_file";
+    FILE *f = fopen(file, "w");
+    double x = 0;
+    int msg_id;
+
+    if (f != NULL)
+      fclose(f);
+
+    printf("TEST_SERVED (Null pointers, a missing socket, a file): ");
+    if ((qe_client_solve(NULL, &x, &x, &x, &x, &x, &msg_id, 1,
+                         QE_PREC_EXTENDED) == QE_ERR_NULLPTR) &&
+        (qe_client_connect("/tmp/qe_served_test_missing.sock") == NULL) &&
+        (qe_server_create(NULL) == NULL) && (f != NULL) &&
+        (qe_server_create(file) == NULL) && (access(file, F_OK) == 0)) {
+      printf("[OK].\n");
+      res = 0;
+    } else
+      printf("[ERROR]: QE_ERR_NULLPTR and NULL were expected.\n");
+    unlink(file);
+  }
+
+  if (strcmp(argv[1], "served1") == 0)
+    res = check_frames();
+
+  if (strcmp(argv[1], "served6") == 0)
+    res = check_second();
+
+  /*
+   * Search for the desired structure by the test_id
+   * parameter received by the main function.
+   */
+  for (int i = 0; i < size; i++)
+    if (strcmp(argv[1], test_param_arr[i].test_id) == 0)
+      res = check(i);
+
+  return res;
+}
+
+/* The equations and the results of a client thread. */
+typedef struct {
+  const test_param *t;
+  double *a, *b, *c, *res1, *res2;
+  int *msg_id;
+  int failed;
+} client_arg;
+
+/* A client thread: solves its equations call by call. */
+static void *client_main(void *p) {
+  client_arg *arg = p;
+  const test_param *t = arg->t;
+  qe_client *cl = qe_client_connect(socket_path);
+
+  if (cl == NULL) {
+    arg->failed = 1;
+    return NULL;
+  }
+
+  for (size_t k = 0; (k < t->calls) && !arg->failed; k++) {
+    size_t i = k * t->size;
+
+    if (qe_client_solve(cl, arg->a + i, arg->b + i, arg->c + i, arg->res1 + i,
+                        arg->res2 + i, arg->msg_id + i, t->size,
+                        t->prec) != QE_BATCH_OK)
+      arg->failed = 1;
+  }
+
+  qe_client_close(cl);
+  return NULL;
+}
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, solves the equations through
+ * the server and compares the results. In case of an error,
+ * it returns 1.
+ */
+static int check(int test_num) {
+  test_param *t = &test_param_arr[test_num];
+  size_t n = t->calls * t->size;
+  client_arg args[64];
+  pthread_t threads[64], server;
+  double *true_res1, *true_res2;
+  int *true_msg_id;
+  qe_server *srv;
+  int res = 0;
+
+  printf("TEST_SERVED_%d (%s): ", test_num, t->name);
+
+  true_res1 = malloc((n + 1) * sizeof(double));
+  true_res2 = malloc((n + 1) * sizeof(double));
+  true_msg_id = malloc((n + 1) * sizeof(int));
+  for (int j = 0; j < t->nclients; j++) {
+    client_arg *arg = &args[j];
+
+    arg->t = t;
+    arg->failed = 0;
+    arg->a = malloc((n + 1) * sizeof(double));
+    arg->b = malloc((n + 1) * sizeof(double));
+    arg->c = malloc((n + 1) * sizeof(double));
+    arg->res1 = malloc((n + 1) * sizeof(double));
+    arg->res2 = malloc((n + 1) * sizeof(double));
+    arg->msg_id = malloc((n + 1) * sizeof(int));
+    if (!arg->a || !arg->b || !arg->c || !arg->res1 || !arg->res2 ||
+        !arg->msg_id) {
+      printf("[ERROR]: Out of memory.\n");
+      exit(1);
+    }
+
+    /* Random parameters from -1 to 1, every tenth `a` is zero. */
+    for (size_t i = 0; i < n; i++) {
+      arg->a[i] = (i % 10 == 0) ? 0 : 2.0 * rand() / RAND_MAX - 1.0;
+      arg->b[i] = 2.0 * rand() / RAND_MAX - 1.0;
+      arg->c[i] = 2.0 * rand() / RAND_MAX - 1.0;
+    }
+  }
+  if (!true_res1 || !true_res2 || !true_msg_id) {
+    printf("[ERROR]: Out of memory.\n");
+    exit(1);
+  }
+
+  srv = start_server(&server);
+  for (int j = 0; j < t->nclients; j++)
+    pthread_create(&threads[j], NULL, client_main, &args[j]);
+  for (int j = 0; j < t->nclients; j++)
+    pthread_join(threads[j], NULL);
+  stop_server(srv, server);
+
+  for (int j = 0; (j < t->nclients) && !res; j++) {
+    client_arg *arg = &args[j];
+
+    if (arg->failed) {
+      printf("[ERROR]: The client %d failed.\n", j);
+      res = 1;
+      break;
+    }
+
+    solve_equation_batch_prec(arg->a, arg->b, arg->c, true_res1, true_res2,
+                              true_msg_id, n, t->prec);
+    for (size_t i = 0; (i < n) && !res; i++)
+      if ((arg->msg_id[i] != true_msg_id[i]) ||
+          (memcmp(&arg->res1[i], &true_res1[i], sizeof(double)) != 0) ||
+          (memcmp(&arg->res2[i], &true_res2[i], sizeof(double)) != 0)) {
+        printf("[ERROR]:\n");
+        printf("\tEquation %zu: a = %A   b = %A   c = %A\n", i, arg->a[i],
+               arg->b[i], arg->c[i]);
+        printf("\tReceived answer: res1 = %A   res2 = %A   msg[%d]\n",
+               arg->res1[i], arg->res2[i], arg->msg_id[i]);
+        printf("\tExpected answer: res1 = %A   res2 = %A   msg[%d]\n",
+               true_res1[i], true_res2[i], true_msg_id[i]);
+        res = 1;
+      }
+  }
+
+  for (int j = 0; j < t->nclients; j++) {
+    free(args[j].a);
+    free(args[j].b);
+    free(args[j].c);
+    free(args[j].res1);
+    free(args[j].res2);
+    free(args[j].msg_id);
+  }
+  free(true_res1);
+  free(true_res2);
+  free(true_msg_id);
+
+  if (!res)
+    printf("[OK].\n");
+  return res;
+}
+
+/* The function connects a raw socket to the server. */
+static int raw_connect(void) {
+  struct sockaddr_un addr;
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, socket_path);
+  if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    printf("[ERROR]: The connection failed.\n");
+    exit(1);
+  }
+  return fd;
+}
+
+/*
+ * The function reads the reply to the frame with the equation
+ * x^2 - (k + 1) * x + k = 0 (the roots k and 1). Returns 1 if it
+ * is correct.
+ */
+static int read_reply(int fd, double k) {
+  qe_served_header h;
+  qe_served_res r;
+
+  return (recv(fd, &h, sizeof(h), MSG_WAITALL) == sizeof(h)) &&
+         (h.magic == QE_SERVED_MAGIC) && (h.n == 1) &&
+         (recv(fd, &r, sizeof(r), MSG_WAITALL) == sizeof(r)) &&
+         (r.msg_id == QE_OK_TWO_RES) && (r.res1 == k) && (r.res2 == 1);
+}
+
+/* The function checks the frames sent by hand. */
+static int check_frames(void) {
+  qe_served_header h = {QE_SERVED_MAGIC, 1, QE_PREC_DOUBLE, 0};
+  pthread_t server;
+  qe_server *srv = start_server(&server);
+  char byte;
+  int fd, ok = 1;
+
+  printf("TEST_SERVED (Frames sent by hand): ");
+
+  /* Three frames at once, the last one sent in two parts. */
+  fd = raw_connect();
+  for (int k = 2; k <= 4; k++) {
+    qe_served_eq eq = {1, -(k + 1), k};
+
+    send(fd, &h, sizeof(h), 0);
+    if (k == 4)
+      usleep(10000);
+    send(fd, &eq, sizeof(eq), 0);
+  }
+  for (int k = 2; k <= 4; k++)
+    ok = ok && read_reply(fd, k);
+
+  /* An empty frame gets an empty reply. */
+  h.n = 0;
+  send(fd, &h, sizeof(h), 0);
+  ok = ok && (recv(fd, &h, sizeof(h), MSG_WAITALL) == sizeof(h)) &&
+       (h.magic == QE_SERVED_MAGIC) && (h.n == 0);
+  h.n = 1;
+  h.prec = QE_PREC_DOUBLE;
+
+  /* The reply comes after the client closed its side. */
+  {
+    qe_served_eq eq = {1, -6, 5};
+
+    send(fd, &h, sizeof(h), 0);
+    send(fd, &eq, sizeof(eq), 0);
+    shutdown(fd, SHUT_WR);
+    ok = ok && read_reply(fd, 5) && (recv(fd, &byte, 1, 0) == 0);
+    close(fd);
+  }
+
+  /* A wrong magic value closes the connection. */
+  fd = raw_connect();
+  h.magic = 0;
+  send(fd, &h, sizeof(h), 0);
+  ok = ok && (recv(fd, &byte, 1, 0) == 0);
+  close(fd);
+
+  stop_server(srv, server);
+  if (ok)
+    printf("[OK].\n");
+  else
+    printf("[ERROR]: A wrong reply was received.\n");
+  return !ok;
+}
+
+/*
+ * The function starts two servers on the same socket path: the
+ * second one must fail with EADDRINUSE and leave the socket of the
+ * first one, which still serves a client. Then a socket file that
+ * nobody listens on must be replaced. In case of an error, it
+ * returns 1.
+ */
+static int check_second(void) {
+  struct sockaddr_un addr;
+  pthread_t thread;
+  qe_server *srv = start_server(&thread), *second;
+  qe_client *cl;
+  double a = 1, b = -3, c = 2, res1 = 0, res2 = 0;
+  int msg_id = 0, fd, err, res = 0;
+
+  printf("TEST_SERVED (A second server on the same socket): ");
+
+  second = qe_server_create(socket_path);
+  err = errno;
+  cl = qe_client_connect(socket_path);
+  if ((second != NULL) || (err != EADDRINUSE) || (cl == NULL) ||
+      (qe_client_solve(cl, &a, &b, &c, &res1, &res2, &msg_id, 1,
+                       QE_PREC_EXTENDED) != QE_BATCH_OK) ||
+      (msg_id != QE_OK_TWO_RES) || (res1 != 2) || (res2 != 1)) {
+    printf("[ERROR]: The second server took the socket of the first.\n");
+    res = 1;
+  }
+  if (second != NULL)
+    qe_server_destroy(second);
+  qe_client_close(cl);
+  stop_server(srv, thread);
+
+  /* A socket bound and closed without listening is stale. */
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, socket_path);
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (!res && ((fd < 0) ||
+               (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0))) {
+    printf("[ERROR]: The stale socket was not created.\n");
+    res = 1;
+  }
+  if (fd >= 0)
+    close(fd);
+
+  if (!res) {
+    srv = qe_server_create(socket_path);
+    if (srv == NULL) {
+      printf("[ERROR]: The stale socket was not replaced.\n");
+      res = 1;
+    } else
+      qe_server_destroy(srv);
+  }
+
+  unlink(socket_path);
+  if (!res)
+    printf("[OK].\n");
+  return res;
+}
@@ -0,0 +1,267 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the tests for the
+ * shared-memory channel (qe_shm).
+ *
+ * The test "shm0" checks the passing of null pointers, of a
+ * descriptor that is not a region and of a batch larger than the
+ * region. The other tests fork a solver process that maps the
+ * region by qe_shm_open and serves it; the test process writes
+ * batches of random equations into the region and checks that the
+ * results are bit-identical to the results of
+ * solve_equation_batch_prec. The test "shm5" shuts the channel
+ * down right after the last submit, before the wait.
+ *
+-------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include "qe_pool.h"
+#include "qe_shm.h"
+#include "quadratic_equation.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, solves the batches through the
+ * solver process and compares the results. In case of an error,
+ * it returns 1.
+ */
+static int check(int test_num);
+
+/*
+ * A structure that describes a test: the region and the batches
+ * passed through it.
+ */
+typedef struct {
+  size_t capacity; /* Equations in the region. */
+  size_t batches;  /* Batches submitted one after another. */
+  size_t size;     /* Largest batch, the k-th one has size - k % size. */
+  int prec;        /* Precision mode. */
+  int nthreads;    /* Threads of the pool of the solver, 0 for none. */
+  int early;       /* The last batch is followed by the shutdown. */
+  char *name;      /* Name of the test. */
+  char *test_id;   /* The test ID is needed to select a structure. */
+} test_param;
+
+/* An array of test_param type structures. */
+test_param test_param_arr[] = {
+    {.capacity = 1000,
+     .batches = 1,
+     .size = 1000,
+     .prec = QE_PREC_EXTENDED,
+     .nthreads = 0,
+     .name = "One full batch.",
+     .test_id = "shm1"},
+
+    {.capacity = 64,
+     .batches = 20000,
+     .size = 64,
+     .prec = QE_PREC_DOUBLE,
+     .nthreads = 0,
+     .name = "Many small batches.",
+     .test_id = "shm2"},
+
+    {.capacity = 1 << 21,
+     .batches = 2,
+     .size = 1 << 21,
+     .prec = QE_PREC_EXTENDED,
+     .nthreads = 4,
+     .name = "Large batches solved by a pool.",
+     .test_id = "shm3"},
+
+    {.capacity = 100003,
+     .batches = 10,
+     .size = 100003,
+     .prec = QE_PREC_DOUBLE,
+     .nthreads = 2,
+     .name = "Batches of different sizes solved by a pool.",
+     .test_id = "shm4"},
+
+    {.capacity = 1000,
+     .batches = 3,
+     .size = 1000,
+     .prec = QE_PREC_DOUBLE,
+     .nthreads = 0,
+     .early = 1,
+     .name = "The shutdown right after the last submit.",
+     .test_id = "shm5"}};
+
+/*
+ * The main function receives one parameter as input.
+ * It is needed to compare with test_id and select
+ * the desired test.
+ */
+int main(int argc, char *argv[]) {
+
+  /*
+   * The value returned by the main function. In case of a
+   * failed test, the unchanged value of 1 will be returned.
+   */
+  int res = 1;
+
+  /* The number of elements in the test_param_arr array. */
+  int size = sizeof(test_param_arr) / sizeof(test_param_arr[0]);
+
+  /* Checking for the number of passed parameters in main. */
+  if (argc != 2) {
+    printf("[ERROR]: The wrong number of arguments was passed.\n");
+    exit(res);
+  }
+
+  /* A lost wake-up must fail the test, not hang it. */
+  alarm(120);
+
+  if (strcmp(argv[1], "shm0") == 0) {
+    qe_shm *shm = qe_shm_create(10);
+    int fd = memfd_create("qe_shm_test", 0);
+
+    printf("TEST_SHM (Null pointers, a wrong descriptor, a large batch): ");
+    if ((shm != NULL) && (qe_shm_submit(NULL, 1, 0) == QE_ERR_NULLPTR) &&
+        (qe_shm_wait(NULL) == QE_ERR_NULLPTR) &&
+        (qe_shm_serve(NULL, NULL) == QE_ERR_NULLPTR) &&
+        (qe_shm_get_arrays(NULL) == NULL) && (qe_shm_open(-1) == NULL) &&
+        (ftruncate(fd, 65536) == 0) && (qe_shm_open(fd) == NULL) &&
+        (qe_shm_submit(shm, 11, 0) == QE_SHM_ERR_SIZE) &&
+        (qe_shm_get_arrays(shm)->capacity == 10)) {
+      printf("[OK].\n");
+      res = 0;
+    } else
+      printf("[ERROR]: QE_ERR_NULLPTR, QE_SHM_ERR_SIZE and NULL were "
+             "expected.\n");
+
+    close(fd);
+    qe_shm_close(shm);
+  }
+
+  /*
+   * Search for the desired structure by the test_id
+   * parameter received by the main function.
+   */
+  for (int i = 0; i < size; i++)
+    if (strcmp(argv[1], test_param_arr[i].test_id) == 0)
+      res = check(i);
+
+  return res;
+}
+
+/*
+ * The solver process: maps the region by its own descriptor and
+ * serves it until the shutdown.
+ */
+static void solver_main(int fd, int nthreads) {
+  qe_shm *shm = qe_shm_open(dup(fd));
+  qe_pool *pool = (nthreads > 0) ? qe_pool_create(nthreads, 0) : NULL;
+  int res;
+
+  if (shm == NULL)
+    _exit(2);
+
+  res = qe_shm_serve(shm, pool);
+  if (pool != NULL)
+    qe_pool_destroy(pool);
+  qe_shm_close(shm);
+  _exit(res != 0);
+}
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, solves the batches through the
+ * solver process and compares the results. In case of an error,
+ * it returns 1.
+ */
+static int check(int test_num) {
+  test_param *t = &test_param_arr[test_num];
+  qe_shm *shm = qe_shm_create(t->capacity);
+  const qe_shm_arrays *ar = qe_shm_get_arrays(shm);
+  double *true_res1, *true_res2;
+  int *true_msg_id;
+  int res = 0, status;
+  pid_t pid;
+
+  printf("TEST_SHM_%d (%s): ", test_num, t->name);
+
+  true_res1 = malloc(t->size * sizeof(double));
+  true_res2 = malloc(t->size * sizeof(double));
+  true_msg_id = malloc(t->size * sizeof(int));
+  if ((shm == NULL) || !true_res1 || !true_res2 || !true_msg_id) {
+    printf("[ERROR]: The region was not created.\n");
+    exit(1);
+  }
+
+  pid = fork();
+  if (pid == 0)
+    solver_main(qe_shm_fd(shm), t->nthreads);
+
+  for (size_t k = 0; (k < t->batches) && !res; k++) {
+    size_t n = t->size - k % t->size;
+
+    /* Random parameters from -1 to 1, every tenth `a` is zero. */
+    for (size_t i = 0; i < n; i++) {
+      ar->a[i] = ((i + k) % 10 == 0) ? 0 : 2.0 * rand() / RAND_MAX - 1.0;
+      ar->b[i] = 2.0 * rand() / RAND_MAX - 1.0;
+      ar->c[i] = 2.0 * rand() / RAND_MAX - 1.0;
+    }
+
+    if (qe_shm_submit(shm, n, t->prec) != QE_BATCH_OK) {
+      printf("[ERROR]: The batch %zu was not submitted.\n", k);
+      res = 1;
+      break;
+    }
+
+    /* The pending batch must be solved, not dropped. */
+    if (t->early && (k + 1 == t->batches))
+      qe_shm_shutdown(shm);
+
+    if (qe_shm_wait(shm) != QE_BATCH_OK) {
+      printf("[ERROR]: The batch %zu failed.\n", k);
+      res = 1;
+      break;
+    }
+
+    solve_equation_batch_prec(ar->a, ar->b, ar->c, true_res1, true_res2,
+                              true_msg_id, n, t->prec);
+    for (size_t i = 0; (i < n) && !res; i++)
+      if ((ar->msg_id[i] != true_msg_id[i]) ||
+          (memcmp(&ar->res1[i], &true_res1[i], sizeof(double)) != 0) ||
+          (memcmp(&ar->res2[i], &true_res2[i], sizeof(double)) != 0)) {
+        printf("[ERROR]:\n");
+        printf("\tBatch %zu, equation %zu: a = %A   b = %A   c = %A\n", k, i,
+               ar->a[i], ar->b[i], ar->c[i]);
+        printf("\tReceived answer: res1 = %A   res2 = %A   msg[%d]\n",
+               ar->res1[i], ar->res2[i], ar->msg_id[i]);
+        printf("\tExpected answer: res1 = %A   res2 = %A   msg[%d]\n",
+               true_res1[i], true_res2[i], true_msg_id[i]);
+        res = 1;
+      }
+  }
+
+  if (t->early) {
+    if (!res && (qe_shm_submit(shm, 1, t->prec) != QE_SHM_ERR_SHUTDOWN)) {
+      printf("[ERROR]: QE_SHM_ERR_SHUTDOWN was expected.\n");
+      res = 1;
+    }
+  } else
+    qe_shm_shutdown(shm);
+
+  if ((waitpid(pid, &status, 0) != pid) || !WIFEXITED(status) ||
+      (WEXITSTATUS(status) != 0)) {
+    if (!res)
+      printf("[ERROR]: The solver process failed.\n");
+    res = 1;
+  }
+
+  qe_shm_close(shm);
+  free(true_res1);
+  free(true_res2);
+  free(true_msg_id);
+
+  if (!res)
+    printf("[OK].\n");
+  return res;
+}
@@ -0,0 +1,340 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the tests for the
+ * statistics of the calls (qe_stats).
+ *
+ * The tests "stats1" - "stats12" solve one equation and check
+ * that exactly its branch and its msg_id are counted. The test
+ * "stats13" solves equations in two waves of threads and checks
+ * that the counters of all of them add up. If the library is
+ * built without QE_STATS, the tests check that the snapshot is
+ * all zeros. The test "stats0" checks the passing of null
+ * pointers.
+ *
+-------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "qe_stats.h"
+#include "quadratic_equation.h"
+#include <float.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The number of threads and of equations of one thread in "stats13". */
+#define STATS_THREADS 4
+#define STATS_CALLS 10000
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, solves the equation and checks
+ * the counters. In case of an error, it returns 1.
+ */
+static int check(int test_num);
+
+/*
+ * The function solves equations in two waves of threads and
+ * checks that the counters add up. In case of an error, it returns 1.
+ */
+static int check_threads(void);
+
+/* The function checks that a snapshot is all zeros. */
+static int is_zero(const qe_stats *stats);
+
+/* A structure that describes a test: one equation and its counters. */
+typedef struct {
+  double a;      /* Transmitted parameter. */
+  double b;      /* Transmitted parameter. */
+  double c;      /* Transmitted parameter. */
+  int prec;      /* The precision mode. */
+  int branch;    /* Expected branch. */
+  int msg_id;    /* Expected response. */
+  char *name;    /* Name of the test. */
+  char *test_id; /* The test ID is needed to select a structure. */
+} test_param;
+
+/* An array of test_param type structures. */
+test_param test_param_arr[] = {
+    {.a = 0,
+     .b = 0,
+     .c = 0,
+     .prec = QE_PREC_EXTENDED,
+     .branch = QE_STATS_BR_ALL_ZERO,
+     .msg_id = QE_OK_INF_RES,
+     .name = "All the parameters are zero.",
+     .test_id = "stats1"},
+
+    {.a = 0,
+     .b = 0,
+     .c = 5,
+     .prec = QE_PREC_EXTENDED,
+     .branch = QE_STATS_BR_ONLY_C,
+     .msg_id = QE_OK_NO_RES,
+     .name = "Only c is not zero.",
+     .test_id = "stats2"},
+
+    {.a = 0,
+     .b = 3,
+     .c = 0,
+     .prec = QE_PREC_EXTENDED,
+     .branch = QE_STATS_BR_ONLY_B,
+     .msg_id = QE_OK_ONE_RES,
+     .name = "Only b is not zero.",
+     .test_id = "stats3"},
+
+    {.a = 2,
+     .b = 0,
+     .c = 0,
+     .prec = QE_PREC_EXTENDED,
+     .branch = QE_STATS_BR_ONLY_A,
+     .msg_id = QE_OK_ONE_RES,
+     .name = "Only a is not zero.",
+     .test_id = "stats4"},
+
+    {.a = 0,
+     .b = 1e-300,
+     .c = 1e300,
+     .prec = QE_PREC_EXTENDED,
+     .branch = QE_STATS_BR_LINEAR,
+     .msg_id = QE_ERR_OVERFLOW,
+     .name = "The linear equation, the root overflows.",
+     .test_id = "stats5"},
+
+    {.a = 1,
+     .b = -3,
+     .c = 2,
+     .prec = QE_PREC_EXTENDED,
+     .branch = QE_STATS_BR_DISC_POS,
+     .msg_id = QE_OK_TWO_RES,
+     .name = "Two roots.",
+     .test_id = "stats6"},
+
+    {.a = 1,
+     .b = 2,
+     .c = 1,
+     .prec = QE_PREC_EXTENDED,
+     .branch = QE_STATS_BR_DISC_ZERO,
+     .msg_id = QE_OK_ONE_RES,
+     .name = "One root.",
+     .test_id = "stats7"},
+
+    {.a = 1,
+     .b = 1,
+     .c = 1,
+     .prec = QE_PREC_EXTENDED,
+     .branch = QE_STATS_BR_DISC_NEG,
+     .msg_id = QE_OK_NO_RES,
+     .name = "No roots.",
+     .test_id = "stats8"},
+
+    {.a = 1,
+     .b = -3,
+     .c = 2,
+     .prec = QE_PREC_DOUBLE,
+     .branch = QE_STATS_BR_DISC_POS,
+     .msg_id = QE_OK_TWO_RES,
+     .name = "Two roots, QE_PREC_DOUBLE.",
+     .test_id = "stats9"},
+
+    {.a = 1e-300,
+     .b = 1e10,
+     .c = 1,
+     .prec = QE_PREC_DOUBLE,
+     .branch = QE_STATS_BR_SCALED,
+     .msg_id = QE_ERR_OVERFLOW,
+     .name = "Tiny a, the root overflows, QE_PREC_DOUBLE.",
+     .test_id = "stats10"},
+
+    {.a = 1,
+     .b = INFINITY,
+     .c = 1,
+     .prec = QE_PREC_DOUBLE,
+     .branch = QE_STATS_BR_NOT_FINITE,
+     .msg_id = QE_ERR_OVERFLOW,
+     .name = "Infinite b, QE_PREC_DOUBLE.",
+     .test_id = "stats11"},
+
+    {.a = 0,
+     .b = 2,
+     .c = -4,
+     .prec = QE_PREC_DOUBLE,
+     .branch = QE_STATS_BR_LINEAR,
+     .msg_id = QE_OK_ONE_RES,
+     .name = "The linear equation, QE_PREC_DOUBLE.",
+     .test_id = "stats12"}};
+
+/*
+ * The main function receives one parameter as input.
+ * It is needed to compare with test_id and select
+ * the desired test.
+ */
+int main(int argc, char *argv[]) {
+
+  /*
+   * The value returned by the main function. In case of a
+   * failed test, the unchanged value of 1 will be returned.
+   */
+  int res = 1;
+
+  /* The number of elements in the test_param_arr array. */
+  int size = sizeof(test_param_arr) / sizeof(test_param_arr[0]);
+
+  /* Checking for the number of passed parameters in main. */
+  if (argc != 2) {
+    printf("[ERROR]: The wrong number of arguments was passed.\n");
+    exit(res);
+  }
+
+  if (strcmp(argv[1], "stats0") == 0) {
+    qe_stats stats;
+    double x;
+
+    printf("TEST_STATS (Null pointers): ");
+    qe_stats_snapshot(NULL);
+    qe_stats_reset();
+    solve_equation(1, 2, 1, &x, NULL);
+    qe_stats_snapshot(&stats);
+
+    if ((stats.enabled == qe_stats_enabled()) &&
+        (stats.enabled ? (stats.status[QE_ERR_NULLPTR - QE_ERR_NULLPTR] == 1)
+                       : is_zero(&stats))) {
+      printf("[OK].\n");
+      res = 0;
+    } else
+      printf("[ERROR]: The call was not counted as QE_ERR_NULLPTR.\n");
+  }
+
+  if (strcmp(argv[1], "stats13") == 0)
+    res = check_threads();
+
+  /*
+   * Search for the desired structure by the test_id
+   * parameter received by the main function.
+   */
+  for (int i = 0; i < size; i++)
+    if (strcmp(argv[1], test_param_arr[i].test_id) == 0)
+      res = check(i);
+
+  return res;
+}
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, solves the equation and checks
+ * the counters. In case of an error, it returns 1.
+ */
+static int check(int test_num) {
+  test_param *t = &test_param_arr[test_num];
+  qe_stats stats;
+  double res1, res2;
+  int msg_id, res = 0;
+
+  printf("TEST_STATS_%d (%s): ", test_num, t->name);
+
+  qe_stats_reset();
+  msg_id = solve_equation_prec(t->a, t->b, t->c, &res1, &res2, t->prec);
+  qe_stats_snapshot(&stats);
+
+  if (msg_id != t->msg_id) {
+    printf("[ERROR]: msg[%d] was received, msg[%d] was expected.\n", msg_id,
+           t->msg_id);
+    return 1;
+  }
+
+  if (!qe_stats_enabled()) {
+    res = !is_zero(&stats);
+  } else {
+    unsigned long long branches = 0;
+
+    for (int i = 0; i < QE_STATS_BRANCHES; i++)
+      branches += stats.branch[i];
+    res = (stats.calls != 1) || (branches != 1) ||
+          (stats.branch[t->branch] != 1) ||
+          (stats.status[t->msg_id - QE_ERR_NULLPTR] != 1);
+  }
+
+  if (res) {
+    printf("[ERROR]: calls %llu, the branch %d counted %llu times, the "
+           "msg_id %llu times.\n",
+           stats.calls, t->branch, stats.branch[t->branch],
+           stats.status[t->msg_id - QE_ERR_NULLPTR]);
+  } else
+    printf("[OK].\n");
+  return res;
+}
+
+/* A thread of the test "stats13": solves STATS_CALLS equations. */
+static void *thread_main(void *p) {
+  unsigned int seed = (unsigned int)(size_t)p;
+  double res1, res2;
+
+  for (int i = 0; i < STATS_CALLS; i++)
+    solve_equation_prec((double)(rand_r(&seed) % 21 - 10),
+                        (double)(rand_r(&seed) % 21 - 10),
+                        (double)(rand_r(&seed) % 21 - 10), &res1, &res2,
+                        i % 2);
+  return NULL;
+}
+
+/*
+ * The function solves equations in two waves of threads and
+ * checks that the counters add up. The threads of the second wave
+ * take the counters of the finished ones.
+ */
+static int check_threads(void) {
+  pthread_t threads[STATS_THREADS];
+  unsigned long long calls = 2ULL * STATS_THREADS * STATS_CALLS;
+  unsigned long long status = 0, branches = 0, latency = 0;
+  qe_stats stats;
+  int res;
+
+  printf("TEST_STATS (Two waves of %d threads): ", STATS_THREADS);
+
+  qe_stats_reset();
+  for (int wave = 0; wave < 2; wave++) {
+    for (int i = 0; i < STATS_THREADS; i++)
+      pthread_create(&threads[i], NULL, thread_main,
+                     (void *)(size_t)(wave * STATS_THREADS + i + 1));
+    for (int i = 0; i < STATS_THREADS; i++)
+      pthread_join(threads[i], NULL);
+  }
+  qe_stats_snapshot(&stats);
+
+  if (!qe_stats_enabled()) {
+    res = !is_zero(&stats);
+  } else {
+    for (int i = 0; i < QE_STATS_STATUSES; i++)
+      status += stats.status[i];
+    for (int i = 0; i < QE_STATS_BRANCHES; i++)
+      branches += stats.branch[i];
+    for (int i = 0; i < QE_STATS_BUCKETS; i++)
+      latency += stats.latency[i];
+
+    /* Every thread measures every QE_STATS_SAMPLE_PERIOD-th call. */
+    res = (stats.calls != calls) || (status != calls) ||
+          (branches != calls) || (latency != stats.samples);
+#if defined(__x86_64__) || defined(__i386__)
+    res |= (stats.samples + STATS_THREADS < calls / QE_STATS_SAMPLE_PERIOD) ||
+           (stats.samples > calls / QE_STATS_SAMPLE_PERIOD + STATS_THREADS);
+#endif
+  }
+
+  if (res)
+    printf("[ERROR]: calls %llu of %llu, statuses %llu, branches %llu, "
+           "samples %llu, in the histogram %llu.\n",
+           stats.calls, calls, status, branches, stats.samples, latency);
+  else
+    printf("[OK].\n");
+  return res;
+}
+
+/* The function checks that a snapshot is all zeros. */
+static int is_zero(const qe_stats *stats) {
+  qe_stats zero;
+
+  memset(&zero, 0, sizeof(zero));
+  return memcmp(stats, &zero, sizeof(zero)) == 0;
+}
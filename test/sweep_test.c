@@ -0,0 +1,371 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the tests for
+ * the sweeps (qe_sweep.h).
+ *
+ * Every test solves a sweep or a batch with a shared `a` in both
+ * precision modes and checks that every msg_id is the same as the
+ * msg_id of solve_equation_prec, and every root differs from its
+ * root by at most one unit in the last place (if `a` is a power of
+ * two, the roots must be the same). The test "sweep0" checks the
+ * passing of null pointers.
+ *
+-------------------------------------------------------------*/
+
+#include "qe_sweep.h"
+#include "quadratic_equation.h"
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The maximum difference of the roots in units in the last place. */
+#define SWEEP_ULPS 1
+
+/* The functions of the sweeps that are tested. */
+#define SWEEP_C 0
+#define SWEEP_C_RANGE 1
+#define SWEEP_B 2
+#define SWEEP_FIXED_A 3
+#define SWEEP_MONIC 4
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, solves the sweep in the given
+ * precision mode and compares the results with solve_equation_prec.
+ * In case of an error, it returns 1.
+ */
+static int check(int test_num, int prec);
+
+/*
+ * The function returns the distance between two doubles
+ * in units in the last place.
+ */
+static uint64_t ulp_distance(double x, double y);
+
+/*
+ * A structure that describes a test. The changing parameter
+ * is start + i * step; if special is set, some of its values
+ * are replaced by zeros, infinities, NaN and huge or tiny numbers.
+ * For SWEEP_FIXED_A and SWEEP_MONIC it is `c`, and b[i] is the
+ * value of `c` of the equation (7 * i) % size.
+ */
+typedef struct {
+  int sweep;     /* The function of the sweep. */
+  double a;      /* Transmitted parameter (not for SWEEP_MONIC). */
+  double b;      /* Transmitted parameter (not for SWEEP_B). */
+  double c;      /* Transmitted parameter (only for SWEEP_B). */
+  double start;  /* The first value of the changing parameter. */
+  double step;   /* The step of the changing parameter. */
+  size_t size;   /* The number of equations. */
+  int special;   /* Whether special values are inserted. */
+  char *name;    /* Name of the test. */
+  char *test_id; /* The test ID is needed to select a structure. */
+} test_param;
+
+/* An array of test_param type structures. */
+test_param test_param_arr[] = {
+    {.sweep = SWEEP_C,
+     .a = 1,
+     .b = -3,
+     .start = -100,
+     .step = 0.01,
+     .size = 20000,
+     .name = "c from -100 to 100, two, one and no roots.",
+     .test_id = "sweep1"},
+
+    {.sweep = SWEEP_C_RANGE,
+     .a = 1,
+     .b = 2,
+     .start = -4,
+     .step = 0.25,
+     .size = 40,
+     .name = "A grid of c crossing the double root (c = 1).",
+     .test_id = "sweep2"},
+
+    {.sweep = SWEEP_C_RANGE,
+     .a = -3.5,
+     .b = 1e8,
+     .start = -1e-3,
+     .step = 1e-7,
+     .size = 20000,
+     .name = "Ill-conditioned grid, b * b >> 4 * a * c.",
+     .test_id = "sweep3"},
+
+    {.sweep = SWEEP_B,
+     .a = 1,
+     .c = 1,
+     .start = -4,
+     .step = 0.5,
+     .size = 17,
+     .name = "b from -4 to 4, the double roots b = -2 and b = 2.",
+     .test_id = "sweep4"},
+
+    {.sweep = SWEEP_B,
+     .a = 0.3,
+     .c = -7.25,
+     .start = -1000,
+     .step = 0.0137,
+     .size = 150000,
+     .name = "A long sweep of b.",
+     .test_id = "sweep5"},
+
+    {.sweep = SWEEP_C,
+     .a = 2,
+     .b = 5,
+     .start = -50,
+     .step = 0.125,
+     .size = 1000,
+     .special = 1,
+     .name = "Zeros, infinities, NaN, huge and tiny values of c.",
+     .test_id = "sweep6"},
+
+    {.sweep = SWEEP_B,
+     .a = -1,
+     .c = 3,
+     .start = -50,
+     .step = 0.125,
+     .size = 1000,
+     .special = 1,
+     .name = "Zeros, infinities, NaN, huge and tiny values of b.",
+     .test_id = "sweep7"},
+
+    {.sweep = SWEEP_C,
+     .a = 0,
+     .b = 2,
+     .start = -10,
+     .step = 0.5,
+     .size = 41,
+     .name = "a = 0, the linear equations.",
+     .test_id = "sweep8"},
+
+    {.sweep = SWEEP_C_RANGE,
+     .a = 1e-300,
+     .b = 1,
+     .start = -1e10,
+     .step = 1e8,
+     .size = 201,
+     .name = "Tiny a, the roots overflow.",
+     .test_id = "sweep9"},
+
+    {.sweep = SWEEP_B,
+     .a = 1e300,
+     .c = 1e300,
+     .start = -1e300,
+     .step = 1e297,
+     .size = 2001,
+     .name = "Huge parameters.",
+     .test_id = "sweep10"},
+
+    {.sweep = SWEEP_FIXED_A,
+     .a = 0.3,
+     .start = -100,
+     .step = 0.0113,
+     .size = 20000,
+     .name = "A shared a, two, one and no roots.",
+     .test_id = "sweep11"},
+
+    {.sweep = SWEEP_MONIC,
+     .a = 1,
+     .start = -50,
+     .step = 0.125,
+     .size = 20001,
+     .special = 1,
+     .name = "Monic equations with special values of b and c.",
+     .test_id = "sweep12"},
+
+    {.sweep = SWEEP_FIXED_A,
+     .a = -4,
+     .start = -3,
+     .step = 0.25,
+     .size = 1001,
+     .special = 1,
+     .name = "A shared a that is a power of two.",
+     .test_id = "sweep13"},
+
+    {.sweep = SWEEP_FIXED_A,
+     .a = 1e-300,
+     .start = -1e10,
+     .step = 1e7,
+     .size = 2001,
+     .special = 1,
+     .name = "A shared tiny a.",
+     .test_id = "sweep14"},
+
+    {.sweep = SWEEP_FIXED_A,
+     .a = 0,
+     .start = -10,
+     .step = 0.5,
+     .size = 41,
+     .special = 1,
+     .name = "A shared a = 0, the linear equations.",
+     .test_id = "sweep15"}};
+
+/*
+ * The main function receives one parameter as input.
+ * It is needed to compare with test_id and select
+ * the desired test.
+ */
+int main(int argc, char *argv[]) {
+
+  /*
+   * The value returned by the main function. In case of a
+   * failed test, the unchanged value of 1 will be returned.
+   */
+  int res = 1;
+
+  /* The number of elements in the test_param_arr array. */
+  int size = sizeof(test_param_arr) / sizeof(test_param_arr[0]);
+
+  /* Checking for the number of passed parameters in main. */
+  if (argc != 2) {
+    printf("[ERROR]: The wrong number of arguments was passed.\n");
+    exit(res);
+  }
+
+  if (strcmp(argv[1], "sweep0") == 0) {
+    double c = 1, res1, res2;
+    int msg_id;
+
+    printf("TEST_SWEEP (Null pointers): ");
+    if ((solve_equation_sweep_c(1, 2, NULL, &res1, &res2, &msg_id, 1,
+                                QE_PREC_EXTENDED) == QE_ERR_NULLPTR) &&
+        (solve_equation_sweep_c_range(1, 2, 1, 1, &res1, NULL, &msg_id, 1,
+                                      QE_PREC_DOUBLE) == QE_ERR_NULLPTR) &&
+        (solve_equation_sweep_b(1, &c, 1, &res1, &res2, NULL, 1,
+                                QE_PREC_EXTENDED) == QE_ERR_NULLPTR) &&
+        (solve_equation_sweep_b(1, NULL, 1, NULL, NULL, NULL, 0,
+                                QE_PREC_EXTENDED) == QE_BATCH_OK) &&
+        (solve_equation_batch_fixed_a(1, &c, NULL, &res1, &res2, &msg_id, 1,
+                                      QE_PREC_DOUBLE) == QE_ERR_NULLPTR) &&
+        (solve_equation_batch_monic(NULL, &c, &res1, &res2, &msg_id, 1,
+                                    QE_PREC_EXTENDED) == QE_ERR_NULLPTR)) {
+      printf("[OK].\n");
+      res = 0;
+    } else
+      printf("[ERROR]: QE_ERR_NULLPTR was expected.\n");
+  }
+
+  /*
+   * Search for the desired structure by the test_id
+   * parameter received by the main function.
+   */
+  for (int i = 0; i < size; i++)
+    if (strcmp(argv[1], test_param_arr[i].test_id) == 0)
+      res = check(i, QE_PREC_EXTENDED) | check(i, QE_PREC_DOUBLE);
+
+  return res;
+}
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, solves the sweep in the given
+ * precision mode and compares the results with solve_equation_prec.
+ * In case of an error, it returns 1.
+ */
+static int check(int test_num, int prec) {
+  static const double special[] = {0,       -0.0,    INFINITY, -INFINITY,
+                                   NAN,     1e300,   -1e300,   1e-300,
+                                   DBL_MAX, DBL_MIN, 0x1p-1074};
+  test_param *t = &test_param_arr[test_num];
+  double *x, *y, *res1, *res2;
+  int *msg_id, res = 0, fixed, exact;
+  int e;
+
+  printf("TEST_SWEEP_%d (%s, %s): ", test_num, t->name,
+         (prec == QE_PREC_DOUBLE) ? "double" : "extended");
+
+  x = malloc(t->size * sizeof(double));
+  y = malloc(t->size * sizeof(double));
+  res1 = malloc(t->size * sizeof(double));
+  res2 = malloc(t->size * sizeof(double));
+  msg_id = malloc(t->size * sizeof(int));
+  if (!x || !y || !res1 || !res2 || !msg_id) {
+    printf("[ERROR]: Out of memory.\n");
+    exit(1);
+  }
+
+  /* The values of the changing parameter, as computed by the range. */
+  for (size_t i = 0; i < t->size; i++)
+    x[i] = t->start + (double)i * t->step;
+  if (t->special)
+    for (size_t i = 0; i < t->size; i += 37)
+      x[i] = special[(i / 37) % (sizeof(special) / sizeof(special[0]))];
+  for (size_t i = 0; i < t->size; i++)
+    y[i] = x[(7 * i) % t->size];
+
+  /* The roots of a shared `a` that is a power of two are the same. */
+  fixed = (t->sweep == SWEEP_FIXED_A) || (t->sweep == SWEEP_MONIC);
+  exact = fixed && (t->a != 0) && (fabs(frexp(t->a, &e)) == 0.5);
+
+  switch (t->sweep) {
+  case SWEEP_C:
+    solve_equation_sweep_c(t->a, t->b, x, res1, res2, msg_id, t->size, prec);
+    break;
+  case SWEEP_C_RANGE:
+    solve_equation_sweep_c_range(t->a, t->b, t->start, t->step, res1, res2,
+                                 msg_id, t->size, prec);
+    break;
+  case SWEEP_B:
+    solve_equation_sweep_b(t->a, x, t->c, res1, res2, msg_id, t->size, prec);
+    break;
+  case SWEEP_FIXED_A:
+    solve_equation_batch_fixed_a(t->a, y, x, res1, res2, msg_id, t->size,
+                                 prec);
+    break;
+  default:
+    solve_equation_batch_monic(y, x, res1, res2, msg_id, t->size, prec);
+  }
+
+  for (size_t i = 0; (i < t->size) && !res; i++) {
+    double b = (t->sweep == SWEEP_B) ? x[i] : (fixed ? y[i] : t->b);
+    double c = (t->sweep == SWEEP_B) ? t->c : x[i];
+    double true_res1, true_res2;
+    int true_msg_id;
+
+    true_msg_id =
+        solve_equation_prec(t->a, b, c, &true_res1, &true_res2, prec);
+
+    if ((msg_id[i] != true_msg_id) ||
+        (ulp_distance(res1[i], true_res1) > (exact ? 0 : SWEEP_ULPS)) ||
+        (ulp_distance(res2[i], true_res2) > (exact ? 0 : SWEEP_ULPS))) {
+      printf("[ERROR]:\n");
+      printf("\tParameters passed: a = %A   b = %A   c = %A\n", t->a, b, c);
+      printf("\tReceived answer: res1 = %A   res2 = %A   msg[%d]\n", res1[i],
+             res2[i], msg_id[i]);
+      printf("\tExpected answer: res1 = %A   res2 = %A   msg[%d]\n",
+             true_res1, true_res2, true_msg_id);
+      res = 1;
+    }
+  }
+
+  free(x);
+  free(y);
+  free(res1);
+  free(res2);
+  free(msg_id);
+
+  if (!res)
+    printf("[OK].\n");
+  return res;
+}
+
+/*
+ * The function returns the distance between two doubles
+ * in units in the last place. The bits are mapped to integers
+ * that grow with the numbers; equal NaNs have the distance 0.
+ */
+static uint64_t ulp_distance(double x, double y) {
+  uint64_t ux, uy;
+
+  if (isnan(x) && isnan(y))
+    return 0;
+
+  memcpy(&ux, &x, sizeof(ux));
+  memcpy(&uy, &y, sizeof(uy));
+  ux = (ux >> 63) ? ~ux : ux | (1ULL << 63);
+  uy = (uy >> 63) ? ~uy : uy | (1ULL << 63);
+  return (ux > uy) ? ux - uy : uy - ux;
+}
@@ -0,0 +1,311 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the tests for the
+ * table of equations with incremental solving (qe_table).
+ *
+ * Every test changes the equations of a table for several ticks,
+ * by its pattern, and refreshes the table after every tick. The
+ * same changes are made to plain arrays, which are solved whole by
+ * solve_equation_batch_prec, and the results of the table must be
+ * exactly the same, as must be the number of the dirty equations.
+ * The test "table0" checks the passing of null pointers and of
+ * equations out of the table.
+ *
+-------------------------------------------------------------*/
+
+#include "qe_pool.h"
+#include "qe_table.h"
+#include "quadratic_equation.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The patterns of the changes. */
+#define PATTERN_SCATTERED 0 /* Equations at random places. */
+#define PATTERN_RUNS 1      /* Runs of equations set by qe_table_set_range. */
+#define PATTERN_SAME 2      /* Some equations set to their own parameters. */
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, changes and refreshes a table
+ * in the given precision mode and compares its results with the
+ * ones of the solved arrays. In case of an error, it returns 1.
+ */
+static int check(int test_num, int prec);
+
+/* A structure that describes a test. */
+typedef struct {
+  int pattern;    /* The pattern of the changes. */
+  size_t size;    /* The number of equations of the table. */
+  int ticks;      /* The number of refreshes after the first one. */
+  size_t changes; /* The equations (or runs) set in a tick. */
+  int nthreads;   /* Threads of the pool, 0 for qe_table_refresh. */
+  char *name;     /* Name of the test. */
+  char *test_id;  /* The test ID is needed to select a structure. */
+} test_param;
+
+/* An array of test_param type structures. */
+test_param test_param_arr[] = {
+    {.pattern = PATTERN_SCATTERED,
+     .size = 1000,
+     .ticks = 20,
+     .changes = 10,
+     .nthreads = 0,
+     .name = "A few scattered changes.",
+     .test_id = "table1"},
+
+    {.pattern = PATTERN_RUNS,
+     .size = 100003,
+     .ticks = 10,
+     .changes = 5,
+     .nthreads = 0,
+     .name = "Runs of changes.",
+     .test_id = "table2"},
+
+    {.pattern = PATTERN_SAME,
+     .size = 5000,
+     .ticks = 10,
+     .changes = 300,
+     .nthreads = 0,
+     .name = "Equations set to the same parameters.",
+     .test_id = "table3"},
+
+    {.pattern = PATTERN_SCATTERED,
+     .size = 200000,
+     .ticks = 5,
+     .changes = 20000,
+     .nthreads = 4,
+     .name = "Many scattered changes on a pool of 4 threads.",
+     .test_id = "table4"},
+
+    {.pattern = PATTERN_RUNS,
+     .size = 300001,
+     .ticks = 5,
+     .changes = 10,
+     .nthreads = 3,
+     .name = "Runs of changes on a pool of 3 threads.",
+     .test_id = "table5"},
+
+    {.pattern = PATTERN_SCATTERED,
+     .size = 65,
+     .ticks = 30,
+     .changes = 100,
+     .nthreads = 2,
+     .name = "A table of 65 equations.",
+     .test_id = "table6"}};
+
+/*
+ * The main function receives one parameter as input.
+ * It is needed to compare with test_id and select
+ * the desired test.
+ */
+int main(int argc, char *argv[]) {
+
+  /*
+   * The value returned by the main function. In case of a
+   * failed test, the unchanged value of 1 will be returned.
+   */
+  int res = 1;
+
+  /* The number of elements in the test_param_arr array. */
+  int size = sizeof(test_param_arr) / sizeof(test_param_arr[0]);
+
+  /* Checking for the number of passed parameters in main. */
+  if (argc != 2) {
+    printf("[ERROR]: The wrong number of arguments was passed.\n");
+    exit(res);
+  }
+
+  if (strcmp(argv[1], "table0") == 0) {
+    qe_table *table = qe_table_create(3, QE_PREC_DOUBLE);
+    double x = 1, res1, res2;
+    int ok;
+
+    printf("TEST_TABLE (Null pointers, equations out of the table): ");
+    ok = (table != NULL) && (qe_table_create(0, QE_PREC_DOUBLE) == NULL) &&
+         (qe_table_size(table) == 3) && (qe_table_dirty(table) == 3) &&
+         (qe_table_get(table, 0, &res1, &res2) == QE_ERR_NULLPTR) &&
+         (qe_table_set(NULL, 0, x, x, x) == QE_ERR_NULLPTR) &&
+         (qe_table_set(table, 3, x, x, x) == QE_ERR_NULLPTR) &&
+         (qe_table_set_range(table, 2, &x, &x, &x, 2) == QE_ERR_NULLPTR) &&
+         (qe_table_set_range(table, 0, &x, NULL, &x, 1) == QE_ERR_NULLPTR) &&
+         (qe_table_set_range(table, 3, &x, &x, &x, 0) == QE_BATCH_OK) &&
+         (qe_table_refresh(NULL) == 0) &&
+         (qe_table_refresh_parallel(NULL, NULL) == 0) &&
+         (qe_table_refresh(table) == 3) && (qe_table_dirty(table) == 0) &&
+         (qe_table_get(table, 1, &res1, &res2) == QE_OK_INF_RES) &&
+         (qe_table_get(table, 3, &res1, &res2) == QE_ERR_NULLPTR) &&
+         (qe_table_get(table, 0, NULL, &res2) == QE_ERR_NULLPTR) &&
+         (qe_table_set(table, 1, 1, 0, -4) == QE_BATCH_OK) &&
+         (qe_table_get(table, 1, &res1, &res2) == QE_OK_INF_RES) &&
+         (qe_table_refresh_parallel(table, NULL) == 1) &&
+         (qe_table_get(table, 1, &res1, &res2) == QE_OK_TWO_RES) &&
+         (fmin(res1, res2) == -2) && (fmax(res1, res2) == 2);
+    qe_table_destroy(table);
+    qe_table_destroy(NULL);
+
+    if (ok) {
+      printf("[OK].\n");
+      res = 0;
+    } else
+      printf("[ERROR]: The checks of the arguments failed.\n");
+  }
+
+  /*
+   * Search for the desired structure by the test_id
+   * parameter received by the main function.
+   */
+  for (int i = 0; i < size; i++)
+    if (strcmp(argv[1], test_param_arr[i].test_id) == 0)
+      res = check(i, QE_PREC_EXTENDED) | check(i, QE_PREC_DOUBLE);
+
+  return res;
+}
+
+/* The function returns a random number from -1 to 1. */
+static double rand_unit(void) { return 2.0 * rand() / RAND_MAX - 1.0; }
+
+/* The function returns a random index from 0 to n - 1. */
+static size_t rand_index(size_t n) {
+  return (((size_t)rand() << 16) ^ (size_t)rand()) % n;
+}
+
+/*
+ * The function sets the i-th equation of the table and of the
+ * arrays, and marks it in dirty if its parameters change.
+ */
+static void set(qe_table *table, double *a, double *b, double *c,
+                char *dirty, size_t i, double na, double nb, double nc) {
+  if ((a[i] != na) || (b[i] != nb) || (c[i] != nc))
+    dirty[i] = 1;
+  a[i] = na;
+  b[i] = nb;
+  c[i] = nc;
+  qe_table_set(table, i, na, nb, nc);
+}
+
+/*
+ * The function makes the changes of one tick by the pattern of the
+ * test and marks the changed equations in dirty.
+ */
+static void change(const test_param *t, qe_table *table, double *a,
+                   double *b, double *c, char *dirty) {
+  for (size_t k = 0; k < t->changes; k++) {
+    size_t i = rand_index(t->size), m, j;
+    double na[256], nb[256], nc[256];
+
+    switch (t->pattern) {
+    case PATTERN_SCATTERED:
+      set(table, a, b, c, dirty, i, rand_unit(), rand_unit(), rand_unit());
+      break;
+    case PATTERN_RUNS:
+      m = 1 + rand_index(256);
+      if (m > t->size - i)
+        m = t->size - i;
+      for (j = 0; j < m; j++) {
+        na[j] = rand_unit();
+        nb[j] = (j % 7 == 0) ? 0 : rand_unit();
+        nc[j] = rand_unit();
+        if ((a[i + j] != na[j]) || (b[i + j] != nb[j]) ||
+            (c[i + j] != nc[j]))
+          dirty[i + j] = 1;
+        a[i + j] = na[j];
+        b[i + j] = nb[j];
+        c[i + j] = nc[j];
+      }
+      qe_table_set_range(table, i, na, nb, nc, m);
+      break;
+    default:
+      if (k % 2 == 0)
+        set(table, a, b, c, dirty, i, a[i], b[i], c[i]);
+      else
+        set(table, a, b, c, dirty, i, rand_unit(), rand_unit(), a[i]);
+    }
+  }
+}
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, changes and refreshes a table
+ * in the given precision mode and compares its results with the
+ * ones of the solved arrays. In case of an error, it returns 1.
+ */
+static int check(int test_num, int prec) {
+  test_param *t = &test_param_arr[test_num];
+  double *a, *b, *c, *res1, *res2;
+  const double *t_res1, *t_res2;
+  const int *t_msg_id;
+  int *msg_id, res = 0;
+  char *dirty;
+  qe_table *table;
+  qe_pool *pool = NULL;
+
+  printf("TEST_TABLE_%d (%s, %s): ", test_num, t->name,
+         (prec == QE_PREC_DOUBLE) ? "double" : "extended");
+
+  a = calloc(t->size, sizeof(double));
+  b = calloc(t->size, sizeof(double));
+  c = calloc(t->size, sizeof(double));
+  res1 = malloc(t->size * sizeof(double));
+  res2 = malloc(t->size * sizeof(double));
+  msg_id = malloc(t->size * sizeof(int));
+  dirty = calloc(t->size, 1);
+  table = qe_table_create(t->size, prec);
+  if (!a || !b || !c || !res1 || !res2 || !msg_id || !dirty || !table) {
+    printf("[ERROR]: Out of memory.\n");
+    exit(1);
+  }
+  qe_table_results(table, &t_res1, &t_res2, &t_msg_id);
+
+  /* The first tick starts from the table of zeros, all dirty. */
+  memset(dirty, 1, t->size);
+  srand(test_num);
+  if (t->nthreads > 0)
+    pool = qe_pool_create(t->nthreads, 0);
+
+  for (int tick = 0; (tick <= t->ticks) && !res; tick++) {
+    size_t ndirty = 0, solved;
+
+    change(t, table, a, b, c, dirty);
+    for (size_t i = 0; i < t->size; i++)
+      ndirty += (size_t)dirty[i];
+    if (qe_table_dirty(table) != ndirty) {
+      printf("[ERROR]: Tick %d: %zu dirty equations, expected %zu.\n", tick,
+             qe_table_dirty(table), ndirty);
+      res = 1;
+    }
+
+    solved = (pool != NULL) ? qe_table_refresh_parallel(table, pool)
+                            : qe_table_refresh(table);
+    solve_equation_batch_prec(a, b, c, res1, res2, msg_id, t->size, prec);
+
+    if ((solved != ndirty) || (qe_table_dirty(table) != 0)) {
+      printf("[ERROR]: Tick %d: %zu equations refreshed, expected %zu.\n",
+             tick, solved, ndirty);
+      res = 1;
+    }
+    if ((memcmp(t_res1, res1, t->size * sizeof(double)) != 0) ||
+        (memcmp(t_res2, res2, t->size * sizeof(double)) != 0) ||
+        (memcmp(t_msg_id, msg_id, t->size * sizeof(int)) != 0)) {
+      printf("[ERROR]: Tick %d: the results differ.\n", tick);
+      res = 1;
+    }
+    memset(dirty, 0, t->size);
+  }
+
+  if (pool != NULL)
+    qe_pool_destroy(pool);
+  qe_table_destroy(table);
+  free(a);
+  free(b);
+  free(c);
+  free(res1);
+  free(res2);
+  free(msg_id);
+  free(dirty);
+
+  if (!res)
+    printf("[OK].\n");
+  return res;
+}
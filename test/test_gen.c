@@ -0,0 +1,78 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the generators of
+ * parameters shared by the tests of the batch functions.
+ *
+-------------------------------------------------------------*/
+
+#include "test_gen.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The function returns a double with random bits. */
+double gen_random_bits(void) {
+  unsigned long long u = 0;
+  double x;
+
+  for (int i = 0; i < 4; i++)
+    u = (u << 16) ^ (unsigned long long)rand();
+
+  memcpy(&x, &u, sizeof(x));
+  return x;
+}
+
+/* Random parameters from -1 to 1. */
+void gen_uniform(size_t i, double *a, double *b, double *c) {
+  (void)i;
+  *a = 2.0 * rand() / RAND_MAX - 1.0;
+  *b = 2.0 * rand() / RAND_MAX - 1.0;
+  *c = 2.0 * rand() / RAND_MAX - 1.0;
+}
+
+/* Random integers from -4 to 4. */
+void gen_integer(size_t i, double *a, double *b, double *c) {
+  (void)i;
+  *a = rand() % 9 - 4;
+  *b = rand() % 9 - 4;
+  *c = rand() % 9 - 4;
+}
+
+/* Random bit patterns. */
+void gen_bits(size_t i, double *a, double *b, double *c) {
+  (void)i;
+  *a = gen_random_bits();
+  *b = gen_random_bits();
+  *c = gen_random_bits();
+}
+
+/* Random parameters with random exponents from -300 to 300. */
+void gen_scaled(size_t i, double *a, double *b, double *c) {
+  gen_uniform(i, a, b, c);
+  gen_scale(a, b, c, 300);
+}
+
+/* The function multiplies the parameters by random powers of two. */
+void gen_scale(double *a, double *b, double *c, int max_exp) {
+  *a = ldexp(*a, rand() % (2 * max_exp + 1) - max_exp);
+  *b = ldexp(*b, rand() % (2 * max_exp + 1) - max_exp);
+  *c = ldexp(*c, rand() % (2 * max_exp + 1) - max_exp);
+}
+
+/* The function allocates memory or terminates the test. */
+void *gen_alloc(size_t size) {
+  void *p = malloc(size);
+
+  if (p == NULL) {
+    printf("[ERROR]: Out of memory.\n");
+    exit(1);
+  }
+  return p;
+}
+
+/* The function fills n sets of parameters with the generator. */
+void gen_fill(gen_select select, double *a, double *b, double *c, size_t n) {
+  for (size_t i = 0; i < n; i++)
+    select(i, &a[i], &b[i], &c[i]);
+}
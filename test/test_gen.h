@@ -0,0 +1,55 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the declarations of the generators of
+ * parameters shared by the tests of the batch functions
+ * (test_gen.c).
+ *
+ * A generator writes the i-th set of parameters to a, b, c;
+ * the index is not used by the random generators, it is there
+ * so that a test can also take its parameters from a table.
+ * All of them use rand(), so a test is repeatable.
+ *
+-------------------------------------------------------------*/
+
+#ifndef TEST_GEN_H
+#define TEST_GEN_H
+
+#include <stddef.h>
+
+/* The type of a generator of parameters. */
+typedef void (*gen_select)(size_t i, double *a, double *b, double *c);
+
+/* The function returns a double with random bits. */
+double gen_random_bits(void);
+
+/* Random parameters from -1 to 1. */
+void gen_uniform(size_t i, double *a, double *b, double *c);
+
+/*
+ * Random integers from -4 to 4. A third of the parameters are
+ * zero, so all the special cases and exact discriminants occur.
+ */
+void gen_integer(size_t i, double *a, double *b, double *c);
+
+/* Random bit patterns (any exponent, infinities, NaN). */
+void gen_bits(size_t i, double *a, double *b, double *c);
+
+/* Random parameters from -1 to 1 multiplied by 2^-300 - 2^300. */
+void gen_scaled(size_t i, double *a, double *b, double *c);
+
+/*
+ * The function multiplies each parameter by 2^e with a random e
+ * from -max_exp to max_exp.
+ */
+void gen_scale(double *a, double *b, double *c, int max_exp);
+
+/*
+ * The function allocates size bytes. If there is no memory, it
+ * prints an error and terminates the test with the code 1.
+ */
+void *gen_alloc(size_t size);
+
+/* The function fills n sets of parameters with the generator. */
+void gen_fill(gen_select select, double *a, double *b, double *c, size_t n);
+
+#endif
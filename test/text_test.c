@@ -0,0 +1,212 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the tests for
+ * the qe_parse_double function.
+ *
+ * Each test writes random numbers in its own format and checks
+ * that qe_parse_double gives the same double as strtod and stops
+ * at the same character. The text is not followed by a zero
+ * byte, so reading past its end is also detected (by tools like
+ * valgrind). The test "text0" checks the malformed numbers; unlike
+ * strtod, qe_parse_double does not skip the leading white space, so
+ * an empty field at the end of a line is not read from the next one.
+ *
+-------------------------------------------------------------*/
+
+#include "qe_text.h"
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, formats random numbers and
+ * compares the results of qe_parse_double and strtod.
+ * In case of an error, it returns 1.
+ */
+static int check(int test_num);
+
+/*
+ * The function parses the number from a buffer without the zero
+ * byte and compares the result with strtod. It returns true if
+ * they match, otherwise it prints an error.
+ */
+static int check_number(const char *text);
+
+/* The function returns a double with random bits. */
+static double random_bits(void);
+
+/*
+ * A structure that describes a test: the format of
+ * the numbers and the generator of their values.
+ */
+typedef struct {
+  char *format;           /* The format of printf. */
+  double (*random)(void); /* Generator of the values. */
+  char *name;             /* Name of the test. */
+  char *test_id;          /* The test ID is needed to select a structure. */
+} test_param;
+
+/* Random numbers from -1000 to 1000. */
+static double random_uniform(void) {
+  return 2000.0 * rand() / RAND_MAX - 1000.0;
+}
+
+/* Random integers. */
+static double random_integer(void) { return (double)(rand() % 20001 - 10000); }
+
+/* An array of test_param type structures. */
+test_param test_param_arr[] = {
+    {.format = "%.17g",
+     .random = random_uniform,
+     .name = "17 significant digits.",
+     .test_id = "text1"},
+
+    {.format = "%.6f",
+     .random = random_uniform,
+     .name = "Fixed point, 6 digits after the point.",
+     .test_id = "text2"},
+
+    {.format = "%.0f",
+     .random = random_integer,
+     .name = "Integers.",
+     .test_id = "text3"},
+
+    {.format = "%.17e",
+     .random = random_bits,
+     .name = "Any exponent, infinities and NaN.",
+     .test_id = "text4"},
+
+    {.format = "%.25e",
+     .random = random_uniform,
+     .name = "More than 19 digits.",
+     .test_id = "text5"},
+
+    {.format = "%a",
+     .random = random_bits,
+     .name = "Hexadecimal numbers.",
+     .test_id = "text6"}};
+
+/* Malformed numbers and numbers followed by other characters. */
+static const char *special[] = {"",     "-",     "+",     ".",      "e5",
+                                "abc",  "-.e1",  "1e",    "1e+",    "1.5.3",
+                                "7,",   "0.5x",  "-0",    "00012.50", ".5",
+                                "5.",   "1e400", "1e-400", "INF",   "-nan",
+                                "12345678901234567", "123456789012345678901",
+                                "\n2",  " 5",   "\t-1"};
+
+/*
+ * The main function receives one parameter as input.
+ * It is needed to compare with test_id and select
+ * the desired test.
+ */
+int main(int argc, char *argv[]) {
+
+  /*
+   * The value returned by the main function. In case of a
+   * failed test, the unchanged value of 1 will be returned.
+   */
+  int res = 1;
+
+  /* The number of elements in the test_param_arr array. */
+  int size = sizeof(test_param_arr) / sizeof(test_param_arr[0]);
+
+  /* Checking for the number of passed parameters in main. */
+  if (argc != 2) {
+    printf("[ERROR]: The wrong number of arguments was passed.\n");
+    exit(res);
+  }
+
+  if (strcmp(argv[1], "text0") == 0) {
+    printf("TEST_TEXT (Malformed and special numbers): ");
+    res = 0;
+    for (size_t i = 0; (i < sizeof(special) / sizeof(special[0])) && !res; i++)
+      if (!check_number(special[i]))
+        res = 1;
+    if (!res)
+      printf("[OK].\n");
+  }
+
+  /*
+   * Search for the desired structure by the test_id
+   * parameter received by the main function.
+   */
+  for (int i = 0; i < size; i++)
+    if (strcmp(argv[1], test_param_arr[i].test_id) == 0)
+      res = check(i);
+
+  return res;
+}
+
+/*
+ * The function is used for testing. It receives the structure
+ * number from the array as input, formats random numbers and
+ * compares the results of qe_parse_double and strtod.
+ * In case of an error, it returns 1.
+ */
+static int check(int test_num) {
+  char text[64];
+
+  printf("TEST_TEXT_%d (%s): ", test_num, test_param_arr[test_num].name);
+
+  for (int i = 0; i < 200000; i++) {
+    snprintf(text, sizeof(text), test_param_arr[test_num].format,
+             test_param_arr[test_num].random());
+    if (!check_number(text))
+      return 1;
+  }
+
+  printf("[OK].\n");
+  return 0;
+}
+
+/*
+ * The function parses the number from a buffer without the zero
+ * byte and compares the result with strtod. It returns true if
+ * they match, otherwise it prints an error.
+ */
+static int check_number(const char *text) {
+  size_t len = strlen(text);
+  char *buf = malloc(len + 1);
+  const char *stop;
+  char *true_stop;
+  double x = 0, true_x;
+  int ok;
+
+  memcpy(buf, text, len);
+  stop = qe_parse_double(buf, buf + len, &x);
+
+  true_x = strtod(text, &true_stop);
+  if ((true_stop == text) || isspace((unsigned char)text[0]))
+    ok = (stop == NULL);
+  else
+    ok = (stop == buf + (true_stop - text)) &&
+         ((memcmp(&x, &true_x, sizeof(double)) == 0) ||
+          (isnan(x) && isnan(true_x)));
+
+  if (!ok) {
+    printf("[ERROR]:\n");
+    printf("\tText: \"%s\"\n", text);
+    printf("\tReceived: %A, %ld characters\n", x,
+           stop ? (long)(stop - buf) : -1L);
+    printf("\tExpected: %A, %ld characters\n", true_x,
+           (true_stop != text) ? (long)(true_stop - text) : -1L);
+  }
+
+  free(buf);
+  return ok;
+}
+
+/* The function returns a double with random bits. */
+static double random_bits(void) {
+  unsigned long long u = 0;
+  double x;
+
+  for (int i = 0; i < 4; i++)
+    u = (u << 16) ^ (unsigned long long)rand();
+
+  memcpy(&x, &u, sizeof(x));
+  return x;
+}
@@ -0,0 +1,747 @@
+/*-------------------------------------------------------------
+ *
+ * This file contains the implementation of the qe_verify
+ * program, which checks the solving functions on a large
+ * number of random equations on all the processors.
+ *
+ * The parameters of the i-th equation depend only on the seed
+ * and on i (a counter-based generator, SplitMix64 of the
+ * index), so the equations are split between the threads of a
+ * pool in chunks, and a failed one is reproduced by its index:
+ * qe_verify -s seed -b index -n 1. They cover the whole double
+ * range: subnormals, values near DBL_MAX, zeros, infinities and
+ * NaN, exact double roots and close roots, and b * b much larger
+ * than 4 * a * c.
+ *
+ * Every equation is solved by solve_equation and by
+ * solve_equation_prec in the QE_PREC_DOUBLE mode, and both are
+ * checked against a reference in __float128, where b * b and
+ * 4 * a * c are exact and the sign of the discriminant is exact:
+ *
+ *   - the msg_id must be the one of the exact equation, except
+ *     for a discriminant within the rounding error of the mode
+ *     (then no root, one root or two roots are accepted) and for
+ *     a root within 2^-50 of DBL_MAX (then QE_ERR_OVERFLOW is
+ *     accepted too);
+ *   - the residual a * x^2 + b * x + c of every root must be
+ *     within the bound given by the rounding errors of the mode,
+ *     the sum of the roots must be -b / a, and res1 must be the
+ *     root (-b + sqrt(D)) / (2 * a), as in solve_equation.
+ *
+ * solve_equation_branchless, solve_equation_inline and the batch
+ * kernels of every instruction set in both modes must give
+ * bit-identical results.
+ *
+ * The reference checks are first done in double-double
+ * arithmetic by loops over blocks of equations that the compiler
+ * vectorizes. The equations that they do not accept (zero
+ * parameters, parameters outside 2^-300 .. 2^300, results close
+ * to a bound, failures) are checked again in __float128, which
+ * is emulated in software, and only this check reports a failure.
+ *
+ * Usage: qe_verify [-n count] [-b first] [-s seed] [-t threads]
+ *                  [-i isa]
+ *
+ *   -n  the number of equations (1000000000 by default);
+ *   -b  the index of the first equation (0 by default);
+ *   -s  the seed of the generator (1 by default);
+ *   -t  the number of threads (by default one thread per
+ *       processor available to the process);
+ *   -i  the best instruction set whose kernels are checked
+ *       (the QE_ISA_* values), by default the best supported
+ *       one; the ones below it are checked in the next passes.
+ *
+-------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 199309L
+#define QE_INLINE
+
+#include "qe_pool.h"
+#include "quadratic_equation.h"
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* The number of equations of a chunk of the pool. */
+#define VERIFY_CHUNK 65536
+
+/* The number of equations checked together by the vectorized loops. */
+#define VERIFY_BLOCK 512
+
+/* The number of the failures that are printed. */
+#define VERIFY_PRINT 20
+
+/*
+ * The bounds of the parameters that the double-double checks
+ * accept: no product of them or of the roots overflows or loses
+ * its error term.
+ */
+#define VERIFY_MIN 0x1p-300
+#define VERIFY_MAX 0x1p300
+
+/*
+ * The bounds of the rounding errors of the modes, 4 times larger
+ * than the errors. The discriminant of solve_equation is computed
+ * in long double with an error up to 2^-63 * (b * b + |4 * a * c|).
+ * The one of the QE_PREC_DOUBLE mode (Kahan's method) has a
+ * relative error of 2^-53, the bound only allows for the scaling
+ * of huge and tiny parameters. The roots are rounded to double.
+ */
+#define VERIFY_EPS_EXTENDED 0x1p-61
+#define VERIFY_EPS_DOUBLE 0x1p-98
+#define VERIFY_ULP 0x1p-51
+
+/* The reference type: 113 bits of mantissa, 15 bits of exponent. */
+typedef __float128 quad;
+
+/* The results of one path for a block of equations. */
+typedef struct {
+  double res1[VERIFY_BLOCK];
+  double res2[VERIFY_BLOCK];
+  int msg_id[VERIFY_BLOCK];
+} verify_res;
+
+/* The parameters and the counters of a pass. */
+typedef struct {
+  uint64_t seed;     /* The seed of the generator. */
+  uint64_t first;    /* The index of the first equation. */
+  uint64_t n;        /* The number of equations. */
+  int reference;     /* Whether the reference checks are done. */
+  uint64_t slow;     /* The results checked in __float128. */
+  uint64_t failures; /* The number of failures. */
+} verify_pass;
+
+/* The SplitMix64 finalizer. */
+static uint64_t mix(uint64_t z) {
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+/* The function returns the j-th random number of the i-th equation. */
+static uint64_t random_u64(uint64_t seed, uint64_t i, int j) {
+  return mix(mix(seed) + (i * 16 + (uint64_t)j + 1) * 0x9E3779B97F4A7C15ULL);
+}
+
+/* The function returns the double with the given bits. */
+static double from_bits(uint64_t u) {
+  double x;
+
+  memcpy(&x, &u, sizeof(x));
+  return x;
+}
+
+/*
+ * The function returns a double with the sign and the mantissa from
+ * the random number r and an exponent from lo to hi (-1023 is the
+ * exponent of the subnormals).
+ */
+static double random_double(uint64_t r, int lo, int hi) {
+  uint64_t e = (uint64_t)(lo + 1023) + mix(r) % (uint64_t)(hi - lo + 1);
+
+  return from_bits((r & 0x800FFFFFFFFFFFFFULL) | (e << 52));
+}
+
+/* The function returns an infinity or NaN. */
+static double random_special(uint64_t r) {
+  static const double special[] = {INFINITY, -INFINITY, NAN};
+
+  return special[r % 3];
+}
+
+/*
+ * The function generates the parameters of the i-th equation. The
+ * first random number selects one of 16 distributions.
+ */
+static void generate(uint64_t seed, uint64_t i, double *a, double *b,
+                     double *c) {
+  uint64_t r[8];
+  double r1, r2;
+  int k;
+
+  for (k = 0; k < 8; k++)
+    r[k] = random_u64(seed, i, k);
+
+  switch (r[0] % 16) {
+
+  /* Well-scaled parameters. */
+  case 0:
+  case 1:
+  case 2:
+  case 3:
+    *a = random_double(r[1], -40, 40);
+    *b = random_double(r[2], -40, 40);
+    *c = random_double(r[3], -40, 40);
+    break;
+
+  /* Any finite exponent, subnormals included. */
+  case 4:
+  case 5:
+    *a = random_double(r[1], -1023, 1023);
+    *b = random_double(r[2], -1023, 1023);
+    *c = random_double(r[3], -1023, 1023);
+    break;
+
+  /* Random bits, and an infinity or NaN with the probability 1/4. */
+  case 6:
+    *a = from_bits(r[1]);
+    *b = from_bits(r[2]);
+    *c = from_bits(r[3]);
+    if (r[4] % 4 == 0) {
+      double *p[3] = {a, b, c};
+
+      *p[r[5] % 3] = random_special(r[6]);
+    }
+    break;
+
+  /* Parameters near DBL_MAX, the others with any exponent. */
+  case 7:
+    *a = (r[4] & 1) ? random_double(r[1], 1000, 1023)
+                    : random_double(r[1], -1023, 1023);
+    *b = (r[4] & 2) ? random_double(r[2], 1000, 1023)
+                    : random_double(r[2], -1023, 1023);
+    *c = (r[4] & 4) ? random_double(r[3], 1000, 1023)
+                    : random_double(r[3], -1023, 1023);
+    if (r[4] & 8)
+      *b = (r[4] & 16) ? DBL_MAX : -DBL_MAX;
+    break;
+
+  /* Subnormal and tiny parameters, the others with any exponent. */
+  case 8:
+    *a = (r[4] & 1) ? random_double(r[1], -1023, -960)
+                    : random_double(r[1], -1023, 1023);
+    *b = (r[4] & 2) ? random_double(r[2], -1023, -960)
+                    : random_double(r[2], -1023, 1023);
+    *c = (r[4] & 4) ? random_double(r[3], -1023, -960)
+                    : random_double(r[3], -1023, 1023);
+    break;
+
+  /* Small integers: zeros and exact discriminants. */
+  case 9:
+    *a = (double)(int)(r[1] % 17) - 8;
+    *b = (double)(int)(r[2] % 17) - 8;
+    *c = (double)(int)(r[3] % 17) - 8;
+    break;
+
+  /* a * (x - r1) * (x - r2) with random roots. */
+  case 10:
+  case 11:
+    r1 = random_double(r[1], -30, 30);
+    r2 = random_double(r[2], -30, 30);
+    *a = random_double(r[3], -60, 60);
+    *b = -*a * (r1 + r2);
+    *c = *a * r1 * r2;
+    break;
+
+  /* Roots that differ by 2^-10 .. 2^-70 of their value. */
+  case 12:
+    r1 = random_double(r[1], -30, 30);
+    r2 = r1 * (1 + ldexp((r[2] & 1) ? 1 : -1, -10 - (int)(r[2] % 61)));
+    *a = random_double(r[3], -60, 60);
+    *b = -*a * (r1 + r2);
+    *c = *a * r1 * r2;
+    break;
+
+  /* An exact double root: the discriminant is exactly zero. */
+  case 13:
+    r1 = ldexp((double)(int64_t)(r[1] % 65535) - 32767, (int)(r[3] % 41) - 20);
+    *a = ldexp((double)(int64_t)(r[2] % 1048575) - 524287,
+               (int)(r[4] % 81) - 40);
+    *b = -2 * *a * r1;
+    *c = *a * r1 * r1;
+    break;
+
+  /* Every parameter is zero (+0 or -0) with the probability 1/2. */
+  case 14:
+    *a = (r[4] & 1) ? random_double(r[1], -40, 40) : ((r[4] & 8) ? -0.0 : 0);
+    *b = (r[4] & 2) ? random_double(r[2], -40, 40) : ((r[4] & 16) ? -0.0 : 0);
+    *c = (r[4] & 4) ? random_double(r[3], -40, 40) : ((r[4] & 32) ? -0.0 : 0);
+    break;
+
+  /* b * b much larger than 4 * a * c: one root is very small. */
+  default:
+    *a = random_double(r[1], -40, 40);
+    *b = random_double(r[2], 20, 500);
+    *c = random_double(r[3], -40, 40);
+    break;
+  }
+}
+
+/* The exact product x * y = *p + *e (Dekker's method, no overflow). */
+static inline void two_prod(double x, double y, double *p, double *e) {
+  const double split = 134217729.0;
+  double t, xh, xl, yh, yl;
+
+  t = split * x;
+  xh = t - (t - x);
+  xl = x - xh;
+  t = split * y;
+  yh = t - (t - y);
+  yl = y - yh;
+
+  *p = x * y;
+  *e = (((xh * yh - *p) + xh * yl) + xl * yh) + xl * yl;
+}
+
+/* The exact sum x + y = *s + *e (Knuth's method). */
+static inline void two_sum(double x, double y, double *s, double *e) {
+  double t;
+
+  *s = x + y;
+  t = *s - x;
+  *e = (x - (*s - t)) + (y - t);
+}
+
+/* The residual a * x^2 + b * x + c in double-double arithmetic. */
+static inline double residual(double a, double b, double c, double x) {
+  double h, l, hh, hl, bh, bl, s1, e1, s2, e2;
+
+  two_prod(a, x, &h, &l);
+  two_prod(h, x, &hh, &hl);
+  two_prod(b, x, &bh, &bl);
+  two_sum(hh, bh, &s1, &e1);
+  two_sum(s1, c, &s2, &e2);
+  return s2 + (((e1 + e2) + (hl + bl)) + l * x);
+}
+
+/* The sum a * x1 + a * x2 + b in double-double arithmetic. */
+static inline double vieta(double a, double b, double x1, double x2) {
+  double h1, l1, h2, l2, s1, e1, s2, e2;
+
+  two_prod(a, x1, &h1, &l1);
+  two_prod(a, x2, &h2, &l2);
+  two_sum(h1, h2, &s1, &e1);
+  two_sum(s1, b, &s2, &e2);
+  return s2 + ((e1 + e2) + (l1 + l2));
+}
+
+/*
+ * The function does the reference checks of a block in double-double
+ * arithmetic, with half of the bounds of check_reference. fail[i] is
+ * 0 if the results of the i-th equation are accepted, otherwise they
+ * are checked by check_reference. The loop has no branches and only
+ * double values, so the compiler vectorizes it (a comparison is
+ * turned into 0 or 1 by a select).
+ */
+static void check_block(const double *a, const double *b, const double *c,
+                        const verify_res *r, double eps,
+                        double *restrict fail) {
+  for (int i = 0; i < VERIFY_BLOCK; i++) {
+    double x1 = r->res1[i], x2 = r->res2[i], m = r->msg_id[i];
+    double fa = fabs(a[i]), fb = fabs(b[i]), fc = fabs(c[i]);
+    double fx1 = fabs(x1), fx2 = fabs(x2);
+    double p, dp, q, dq, d, s, cls, r1, r2, b1, b2, v, bv, order;
+    double lo, hi, has, no, f;
+
+    /* The parameters and the roots are in range. */
+    lo = (fa < fb) ? fa : fb;
+    lo = (lo < fc) ? lo : fc;
+    hi = (fa > fb) ? fa : fb;
+    hi = (hi > fc) ? hi : fc;
+    f = ((lo >= VERIFY_MIN) ? 0.0 : 1.0) + ((hi <= VERIFY_MAX) ? 0.0 : 1.0);
+    f += ((fx1 <= 0x1p700) ? 0.0 : 1.0) + ((fx2 <= 0x1p700) ? 0.0 : 1.0);
+
+    /* The msg_id: the sign of the discriminant, or any if it is close to 0. */
+    two_prod(b[i], b[i], &p, &dp);
+    two_prod(4.0 * a[i], c[i], &q, &dq);
+    d = (p - q) + (dp - dq);
+    s = p + fabs(q);
+
+    cls = (d > 0) ? QE_OK_TWO_RES : QE_OK_NO_RES;
+    cls = (d == 0) ? QE_OK_ONE_RES : cls;
+    has = ((m == QE_OK_TWO_RES) ? 1.0 : 0.0) +
+          ((m == QE_OK_ONE_RES) ? 1.0 : 0.0);
+    no = (m == QE_OK_NO_RES) ? 1.0 : 0.0;
+    f += ((m == cls) ? 0.0 : 1.0) *
+         (((fabs(d) <= 0.5 * eps * s) ? 0.0 : 1.0) + (1.0 - has - no));
+
+    /* The roots are 0 if there are none, equal if there is one. */
+    f += (1.0 - has) * (((x1 == 0) ? 0.0 : 1.0) + ((x2 == 0) ? 0.0 : 1.0));
+    f += ((m == QE_OK_ONE_RES) ? 1.0 : 0.0) * ((x1 == x2) ? 0.0 : 1.0);
+
+    /* The residuals and their bounds. */
+    r1 = fabs(residual(a[i], b[i], c[i], x1));
+    r2 = fabs(residual(a[i], b[i], c[i], x2));
+    b1 = VERIFY_ULP * (fabs(2.0 * a[i] * x1 + b[i]) * fx1 + fabs(d) / fa);
+    b2 = VERIFY_ULP * (fabs(2.0 * a[i] * x2 + b[i]) * fx2 + fabs(d) / fa);
+    b1 = 0.5 * (b1 + eps * s / fa);
+    b2 = 0.5 * (b2 + eps * s / fa);
+
+    /* The sum of the roots and their order. */
+    v = fabs(vieta(a[i], b[i], x1, x2));
+    bv = 0.5 * VERIFY_ULP * (fb + fa * (fx1 + fx2));
+    order = (x1 - x2) * copysign(1.0, a[i]) + 0.5 * VERIFY_ULP * (fx1 + fx2);
+
+    f += has * (((r1 <= b1) ? 0.0 : 1.0) + ((r2 <= b2) ? 0.0 : 1.0) +
+                ((v <= bv) ? 0.0 : 1.0) + ((order >= 0) ? 0.0 : 1.0));
+    fail[i] = f;
+  }
+}
+
+/*
+ * The function returns whether the larger root of an equation with
+ * the discriminant d (not negative) is larger than f * DBL_MAX:
+ * |b| + sqrt(d) > 2 * |a| * f * DBL_MAX.
+ */
+static int exceeds(quad a, quad b, quad d, quad f) {
+  quad t = 2 * (a < 0 ? -a : a) * f * (quad)DBL_MAX - (b < 0 ? -b : b);
+
+  return (t < 0) || (d > t * t);
+}
+
+/* The absolute value of a quad. */
+static quad qabs(quad x) { return (x < 0) ? -x : x; }
+
+/* The bit of the msg_id in the set of the accepted ones. */
+#define BIT(msg_id) (1u << ((msg_id)-QE_ERR_NULLPTR))
+
+/*
+ * The function checks the results of one equation against the
+ * reference in __float128. Returns NULL if they are accepted,
+ * otherwise the description of the failure. The equations with
+ * infinite or NaN parameters are not checked.
+ */
+static const char *check_reference(double a, double b, double c, int m,
+                                   double x1, double x2, int prec) {
+  const quad lo = 1 - (quad)0x1p-50, hi = 1 + (quad)0x1p-50;
+  quad qa = a, qb = b, qc = c, d, s, z, dlo, dhi, x[2], g, bound;
+  double eps = (prec == QE_PREC_DOUBLE) ? VERIFY_EPS_DOUBLE
+                                        : VERIFY_EPS_EXTENDED;
+  unsigned int accepted;
+  int has = (m == QE_OK_TWO_RES) || (m == QE_OK_ONE_RES);
+
+  if (!isfinite(a) || !isfinite(b) || !isfinite(c))
+    return NULL;
+
+  if (!has && ((x1 != 0) || (x2 != 0)))
+    return "the roots are not zero";
+  if ((m == QE_OK_ONE_RES) && (x1 != x2))
+    return "one root, but res1 != res2";
+
+  /* The special cases. */
+  if ((a == 0) && (b == 0))
+    return (m == ((c == 0) ? QE_OK_INF_RES : QE_OK_NO_RES)) ? NULL
+                                                            : "wrong msg_id";
+
+  if ((c == 0) && ((a == 0) || (b == 0)))
+    return ((m == QE_OK_ONE_RES) && (x1 == 0)) ? NULL : "the root 0 expected";
+
+  /* The linear equation, the root -c / b. */
+  if (a == 0) {
+    quad r = qabs(qc / qb);
+
+    accepted = (r > hi * (quad)DBL_MAX)
+                   ? BIT(QE_ERR_OVERFLOW)
+                   : ((r < lo * (quad)DBL_MAX)
+                          ? BIT(QE_OK_ONE_RES)
+                          : BIT(QE_ERR_OVERFLOW) | BIT(QE_OK_ONE_RES));
+    if (!(accepted & BIT(m)))
+      return "wrong msg_id";
+    if ((m == QE_OK_ONE_RES) &&
+        (qabs(qb * x1 + qc) >
+         4 * ((quad)0x1p-53 * qabs(qb * x1) + qabs(qb) * (quad)0x1p-1074)))
+      return "the residual is too large";
+    return NULL;
+  }
+
+  /* b * b and 4 * a * c are exact, d has one rounding. */
+  d = qb * qb - 4 * qa * qc;
+  s = qb * qb + qabs(4 * qa * qc);
+  z = (quad)eps * s;
+
+  /*
+   * The discriminant that the mode may have computed lies in
+   * dlo .. dhi. If it is within the rounding error of zero, no
+   * roots, one root or two roots are accepted.
+   */
+  if (qabs(d) <= z) {
+    dlo = 0;
+    dhi = ((d > 0) ? d : 0) + 2 * z;
+    accepted = BIT(QE_OK_NO_RES);
+    if (!exceeds(qa, qb, dlo, hi))
+      accepted |= BIT(QE_OK_ONE_RES) | BIT(QE_OK_TWO_RES);
+    if (exceeds(qa, qb, dhi, lo))
+      accepted |= BIT(QE_ERR_OVERFLOW);
+  } else if (d < 0) {
+    accepted = BIT(QE_OK_NO_RES);
+  } else {
+    accepted = 0;
+    if (!exceeds(qa, qb, d, hi))
+      accepted |= BIT(QE_OK_TWO_RES);
+    if (exceeds(qa, qb, d, lo))
+      accepted |= BIT(QE_ERR_OVERFLOW);
+  }
+
+  /*
+   * solve_equation takes the square root of the discriminant in
+   * double, so it overflows if the discriminant is above DBL_MAX.
+   */
+  if ((prec != QE_PREC_DOUBLE) && (d > lo * (quad)DBL_MAX)) {
+    if (d > hi * (quad)DBL_MAX)
+      accepted = BIT(QE_ERR_OVERFLOW);
+    else
+      accepted |= BIT(QE_ERR_OVERFLOW);
+  }
+
+  if (!(accepted & BIT(m)))
+    return "wrong msg_id";
+  if (!has)
+    return NULL;
+
+  /*
+   * The residuals, multiplied by |a| (a division is slow in
+   * __float128). A root has the error of its rounding, and the
+   * error of the square root of the discriminant divided by 2 * a.
+   * The discriminant of solve_equation is also rounded to double,
+   * which loses its bits below 2^-1074.
+   */
+  x[0] = x1;
+  x[1] = x2;
+  for (int k = 0; k < 2; k++) {
+    g = qabs(2 * qa * x[k] + qb);
+    bound = 4 * ((quad)0x1p-53 * (g * qabs(x[k]) * qabs(qa) + qabs(d)) + z +
+                 (quad)0x1p-1074 *
+                     (g * qabs(qa) + ((prec == QE_PREC_DOUBLE) ? 0 : 1)));
+    if (qabs(qa) * qabs((qa * x[k] + qb) * x[k] + qc) > bound)
+      return "the residual is too large";
+  }
+
+  if (qabs(qa * x1 + qa * x2 + qb) >
+      4 * ((quad)0x1p-53 * (qabs(qb) + qabs(qa) * (qabs(x[0]) + qabs(x[1]))) +
+           qabs(qa) * (quad)0x1p-1073))
+    return "the sum of the roots is not -b / a";
+
+  if (((a > 0) ? x[0] - x[1] : x[1] - x[0]) <
+      -4 * (quad)0x1p-53 * (qabs(x[0]) + qabs(x[1])))
+    return "res1 is not (-b + sqrt(D)) / (2 * a)";
+
+  return NULL;
+}
+
+/* The function prints a failure, only the first VERIFY_PRINT ones. */
+static void report(verify_pass *pass, uint64_t index, double a, double b,
+                   double c, const char *path, int prec, const char *reason,
+                   int msg_id, double res1, double res2) {
+  uint64_t k = __atomic_fetch_add(&pass->failures, 1, __ATOMIC_RELAXED);
+
+  if (k >= VERIFY_PRINT)
+    return;
+
+  printf("[ERROR]: equation %llu, %s (mode %d): %s.\n"
+         "\tParameters passed: a = %A   b = %A   c = %A\n"
+         "\tReceived answer: res1 = %A   res2 = %A   msg[%d]\n",
+         (unsigned long long)index, path, prec, reason, a, b, c, res1, res2,
+         msg_id);
+}
+
+/*
+ * The function compares the results of a path with the ones of the
+ * scalar function bit by bit and reports the differences.
+ */
+static void compare(verify_pass *pass, uint64_t first, size_t n,
+                    const double *a, const double *b, const double *c,
+                    const verify_res *r, const verify_res *expected,
+                    const char *path, int prec) {
+  for (size_t i = 0; i < n; i++)
+    if ((r->msg_id[i] != expected->msg_id[i]) ||
+        (memcmp(&r->res1[i], &expected->res1[i], sizeof(double)) != 0) ||
+        (memcmp(&r->res2[i], &expected->res2[i], sizeof(double)) != 0))
+      report(pass, first + (uint64_t)i, a[i], b[i], c[i], path, prec,
+             "differs from the scalar function", r->msg_id[i], r->res1[i],
+             r->res2[i]);
+}
+
+/*
+ * The function does the reference checks of the results of a mode:
+ * in double-double by check_block, and the equations that it does
+ * not accept in __float128. Returns the number of the latter.
+ */
+static uint64_t check_mode(verify_pass *pass, uint64_t first, size_t n,
+                           const double *a, const double *b, const double *c,
+                           const verify_res *r, int prec, const char *path) {
+  double fail[VERIFY_BLOCK];
+  uint64_t slow = 0;
+  const char *reason;
+
+  check_block(a, b, c, r,
+              (prec == QE_PREC_DOUBLE) ? VERIFY_EPS_DOUBLE
+                                       : VERIFY_EPS_EXTENDED,
+              fail);
+
+  for (size_t i = 0; i < n; i++) {
+    if (fail[i] == 0)
+      continue;
+
+    slow++;
+    reason = check_reference(a[i], b[i], c[i], r->msg_id[i], r->res1[i],
+                             r->res2[i], prec);
+    if (reason != NULL)
+      report(pass, first + (uint64_t)i, a[i], b[i], c[i], path, prec, reason,
+             r->msg_id[i], r->res1[i], r->res2[i]);
+  }
+
+  return slow;
+}
+
+/* The function checks one chunk of equations (a task of the pool). */
+static void check_chunk(void *ctx, size_t chunk) {
+  verify_pass *pass = ctx;
+  double a[VERIFY_BLOCK], b[VERIFY_BLOCK], c[VERIFY_BLOCK];
+  verify_res ext, dbl, r;
+  uint64_t start = (uint64_t)chunk * VERIFY_CHUNK, slow = 0;
+  uint64_t end = (start + VERIFY_CHUNK < pass->n) ? start + VERIFY_CHUNK
+                                                  : pass->n;
+
+  for (uint64_t k = start; k < end; k += VERIFY_BLOCK) {
+    uint64_t first = pass->first + k;
+    size_t m = (end - k < VERIFY_BLOCK) ? (size_t)(end - k) : VERIFY_BLOCK;
+
+    /* The last block is filled up with the equation 0 * x^2 + 0 * x + 0. */
+    for (size_t i = 0; i < VERIFY_BLOCK; i++) {
+      if (i < m)
+        generate(pass->seed, first + i, &a[i], &b[i], &c[i]);
+      else
+        a[i] = b[i] = c[i] = 0;
+    }
+
+    for (int i = 0; i < VERIFY_BLOCK; i++) {
+      ext.msg_id[i] = solve_equation(a[i], b[i], c[i], &ext.res1[i],
+                                     &ext.res2[i]);
+      dbl.msg_id[i] = solve_equation_prec(a[i], b[i], c[i], &dbl.res1[i],
+                                          &dbl.res2[i], QE_PREC_DOUBLE);
+    }
+
+    if (pass->reference) {
+      slow += check_mode(pass, first, m, a, b, c, &ext, QE_PREC_EXTENDED,
+                         "solve_equation");
+      slow += check_mode(pass, first, m, a, b, c, &dbl, QE_PREC_DOUBLE,
+                         "solve_equation_prec");
+
+      for (int i = 0; i < VERIFY_BLOCK; i++)
+        r.msg_id[i] = solve_equation_branchless(a[i], b[i], c[i], &r.res1[i],
+                                                &r.res2[i]);
+      compare(pass, first, m, a, b, c, &r, &ext, "solve_equation_branchless",
+              QE_PREC_EXTENDED);
+
+      for (int i = 0; i < VERIFY_BLOCK; i++) {
+        qe_result q = solve_equation_inline(a[i], b[i], c[i]);
+
+        r.msg_id[i] = q.msg_id;
+        r.res1[i] = q.res1;
+        r.res2[i] = q.res2;
+      }
+      compare(pass, first, m, a, b, c, &r, &ext, "solve_equation_inline",
+              QE_PREC_EXTENDED);
+    }
+
+    solve_equation_batch_prec(a, b, c, r.res1, r.res2, r.msg_id,
+                              VERIFY_BLOCK, QE_PREC_EXTENDED);
+    compare(pass, first, m, a, b, c, &r, &ext, "solve_equation_batch_prec",
+            QE_PREC_EXTENDED);
+    solve_equation_batch_prec(a, b, c, r.res1, r.res2, r.msg_id,
+                              VERIFY_BLOCK, QE_PREC_DOUBLE);
+    compare(pass, first, m, a, b, c, &r, &dbl, "solve_equation_batch_prec",
+            QE_PREC_DOUBLE);
+  }
+
+  __atomic_fetch_add(&pass->slow, slow, __ATOMIC_RELAXED);
+}
+
+/* The function returns the time in seconds. */
+static double time_s(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/*
+ * The main function parses the options and runs a pass for every
+ * instruction set from the selected one down to QE_ISA_GENERIC. The
+ * first pass also does the reference checks. Returns 1 if a check
+ * failed.
+ */
+int main(int argc, char *argv[]) {
+  verify_pass pass;
+  qe_pool *pool;
+  long isa = -1, threads = 0;
+  uint64_t failures = 0;
+  int opt, done = 0;
+
+  memset(&pass, 0, sizeof(pass));
+  pass.seed = 1;
+  pass.n = 1000000000;
+
+  while ((opt = getopt(argc, argv, "n:b:s:t:i:h")) != -1) {
+    switch (opt) {
+    case 'n':
+      pass.n = strtoull(optarg, NULL, 10);
+      break;
+    case 'b':
+      pass.first = strtoull(optarg, NULL, 10);
+      break;
+    case 's':
+      pass.seed = strtoull(optarg, NULL, 10);
+      break;
+    case 't':
+      threads = strtol(optarg, NULL, 10);
+      break;
+    case 'i':
+      isa = strtol(optarg, NULL, 10);
+      break;
+    default:
+      fprintf(stderr,
+              "Usage: %s [-n count] [-b first] [-s seed] [-t threads] "
+              "[-i isa]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  pool = qe_pool_create((int)threads, 0);
+  if (pool == NULL) {
+    fprintf(stderr, "qe_verify: the threads could not be created.\n");
+    return 1;
+  }
+
+  if ((isa < QE_ISA_GENERIC) || (isa > QE_ISA_AVX512))
+    isa = qe_batch_get_isa();
+
+  for (; isa >= QE_ISA_GENERIC; isa--) {
+    double t;
+
+    /* An unsupported instruction set is replaced by a checked one. */
+    if (qe_batch_set_isa((int)isa) != isa)
+      continue;
+
+    pass.reference = !done;
+    pass.slow = pass.failures = 0;
+
+    t = time_s();
+    qe_pool_run(pool, (size_t)((pass.n + VERIFY_CHUNK - 1) / VERIFY_CHUNK),
+                check_chunk, &pass);
+    t = time_s() - t;
+
+    printf("%s: %llu equations from %llu (seed %llu), %s%llu failures, "
+           "%.1f s, %.0f equations/s on %d threads.\n",
+           qe_batch_isa_name((int)isa), (unsigned long long)pass.n,
+           (unsigned long long)pass.first, (unsigned long long)pass.seed,
+           pass.reference ? "reference checks, " : "",
+           (unsigned long long)pass.failures, t, (double)pass.n / t,
+           qe_pool_size(pool));
+    if (pass.reference)
+      printf("\t%llu results checked in __float128.\n",
+             (unsigned long long)pass.slow);
+
+    failures += pass.failures;
+    done = 1;
+  }
+
+  qe_pool_destroy(pool);
+  return failures != 0;
+}